@@ -0,0 +1,546 @@
+/*
+ * Benchmarks of the operations exposed through Rga.kt, issuing the same
+ * submissions (rects, usage, core mask) as the Java_com_rockchip_librga_Rga_*
+ * entry points, minus the JNI marshalling.
+ *
+ * Built against librga on Android (run it with adb shell) and against the
+ * software backend on a host. Every op runs at 16x16 to measure the per-call
+ * overhead, then at 480p .. 8K. Geometric ops and cvtcolor also sweep the
+ * common formats; blending and the job (Task) variants use RGBA_8888.
+ * 10-bit sources are converted to NV12 by the RGA (imcvtcolor10) and by the
+ * CPU kernels (cpu10*) for comparison. imcvtcolorSliced writes RGBA -> NV12
+ * in 64-row slices (rga_slice.h); imcvtcolorSlice64 is its first slice alone,
+ * i.e. how long an encoder waits for the first rows. imcvtcolorNv21* convert
+ * an NV21 frame held in an app array to RGBA: Copy the way
+ * createRgaBufferFromNv21 does (new buffer plus copy per frame), Pooled
+ * through rga_staging.h, and Pinned in place as a pinned ByteArray is.
+ *
+ *   rga_bench [--filter=REGEX] [--min_time=SEC] [--out=FILE.json]
+ *             [--baseline=FILE.json] [--threshold=FRACTION] [--list]
+ *
+ * --out writes Google Benchmark compatible JSON. --baseline compares median
+ * times against such a file and exits with 1 if any benchmark got slower by
+ * more than --threshold (default 0.10).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+#include "im2d_type.h"
+#include "rga_backend.h"
+#include "rga_cpu.h"
+#include "rga_slice.h"
+#include "rga_staging.h"
+
+#define RGA_BENCH_CORE (IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1)
+#define BENCH_SLICE_ROWS 64
+
+typedef struct {
+    const char *name;
+    int width;
+    int height;
+} Resolution;
+
+typedef struct {
+    const char *name;
+    int format;
+} Format;
+
+static const Resolution kOverhead = {"16x16", 16, 16};
+
+static const Resolution kResolutions[] = {
+    {"480p", 640, 480},
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"4K", 3840, 2160},
+    {"8K", 7680, 4320},
+};
+
+static const Format kFormats[] = {
+    {"RGBA_8888", RK_FORMAT_RGBA_8888},
+    {"RGB_888", RK_FORMAT_RGB_888},
+    {"RGB_565", RK_FORMAT_RGB_565},
+    {"NV12", RK_FORMAT_YCbCr_420_SP},
+    {"NV21", RK_FORMAT_YCrCb_420_SP},
+    {"I420", RK_FORMAT_YCbCr_420_P},
+};
+
+static const Format kNv21Format = {"NV21", RK_FORMAT_YCrCb_420_SP};
+
+static const Format kTenBitFormats[] = {
+    {"NV12_10B", RK_FORMAT_YCbCr_420_SP_10B},
+    {"P010", RGA_FORMAT_P010},
+};
+
+typedef enum {
+    OP_COPY,
+    OP_RESIZE,
+    OP_RESCALE,
+    OP_CROP,
+    OP_ROTATE,
+    OP_FLIP,
+    OP_TRANSLATE,
+    OP_CVTCOLOR,
+    OP_BLEND,
+    OP_COMPOSITE,
+    OP_CVTCOLOR10,      /* 10-bit -> NV12 on the RGA */
+    OP_CPU10,           /* the same with rgaCpuConvert10Bit */
+    OP_CPU10_DITHER,
+    OP_CPU10_RGBA,
+    OP_CVTCOLOR_SLICED, /* RGBA -> NV12 in 64-row slices */
+    OP_CVTCOLOR_SLICE,  /* the first of those slices */
+    OP_NV21_COPY,       /* NV21 array -> RGBA via a new buffer */
+    OP_NV21_POOLED,     /* ... via a pooled staging buffer */
+    OP_NV21_PINNED,     /* ... read in place */
+} BenchOp;
+
+typedef struct {
+    const char *name;
+    BenchOp op;
+    bool task;          /* submitted as imbeginJob + task + imendJob */
+    bool allFormats;
+    bool tenBit;        /* sweeps kTenBitFormats instead */
+    bool nv21;          /* NV21 source only */
+} OpInfo;
+
+static const OpInfo kOps[] = {
+    {"imcopy", OP_COPY, false, true, false, false},
+    {"imresize", OP_RESIZE, false, true, false, false},
+    {"imrescale", OP_RESCALE, false, true, false, false},
+    {"imcrop", OP_CROP, false, true, false, false},
+    {"imrotate", OP_ROTATE, false, true, false, false},
+    {"imflip", OP_FLIP, false, true, false, false},
+    {"imtranslate", OP_TRANSLATE, false, true, false, false},
+    {"imcvtcolor", OP_CVTCOLOR, false, true, false, false},
+    {"imblend", OP_BLEND, false, false, false, false},
+    {"imcomposite", OP_COMPOSITE, false, false, false, false},
+    {"imcopyTask", OP_COPY, true, false, false, false},
+    {"imresizeTask", OP_RESIZE, true, false, false, false},
+    {"imrescaleTask", OP_RESCALE, true, false, false, false},
+    {"imcropTask", OP_CROP, true, false, false, false},
+    {"imrotateTask", OP_ROTATE, true, false, false, false},
+    {"imflipTask", OP_FLIP, true, false, false, false},
+    {"imtranslateTask", OP_TRANSLATE, true, false, false, false},
+    {"imcvtcolorTask", OP_CVTCOLOR, true, false, false, false},
+    {"imblendTask", OP_BLEND, true, false, false, false},
+    {"imcompositeTask", OP_COMPOSITE, true, false, false, false},
+    {"imcvtcolor10", OP_CVTCOLOR10, false, false, true, false},
+    {"cpu10", OP_CPU10, false, false, true, false},
+    {"cpu10Dither", OP_CPU10_DITHER, false, false, true, false},
+    {"cpu10Rgba", OP_CPU10_RGBA, false, false, true, false},
+    {"imcvtcolorSliced", OP_CVTCOLOR_SLICED, false, false, false, false},
+    {"imcvtcolorSlice64", OP_CVTCOLOR_SLICE, false, false, false, false},
+    {"imcvtcolorNv21Copy", OP_NV21_COPY, false, false, false, true},
+    {"imcvtcolorNv21Pooled", OP_NV21_POOLED, false, false, false, true},
+    {"imcvtcolorNv21Pinned", OP_NV21_PINNED, false, false, false, true},
+};
+
+struct Image {
+    std::vector<uint8_t> data;
+    rga_buffer_t buf;
+};
+
+typedef struct {
+    std::string name;
+    int64_t iterations;
+    double medianNs;
+    double meanNs;
+    double minNs;
+    double cpuNs;           /* process CPU time per call, includes worker threads */
+    double megapixelsPerSecond;
+    double overheadNs;      /* median of the same op at 16x16 */
+    int status;
+} Result;
+
+static void makeImage(Image &img, int width, int height, int format) {
+    int wstride = (width + 15) & ~15;
+    img.data.assign(rgaFormatImageSize(format, wstride, height), 0);
+    for (size_t i = 0; i < img.data.size(); i++) {
+        img.data[i] = (uint8_t)(i * 7 + (i >> 11));
+    }
+    memset(&img.buf, 0, sizeof(img.buf));
+    img.buf.vir_addr = img.data.data();
+    img.buf.width = width;
+    img.buf.height = height;
+    img.buf.wstride = wstride;
+    img.buf.hstride = height;
+    img.buf.format = format;
+}
+
+static double nowNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* One prepared benchmark case: buffers and the exact submission. */
+class Case {
+public:
+    Case(const OpInfo &info, int width, int height, int format) : mInfo(info) {
+        int dstFormat = format;
+        int dstW = width;
+        int dstH = height;
+        mSrect = {};
+        mDrect = {};
+        mUsage = 0;
+        switch (info.op) {
+        case OP_RESIZE:
+            dstW = width / 2;
+            dstH = height / 2;
+            break;
+        case OP_RESCALE:
+            dstW = width / 2;
+            dstH = height / 2;
+            mSrect = {0, 0, width, height};
+            mDrect = {0, 0, dstW, dstH};
+            break;
+        case OP_CROP:
+            dstW = width / 2;
+            dstH = height / 2;
+            mSrect = {width / 4 & ~1, height / 4 & ~1, dstW, dstH};
+            break;
+        case OP_ROTATE:
+            dstW = height;
+            dstH = width;
+            mUsage = IM_HAL_TRANSFORM_ROT_90;
+            break;
+        case OP_FLIP:
+            mUsage = IM_HAL_TRANSFORM_FLIP_H;
+            break;
+        case OP_TRANSLATE: {
+            int x = width / 8 & ~1;
+            int y = height / 8 & ~1;
+            mSrect = {x, y, width - x, height - y};
+            mDrect = {0, 0, width, height};
+            break;
+        }
+        case OP_CVTCOLOR:
+            dstFormat = format == RK_FORMAT_RGBA_8888 ? RK_FORMAT_YCbCr_420_SP : RK_FORMAT_RGBA_8888;
+            break;
+        case OP_BLEND:
+            mUsage = IM_SYNC | IM_ALPHA_BLEND_SRC_OVER;
+            break;
+        case OP_COMPOSITE:
+            mUsage = IM_ALPHA_BLEND_SRC_OVER;
+            makeImage(mPat, width, height, format);
+            break;
+        case OP_CVTCOLOR10:
+        case OP_CPU10:
+        case OP_CPU10_DITHER:
+            dstFormat = RK_FORMAT_YCbCr_420_SP;
+            break;
+        case OP_CPU10_RGBA:
+            dstFormat = RK_FORMAT_RGBA_8888;
+            break;
+        case OP_CVTCOLOR_SLICED:
+            dstFormat = RK_FORMAT_YCbCr_420_SP;
+            break;
+        case OP_CVTCOLOR_SLICE:
+            dstFormat = RK_FORMAT_YCbCr_420_SP;
+            dstH = std::min(height, BENCH_SLICE_ROWS);
+            mSrect = {0, 0, width, dstH};
+            mDrect = {0, 0, width, dstH};
+            break;
+        case OP_NV21_COPY:
+        case OP_NV21_POOLED:
+        case OP_NV21_PINNED:
+            dstFormat = RK_FORMAT_RGBA_8888;
+            break;
+        default:
+            break;
+        }
+        makeImage(mSrc, width, height, format);
+        makeImage(mDst, dstW, dstH, dstFormat);
+        if (info.op != OP_COMPOSITE) {
+            memset(&mPat.buf, 0, sizeof(mPat.buf));
+        }
+        mPixels = (int64_t)dstW * dstH;
+
+        mOpt = {};
+        mOpt.version = RGA_CURRENT_API_VERSION;
+        mOpt.core = RGA_BENCH_CORE;
+    }
+
+    IM_STATUS run() {
+        if (mInfo.op == OP_CPU10 || mInfo.op == OP_CPU10_DITHER || mInfo.op == OP_CPU10_RGBA) {
+            return rgaCpuConvert10Bit(mSrc.buf, mDst.buf, mInfo.op == OP_CPU10_DITHER);
+        }
+        if (mInfo.op == OP_CVTCOLOR_SLICED) {
+            im_intr_config_t intr = {IM_INTR_WRITE_INTR, 0, BENCH_SLICE_ROWS, BENCH_SLICE_ROWS};
+            return rgaProcessSliced(mInfo.name, mSrc.buf, mDst.buf, mSrect, mDrect, &mOpt, mUsage, intr, &mProgress);
+        }
+        if (mInfo.op == OP_NV21_COPY) {
+            std::vector<uint8_t> copy(mSrc.data.size());
+            memcpy(copy.data(), mSrc.data.data(), copy.size());
+            rga_buffer_t src = mSrc.buf;
+            src.vir_addr = copy.data();
+            return rgaProcess(mInfo.name, src, mDst.buf, {}, {}, {}, {}, -1, NULL, &mOpt, 0);
+        }
+        if (mInfo.op == OP_NV21_POOLED) {
+            rga_buffer_t src;
+            IM_STATUS ret = mStaging.acquire(mSrc.buf.width, mSrc.buf.height, mSrc.buf.format, 0, &src);
+            if (ret != IM_STATUS_SUCCESS) {
+                return ret;
+            }
+            memcpy(src.vir_addr, mSrc.data.data(), mSrc.data.size());
+            ret = rgaProcess(mInfo.name, src, mDst.buf, {}, {}, {}, {}, -1, NULL, &mOpt, 0);
+            mStaging.release(src);
+            return ret;
+        }
+        if (!mInfo.task) {
+            return rgaProcess(mInfo.name, mSrc.buf, mDst.buf, mPat.buf, mSrect, mDrect, {},
+                              -1, NULL, &mOpt, mUsage);
+        }
+        im_job_handle_t job = rgaBeginJob(0);
+        if (job == 0) {
+            return IM_STATUS_FAILED;
+        }
+        IM_STATUS ret = rgaProcessTask(mInfo.name, job, mSrc.buf, mDst.buf, mPat.buf, mSrect, mDrect, {},
+                                       &mOpt, mUsage & ~IM_SYNC);
+        if (ret != IM_STATUS_SUCCESS) {
+            rgaCancelJob(job);
+            return ret;
+        }
+        return rgaEndJob(job, IM_SYNC, 0, NULL);
+    }
+
+    int64_t pixels() const {
+        return mPixels;
+    }
+
+private:
+    const OpInfo &mInfo;
+    Image mSrc;
+    Image mDst;
+    Image mPat;
+    im_rect mSrect;
+    im_rect mDrect;
+    im_opt_t mOpt;
+    int mUsage;
+    int64_t mPixels;
+    RgaSliceProgress mProgress;
+    RgaStagingPool mStaging{1};
+};
+
+static Result measure(Case &bench, const std::string &name, double minTimeSec) {
+    Result result = {};
+    result.name = name;
+    result.status = bench.run();    /* warm-up: page faults, worker pool, driver caches */
+    if (result.status != IM_STATUS_SUCCESS) {
+        return result;
+    }
+
+    std::vector<double> samples;
+    double start = nowNs(CLOCK_MONOTONIC);
+    double cpuStart = nowNs(CLOCK_PROCESS_CPUTIME_ID);
+    double elapsed = 0;
+    while (samples.size() < 3 || elapsed < minTimeSec * 1e9) {
+        double t0 = nowNs(CLOCK_MONOTONIC);
+        IM_STATUS ret = bench.run();
+        double t1 = nowNs(CLOCK_MONOTONIC);
+        if (ret != IM_STATUS_SUCCESS) {
+            result.status = ret;
+            return result;
+        }
+        samples.push_back(t1 - t0);
+        elapsed = t1 - start;
+    }
+    double cpu = nowNs(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples) {
+        sum += s;
+    }
+    size_t n = samples.size();
+    result.iterations = (int64_t)n;
+    result.medianNs = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    result.meanNs = sum / n;
+    result.minNs = samples[0];
+    result.cpuNs = cpu / n;
+    result.megapixelsPerSecond = bench.pixels() * 1e3 / result.medianNs;
+    return result;
+}
+
+static void writeJson(const char *path, const std::vector<Result> &results) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    time_t now = time(NULL);
+    char date[64];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(f, "{\n  \"context\": {\n");
+    fprintf(f, "    \"date\": \"%s\",\n    \"host_name\": \"%s\",\n", date, host);
+    fprintf(f, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+#if defined(RGA_SOFTWARE_BACKEND)
+    fprintf(f, "    \"backend\": \"software\"\n");
+#else
+    fprintf(f, "    \"backend\": \"librga\"\n");
+#endif
+    fprintf(f, "  },\n  \"benchmarks\": [\n");
+    bool first = true;
+    for (const Result &r : results) {
+        if (r.status != IM_STATUS_SUCCESS) {
+            continue;
+        }
+        fprintf(f, "%s    {\n", first ? "" : ",\n");
+        fprintf(f, "      \"name\": \"%s\",\n", r.name.c_str());
+        fprintf(f, "      \"run_type\": \"iteration\",\n");
+        fprintf(f, "      \"iterations\": %lld,\n", (long long)r.iterations);
+        fprintf(f, "      \"real_time\": %.1f,\n", r.medianNs);
+        fprintf(f, "      \"cpu_time\": %.1f,\n", r.cpuNs);
+        fprintf(f, "      \"time_unit\": \"ns\",\n");
+        fprintf(f, "      \"mean_time\": %.1f,\n", r.meanNs);
+        fprintf(f, "      \"min_time\": %.1f,\n", r.minNs);
+        fprintf(f, "      \"overhead_time\": %.1f,\n", r.overheadNs);
+        fprintf(f, "      \"megapixels_per_second\": %.3f\n", r.megapixelsPerSecond);
+        fprintf(f, "    }");
+        first = false;
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+}
+
+/* Pull name -> real_time out of a file written by writeJson (or Google Benchmark). */
+static bool readBaseline(const char *path, std::map<std::string, double> &times) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+    std::string json;
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        json.append(chunk, n);
+    }
+    fclose(f);
+
+    std::regex entry("\"name\"\\s*:\\s*\"([^\"]+)\"[^}]*?\"real_time\"\\s*:\\s*([0-9.eE+-]+)");
+    for (auto it = std::sregex_iterator(json.begin(), json.end(), entry); it != std::sregex_iterator(); ++it) {
+        times[(*it)[1].str()] = atof((*it)[2].str().c_str());
+    }
+    return true;
+}
+
+static int compareBaseline(const std::map<std::string, double> &baseline,
+                           const std::vector<Result> &results, double threshold) {
+    int regressions = 0;
+    printf("\n%-44s %14s %14s %8s\n", "Comparison", "Baseline ns", "Current ns", "Change");
+    for (const Result &r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || r.status != IM_STATUS_SUCCESS || it->second <= 0) {
+            continue;
+        }
+        double change = r.medianNs / it->second - 1.0;
+        bool regressed = change > threshold;
+        regressions += regressed;
+        printf("%-44s %14.0f %14.0f %+7.1f%%%s\n", r.name.c_str(), it->second, r.medianNs,
+               change * 100, regressed ? "  REGRESSION" : "");
+    }
+    printf("%d regression(s) above %.0f%%\n", regressions, threshold * 100);
+    return regressions;
+}
+
+static const char *argValue(const char *arg, const char *flag) {
+    size_t len = strlen(flag);
+    return strncmp(arg, flag, len) == 0 && arg[len] == '=' ? arg + len + 1 : NULL;
+}
+
+int main(int argc, char **argv) {
+    std::string filter = ".*";
+    double minTime = 0.25;
+    const char *outPath = NULL;
+    const char *baselinePath = NULL;
+    double threshold = 0.10;
+    bool listOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *v;
+        if ((v = argValue(argv[i], "--filter")) != NULL) {
+            filter = v;
+        } else if ((v = argValue(argv[i], "--min_time")) != NULL) {
+            minTime = atof(v);
+        } else if ((v = argValue(argv[i], "--out")) != NULL) {
+            outPath = v;
+        } else if ((v = argValue(argv[i], "--baseline")) != NULL) {
+            baselinePath = v;
+        } else if ((v = argValue(argv[i], "--threshold")) != NULL) {
+            threshold = atof(v);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            listOnly = true;
+        } else {
+            fprintf(stderr, "usage: %s [--filter=REGEX] [--min_time=SEC] [--out=FILE.json] "
+                            "[--baseline=FILE.json] [--threshold=FRACTION] [--list]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::map<std::string, double> baseline;
+    if (baselinePath != NULL && !readBaseline(baselinePath, baseline)) {
+        fprintf(stderr, "cannot read baseline %s\n", baselinePath);
+        return 2;
+    }
+
+    std::regex pattern(filter);
+    std::vector<Result> results;
+    printf("%-44s %10s %12s %12s %10s %12s\n", "Benchmark", "Iter", "Median ns", "CPU ns", "MP/s", "Overhead ns");
+
+    for (const OpInfo &op : kOps) {
+        const Format *formats = op.tenBit ? kTenBitFormats : op.nv21 ? &kNv21Format : kFormats;
+        size_t formatCount = op.tenBit ? sizeof(kTenBitFormats) / sizeof(kTenBitFormats[0])
+                                       : op.allFormats ? sizeof(kFormats) / sizeof(kFormats[0]) : 1;
+        for (size_t f = 0; f < formatCount; f++) {
+            const Format &format = formats[f];
+            if (op.op == OP_CVTCOLOR10 && format.format == RGA_FORMAT_P010) {
+                continue;   /* no RGA core reads P010 */
+            }
+            double overheadNs = 0;
+            for (int r = -1; r < (int)(sizeof(kResolutions) / sizeof(kResolutions[0])); r++) {
+                const Resolution &res = r < 0 ? kOverhead : kResolutions[r];
+                std::string name = std::string(op.name) + "/" + format.name + "/" + res.name;
+                if (!std::regex_search(name, pattern)) {
+                    continue;
+                }
+                if (listOnly) {
+                    printf("%s\n", name.c_str());
+                    continue;
+                }
+                Case bench(op, res.width, res.height, format.format);
+                Result result = measure(bench, name, minTime);
+                if (r < 0) {
+                    overheadNs = result.medianNs;
+                }
+                result.overheadNs = overheadNs;
+                if (result.status != IM_STATUS_SUCCESS) {
+                    printf("%-44s failed: %d\n", name.c_str(), result.status);
+                } else {
+                    printf("%-44s %10lld %12.0f %12.0f %10.1f %12.0f\n", name.c_str(),
+                           (long long)result.iterations, result.medianNs, result.cpuNs,
+                           result.megapixelsPerSecond, result.overheadNs);
+                }
+                fflush(stdout);
+                results.push_back(result);
+            }
+        }
+    }
+
+    if (outPath != NULL) {
+        writeJson(outPath, results);
+    }
+    if (baselinePath != NULL && compareBaseline(baseline, results, threshold) > 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -1,15 +1,39 @@
 #include <jni.h>
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <unistd.h>
 #include <android/log.h>
 #include <android/bitmap.h>
 #include <android/hardware_buffer.h>
 #include <android/hardware_buffer_jni.h>
 #include "im2d.h"
 #include "RgaUtils.h"
+#include "rga_cpu.h"
+#include "rga_stats.h"
+#include "rga_atlas.h"
+#include "rga_backend.h"
+#include "rga_compositor.h"
+#include "rga_crossover.h"
+#include "rga_damage.h"
+#include "rga_format.h"
+#include "rga_frame_file.h"
+#include "rga_graph.h"
+#include "rga_osd_text.h"
+#include "rga_pipeline.h"
+#include "rga_scheduler.h"
+#include "rga_slice.h"
+#include "rga_staging.h"
+#include "rga_stripe.h"
+#include "rga_trace.h"
 
 #define TAG "LibrgaJni"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 
+// All JNI operations are scheduled onto the RGA3 cores (see README).
+#define RGA_JNI_SCHEDULER_CORE (IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1)
+
 
 // Define native_handle_t as it is not strictly in NDK headers but needed to extract FD
 typedef struct native_handle {
@@ -34,16 +58,19 @@ rga_buffer_t getRgaBuffer(JNIEnv *env, jobject jRgaBuffer) {
     jfieldID wstrideId = env->GetFieldID(clazz, "wstride", "I");
     jfieldID hstrideId = env->GetFieldID(clazz, "hstride", "I");
     jfieldID fdId = env->GetFieldID(clazz, "fd", "I");
+    jfieldID rdModeId = env->GetFieldID(clazz, "rdMode", "I");
     // handle is ignored in this simple wrapper for now, usually requires more complex mapping
     jfieldID ptrId = env->GetFieldID(clazz, "ptr", "Ljava/nio/ByteBuffer;");
     jfieldID hbId = env->GetFieldID(clazz, "hardwareBuffer", "Ljava/lang/Object;");
 
     int width = env->GetIntField(jRgaBuffer, widthId);
     int height = env->GetIntField(jRgaBuffer, heightId);
-    int format = env->GetIntField(jRgaBuffer, formatId);
+    // Older Rga.kt builds declared RK_FORMAT_* without the "<< 8".
+    int format = rgaFormatNormalize(env->GetIntField(jRgaBuffer, formatId));
     int wstride = env->GetIntField(jRgaBuffer, wstrideId);
     int hstride = env->GetIntField(jRgaBuffer, hstrideId);
     int fd = env->GetIntField(jRgaBuffer, fdId);
+    int rdMode = env->GetIntField(jRgaBuffer, rdModeId);
     jobject ptrObj = env->GetObjectField(jRgaBuffer, ptrId);
     jobject hbObj = env->GetObjectField(jRgaBuffer, hbId);
 
@@ -75,6 +102,7 @@ rga_buffer_t getRgaBuffer(JNIEnv *env, jobject jRgaBuffer) {
     } else {
         LOGE("RgaBuffer has neither valid fd, HardwareBuffer nor valid ByteBuffer");
     }
+    buffer.rd_mode = rdMode;
     return buffer;
 }
 
@@ -94,63 +122,149 @@ im_rect getRgaRect(JNIEnv *env, jobject jRgaRect) {
     return rect;
 }
 
+// Helper to convert Kotlin Array<RgaRect> to im_rect list
+void getRgaRectArray(JNIEnv *env, jobjectArray jRects, std::vector<im_rect> &rects) {
+    jsize count = env->GetArrayLength(jRects);
+    rects.resize(count);
+    if (count == 0) {
+        return;
+    }
+    // Every element is an RgaRect, so the field IDs are looked up once.
+    jclass clazz = env->FindClass("com/rockchip/librga/Rga$RgaRect");
+    jfieldID xId = env->GetFieldID(clazz, "x", "I");
+    jfieldID yId = env->GetFieldID(clazz, "y", "I");
+    jfieldID wId = env->GetFieldID(clazz, "width", "I");
+    jfieldID hId = env->GetFieldID(clazz, "height", "I");
+    for (jsize i = 0; i < count; i++) {
+        jobject jRect = env->GetObjectArrayElement(jRects, i);
+        rects[i].x = env->GetIntField(jRect, xId);
+        rects[i].y = env->GetIntField(jRect, yId);
+        rects[i].width = env->GetIntField(jRect, wId);
+        rects[i].height = env->GetIntField(jRect, hId);
+        env->DeleteLocalRef(jRect);
+    }
+    env->DeleteLocalRef(clazz);
+}
+
+// Helper to convert Kotlin RgaNn to im_nn_t
+im_nn_t getRgaNn(JNIEnv *env, jobject jRgaNn) {
+    jclass clazz = env->GetObjectClass(jRgaNn);
+    im_nn_t nn;
+    nn.scale_r = env->GetIntField(jRgaNn, env->GetFieldID(clazz, "scaleR", "I"));
+    nn.scale_g = env->GetIntField(jRgaNn, env->GetFieldID(clazz, "scaleG", "I"));
+    nn.scale_b = env->GetIntField(jRgaNn, env->GetFieldID(clazz, "scaleB", "I"));
+    nn.offset_r = env->GetIntField(jRgaNn, env->GetFieldID(clazz, "offsetR", "I"));
+    nn.offset_g = env->GetIntField(jRgaNn, env->GetFieldID(clazz, "offsetG", "I"));
+    nn.offset_b = env->GetIntField(jRgaNn, env->GetFieldID(clazz, "offsetB", "I"));
+    return nn;
+}
+
+// Fill, rectangle, mosaic, ROP, palette, OSD and Gaussian blur only exist on the RGA2 cores.
+// With the scheduler restricted to RGA3 they run on the CPU instead.
+static inline bool useCpuForRga2Ops() {
+    return (RGA_JNI_SCHEDULER_CORE & (IM_SCHEDULER_RGA2_CORE0 | IM_SCHEDULER_RGA2_CORE1)) == 0;
+}
+
+static std::atomic<bool> gTenBitDither(false);
+
+// Copies of Java byte arrays (unpinned calls and job tasks); a few frame
+// sizes stay allocated between frames.
+#define RGA_JNI_STAGING_FREE 4
+static RgaStagingPool gStagingPool(RGA_JNI_STAGING_FREE);
+
+// The tightly packed width x height image a Java byte array holds, not yet
+// pointing at its pixels; false if the array is too short for it.
+static bool getArrayImage(JNIEnv *env, jbyteArray array, int width, int height, int format, rga_buffer_t *buffer) {
+    memset(buffer, 0, sizeof(rga_buffer_t));
+    format = rgaFormatNormalize(format);
+    if (array == NULL || width <= 0 || height <= 0 || rgaFormatFind(format) == nullptr ||
+        (size_t)env->GetArrayLength(array) < rgaFormatImageSize(format, width, height)) {
+        return false;
+    }
+    buffer->width = width;
+    buffer->height = height;
+    buffer->wstride = width;
+    buffer->hstride = height;
+    buffer->format = format;
+    return true;
+}
+
+// 10-bit sources go to the RGA first; P010/P210, which no core reads, and
+// cores that reject the packed 10-bit formats fall back to the CPU kernels.
+static IM_STATUS convertTenBit(const rga_buffer_t &src, const rga_buffer_t &dst, im_opt_t *opt) {
+    if (rgaFormatFind(src.format)->tenBit) {
+        IM_STATUS ret = rgaProcess("imcvtcolor", src, dst, {}, {}, {}, {}, -1, NULL, opt, 0);
+        if (ret == IM_STATUS_SUCCESS) {
+            return ret;
+        }
+    }
+    return rgaCpuConvert10Bit(src, dst, gTenBitDither);
+}
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imcopy(JNIEnv *env, jobject thiz, jobject src, jobject dst) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_COPY, srcBuf, dstBuf);
     im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
-    return improcess(srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, 0);
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcess("imcopy", srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imresize(JNIEnv *env, jobject thiz, jobject src, jobject dst, jdouble fx, jdouble fy) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_RESIZE, srcBuf, dstBuf);
     im_opt_t opt;
     memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
-    return improcess(srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, 0);
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcess("imresize", srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imrescale(JNIEnv *env, jobject thiz, jobject src, jobject dst, jdouble fx, jdouble fy) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_RESIZE, srcBuf, dstBuf);
     im_opt_t opt;
     memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
 
     im_rect srect = {0, 0, srcBuf.width, srcBuf.height};
     im_rect drect = {0, 0, (int)(srcBuf.width * fx), (int)(srcBuf.height * fy)};
 
-    return improcess(srcBuf, dstBuf, {}, srect, drect, {}, -1, NULL, &opt, 0);
+    return stats.finish(rgaProcess("imrescale", srcBuf, dstBuf, {}, srect, drect, {}, -1, NULL, &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imcrop(JNIEnv *env, jobject thiz, jobject src, jobject dst, jobject rect) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_CROP, srcBuf, dstBuf);
     im_rect imRect = getRgaRect(env, rect);
     im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
-    return improcess(srcBuf, dstBuf, {}, imRect, {}, {}, -1, NULL, &opt, 0);
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcess("imcrop", srcBuf, dstBuf, {}, imRect, {}, {}, -1, NULL, &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imrotate(JNIEnv *env, jobject thiz, jobject src, jobject dst, jint rotation) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_ROTATE, srcBuf, dstBuf);
 
     im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
-    return improcess(srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, rotation);
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcess("imrotate", srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, rotation));
 
 }
 
@@ -158,25 +272,28 @@ JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imflip(JNIEnv *env, jobject thiz, jobject src, jobject dst, jint mode) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_FLIP, srcBuf, dstBuf);
     im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
-    return improcess(srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, mode);
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcess("imflip", srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, mode));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imtranslate(JNIEnv *env, jobject thiz, jobject src, jobject dst, jint x, jint y) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_TRANSLATE, srcBuf, dstBuf);
     if (x < 0 || y < 0 || x >= srcBuf.width || y >= srcBuf.height) {
         LOGE("Invalid translation parameters: x=%d, y=%d", x, y);
-        return -1;
+        return stats.finish(-1);
     }
     // 完整初始化 im_opt_t 结构体
     im_opt_t opt;
     memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
     im_rect srect;
     srect.x = x;
     srect.y = y;
@@ -185,18 +302,19 @@ Java_com_rockchip_librga_Rga_imtranslate(JNIEnv *env, jobject thiz, jobject src,
     srect.height = (y + srcBuf.height > srcBuf.hstride) ?
                    (srcBuf.hstride - y) : srcBuf.height;
     im_rect drect = {0, 0, dstBuf.width, dstBuf.height};
-    return improcess(srcBuf, dstBuf, {}, srect, drect, {}, -1, NULL, &opt, 0);
+    return stats.finish(rgaProcess("imtranslate", srcBuf, dstBuf, {}, srect, drect, {}, -1, NULL, &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imblend(JNIEnv *env, jobject thiz, jobject src, jobject dst, jint mode) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_BLEND, srcBuf, dstBuf);
     im_opt_t opt;
     memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
-    return improcess(srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt,IM_SYNC | mode);
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcess("imblend", srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt,IM_SYNC | mode));
 }
 
 JNIEXPORT jint JNICALL
@@ -204,104 +322,193 @@ Java_com_rockchip_librga_Rga_imcomposite(JNIEnv *env, jobject thiz, jobject srcA
     rga_buffer_t srcABuf = getRgaBuffer(env, srcA);
     rga_buffer_t srcBBuf = getRgaBuffer(env, srcB);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_COMPOSITE, srcABuf, dstBuf);
     im_opt_t opt;
     memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
-    return improcess(srcABuf, dstBuf, srcBBuf, {}, {}, {}, -1, NULL, &opt, mode);
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcess("imcomposite", srcABuf, dstBuf, srcBBuf, {}, {}, {}, -1, NULL, &opt, mode));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imcvtcolor(JNIEnv *env, jobject thiz, jobject src, jobject dst, jint sfmt, jint dfmt) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_CVTCOLOR, srcBuf, dstBuf);
     im_opt_t opt;
     memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
-    return improcess(srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, 0);
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    if (rgaCpuIsTenBit(srcBuf.format)) {
+        return stats.finish(convertTenBit(srcBuf, dstBuf, &opt));
+    }
+    return stats.finish(rgaProcess("imcvtcolor", srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, 0));
 }
 
 JNIEXPORT jlong JNICALL
 Java_com_rockchip_librga_Rga_imbeginJob(JNIEnv *env, jobject thiz, jlong flags) {
     // 设置当前线程默认调度到 RGA3 核心，这将影响该线程后续创建的任务
-    imconfig(IM_CONFIG_SCHEDULER_CORE, IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1);
-    return (jlong)imbeginJob((uint64_t)flags);
+    imconfig(IM_CONFIG_SCHEDULER_CORE, RGA_JNI_SCHEDULER_CORE);
+    return (jlong)rgaBeginJob((uint64_t)flags);
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imendJob(JNIEnv *env, jobject thiz, jlong jobHandle, jint syncMode) {
-    return imendJob((im_job_handle_t)jobHandle, (int)syncMode);
+    RgaStatsScope stats(RGA_STATS_JOB);
+    // Staged array copies may only go back to the pool once the job is done.
+    bool staged = gStagingPool.holds((im_job_handle_t)jobHandle);
+    if (staged) {
+        syncMode = IM_SYNC;
+    }
+    // Async jobs only report completion through their release fence, which is
+    // requested just for the completion histogram.
+    int fence = -1;
+    bool watch = syncMode == IM_ASYNC && rgaStatsEnabled();
+    uint64_t submitNs = watch ? rgaStatsNowNs() : 0;
+    IM_STATUS ret = rgaEndJob((im_job_handle_t)jobHandle, (int)syncMode, 0, watch ? &fence : NULL);
+    if (watch && ret == IM_STATUS_SUCCESS) {
+        rgaStatsWatchFence(RGA_STATS_JOB, fence, submitNs);
+    } else if (fence >= 0) {
+        close(fence);
+    }
+    gStagingPool.releaseJob((im_job_handle_t)jobHandle);
+    return stats.finish(ret);
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imcancelJob(JNIEnv *env, jobject thiz, jlong jobHandle) {
-    return imcancelJob((im_job_handle_t)jobHandle);
+    IM_STATUS ret = rgaCancelJob((im_job_handle_t)jobHandle);
+    gStagingPool.releaseJob((im_job_handle_t)jobHandle);
+    return ret;
 }
 
+// The *Task calls build the same task the vendor im*Task helpers would and add it
+// through rgaProcessTask, so they are traced and counted like the other submissions.
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imcopyTask(JNIEnv *env, jobject thiz, jlong jobHandle, jobject src, jobject dst) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
-    return imcopyTask((im_job_handle_t)jobHandle, srcBuf, dstBuf);
+    RgaStatsScope stats(RGA_STATS_COPY, srcBuf, dstBuf);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcessTask("imcopyTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, {}, {}, {},
+                                       &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imresizeTask(JNIEnv *env, jobject thiz, jlong jobHandle, jobject src, jobject dst, jdouble fx, jdouble fy) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
-    return imresizeTask((im_job_handle_t)jobHandle, srcBuf, dstBuf, fx, fy);
+    RgaStatsScope stats(RGA_STATS_RESIZE, srcBuf, dstBuf);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+
+    // Like imresizeTask: scale factors shrink dst to src * f (even for YUV), else dst is filled.
+    im_rect drect = {};
+    if (fx > 0 || fy > 0) {
+        drect.width = (int)(srcBuf.width * (fx > 0 ? fx : 1));
+        drect.height = (int)(srcBuf.height * (fy > 0 ? fy : 1));
+        const RgaFormatDesc *desc = rgaFormatFind(dstBuf.format);
+        if (desc != nullptr && desc->yuv) {
+            drect.width &= ~1;
+            drect.height &= ~1;
+        }
+    }
+    return stats.finish(rgaProcessTask("imresizeTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, {}, drect, {},
+                                       &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imrescaleTask(JNIEnv *env, jobject thiz, jlong jobHandle, jobject src, jobject dst, jdouble fx, jdouble fy) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_RESIZE, srcBuf, dstBuf);
     im_rect srect = {0, 0, srcBuf.width, srcBuf.height};
     im_rect drect = {0, 0, (int)(srcBuf.width * fx), (int)(srcBuf.height * fy)};
-
     im_opt_t opt;
     memset(&opt, 0, sizeof(im_opt_t));
     opt.version = RGA_CURRENT_API_VERSION;
-    opt.core = IM_SCHEDULER_RGA3_CORE0 | IM_SCHEDULER_RGA3_CORE1;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
 
-    return improcessTask((im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, srect, drect, {}, &opt, 0);
+    return stats.finish(rgaProcessTask("imrescaleTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, srect, drect,
+                                       {}, &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imcropTask(JNIEnv *env, jobject thiz, jlong jobHandle, jobject src, jobject dst, jobject rect) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_CROP, srcBuf, dstBuf);
     im_rect imRect = getRgaRect(env, rect);
-    return imcropTask((im_job_handle_t)jobHandle, srcBuf, dstBuf, imRect);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcessTask("imcropTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, imRect, {}, {},
+                                       &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imrotateTask(JNIEnv *env, jobject thiz, jlong jobHandle, jobject src, jobject dst, jint rotation) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
-    return imrotateTask((im_job_handle_t)jobHandle, srcBuf, dstBuf, rotation);
+    RgaStatsScope stats(RGA_STATS_ROTATE, srcBuf, dstBuf);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcessTask("imrotateTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, {}, {}, {},
+                                       &opt, rotation));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imflipTask(JNIEnv *env, jobject thiz, jlong jobHandle, jobject src, jobject dst, jint mode) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
-    return imflipTask((im_job_handle_t)jobHandle, srcBuf, dstBuf, mode);
+    RgaStatsScope stats(RGA_STATS_FLIP, srcBuf, dstBuf);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcessTask("imflipTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, {}, {}, {},
+                                       &opt, mode));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imtranslateTask(JNIEnv *env, jobject thiz, jlong jobHandle, jobject src, jobject dst, jint x, jint y) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
-    return imtranslateTask((im_job_handle_t)jobHandle, srcBuf, dstBuf, x, y);
+    RgaStatsScope stats(RGA_STATS_TRANSLATE, srcBuf, dstBuf);
+    if (x < 0 || y < 0 || x >= srcBuf.width || y >= srcBuf.height) {
+        LOGE("Invalid translation parameters: x=%d, y=%d", x, y);
+        return stats.finish(IM_STATUS_INVALID_PARAM);
+    }
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    // Like imtranslateTask: the top-left of src moves to (x, y) of dst.
+    im_rect srect = {0, 0, srcBuf.width - x, srcBuf.height - y};
+    im_rect drect = {x, y, srcBuf.width - x, srcBuf.height - y};
+    return stats.finish(rgaProcessTask("imtranslateTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, srect,
+                                       drect, {}, &opt, 0));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imblendTask(JNIEnv *env, jobject thiz, jlong jobHandle, jobject src, jobject dst, jint mode) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
-    return imblendTask((im_job_handle_t)jobHandle, srcBuf, dstBuf, mode);
+    RgaStatsScope stats(RGA_STATS_BLEND, srcBuf, dstBuf);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcessTask("imblendTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, {}, {}, {},
+                                       &opt, mode));
 }
 
 JNIEXPORT jint JNICALL
@@ -309,14 +516,1423 @@ Java_com_rockchip_librga_Rga_imcompositeTask(JNIEnv *env, jobject thiz, jlong jo
     rga_buffer_t srcABuf = getRgaBuffer(env, srcA);
     rga_buffer_t srcBBuf = getRgaBuffer(env, srcB);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
-    return imcompositeTask((im_job_handle_t)jobHandle, srcABuf, srcBBuf, dstBuf, mode);
+    RgaStatsScope stats(RGA_STATS_COMPOSITE, srcABuf, dstBuf);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcessTask("imcompositeTask", (im_job_handle_t)jobHandle, srcABuf, dstBuf, srcBBuf, {},
+                                       {}, {}, &opt, mode));
 }
 
 JNIEXPORT jint JNICALL
 Java_com_rockchip_librga_Rga_imcvtcolorTask(JNIEnv *env, jobject thiz, jlong jobHandle, jobject src, jobject dst, jint sfmt, jint dfmt) {
     rga_buffer_t srcBuf = getRgaBuffer(env, src);
     rga_buffer_t dstBuf = getRgaBuffer(env, dst);
-    return imcvtcolorTask((im_job_handle_t)jobHandle, srcBuf, dstBuf, sfmt, dfmt);
+    srcBuf.format = rgaFormatNormalize(sfmt);
+    dstBuf.format = rgaFormatNormalize(dfmt);
+    RgaStatsScope stats(RGA_STATS_CVTCOLOR, srcBuf, dstBuf);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaProcessTask("imcvtcolorTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, {}, {}, {},
+                                       &opt, 0));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_improcessArrayNative(JNIEnv *env, jobject thiz, jbyteArray src, jint width,
+                                                  jint height, jint format, jobject dst, jobject srcRect,
+                                                  jobject dstRect, jint usage, jboolean pin) {
+    rga_buffer_t srcBuf;
+    if (!getArrayImage(env, src, width, height, format, &srcBuf)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    im_rect srect = srcRect != NULL ? getRgaRect(env, srcRect) : im_rect{0, 0, width, height};
+    im_rect drect = dstRect != NULL ? getRgaRect(env, dstRect) : im_rect{0, 0, dstBuf.width, dstBuf.height};
+    RgaStatsScope stats(dstBuf.format != srcBuf.format ? RGA_STATS_CVTCOLOR : RGA_STATS_RESIZE, srcBuf, dstBuf);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    // The array is only valid for this call, so the call is always synchronous.
+    usage &= ~IM_ASYNC;
+
+    IM_STATUS ret;
+    if (pin) {
+        // No JNI calls until the array is released; the GC waits for us.
+        srcBuf.vir_addr = env->GetPrimitiveArrayCritical(src, NULL);
+        if (srcBuf.vir_addr == NULL) {
+            return stats.finish(IM_STATUS_OUT_OF_MEMORY);
+        }
+        ret = rgaProcess("improcessArray", srcBuf, dstBuf, {}, srect, drect, {}, -1, NULL, &opt, usage);
+        env->ReleasePrimitiveArrayCritical(src, srcBuf.vir_addr, JNI_ABORT);
+        return stats.finish(ret);
+    }
+    ret = gStagingPool.acquire(width, height, srcBuf.format, 0, &srcBuf);
+    if (ret != IM_STATUS_SUCCESS) {
+        return stats.finish(ret);
+    }
+    env->GetByteArrayRegion(src, 0, (jsize)rgaFormatImageSize(srcBuf.format, width, height),
+                            (jbyte *)srcBuf.vir_addr);
+    ret = rgaProcess("improcessArray", srcBuf, dstBuf, {}, srect, drect, {}, -1, NULL, &opt, usage);
+    gStagingPool.release(srcBuf);
+    return stats.finish(ret);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_improcessArrayTaskNative(JNIEnv *env, jobject thiz, jlong jobHandle, jbyteArray src,
+                                                      jint width, jint height, jint format, jobject dst,
+                                                      jobject srcRect, jobject dstRect, jint usage) {
+    rga_buffer_t srcBuf;
+    if (!getArrayImage(env, src, width, height, format, &srcBuf)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    im_rect srect = srcRect != NULL ? getRgaRect(env, srcRect) : im_rect{0, 0, width, height};
+    im_rect drect = dstRect != NULL ? getRgaRect(env, dstRect) : im_rect{0, 0, dstBuf.width, dstBuf.height};
+    // The job runs after this returns, so it reads a staged copy held until imendJob/imcancelJob.
+    IM_STATUS ret = gStagingPool.acquire(width, height, srcBuf.format, (im_job_handle_t)jobHandle, &srcBuf);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    env->GetByteArrayRegion(src, 0, (jsize)rgaFormatImageSize(srcBuf.format, width, height),
+                            (jbyte *)srcBuf.vir_addr);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return rgaProcessTask("improcessArrayTask", (im_job_handle_t)jobHandle, srcBuf, dstBuf, {}, srect, drect, {},
+                          &opt, usage);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_imfill(JNIEnv *env, jobject thiz, jobject dst, jobject rect, jint color) {
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_FILL, dstBuf);
+    im_rect imRect = getRgaRect(env, rect);
+    if (!useCpuForRga2Ops()) {
+        return stats.finish(imfill(dstBuf, imRect, color));
+    }
+    IM_STATUS ret = rgaCpuFill(dstBuf, &imRect, 1, (uint32_t)color);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU fill failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_imfillArray(JNIEnv *env, jobject thiz, jobject dst, jobjectArray rects, jint color) {
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_FILL, dstBuf);
+    std::vector<im_rect> imRects;
+    getRgaRectArray(env, rects, imRects);
+    if (!useCpuForRga2Ops()) {
+        return stats.finish(imfillArray(dstBuf, imRects.data(), (int)imRects.size(), (uint32_t)color));
+    }
+    IM_STATUS ret = rgaCpuFill(dstBuf, imRects.data(), (int)imRects.size(), (uint32_t)color);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU fill array failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_imrectangle(JNIEnv *env, jobject thiz, jobject dst, jobject rect, jint color, jint thickness) {
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_RECTANGLE, dstBuf);
+    im_rect imRect = getRgaRect(env, rect);
+    if (!useCpuForRga2Ops()) {
+        return stats.finish(imrectangle(dstBuf, imRect, (uint32_t)color, thickness));
+    }
+    IM_STATUS ret = rgaCpuRectangle(dstBuf, &imRect, 1, (uint32_t)color, thickness);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU rectangle failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_imrectangleArray(JNIEnv *env, jobject thiz, jobject dst, jobjectArray rects, jint color, jint thickness) {
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_RECTANGLE, dstBuf);
+    std::vector<im_rect> imRects;
+    getRgaRectArray(env, rects, imRects);
+    if (!useCpuForRga2Ops()) {
+        return stats.finish(imrectangleArray(dstBuf, imRects.data(), (int)imRects.size(), (uint32_t)color, thickness));
+    }
+    IM_STATUS ret = rgaCpuRectangle(dstBuf, imRects.data(), (int)imRects.size(), (uint32_t)color, thickness);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU rectangle array failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_immosaic(JNIEnv *env, jobject thiz, jobject image, jobject rect, jint mode) {
+    rga_buffer_t imageBuf = getRgaBuffer(env, image);
+    RgaStatsScope stats(RGA_STATS_MOSAIC, imageBuf);
+    im_rect imRect = getRgaRect(env, rect);
+    if (!useCpuForRga2Ops()) {
+        return stats.finish(immosaic(imageBuf, imRect, mode));
+    }
+    IM_STATUS ret = rgaCpuMosaic(imageBuf, &imRect, 1, mode);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU mosaic failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_immosaicArray(JNIEnv *env, jobject thiz, jobject image, jobjectArray rects, jint mode) {
+    rga_buffer_t imageBuf = getRgaBuffer(env, image);
+    RgaStatsScope stats(RGA_STATS_MOSAIC, imageBuf);
+    std::vector<im_rect> imRects;
+    getRgaRectArray(env, rects, imRects);
+    if (!useCpuForRga2Ops()) {
+        return stats.finish(immosaicArray(imageBuf, imRects.data(), (int)imRects.size(), mode));
+    }
+    IM_STATUS ret = rgaCpuMosaic(imageBuf, imRects.data(), (int)imRects.size(), mode);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU mosaic array failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_imrop(JNIEnv *env, jobject thiz, jobject src, jobject dst, jint ropCode) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_ROP, srcBuf, dstBuf);
+    if (!useCpuForRga2Ops()) {
+        return stats.finish(imrop(srcBuf, dstBuf, ropCode));
+    }
+    IM_STATUS ret = rgaCpuRop(srcBuf, dstBuf, ropCode);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU rop failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_impalette(JNIEnv *env, jobject thiz, jobject src, jobject dst, jobject lut) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    rga_buffer_t lutBuf = getRgaBuffer(env, lut);
+    RgaStatsScope stats(RGA_STATS_PALETTE, srcBuf, dstBuf);
+    if (!useCpuForRga2Ops()) {
+        return stats.finish(impalette(srcBuf, dstBuf, lutBuf));
+    }
+    IM_STATUS ret = rgaCpuPalette(srcBuf, dstBuf, lutBuf);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU palette failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+// Rga.kt packs RgaOsdConfig into RGA_JNI_OSD_PARAMS ints: mode, block (widthMode,
+// width, count, background, direction, colorMode, normalColor, invertColor),
+// invert (channel, flagsMode, flagsIndex, mode, threshold, alphaMax, alphaMin,
+// ygMax, ygMin, crbMax, crbMin) and bpp2 (acSwap, endianSwap, color0, color1).
+#define RGA_JNI_OSD_PARAMS 24
+
+static bool getOsdConfig(JNIEnv *env, jintArray params, jlong invertFlags, im_osd_t *config) {
+    if (env->GetArrayLength(params) < RGA_JNI_OSD_PARAMS) {
+        return false;
+    }
+    jint p[RGA_JNI_OSD_PARAMS];
+    env->GetIntArrayRegion(params, 0, RGA_JNI_OSD_PARAMS, p);
+    memset(config, 0, sizeof(im_osd_t));
+    config->osd_mode = p[0];
+    im_osd_block_t &block = config->block_parm;
+    block.width_mode = p[1];
+    block.width = p[2];
+    block.block_count = p[3];
+    block.background_config = p[4];
+    block.direction = p[5];
+    block.color_mode = p[6];
+    block.normal_color.value = (uint32_t)p[7];
+    block.invert_color.value = (uint32_t)p[8];
+    im_osd_invert_t &invert = config->invert_config;
+    invert.invert_channel = p[9];
+    invert.flags_mode = p[10];
+    invert.flags_index = p[11];
+    invert.invert_flags = (uint64_t)invertFlags;
+    invert.invert_mode = p[12];
+    invert.threash = p[13];
+    invert.factor = {(uint8_t)p[14], (uint8_t)p[15], (uint8_t)p[16], (uint8_t)p[17], (uint8_t)p[18], (uint8_t)p[19]};
+    config->bpp2_info.ac_swap = (uint8_t)p[20];
+    config->bpp2_info.endian_swap = (uint8_t)p[21];
+    config->bpp2_info.color0.value = (uint32_t)p[22];
+    config->bpp2_info.color1.value = (uint32_t)p[23];
+    return true;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_imosdNative(JNIEnv *env, jobject thiz, jobject osd, jobject dst, jobject rect,
+                                         jintArray params, jlong invertFlags, jboolean cpu) {
+    rga_buffer_t osdBuf = getRgaBuffer(env, osd);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_OSD, osdBuf, dstBuf);
+    im_rect imRect = getRgaRect(env, rect);
+    im_osd_t config;
+    if (!getOsdConfig(env, params, invertFlags, &config)) {
+        return stats.finish(IM_STATUS_INVALID_PARAM);
+    }
+    if (!cpu && !useCpuForRga2Ops()) {
+        return stats.finish(imosd(osdBuf, dstBuf, imRect, &config));
+    }
+    IM_STATUS ret = rgaCpuOsd(osdBuf, dstBuf, imRect, &config);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU osd failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_osdStatisticsNative(JNIEnv *env, jobject thiz, jobject dst, jobject rect,
+                                                 jintArray params, jintArray luma, jlongArray flags) {
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    im_rect imRect = getRgaRect(env, rect);
+    im_osd_t config;
+    if (!getOsdConfig(env, params, 0, &config) || luma == nullptr || flags == nullptr ||
+        env->GetArrayLength(flags) < 1) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    RgaCpuOsdStatistics result;
+    IM_STATUS ret = rgaCpuOsdStatistics(dstBuf, imRect, config, &result);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    jint values[RGA_CPU_OSD_MAX_BLOCKS];
+    int count = std::min(result.blocks, (int)env->GetArrayLength(luma));
+    for (int i = 0; i < count; i++) {
+        values[i] = result.luma[i];
+    }
+    env->SetIntArrayRegion(luma, 0, count, values);
+    jlong bits = (jlong)result.flags;
+    env->SetLongArrayRegion(flags, 0, 1, &bits);
+    return ret;
+}
+
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_imgaussianBlur(JNIEnv *env, jobject thiz, jobject src, jobject dst,
+                                            jint ksizeWidth, jint ksizeHeight,
+                                            jdouble sigmaX, jdouble sigmaY,
+                                            jdoubleArray matrix, jint borderType) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_GAUSSIAN, srcBuf, dstBuf);
+
+    if (ksizeWidth <= 0 || ksizeHeight <= 0 || ksizeWidth > 255 || ksizeHeight > 255) {
+        return stats.finish(IM_STATUS_INVALID_PARAM);
+    }
+
+    // The kernel is always handed over as a matrix so fractional sigmas survive
+    // (imsetOptGaussianBlur only takes integer sigmas).
+    std::vector<double> kernel(ksizeWidth * ksizeHeight);
+    im_gauss_t gauss;
+    memset(&gauss, 0, sizeof(gauss));
+    gauss.ksize.width = ksizeWidth;
+    gauss.ksize.height = ksizeHeight;
+    gauss.sigma_x = sigmaX;
+    gauss.sigma_y = sigmaY;
+    if (matrix != NULL) {
+        if (env->GetArrayLength(matrix) != ksizeWidth * ksizeHeight) {
+            LOGE("Gaussian matrix must have %d elements", ksizeWidth * ksizeHeight);
+            return stats.finish(IM_STATUS_INVALID_PARAM);
+        }
+        env->GetDoubleArrayRegion(matrix, 0, ksizeWidth * ksizeHeight, kernel.data());
+        gauss.matrix = kernel.data();
+    } else {
+        rgaCpuGaussianKernel(gauss, kernel.data());
+    }
+
+    // The hardware only reflects at the border; other modes, and RGA3-only
+    // scheduling, go straight to the CPU.
+    if (borderType == IM_BORDER_REFLECT && !useCpuForRga2Ops()) {
+        im_opt_t opt;
+        memset(&opt, 0, sizeof(opt));
+        opt.version = RGA_CURRENT_API_VERSION;
+        opt.core = RGA_JNI_SCHEDULER_CORE;
+        imsetOptGaussianBlurMatrix(&opt, ksizeWidth, ksizeHeight, kernel.data());
+        IM_STATUS ret = rgaProcess("imgaussianBlur", srcBuf, dstBuf, {}, {}, {}, {}, -1, NULL, &opt, IM_GAUSS);
+        if (ret == IM_STATUS_SUCCESS) {
+            return stats.finish(ret);
+        }
+    }
+
+    IM_STATUS ret = rgaCpuGaussianBlur(srcBuf, dstBuf, gauss, borderType);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU gaussian blur failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+
+// One RGA pass doing crop, scale, format conversion and quantization into drect of dst.
+// Cores that cannot quantize while converting get the quantization as a second, in-place pass.
+static IM_STATUS tensorHardwarePass(rga_buffer_t src, rga_buffer_t dst, im_rect srect, im_rect drect,
+                                    const im_nn_t *nn) {
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+
+    if (nn == NULL) {
+        return rgaProcess("tensorHardwarePass", src, dst, {}, srect, drect, {}, -1, NULL, &opt, 0);
+    }
+    rga_buffer_t quantized = dst;
+    quantized.nn = *nn;
+    IM_STATUS ret = rgaProcess("tensorHardwarePass", src, quantized, {}, srect, drect, {}, -1, NULL, &opt, IM_NN_QUANTIZE);
+    if (ret == IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    ret = rgaProcess("tensorHardwarePass", src, dst, {}, srect, drect, {}, -1, NULL, &opt, 0);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    return rgaProcess("tensorHardwarePass", dst, quantized, {}, drect, drect, {}, -1, NULL, &opt, IM_NN_QUANTIZE);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_prepareTensor(JNIEnv *env, jobject thiz, jobject src, jobject tensor,
+                                           jobject srcRect, jobject dstRect, jint layout, jobject nn) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t tensorBuf = getRgaBuffer(env, tensor);
+    RgaStatsScope stats(RGA_STATS_TENSOR, srcBuf, tensorBuf);
+    im_rect srect = srcRect != NULL ? getRgaRect(env, srcRect) : im_rect{0, 0, srcBuf.width, srcBuf.height};
+    im_rect drect = dstRect != NULL ? getRgaRect(env, dstRect) : im_rect{0, 0, tensorBuf.width, tensorBuf.height};
+    im_nn_t nnInfo;
+    const im_nn_t *nnPtr = NULL;
+    if (nn != NULL) {
+        nnInfo = getRgaNn(env, nn);
+        nnPtr = &nnInfo;
+    }
+    // Checked before any RGA pass: the NCHW scratch below only holds 3 bytes per pixel.
+    if (tensorBuf.format != RK_FORMAT_RGB_888 && tensorBuf.format != RK_FORMAT_BGR_888) {
+        return stats.finish(IM_STATUS_NOT_SUPPORTED);
+    }
+
+    if (layout == RGA_CPU_TENSOR_NHWC) {
+        if (tensorHardwarePass(srcBuf, tensorBuf, srect, drect, nnPtr) == IM_STATUS_SUCCESS) {
+            return stats.finish(IM_STATUS_SUCCESS);
+        }
+    } else if (layout == RGA_CPU_TENSOR_NCHW && drect.width > 0 && drect.height > 0) {
+        // The RGA only writes interleaved pixels: render NHWC into scratch and split the planes.
+        int wstride = (drect.width + 15) & ~15;
+        std::vector<uint8_t> scratch((size_t)wstride * drect.height * 3);
+        rga_buffer_t packed = wrapbuffer_virtualaddr_t(scratch.data(), drect.width, drect.height,
+                                                       wstride, drect.height, tensorBuf.format);
+        im_rect whole = {0, 0, drect.width, drect.height};
+        if (tensorHardwarePass(srcBuf, packed, srect, whole, nnPtr) == IM_STATUS_SUCCESS &&
+            rgaCpuTensorToPlanar(packed, tensorBuf, drect) == IM_STATUS_SUCCESS) {
+            return stats.finish(IM_STATUS_SUCCESS);
+        }
+    }
+
+    IM_STATUS ret = rgaCpuPrepareTensor(srcBuf, srect, tensorBuf, drect, layout, nnPtr);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU prepareTensor failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+
+// Fill rects of dst through the RGA2 color fill when it is available, otherwise on the CPU.
+static IM_STATUS fillRects(const rga_buffer_t &dst, const im_rect *rects, int count, uint32_t color) {
+    if (count == 0) {
+        return IM_STATUS_SUCCESS;
+    }
+    if (!useCpuForRga2Ops()) {
+        return imfillArray(dst, const_cast<im_rect *>(rects), count, color);
+    }
+    return rgaCpuFill(dst, rects, count, color);
+}
+
+// Copy (and scale) src into drect of dst on the scheduled cores.
+static IM_STATUS processIntoRect(const rga_buffer_t &src, const rga_buffer_t &dst, const im_rect &drect) {
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return rgaProcess("processIntoRect", src, dst, {}, {}, drect, {}, -1, NULL, &opt, 0);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_immakeBorder(JNIEnv *env, jobject thiz, jobject src, jobject dst,
+                                          jint top, jint bottom, jint left, jint right,
+                                          jint borderType, jint value) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_BORDER, srcBuf, dstBuf);
+    if (!useCpuForRga2Ops()) {
+        return stats.finish(immakeBorder(srcBuf, dstBuf, top, bottom, left, right, borderType, value, 1));
+    }
+
+    // immakeBorder takes no im_opt_t, so it cannot be pinned to RGA3 and its constant
+    // border relies on the RGA2 fill: copy the image on RGA3, then build the border.
+    if (top < 0 || bottom < 0 || left < 0 || right < 0 ||
+        srcBuf.width + left + right != dstBuf.width || srcBuf.height + top + bottom != dstBuf.height) {
+        return stats.finish(IM_STATUS_INVALID_PARAM);
+    }
+    im_rect inner = {left, top, srcBuf.width, srcBuf.height};
+    IM_STATUS ret = processIntoRect(srcBuf, dstBuf, inner);
+    if (ret != IM_STATUS_SUCCESS) {
+        return stats.finish(ret);
+    }
+    ret = rgaCpuMakeBorder(dstBuf, inner, borderType, (uint32_t)value);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU make border failed: %d", ret);
+    }
+    return stats.finish(ret);
+}
+
+// Largest rect with src's aspect ratio centered in dstW x dstH, with position and size
+// rounded down to multiples of align.
+static im_rect letterboxRect(int srcW, int srcH, int dstW, int dstH, int align) {
+    if (align < 1) {
+        align = 1;
+    }
+    double scale = std::min((double)dstW / srcW, (double)dstH / srcH);
+    int w = (int)(srcW * scale + 0.5) / align * align;
+    int h = (int)(srcH * scale + 0.5) / align * align;
+    w = std::max(align, std::min(w, dstW));
+    h = std::max(align, std::min(h, dstH));
+    int x = (dstW - w) / 2 / align * align;
+    int y = (dstH - h) / 2 / align * align;
+    return {x, y, w, h};
+}
+
+JNIEXPORT jobject JNICALL
+Java_com_rockchip_librga_Rga_letterbox(JNIEnv *env, jobject thiz, jobject src, jobject dst,
+                                       jint padColor, jint align) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_LETTERBOX, srcBuf, dstBuf);
+
+    im_rect content = {0, 0, 0, 0};
+    IM_STATUS ret = IM_STATUS_INVALID_PARAM;
+    if (srcBuf.width > 0 && srcBuf.height > 0 && dstBuf.width > 0 && dstBuf.height > 0) {
+        content = letterboxRect(srcBuf.width, srcBuf.height, dstBuf.width, dstBuf.height, align);
+        ret = processIntoRect(srcBuf, dstBuf, content);
+        if (ret == IM_STATUS_SUCCESS) {
+            // Only the strips around the image are filled, never the whole frame.
+            im_rect strips[4];
+            int count = rgaCpuBorderStrips(dstBuf.width, dstBuf.height, content, strips);
+            ret = fillRects(dstBuf, strips, count, (uint32_t)padColor);
+            if (ret != IM_STATUS_SUCCESS) {
+                LOGE("letterbox border fill failed: %d", ret);
+            }
+        }
+    }
+
+    stats.finish(ret);
+
+    jclass clazz = env->FindClass("com/rockchip/librga/Rga$RgaLetterbox");
+    jmethodID ctor = env->GetMethodID(clazz, "<init>", "(IFFIIII)V");
+    float scaleX = content.width > 0 ? (float)content.width / srcBuf.width : 0.0f;
+    float scaleY = content.height > 0 ? (float)content.height / srcBuf.height : 0.0f;
+    return env->NewObject(clazz, ctor, (jint)ret, scaleX, scaleY,
+                          content.x, content.y, content.width, content.height);
+}
+
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_cropResizeBatch(JNIEnv *env, jobject thiz, jobject src, jobjectArray rects,
+                                             jint outWidth, jint outHeight, jobject dstTensor) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dstTensor);
+    RgaStatsScope stats(RGA_STATS_BATCH, srcBuf, dstBuf);
+    std::vector<im_rect> srects;
+    getRgaRectArray(env, rects, srects);
+    int count = (int)srects.size();
+    if (count == 0) {
+        return stats.finish(IM_STATUS_SUCCESS);
+    }
+    // One job, so the batch is written entirely or not at all.
+    if (count > RGA_JOB_MAX_TASKS) {
+        LOGE("cropResizeBatch: %d crops exceed the %d tasks of a job", count, RGA_JOB_MAX_TASKS);
+        return stats.finish(IM_STATUS_INVALID_PARAM);
+    }
+    if (outWidth <= 0 || outHeight <= 0 || dstBuf.width < outWidth ||
+        (int64_t)dstBuf.height < (int64_t)outHeight * count) {
+        LOGE("cropResizeBatch: dst %dx%d cannot hold %d crops of %dx%d",
+             dstBuf.width, dstBuf.height, count, outWidth, outHeight);
+        return stats.finish(IM_STATUS_INVALID_PARAM);
+    }
+
+    imconfig(IM_CONFIG_SCHEDULER_CORE, RGA_JNI_SCHEDULER_CORE);
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+
+    // Crop i lands in rows [i * outHeight, (i + 1) * outHeight): with wstride == outWidth
+    // the crops are contiguous, i.e. an N x outHeight x outWidth tensor.
+    im_job_handle_t job = rgaBeginJob(0);
+    if (job == 0) {
+        return stats.finish(IM_STATUS_FAILED);
+    }
+    for (int i = 0; i < count; i++) {
+        im_rect drect = {0, i * outHeight, outWidth, outHeight};
+        IM_STATUS ret = rgaProcessTask("cropResizeBatch", job, srcBuf, dstBuf, {}, srects[i], drect, {}, &opt, 0);
+        if (ret != IM_STATUS_SUCCESS) {
+            LOGE("cropResizeBatch: task %d failed: %d", i, ret);
+            rgaCancelJob(job);
+            return stats.finish(ret);
+        }
+    }
+    return stats.finish(rgaEndJob(job, IM_SYNC, 0, NULL));
+}
+
+// rects receives x, y, width, height per item.
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_imresizeAtlasNative(JNIEnv *env, jobject thiz, jobjectArray items, jobject atlas,
+                                                 jint padding, jintArray rects) {
+    rga_buffer_t atlasBuf = getRgaBuffer(env, atlas);
+    RgaStatsScope stats(RGA_STATS_BATCH, atlasBuf);
+    jsize count = env->GetArrayLength(items);
+    if (count == 0) {
+        return stats.finish(IM_STATUS_SUCCESS);
+    }
+    const RgaFormatDesc *desc = rgaFormatFind(atlasBuf.format);
+    if (desc == nullptr || env->GetArrayLength(rects) < count * 4) {
+        return stats.finish(IM_STATUS_INVALID_PARAM);
+    }
+
+    std::vector<RgaAtlasItem> list(count);
+    jclass clazz = env->FindClass("com/rockchip/librga/Rga$RgaAtlasItem");
+    jfieldID srcId = env->GetFieldID(clazz, "src", "Lcom/rockchip/librga/Rga$RgaBuffer;");
+    jfieldID widthId = env->GetFieldID(clazz, "width", "I");
+    jfieldID heightId = env->GetFieldID(clazz, "height", "I");
+    jfieldID srcRectId = env->GetFieldID(clazz, "srcRect", "Lcom/rockchip/librga/Rga$RgaRect;");
+    for (jsize i = 0; i < count; i++) {
+        jobject jItem = env->GetObjectArrayElement(items, i);
+        RgaAtlasItem &item = list[i];
+        memset(&item, 0, sizeof(item));
+        jobject src = env->GetObjectField(jItem, srcId);
+        item.src = getRgaBuffer(env, src);
+        env->DeleteLocalRef(src);
+        item.width = env->GetIntField(jItem, widthId);
+        item.height = env->GetIntField(jItem, heightId);
+        jobject srcRect = env->GetObjectField(jItem, srcRectId);
+        if (srcRect != NULL) {
+            item.srect = getRgaRect(env, srcRect);
+            env->DeleteLocalRef(srcRect);
+        }
+        env->DeleteLocalRef(jItem);
+        if (item.width % desc->rectAlign != 0 || item.height % desc->rectAlign != 0) {
+            LOGE("imresizeAtlas: item %d is %dx%d, %s needs multiples of %d",
+                 i, item.width, item.height, desc->name, desc->rectAlign);
+            env->DeleteLocalRef(clazz);
+            return stats.finish(IM_STATUS_INVALID_PARAM);
+        }
+    }
+    env->DeleteLocalRef(clazz);
+
+    std::vector<im_rect> placed(count);
+    if (rgaAtlasPack(atlasBuf.width, atlasBuf.height, list.data(), count, padding, desc->rectAlign,
+                     placed.data()) < 0) {
+        LOGE("imresizeAtlas: %d items do not fit into %dx%d", count, atlasBuf.width, atlasBuf.height);
+        return stats.finish(IM_STATUS_INVALID_PARAM);
+    }
+    std::vector<jint> values(count * 4);
+    for (jsize i = 0; i < count; i++) {
+        values[i * 4] = placed[i].x;
+        values[i * 4 + 1] = placed[i].y;
+        values[i * 4 + 2] = placed[i].width;
+        values[i * 4 + 3] = placed[i].height;
+    }
+    env->SetIntArrayRegion(rects, 0, count * 4, values.data());
+
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    return stats.finish(rgaAtlasBuild(list.data(), placed.data(), count, atlasBuf, &opt));
+}
+
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_statsSetEnabled(JNIEnv *env, jobject thiz, jboolean enabled) {
+    rgaStatsSetEnabled(enabled);
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_statsReset(JNIEnv *env, jobject thiz) {
+    rgaStatsReset();
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_rockchip_librga_Rga_statsOpNames(JNIEnv *env, jobject thiz) {
+    jobjectArray names = env->NewObjectArray(RGA_STATS_OP_COUNT, env->FindClass("java/lang/String"), NULL);
+    for (int op = 0; op < RGA_STATS_OP_COUNT; op++) {
+        jstring name = env->NewStringUTF(rgaStatsOpName(op));
+        env->SetObjectArrayElement(names, op, name);
+        env->DeleteLocalRef(name);
+    }
+    return names;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_rockchip_librga_Rga_statsSnapshotNative(JNIEnv *env, jobject thiz) {
+    std::vector<int64_t> values(RGA_STATS_OP_COUNT * RGA_STATS_FIELDS);
+    rgaStatsSnapshot(values.data());
+    jlongArray out = env->NewLongArray((jsize)values.size());
+    env->SetLongArrayRegion(out, 0, (jsize)values.size(), (const jlong *)values.data());
+    return out;
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_traceStart(JNIEnv *env, jobject thiz, jint capacityPerThread) {
+    rgaTraceStart(capacityPerThread);
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_traceStop(JNIEnv *env, jobject thiz) {
+    rgaTraceStop();
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_rockchip_librga_Rga_traceDumpJson(JNIEnv *env, jobject thiz) {
+    return env->NewStringUTF(rgaTraceDumpJson().c_str());
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_setCpuFastPath(JNIEnv *env, jobject thiz, jboolean enabled) {
+    rgaCrossoverSetEnabled(enabled);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_calibrateCpuFastPath(JNIEnv *env, jobject thiz, jint iterations) {
+    return rgaCrossoverCalibrate(RGA_JNI_SCHEDULER_CORE, iterations);
+}
+
+static std::string getString(JNIEnv *env, jstring str) {
+    const char *chars = env->GetStringUTFChars(str, NULL);
+    std::string result(chars);
+    env->ReleaseStringUTFChars(str, chars);
+    return result;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_rockchip_librga_Rga_saveCpuFastPath(JNIEnv *env, jobject thiz, jstring path, jstring key) {
+    return rgaCrossoverSave(getString(env, path), getString(env, key));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_rockchip_librga_Rga_loadCpuFastPath(JNIEnv *env, jobject thiz, jstring path, jstring key) {
+    return rgaCrossoverLoad(getString(env, path), getString(env, key));
+}
+
+// rgaNs, cpuNs per op and bucket, in rga_crossover.h order.
+JNIEXPORT jlongArray JNICALL
+Java_com_rockchip_librga_Rga_cpuFastPathTableNative(JNIEnv *env, jobject thiz) {
+    RgaCrossoverEntry table[RGA_CROSSOVER_OP_COUNT * RGA_CROSSOVER_BUCKETS];
+    rgaCrossoverSnapshot(table);
+    jlong values[RGA_CROSSOVER_OP_COUNT * RGA_CROSSOVER_BUCKETS * 2];
+    for (int i = 0; i < RGA_CROSSOVER_OP_COUNT * RGA_CROSSOVER_BUCKETS; i++) {
+        values[2 * i] = table[i].rgaNs;
+        values[2 * i + 1] = table[i].cpuNs;
+    }
+    jlongArray out = env->NewLongArray(RGA_CROSSOVER_OP_COUNT * RGA_CROSSOVER_BUCKETS * 2);
+    env->SetLongArrayRegion(out, 0, RGA_CROSSOVER_OP_COUNT * RGA_CROSSOVER_BUCKETS * 2, values);
+    return out;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_pipelineCreate(JNIEnv *env, jobject thiz, jobjectArray stages,
+                                            jint depth, jint outputSlots) {
+    jsize count = env->GetArrayLength(stages);
+    std::vector<RgaPipelineStage> chain(count);
+    jclass clazz = env->FindClass("com/rockchip/librga/Rga$RgaPipelineStage");
+    jfieldID widthId = env->GetFieldID(clazz, "width", "I");
+    jfieldID heightId = env->GetFieldID(clazz, "height", "I");
+    jfieldID formatId = env->GetFieldID(clazz, "format", "I");
+    jfieldID srcRectId = env->GetFieldID(clazz, "srcRect", "Lcom/rockchip/librga/Rga$RgaRect;");
+    jfieldID dstRectId = env->GetFieldID(clazz, "dstRect", "Lcom/rockchip/librga/Rga$RgaRect;");
+    jfieldID usageId = env->GetFieldID(clazz, "usage", "I");
+    jfieldID rdModeId = env->GetFieldID(clazz, "rdMode", "I");
+    for (jsize i = 0; i < count; i++) {
+        jobject jStage = env->GetObjectArrayElement(stages, i);
+        RgaPipelineStage &stage = chain[i];
+        memset(&stage, 0, sizeof(stage));
+        stage.width = env->GetIntField(jStage, widthId);
+        stage.height = env->GetIntField(jStage, heightId);
+        stage.format = env->GetIntField(jStage, formatId);
+        stage.usage = env->GetIntField(jStage, usageId);
+        stage.rdMode = env->GetIntField(jStage, rdModeId);
+        jobject srcRect = env->GetObjectField(jStage, srcRectId);
+        if (srcRect != NULL) {
+            stage.srect = getRgaRect(env, srcRect);
+            env->DeleteLocalRef(srcRect);
+        }
+        jobject dstRect = env->GetObjectField(jStage, dstRectId);
+        if (dstRect != NULL) {
+            stage.drect = getRgaRect(env, dstRect);
+            env->DeleteLocalRef(dstRect);
+        }
+        env->DeleteLocalRef(jStage);
+    }
+    env->DeleteLocalRef(clazz);
+
+    RgaPipeline *pipeline = new RgaPipeline(chain, depth, outputSlots, RGA_JNI_SCHEDULER_CORE);
+    IM_STATUS ret = pipeline->init();
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("pipeline init failed: %d", ret);
+        delete pipeline;
+        return 0;
+    }
+    return (jlong)(intptr_t)pipeline;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_pipelineSubmit(JNIEnv *env, jobject thiz, jlong handle, jobject input,
+                                            jint acquireFence, jlong tag, jint timeoutMs) {
+    RgaPipeline *pipeline = (RgaPipeline *)(intptr_t)handle;
+    rga_buffer_t inputBuf = getRgaBuffer(env, input);
+    return pipeline->submit(inputBuf, acquireFence, tag, timeoutMs);
+}
+
+// Returns the output pixels (or null on timeout); meta receives seq, tag, status, slot,
+// width, height, wstride, hstride, format, rd_mode.
+JNIEXPORT jobject JNICALL
+Java_com_rockchip_librga_Rga_pipelineDequeueNative(JNIEnv *env, jobject thiz, jlong handle,
+                                                   jint timeoutMs, jlongArray meta) {
+    RgaPipeline *pipeline = (RgaPipeline *)(intptr_t)handle;
+    RgaPipelineFrame frame;
+    if (pipeline->dequeue(&frame, timeoutMs) == RGA_PIPELINE_TIMEOUT) {
+        return NULL;
+    }
+    const rga_buffer_t &buf = frame.buffer;
+    jlong values[10] = {(jlong)frame.seq, frame.tag, frame.status, frame.slot,
+                        buf.width, buf.height, buf.wstride, buf.hstride, buf.format, buf.rd_mode};
+    env->SetLongArrayRegion(meta, 0, 10, values);
+    return env->NewDirectByteBuffer(buf.vir_addr,
+                                    (jlong)rgaFormatBufferSize(buf.format, buf.wstride, buf.hstride, buf.rd_mode));
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_pipelineRecycle(JNIEnv *env, jobject thiz, jlong handle, jint slot) {
+    ((RgaPipeline *)(intptr_t)handle)->recycle(slot);
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_pipelineFlush(JNIEnv *env, jobject thiz, jlong handle) {
+    ((RgaPipeline *)(intptr_t)handle)->flush();
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_pipelineDestroy(JNIEnv *env, jobject thiz, jlong handle) {
+    delete (RgaPipeline *)(intptr_t)handle;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_schedulerCreate(JNIEnv *env, jobject thiz, jint workers) {
+    RgaScheduler *scheduler = new RgaScheduler(workers, RGA_JNI_SCHEDULER_CORE);
+    IM_STATUS ret = scheduler->init();
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("scheduler init failed: %d", ret);
+        delete scheduler;
+        return 0;
+    }
+    return (jlong)(intptr_t)scheduler;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_schedulerAddStream(JNIEnv *env, jobject thiz, jlong handle, jint maxQueued) {
+    return ((RgaScheduler *)(intptr_t)handle)->addStream(maxQueued);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_schedulerSubmit(JNIEnv *env, jobject thiz, jlong handle, jint stream,
+                                             jobjectArray tasks, jlong deadlineNs, jlong tag) {
+    jsize count = env->GetArrayLength(tasks);
+    std::vector<RgaSchedulerTask> list(count);
+    jclass clazz = env->FindClass("com/rockchip/librga/Rga$RgaSchedulerTask");
+    jfieldID srcId = env->GetFieldID(clazz, "src", "Lcom/rockchip/librga/Rga$RgaBuffer;");
+    jfieldID dstId = env->GetFieldID(clazz, "dst", "Lcom/rockchip/librga/Rga$RgaBuffer;");
+    jfieldID srcRectId = env->GetFieldID(clazz, "srcRect", "Lcom/rockchip/librga/Rga$RgaRect;");
+    jfieldID dstRectId = env->GetFieldID(clazz, "dstRect", "Lcom/rockchip/librga/Rga$RgaRect;");
+    jfieldID usageId = env->GetFieldID(clazz, "usage", "I");
+    for (jsize i = 0; i < count; i++) {
+        jobject jTask = env->GetObjectArrayElement(tasks, i);
+        RgaSchedulerTask &task = list[i];
+        memset(&task, 0, sizeof(task));
+        jobject src = env->GetObjectField(jTask, srcId);
+        jobject dst = env->GetObjectField(jTask, dstId);
+        task.src = getRgaBuffer(env, src);
+        task.dst = getRgaBuffer(env, dst);
+        env->DeleteLocalRef(src);
+        env->DeleteLocalRef(dst);
+        task.usage = env->GetIntField(jTask, usageId);
+        jobject srcRect = env->GetObjectField(jTask, srcRectId);
+        if (srcRect != NULL) {
+            task.srect = getRgaRect(env, srcRect);
+            env->DeleteLocalRef(srcRect);
+        }
+        jobject dstRect = env->GetObjectField(jTask, dstRectId);
+        if (dstRect != NULL) {
+            task.drect = getRgaRect(env, dstRect);
+            env->DeleteLocalRef(dstRect);
+        }
+        env->DeleteLocalRef(jTask);
+    }
+    env->DeleteLocalRef(clazz);
+    return ((RgaScheduler *)(intptr_t)handle)->submit(stream, list, (uint64_t)deadlineNs, tag);
+}
+
+// False on timeout; meta receives stream, tag, status, late, waitNs, latencyNs.
+JNIEXPORT jboolean JNICALL
+Java_com_rockchip_librga_Rga_schedulerPollNative(JNIEnv *env, jobject thiz, jlong handle, jint timeoutMs,
+                                                 jlongArray meta) {
+    RgaSchedulerResult result;
+    if (((RgaScheduler *)(intptr_t)handle)->poll(&result, timeoutMs) == RGA_SCHEDULER_TIMEOUT) {
+        return JNI_FALSE;
+    }
+    jlong values[6] = {result.stream, result.tag, result.status, result.late ? 1 : 0,
+                       (jlong)result.waitNs, (jlong)result.latencyNs};
+    env->SetLongArrayRegion(meta, 0, 6, values);
+    return JNI_TRUE;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_rockchip_librga_Rga_schedulerStatsNative(JNIEnv *env, jobject thiz, jlong handle, jint stream) {
+    RgaSchedulerStats stats = ((RgaScheduler *)(intptr_t)handle)->stats(stream);
+    jlong values[8] = {stats.submitted, stats.completed, stats.late, stats.dropped,
+                       stats.cancelled, stats.failed, stats.jobNs, stats.queued};
+    jlongArray result = env->NewLongArray(8);
+    env->SetLongArrayRegion(result, 0, 8, values);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_schedulerFlush(JNIEnv *env, jobject thiz, jlong handle) {
+    ((RgaScheduler *)(intptr_t)handle)->flush();
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_schedulerDestroy(JNIEnv *env, jobject thiz, jlong handle) {
+    delete (RgaScheduler *)(intptr_t)handle;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_osdTextCreate(JNIEnv *env, jobject thiz, jint atlasWidth, jint atlasHeight,
+                                           jint maxCached) {
+    return (jlong)(intptr_t)new RgaOsdText(atlasWidth, atlasHeight, maxCached, RGA_JNI_SCHEDULER_CORE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_osdTextSetMetrics(JNIEnv *env, jobject thiz, jlong handle, jint ascent,
+                                               jint lineHeight) {
+    ((RgaOsdText *)(intptr_t)handle)->setMetrics(ascent, lineHeight);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_osdTextAddGlyph(JNIEnv *env, jobject thiz, jlong handle, jint codepoint,
+                                             jbyteArray coverage, jint width, jint height, jint left, jint top,
+                                             jint advance) {
+    if (coverage == NULL || env->GetArrayLength(coverage) < width * height) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    jbyte *bytes = env->GetByteArrayElements(coverage, NULL);
+    IM_STATUS ret = ((RgaOsdText *)(intptr_t)handle)->addGlyph((uint32_t)codepoint, (const uint8_t *)bytes,
+                                                              width, height, left, top, advance);
+    env->ReleaseByteArrayElements(coverage, bytes, JNI_ABORT);
+    return ret;
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_rockchip_librga_Rga_osdTextMeasure(JNIEnv *env, jobject thiz, jlong handle, jstring text, jint padding) {
+    std::string str = getString(env, text);
+    jint size[2];
+    ((RgaOsdText *)(intptr_t)handle)->measure(str.c_str(), padding, &size[0], &size[1]);
+    jintArray out = env->NewIntArray(2);
+    env->SetIntArrayRegion(out, 0, 2, size);
+    return out;
+}
+
+// params holds x, y, color, background, padding per label.
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_osdTextDraw(JNIEnv *env, jobject thiz, jlong handle, jobject dst, jobjectArray texts,
+                                         jintArray params, jboolean cpu) {
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_OSD, dstBuf);
+    jsize count = env->GetArrayLength(texts);
+    if (env->GetArrayLength(params) < count * 5) {
+        return stats.finish(IM_STATUS_INVALID_PARAM);
+    }
+    std::vector<std::string> strings(count);
+    std::vector<jint> values(count * 5);
+    env->GetIntArrayRegion(params, 0, count * 5, values.data());
+    std::vector<RgaOsdLabel> labels(count);
+    for (jsize i = 0; i < count; i++) {
+        jstring text = (jstring)env->GetObjectArrayElement(texts, i);
+        strings[i] = getString(env, text);
+        env->DeleteLocalRef(text);
+        RgaOsdLabel &label = labels[i];
+        label.text = strings[i].c_str();
+        label.x = values[i * 5];
+        label.y = values[i * 5 + 1];
+        label.color = (uint32_t)values[i * 5 + 2];
+        label.background = (uint32_t)values[i * 5 + 3];
+        label.padding = values[i * 5 + 4];
+    }
+    return stats.finish(((RgaOsdText *)(intptr_t)handle)->draw(dstBuf, labels.data(), count, cpu));
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_rockchip_librga_Rga_osdTextStatsNative(JNIEnv *env, jobject thiz, jlong handle) {
+    const RgaOsdTextStats &stats = ((RgaOsdText *)(intptr_t)handle)->stats();
+    jlong values[6] = {stats.glyphs, stats.atlasRows, stats.cachedStrings, stats.cacheHits, stats.cacheMisses,
+                       stats.tasks};
+    jlongArray result = env->NewLongArray(6);
+    env->SetLongArrayRegion(result, 0, 6, values);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_osdTextClearCache(JNIEnv *env, jobject thiz, jlong handle) {
+    ((RgaOsdText *)(intptr_t)handle)->clearCache();
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_osdTextDestroy(JNIEnv *env, jobject thiz, jlong handle) {
+    delete (RgaOsdText *)(intptr_t)handle;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_sliceProgressCreate(JNIEnv *env, jobject thiz) {
+    return (jlong)(intptr_t)new RgaSliceProgress();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_sliceProgressRows(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaSliceProgress *)(intptr_t)handle)->rows();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_sliceProgressTotalRows(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaSliceProgress *)(intptr_t)handle)->totalRows();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_sliceProgressStatus(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaSliceProgress *)(intptr_t)handle)->status();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_rockchip_librga_Rga_sliceProgressWait(JNIEnv *env, jobject thiz, jlong handle, jint rows,
+                                               jint timeoutMs) {
+    return ((RgaSliceProgress *)(intptr_t)handle)->waitRows(rows, timeoutMs) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_sliceProgressLatencyNs(JNIEnv *env, jobject thiz, jlong handle, jint rows) {
+    return ((RgaSliceProgress *)(intptr_t)handle)->latencyNs(rows);
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_sliceProgressDestroy(JNIEnv *env, jobject thiz, jlong handle) {
+    delete (RgaSliceProgress *)(intptr_t)handle;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_improcessSlicedNative(JNIEnv *env, jobject thiz, jlong handle, jobject src,
+                                                   jobject dst, jobject srcRect, jobject dstRect, jint usage,
+                                                   jint writeStart, jint writeStep) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    im_rect srect = srcRect != NULL ? getRgaRect(env, srcRect) : im_rect{0, 0, srcBuf.width, srcBuf.height};
+    im_rect drect = dstRect != NULL ? getRgaRect(env, dstRect) : im_rect{0, 0, dstBuf.width, dstBuf.height};
+    im_opt_t opt;
+    memset(&opt, 0, sizeof(im_opt_t));
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = RGA_JNI_SCHEDULER_CORE;
+    im_intr_config_t intr = {IM_INTR_WRITE_INTR, 0, writeStart, writeStep};
+    return rgaProcessSliced("improcessSliced", srcBuf, dstBuf, srect, drect, &opt, usage, intr,
+                            (RgaSliceProgress *)(intptr_t)handle);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_stripeCreate(JNIEnv *env, jobject thiz, jint srcWidth, jint srcHeight,
+                                          jint srcFormat, jint minOutputRows) {
+    return (jlong)(intptr_t)new RgaStripeStream(srcWidth, srcHeight, srcFormat, minOutputRows,
+                                                RGA_JNI_SCHEDULER_CORE);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_stripeBegin(JNIEnv *env, jobject thiz, jlong handle, jobject dst, jobject dstRect,
+                                         jint usage, jlong progress) {
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    im_rect drect = dstRect != NULL ? getRgaRect(env, dstRect) : im_rect{0, 0, dstBuf.width, dstBuf.height};
+    return ((RgaStripeStream *)(intptr_t)handle)->begin(dstBuf, drect, usage, (RgaSliceProgress *)(intptr_t)progress);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_stripePush(JNIEnv *env, jobject thiz, jlong handle, jobject stripe) {
+    return ((RgaStripeStream *)(intptr_t)handle)->push(getRgaBuffer(env, stripe));
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_stripeAbort(JNIEnv *env, jobject thiz, jlong handle) {
+    ((RgaStripeStream *)(intptr_t)handle)->abort();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_stripeInputStep(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaStripeStream *)(intptr_t)handle)->inputStep();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_stripeOutputStep(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaStripeStream *)(intptr_t)handle)->outputStep();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_stripeWrittenRows(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaStripeStream *)(intptr_t)handle)->writtenRows();
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_rockchip_librga_Rga_stripeStatsNative(JNIEnv *env, jobject thiz, jlong handle) {
+    const RgaStripeStats &stats = ((RgaStripeStream *)(intptr_t)handle)->stats();
+    jlong values[5] = {stats.stripes, stats.outputs, stats.inPlace, stats.stitched, stats.copiedRows};
+    jlongArray result = env->NewLongArray(5);
+    env->SetLongArrayRegion(result, 0, 5, values);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_stripeDestroy(JNIEnv *env, jobject thiz, jlong handle) {
+    delete (RgaStripeStream *)(intptr_t)handle;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_graphCreate(JNIEnv *env, jobject thiz) {
+    return (jlong)(intptr_t)new RgaGraph(RGA_JNI_SCHEDULER_CORE);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphInput(JNIEnv *env, jobject thiz, jlong handle, jobject buffer) {
+    return ((RgaGraph *)(intptr_t)handle)->input(getRgaBuffer(env, buffer));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphCrop(JNIEnv *env, jobject thiz, jlong handle, jint node, jobject rect) {
+    return ((RgaGraph *)(intptr_t)handle)->crop(node, getRgaRect(env, rect));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphResize(JNIEnv *env, jobject thiz, jlong handle, jint node,
+                                         jint width, jint height) {
+    return ((RgaGraph *)(intptr_t)handle)->resize(node, width, height);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphCvtcolor(JNIEnv *env, jobject thiz, jlong handle, jint node, jint format) {
+    return ((RgaGraph *)(intptr_t)handle)->cvtcolor(node, format);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphRotate(JNIEnv *env, jobject thiz, jlong handle, jint node, jint rotation) {
+    return ((RgaGraph *)(intptr_t)handle)->rotate(node, rotation);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphFlip(JNIEnv *env, jobject thiz, jlong handle, jint node, jint mode) {
+    return ((RgaGraph *)(intptr_t)handle)->flip(node, mode);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphOutput(JNIEnv *env, jobject thiz, jlong handle, jint node, jobject buffer) {
+    return ((RgaGraph *)(intptr_t)handle)->output(node, getRgaBuffer(env, buffer));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphRebind(JNIEnv *env, jobject thiz, jlong handle, jint node, jobject buffer) {
+    return ((RgaGraph *)(intptr_t)handle)->rebind(node, getRgaBuffer(env, buffer));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphCompile(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaGraph *)(intptr_t)handle)->compile();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_graphRun(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaGraph *)(intptr_t)handle)->run();
+}
+
+// ops, passes, intermediates, intermediateBytes, bytesUnfused, bytesFused
+JNIEXPORT jlongArray JNICALL
+Java_com_rockchip_librga_Rga_graphStatsNative(JNIEnv *env, jobject thiz, jlong handle) {
+    const RgaGraphStats &stats = ((RgaGraph *)(intptr_t)handle)->stats();
+    jlong values[6] = {stats.ops, stats.passes, stats.intermediates,
+                       stats.intermediateBytes, stats.bytesUnfused, stats.bytesFused};
+    jlongArray result = env->NewLongArray(6);
+    env->SetLongArrayRegion(result, 0, 6, values);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_graphDestroy(JNIEnv *env, jobject thiz, jlong handle) {
+    delete (RgaGraph *)(intptr_t)handle;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_compositorCreate(JNIEnv *env, jobject thiz, jint width, jint height) {
+    return (jlong)(intptr_t)new RgaCompositor(width, height, RGA_JNI_SCHEDULER_CORE);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_compositorSetLayer(JNIEnv *env, jobject thiz, jlong handle, jint id, jobject buffer,
+                                                jobject srcRect, jobject dstRect, jint transform, jint alpha,
+                                                jint zOrder, jboolean blend) {
+    RgaLayer layer;
+    memset(&layer, 0, sizeof(layer));
+    layer.buffer = getRgaBuffer(env, buffer);
+    if (srcRect != NULL) {
+        layer.srect = getRgaRect(env, srcRect);
+    }
+    layer.drect = getRgaRect(env, dstRect);
+    layer.transform = transform;
+    layer.alpha = alpha;
+    layer.zorder = zOrder;
+    layer.blend = blend;
+    return ((RgaCompositor *)(intptr_t)handle)->setLayer(id, layer);
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_compositorRemoveLayer(JNIEnv *env, jobject thiz, jlong handle, jint id) {
+    ((RgaCompositor *)(intptr_t)handle)->removeLayer(id);
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_compositorDamageLayer(JNIEnv *env, jobject thiz, jlong handle, jint id) {
+    ((RgaCompositor *)(intptr_t)handle)->damageLayer(id);
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_compositorSetBackground(JNIEnv *env, jobject thiz, jlong handle, jint color) {
+    ((RgaCompositor *)(intptr_t)handle)->setBackground((uint32_t)color);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_compositorCompose(JNIEnv *env, jobject thiz, jlong handle, jobject dst) {
+    return ((RgaCompositor *)(intptr_t)handle)->compose(getRgaBuffer(env, dst));
+}
+
+// layers, layersDrawn, layersCulled, tasks, damagePixels, pixelsDrawn, pixelsFull
+JNIEXPORT jlongArray JNICALL
+Java_com_rockchip_librga_Rga_compositorStatsNative(JNIEnv *env, jobject thiz, jlong handle) {
+    const RgaCompositorStats &stats = ((RgaCompositor *)(intptr_t)handle)->stats();
+    jlong values[7] = {stats.layers, stats.layersDrawn, stats.layersCulled, stats.tasks,
+                       stats.damagePixels, stats.pixelsDrawn, stats.pixelsFull};
+    jlongArray result = env->NewLongArray(7);
+    env->SetLongArrayRegion(result, 0, 7, values);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_compositorDestroy(JNIEnv *env, jobject thiz, jlong handle) {
+    delete (RgaCompositor *)(intptr_t)handle;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_incrementalCreate(JNIEnv *env, jobject thiz, jint blockSize) {
+    return (jlong)(intptr_t)new RgaIncremental(blockSize, RGA_JNI_SCHEDULER_CORE);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_incrementalProcess(JNIEnv *env, jobject thiz, jlong handle, jobject src, jobject dst,
+                                                jobject srcRect, jobject dstRect, jint usage, jobjectArray dirty) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    im_rect srect = {0, 0, 0, 0};
+    im_rect drect = {0, 0, 0, 0};
+    if (srcRect != NULL) {
+        srect = getRgaRect(env, srcRect);
+    }
+    if (dstRect != NULL) {
+        drect = getRgaRect(env, dstRect);
+    }
+    RgaIncremental *incremental = (RgaIncremental *)(intptr_t)handle;
+    if (dirty == NULL) {
+        return incremental->process(srcBuf, dstBuf, srect, drect, usage, NULL, 0);
+    }
+    std::vector<im_rect> rects;
+    getRgaRectArray(env, dirty, rects);
+    return incremental->process(srcBuf, dstBuf, srect, drect, usage, rects.data(), (int)rects.size());
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_incrementalInvalidate(JNIEnv *env, jobject thiz, jlong handle) {
+    ((RgaIncremental *)(intptr_t)handle)->invalidate();
+}
+
+// frames, fullFrames, skippedFrames, blocks, dirtyBlocks, tasks, pixelsTotal, pixelsProcessed, hashNs
+JNIEXPORT jlongArray JNICALL
+Java_com_rockchip_librga_Rga_incrementalStatsNative(JNIEnv *env, jobject thiz, jlong handle) {
+    const RgaDamageStats &stats = ((RgaIncremental *)(intptr_t)handle)->stats();
+    jlong values[9] = {stats.frames, stats.fullFrames, stats.skippedFrames, stats.blocks, stats.dirtyBlocks,
+                       stats.tasks, stats.pixelsTotal, stats.pixelsProcessed, stats.hashNs};
+    jlongArray result = env->NewLongArray(9);
+    env->SetLongArrayRegion(result, 0, 9, values);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_incrementalResetStats(JNIEnv *env, jobject thiz, jlong handle) {
+    ((RgaIncremental *)(intptr_t)handle)->resetStats();
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_incrementalDestroy(JNIEnv *env, jobject thiz, jlong handle) {
+    delete (RgaIncremental *)(intptr_t)handle;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_frameReaderOpen(JNIEnv *env, jobject thiz, jstring path, jint width, jint height,
+                                             jint format, jint wstride, jint hstride, jlong frameBytes,
+                                             jint prefetch) {
+    RgaFrameReader *reader = new RgaFrameReader();
+    IM_STATUS ret = reader->open(getString(env, path), width, height, format, wstride, hstride,
+                                 (size_t)frameBytes, prefetch);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("frame reader open failed: %d", ret);
+        delete reader;
+        return 0;
+    }
+    return (jlong)(intptr_t)reader;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_frameReaderCount(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaFrameReader *)(intptr_t)handle)->frameCount();
+}
+
+// A view of the frame inside the mapping, or null for a bad index.
+JNIEXPORT jobject JNICALL
+Java_com_rockchip_librga_Rga_frameReaderFrame(JNIEnv *env, jobject thiz, jlong handle, jint index) {
+    RgaFrameReader *reader = (RgaFrameReader *)(intptr_t)handle;
+    rga_buffer_t buf;
+    if (reader->frame(index, &buf) != IM_STATUS_SUCCESS) {
+        return NULL;
+    }
+    return env->NewDirectByteBuffer(buf.vir_addr, (jlong)reader->frameBytes());
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_frameReaderClose(JNIEnv *env, jobject thiz, jlong handle) {
+    delete (RgaFrameReader *)(intptr_t)handle;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_frameWriterOpen(JNIEnv *env, jobject thiz, jstring path, jint width, jint height,
+                                             jint format, jint wstride, jint hstride, jlong frameBytes,
+                                             jint growFrames) {
+    RgaFrameWriter *writer = new RgaFrameWriter();
+    IM_STATUS ret = writer->open(getString(env, path), width, height, format, wstride, hstride,
+                                 (size_t)frameBytes, growFrames);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("frame writer open failed: %d", ret);
+        delete writer;
+        return 0;
+    }
+    return (jlong)(intptr_t)writer;
+}
+
+JNIEXPORT jobject JNICALL
+Java_com_rockchip_librga_Rga_frameWriterNext(JNIEnv *env, jobject thiz, jlong handle) {
+    RgaFrameWriter *writer = (RgaFrameWriter *)(intptr_t)handle;
+    rga_buffer_t buf;
+    IM_STATUS ret = writer->next(&buf);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("frame writer next failed: %d", ret);
+        return NULL;
+    }
+    return env->NewDirectByteBuffer(buf.vir_addr, (jlong)writer->frameBytes());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_frameWriterCount(JNIEnv *env, jobject thiz, jlong handle) {
+    return ((RgaFrameWriter *)(intptr_t)handle)->frameCount();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_frameWriterClose(JNIEnv *env, jobject thiz, jlong handle) {
+    RgaFrameWriter *writer = (RgaFrameWriter *)(intptr_t)handle;
+    IM_STATUS ret = writer->close();
+    delete writer;
+    return ret;
+}
+
+// Flattened RGA_FORMAT_TABLE then RGA_FORMAT_EXT_TABLE, RGA_FORMAT_FIELDS ints per format;
+// must match Rga.kt
+#define RGA_FORMAT_FIELDS 13
+
+static const RgaFormatDesc &formatAt(int i) {
+    return i < RGA_FORMAT_COUNT ? RGA_FORMAT_TABLE[i] : RGA_FORMAT_EXT_TABLE[i - RGA_FORMAT_COUNT];
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_rockchip_librga_Rga_formatTableNative(JNIEnv *env, jobject thiz) {
+    std::vector<jint> values;
+    for (int i = 0; i < RGA_FORMAT_COUNT + RGA_FORMAT_EXT_COUNT; i++) {
+        const RgaFormatDesc &d = formatAt(i);
+        jint fields[RGA_FORMAT_FIELDS] = {
+            d.format, d.planeCount, d.bits[0], d.bits[1], d.bits[2], d.xshift, d.yshift,
+            d.rectAlign, d.strideAlign, d.alpha, d.yuv, d.tenBit, d.byteSamples
+        };
+        values.insert(values.end(), fields, fields + RGA_FORMAT_FIELDS);
+    }
+    jintArray out = env->NewIntArray((jsize)values.size());
+    env->SetIntArrayRegion(out, 0, (jsize)values.size(), values.data());
+    return out;
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_rockchip_librga_Rga_formatNames(JNIEnv *env, jobject thiz) {
+    jobjectArray names = env->NewObjectArray(RGA_FORMAT_COUNT + RGA_FORMAT_EXT_COUNT,
+                                             env->FindClass("java/lang/String"), NULL);
+    for (int i = 0; i < RGA_FORMAT_COUNT + RGA_FORMAT_EXT_COUNT; i++) {
+        jstring name = env->NewStringUTF(formatAt(i).name);
+        env->SetObjectArrayElement(names, i, name);
+        env->DeleteLocalRef(name);
+    }
+    return names;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_rockchip_librga_Rga_bufferSize(JNIEnv *env, jobject thiz, jint format, jint wstride, jint hstride,
+                                        jint rdMode) {
+    return (jlong)rgaFormatBufferSize(format, wstride, hstride, rdMode);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_imageSize(JNIEnv *env, jobject thiz, jint format, jint wstride, jint hstride) {
+    return (jint)rgaFormatImageSize(format, wstride, hstride);
+}
+
+JNIEXPORT void JNICALL
+Java_com_rockchip_librga_Rga_setTenBitDither(JNIEnv *env, jobject thiz, jboolean enabled) {
+    gTenBitDither = enabled;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_rockchip_librga_Rga_convertTenBitCpu(JNIEnv *env, jobject thiz, jobject src, jobject dst, jboolean dither) {
+    rga_buffer_t srcBuf = getRgaBuffer(env, src);
+    rga_buffer_t dstBuf = getRgaBuffer(env, dst);
+    RgaStatsScope stats(RGA_STATS_CVTCOLOR, srcBuf, dstBuf);
+    IM_STATUS ret = rgaCpuConvert10Bit(srcBuf, dstBuf, dither);
+    if (ret != IM_STATUS_SUCCESS) {
+        LOGE("CPU 10-bit conversion failed: %d", ret);
+    }
+    return stats.finish(ret);
 }
 
 } // extern "C"
@@ -0,0 +1,386 @@
+#include "rga_afbc.h"
+
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/dma-buf.h>
+#include "rga_cpu.h"
+
+#define SUBBLOCKS ((RGA_AFBC_BLOCK / RGA_AFBC_SUBBLOCK) * (RGA_AFBC_BLOCK / RGA_AFBC_SUBBLOCK))
+#define CODE_RAW 1
+#define CODE_SOLID 2
+#define CODE_BITS 2
+
+typedef struct {
+    bool yuv;           /* 4:2:0 semi-planar, else one plane of pixelBytes */
+    int pixelBytes;
+    int rawBytes;       /* one raw subblock */
+    int solidBytes;     /* one element of a solid subblock */
+} Coding;
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    void *mapAddr;
+    int mapFd;
+} Bytes;
+
+static bool getCoding(int format, Coding *coding) {
+    const RgaFormatDesc *desc = rgaFormatFind(format);
+    if (desc == nullptr) {
+        return false;
+    }
+    if (desc->planeCount == 1 && desc->bits[0] >= 8 && desc->bits[0] % 8 == 0 && desc->xshift == 0) {
+        coding->yuv = false;
+        coding->pixelBytes = desc->bits[0] / 8;
+        coding->rawBytes = RGA_AFBC_SUBBLOCK * RGA_AFBC_SUBBLOCK * coding->pixelBytes;
+        coding->solidBytes = coding->pixelBytes;
+        return true;
+    }
+    if (desc->planeCount == 2 && desc->xshift == 1 && desc->yshift == 1 && !desc->tenBit) {
+        coding->yuv = true;
+        coding->pixelBytes = 1;
+        coding->rawBytes = RGA_AFBC_SUBBLOCK * RGA_AFBC_SUBBLOCK * 3 / 2;
+        coding->solidBytes = 3;
+        return true;
+    }
+    return false;
+}
+
+bool rgaAfbcSupported(int format) {
+    Coding coding;
+    return getCoding(format, &coding);
+}
+
+static IM_STATUS mapBytes(const rga_buffer_t &buf, Bytes *bytes) {
+    memset(bytes, 0, sizeof(Bytes));
+    bytes->mapFd = -1;
+    int wstride = buf.wstride > 0 ? buf.wstride : buf.width;
+    int hstride = buf.hstride > 0 ? buf.hstride : buf.height;
+    bytes->size = rgaFormatBufferSize(buf.format, wstride, hstride, IM_AFBC16x16_MODE);
+    if (bytes->size == 0) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    // Body offsets are 32-bit.
+    if (bytes->size > UINT32_MAX) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    bytes->data = (uint8_t *)buf.vir_addr;
+    if (bytes->data == nullptr && buf.fd > 0) {
+        void *addr = mmap(nullptr, bytes->size, PROT_READ | PROT_WRITE, MAP_SHARED, buf.fd, 0);
+        if (addr == MAP_FAILED) {
+            return IM_STATUS_OUT_OF_MEMORY;
+        }
+        struct dma_buf_sync sync = { DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW };
+        ioctl(buf.fd, DMA_BUF_IOCTL_SYNC, &sync);
+        bytes->mapAddr = addr;
+        bytes->mapFd = buf.fd;
+        bytes->data = (uint8_t *)addr;
+    }
+    return bytes->data != nullptr ? IM_STATUS_SUCCESS : IM_STATUS_INVALID_PARAM;
+}
+
+static void unmapBytes(Bytes *bytes) {
+    if (bytes->mapAddr != nullptr) {
+        struct dma_buf_sync sync = { DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW };
+        ioctl(bytes->mapFd, DMA_BUF_IOCTL_SYNC, &sync);
+        munmap(bytes->mapAddr, bytes->size);
+    }
+    bytes->mapAddr = nullptr;
+}
+
+static int getCode(const uint8_t *header, int i) {
+    int code = 0;
+    for (int b = 0; b < CODE_BITS; b++) {
+        int bit = 32 + i * CODE_BITS + b;
+        code |= ((header[bit >> 3] >> (bit & 7)) & 1) << b;
+    }
+    return code;
+}
+
+static void setCode(uint8_t *header, int i, int code) {
+    for (int b = 0; b < CODE_BITS; b++) {
+        int bit = 32 + i * CODE_BITS + b;
+        if (code & (1 << b)) {
+            header[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+        }
+    }
+}
+
+static uint32_t getWord(const uint8_t *bytes) {
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static void setWord(uint8_t *bytes, uint32_t word) {
+    bytes[0] = (uint8_t)word;
+    bytes[1] = (uint8_t)(word >> 8);
+    bytes[2] = (uint8_t)(word >> 16);
+    bytes[3] = (uint8_t)(word >> 24);
+}
+
+// Copy the subblock at pixel (x, y) out of img, replicating the right and bottom edges.
+static void gather(const Coding &coding, const RgaCpuImage &img, int x, int y, uint8_t *raw) {
+    const RgaCpuPlane &p0 = img.planes[0];
+    int pb = coding.pixelBytes;
+    for (int j = 0; j < RGA_AFBC_SUBBLOCK; j++) {
+        const uint8_t *row = p0.data + (size_t)std::min(y + j, img.height - 1) * p0.stride;
+        for (int i = 0; i < RGA_AFBC_SUBBLOCK; i++) {
+            memcpy(raw, row + (size_t)std::min(x + i, img.width - 1) * pb, pb);
+            raw += pb;
+        }
+    }
+    if (coding.yuv) {
+        const RgaCpuPlane &p1 = img.planes[1];
+        for (int j = 0; j < RGA_AFBC_SUBBLOCK / 2; j++) {
+            const uint8_t *row = p1.data + (size_t)std::min(y / 2 + j, p1.height - 1) * p1.stride;
+            for (int i = 0; i < RGA_AFBC_SUBBLOCK / 2; i++) {
+                memcpy(raw, row + (size_t)std::min(x / 2 + i, p1.width - 1) * 2, 2);
+                raw += 2;
+            }
+        }
+    }
+}
+
+// Inverse of gather(), dropping the pixels outside img.
+static void scatter(const Coding &coding, const RgaCpuImage &img, int x, int y, const uint8_t *raw) {
+    const RgaCpuPlane &p0 = img.planes[0];
+    int pb = coding.pixelBytes;
+    int w = std::min(RGA_AFBC_SUBBLOCK, img.width - x);
+    int h = std::min(RGA_AFBC_SUBBLOCK, img.height - y);
+    for (int j = 0; j < h; j++) {
+        if (w > 0) {
+            memcpy(p0.data + (size_t)(y + j) * p0.stride + (size_t)x * pb, raw + j * RGA_AFBC_SUBBLOCK * pb, w * pb);
+        }
+    }
+    if (coding.yuv) {
+        const RgaCpuPlane &p1 = img.planes[1];
+        const uint8_t *chroma = raw + RGA_AFBC_SUBBLOCK * RGA_AFBC_SUBBLOCK;
+        for (int j = 0; j < h / 2; j++) {
+            if (w > 0) {
+                memcpy(p1.data + (size_t)(y / 2 + j) * p1.stride + (size_t)x, chroma + j * RGA_AFBC_SUBBLOCK, w);
+            }
+        }
+    }
+}
+
+// Whether every element of raw is equal; the element goes to solid.
+static bool isSolid(const Coding &coding, const uint8_t *raw, uint8_t *solid) {
+    int pb = coding.pixelBytes;
+    int luma = RGA_AFBC_SUBBLOCK * RGA_AFBC_SUBBLOCK * pb;
+    for (int i = pb; i < luma; i += pb) {
+        if (memcmp(raw, raw + i, pb) != 0) {
+            return false;
+        }
+    }
+    memcpy(solid, raw, pb);
+    if (coding.yuv) {
+        const uint8_t *chroma = raw + luma;
+        for (int i = 2; i < coding.rawBytes - luma; i += 2) {
+            if (chroma[i] != chroma[0] || chroma[i + 1] != chroma[1]) {
+                return false;
+            }
+        }
+        solid[1] = chroma[0];
+        solid[2] = chroma[1];
+    }
+    return true;
+}
+
+static void expandSolid(const Coding &coding, const uint8_t *solid, uint8_t *raw) {
+    int pb = coding.pixelBytes;
+    int luma = RGA_AFBC_SUBBLOCK * RGA_AFBC_SUBBLOCK * pb;
+    for (int i = 0; i < luma; i += pb) {
+        memcpy(raw + i, solid, pb);
+    }
+    for (int i = luma; i < coding.rawBytes; i += 2) {
+        raw[i] = solid[1];
+        raw[i + 1] = solid[2];
+    }
+}
+
+static bool sameImage(const rga_buffer_t &a, const rga_buffer_t &b) {
+    return a.width == b.width && a.height == b.height && rgaFormatNormalize(a.format) == rgaFormatNormalize(b.format);
+}
+
+IM_STATUS rgaAfbcEncode(const rga_buffer_t &raster, const rga_buffer_t &afbc, RgaAfbcStats *stats) {
+    Coding coding;
+    if (!getCoding(afbc.format, &coding) || afbc.rd_mode != IM_AFBC16x16_MODE) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    if (!sameImage(raster, afbc)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    RgaCpuImage img;
+    IM_STATUS ret = rgaCpuMapImage(raster, &img);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    Bytes out;
+    ret = mapBytes(afbc, &out);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&img);
+        return ret;
+    }
+
+    int wstride = afbc.wstride > 0 ? afbc.wstride : afbc.width;
+    int hstride = afbc.hstride > 0 ? afbc.hstride : afbc.height;
+    int cols = (wstride + RGA_AFBC_BLOCK - 1) / RGA_AFBC_BLOCK;
+    int rows = (hstride + RGA_AFBC_BLOCK - 1) / RGA_AFBC_BLOCK;
+    size_t headerBytes = (size_t)cols * rows * RGA_FORMAT_FBC_HEADER_BYTES;
+    headerBytes = (headerBytes + RGA_FORMAT_FBC_HEADER_ALIGN - 1) / RGA_FORMAT_FBC_HEADER_ALIGN *
+                  RGA_FORMAT_FBC_HEADER_ALIGN;
+    memset(out.data, 0, headerBytes);
+
+    // Bodies are built per superblock row in parallel, with offsets relative to
+    // the row, then packed behind each other.
+    std::vector<std::vector<uint8_t>> bodies(rows);
+    std::atomic<int64_t> solidBlocks(0);
+    rgaCpuParallelFor(rows, [&](int begin, int end) {
+        uint8_t raw[SUBBLOCKS][RGA_AFBC_SUBBLOCK * RGA_AFBC_SUBBLOCK * 4];
+        uint8_t solid[SUBBLOCKS][4];
+        bool solidSub[SUBBLOCKS];
+        for (int r = begin; r < end; r++) {
+            std::vector<uint8_t> &body = bodies[r];
+            for (int c = 0; c < cols; c++) {
+                uint8_t *header = out.data + ((size_t)r * cols + c) * RGA_FORMAT_FBC_HEADER_BYTES;
+                setWord(header + 12, RGA_AFBC_SOFT_TAG);
+                bool uniform = true;
+                for (int s = 0; s < SUBBLOCKS; s++) {
+                    int x = c * RGA_AFBC_BLOCK + s % (RGA_AFBC_BLOCK / RGA_AFBC_SUBBLOCK) * RGA_AFBC_SUBBLOCK;
+                    int y = r * RGA_AFBC_BLOCK + s / (RGA_AFBC_BLOCK / RGA_AFBC_SUBBLOCK) * RGA_AFBC_SUBBLOCK;
+                    gather(coding, img, std::min(x, img.width - 1), std::min(y, img.height - 1), raw[s]);
+                    solidSub[s] = isSolid(coding, raw[s], solid[s]);
+                    uniform = uniform && solidSub[s] && memcmp(solid[s], solid[0], coding.solidBytes) == 0;
+                }
+                if (uniform) {
+                    memcpy(header + 8, solid[0], coding.solidBytes);
+                    solidBlocks++;
+                    continue;
+                }
+                setWord(header, (uint32_t)body.size());
+                for (int s = 0; s < SUBBLOCKS; s++) {
+                    setCode(header, s, solidSub[s] ? CODE_SOLID : CODE_RAW);
+                    if (solidSub[s]) {
+                        body.insert(body.end(), solid[s], solid[s] + coding.solidBytes);
+                    } else {
+                        body.insert(body.end(), raw[s], raw[s] + coding.rawBytes);
+                    }
+                }
+            }
+        }
+    });
+
+    size_t offset = headerBytes;
+    for (int r = 0; r < rows; r++) {
+        memcpy(out.data + offset, bodies[r].data(), bodies[r].size());
+        for (int c = 0; c < cols; c++) {
+            uint8_t *header = out.data + ((size_t)r * cols + c) * RGA_FORMAT_FBC_HEADER_BYTES;
+            // Solid superblocks keep their subblock codes (and offset) zero.
+            if (getCode(header, 0) != 0) {
+                setWord(header, getWord(header) + (uint32_t)offset);
+            }
+        }
+        offset += bodies[r].size();
+    }
+
+    if (stats != nullptr) {
+        stats->blocks = (int64_t)cols * rows;
+        stats->solidBlocks = solidBlocks;
+        stats->headerBytes = (int64_t)headerBytes;
+        stats->bodyBytes = (int64_t)(offset - headerBytes);
+        stats->rasterBytes = (int64_t)rgaFormatImageSize(afbc.format, afbc.width, afbc.height);
+    }
+    unmapBytes(&out);
+    rgaCpuUnmapImage(&img);
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS rgaAfbcDecode(const rga_buffer_t &afbc, const rga_buffer_t &raster) {
+    Coding coding;
+    if (!getCoding(afbc.format, &coding) || afbc.rd_mode != IM_AFBC16x16_MODE) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    if (!sameImage(raster, afbc)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    RgaCpuImage img;
+    IM_STATUS ret = rgaCpuMapImage(raster, &img);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    Bytes in;
+    ret = mapBytes(afbc, &in);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&img);
+        return ret;
+    }
+
+    int wstride = afbc.wstride > 0 ? afbc.wstride : afbc.width;
+    int hstride = afbc.hstride > 0 ? afbc.hstride : afbc.height;
+    int cols = (wstride + RGA_AFBC_BLOCK - 1) / RGA_AFBC_BLOCK;
+    int rows = (hstride + RGA_AFBC_BLOCK - 1) / RGA_AFBC_BLOCK;
+    size_t headerBytes = (size_t)cols * rows * RGA_FORMAT_FBC_HEADER_BYTES;
+    // Only the superblocks overlapping the image are decoded.
+    int usedCols = std::min(cols, (img.width + RGA_AFBC_BLOCK - 1) / RGA_AFBC_BLOCK);
+    int usedRows = std::min(rows, (img.height + RGA_AFBC_BLOCK - 1) / RGA_AFBC_BLOCK);
+
+    // Refuse foreign AFBC before writing anything to raster.
+    bool foreign = false;
+    for (int r = 0; r < usedRows && !foreign; r++) {
+        for (int c = 0; c < usedCols && !foreign; c++) {
+            const uint8_t *header = in.data + ((size_t)r * cols + c) * RGA_FORMAT_FBC_HEADER_BYTES;
+            foreign = getWord(header + 12) != RGA_AFBC_SOFT_TAG;
+        }
+    }
+    if (foreign) {
+        unmapBytes(&in);
+        rgaCpuUnmapImage(&img);
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    std::atomic<bool> corrupt(false);
+    rgaCpuParallelFor(usedRows, [&](int begin, int end) {
+        uint8_t raw[RGA_AFBC_SUBBLOCK * RGA_AFBC_SUBBLOCK * 4];
+        for (int r = begin; r < end && !corrupt; r++) {
+            for (int c = 0; c < usedCols; c++) {
+                const uint8_t *header = in.data + ((size_t)r * cols + c) * RGA_FORMAT_FBC_HEADER_BYTES;
+                size_t offset = getWord(header);
+                const uint8_t *body = in.data + offset;
+                if (offset != 0 && offset < headerBytes) {
+                    corrupt = true;
+                    break;
+                }
+                for (int s = 0; s < SUBBLOCKS; s++) {
+                    int x = c * RGA_AFBC_BLOCK + s % (RGA_AFBC_BLOCK / RGA_AFBC_SUBBLOCK) * RGA_AFBC_SUBBLOCK;
+                    int y = r * RGA_AFBC_BLOCK + s / (RGA_AFBC_BLOCK / RGA_AFBC_SUBBLOCK) * RGA_AFBC_SUBBLOCK;
+                    int code = offset == 0 ? CODE_SOLID : getCode(header, s);
+                    size_t bytes = code == CODE_RAW ? coding.rawBytes : coding.solidBytes;
+                    const uint8_t *data = offset == 0 ? header + 8 : body;
+                    if ((code != CODE_RAW && code != CODE_SOLID) || (offset != 0 && offset + bytes > in.size)) {
+                        corrupt = true;
+                        break;
+                    }
+                    if (code == CODE_RAW) {
+                        memcpy(raw, data, bytes);
+                    } else {
+                        expandSolid(coding, data, raw);
+                    }
+                    if (offset != 0) {
+                        body += bytes;
+                        offset += bytes;
+                    }
+                    if (x < img.width && y < img.height) {
+                        scatter(coding, img, x, y, raw);
+                    }
+                }
+            }
+        }
+    });
+
+    unmapBytes(&in);
+    rgaCpuUnmapImage(&img);
+    return corrupt ? IM_STATUS_FAILED : IM_STATUS_SUCCESS;
+}
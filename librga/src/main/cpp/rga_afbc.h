@@ -0,0 +1,61 @@
+#ifndef _rga_afbc_h_
+#define _rga_afbc_h_
+
+#include <stdint.h>
+#include "im2d_type.h"
+
+/*
+ * CPU reference for IM_AFBC16x16_MODE buffers, to check rd_mode plumbing and
+ * measure the bandwidth an AFBC source or destination saves on a Linux host.
+ *
+ * The buffer layout follows AFBC: a header area of 16 bytes per 16x16
+ * superblock (RGA_FORMAT_FBC_HEADER_*), then the superblock bodies, each split
+ * into 16 4x4 subblocks in raster order. The subblock coding is deliberately
+ * simple and is not bit-compatible with the hardware encoder:
+ *
+ *   header bytes 0..3    body offset from the buffer start, little endian;
+ *                        0 = solid superblock, colour in bytes 8..11
+ *   header bytes 4..7    16 x 2-bit subblock codes, LSB first:
+ *                        1 = raw, 2 = solid (one element)
+ *   header bytes 12..15  RGA_AFBC_SOFT_TAG, little endian
+ *
+ * A raw subblock holds 16 pixels, or for YUV 4:2:0 semi-planar 16 luma bytes
+ * followed by 4 chroma pairs. Supported formats are single-plane formats with
+ * whole-byte pixels and 8-bit YUV 4:2:0 semi-planar.
+ *
+ * Only buffers written by rgaAfbcEncode can be decoded. AFBC from the hardware
+ * or a video decoder lacks the tag and is refused with IM_STATUS_NOT_SUPPORTED
+ * rather than decoded into garbage, so the software backend cannot read such
+ * buffers, and its AFBC output cannot be handed to the hardware.
+ *
+ * Buffers are sized with rgaFormatBufferSize(format, wstride, hstride,
+ * IM_AFBC16x16_MODE); the superblock grid covers wstride x hstride.
+ */
+
+#define RGA_AFBC_BLOCK 16
+#define RGA_AFBC_SUBBLOCK 4
+#define RGA_AFBC_SOFT_TAG 0x53414752u /* "RGAS" */
+
+typedef struct {
+    int64_t blocks;         /* superblocks */
+    int64_t solidBlocks;    /* stored in their header alone */
+    int64_t headerBytes;    /* header area, with padding */
+    int64_t bodyBytes;      /* bodies actually written */
+    int64_t rasterBytes;    /* the same image uncompressed */
+} RgaAfbcStats;
+
+bool rgaAfbcSupported(int format);
+
+/*
+ * Compress raster (rd_mode raster) into afbc (rd_mode IM_AFBC16x16_MODE, same
+ * size and format). stats may be null.
+ */
+IM_STATUS rgaAfbcEncode(const rga_buffer_t &raster, const rga_buffer_t &afbc, RgaAfbcStats *stats);
+
+/*
+ * Expand afbc into raster. A header without RGA_AFBC_SOFT_TAG fails with
+ * IM_STATUS_NOT_SUPPORTED, a corrupt one with IM_STATUS_FAILED.
+ */
+IM_STATUS rgaAfbcDecode(const rga_buffer_t &afbc, const rga_buffer_t &raster);
+
+#endif
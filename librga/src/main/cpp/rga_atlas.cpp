@@ -0,0 +1,132 @@
+#include "rga_atlas.h"
+
+#include <algorithm>
+#include <vector>
+#include "rga_backend.h"
+
+// One run of the skyline: the atlas is filled up to y over [x, x + width).
+typedef struct {
+    int x;
+    int y;
+    int width;
+} Segment;
+
+static int alignUp(int v, int align) {
+    return (v + align - 1) / align * align;
+}
+
+static bool isEmptyRect(const im_rect &r) {
+    return r.width <= 0 || r.height <= 0;
+}
+
+// Lowest y for a span of width starting at segment i.
+static int spanTop(const std::vector<Segment> &sky, size_t i, int width) {
+    int y = 0;
+    for (size_t j = i; j < sky.size() && width > 0; j++) {
+        y = std::max(y, sky[j].y);
+        width -= sky[j].width;
+    }
+    return y;
+}
+
+// Raise [x, x + width) to y and merge neighbours of equal height.
+static void raise(std::vector<Segment> &sky, size_t i, int width, int y) {
+    int x = sky[i].x;
+    int end = x + width;
+    size_t j = i;
+    while (j < sky.size() && sky[j].x + sky[j].width <= end) {
+        j++;
+    }
+    if (j < sky.size() && sky[j].x < end) {
+        sky[j].width -= end - sky[j].x;
+        sky[j].x = end;
+    }
+    sky.erase(sky.begin() + i, sky.begin() + j);
+    sky.insert(sky.begin() + i, Segment{x, y, width});
+    for (size_t k = 0; k + 1 < sky.size();) {
+        if (sky[k].y == sky[k + 1].y) {
+            sky[k].width += sky[k + 1].width;
+            sky.erase(sky.begin() + k + 1);
+        } else {
+            k++;
+        }
+    }
+}
+
+int rgaAtlasPack(int width, int height, const RgaAtlasItem *items, int count, int padding, int align,
+                 im_rect *rects) {
+    if (width <= 0 || height <= 0 || count < 0 || padding < 0) {
+        return -1;
+    }
+    if (align < 1) {
+        align = 1;
+    }
+    std::vector<int> order(count);
+    for (int i = 0; i < count; i++) {
+        if (items[i].width <= 0 || items[i].height <= 0) {
+            return -1;
+        }
+        order[i] = i;
+    }
+    // Tallest first keeps the skyline flat.
+    std::stable_sort(order.begin(), order.end(), [items](int a, int b) {
+        return items[a].height != items[b].height ? items[a].height > items[b].height
+                                                  : items[a].width > items[b].width;
+    });
+
+    std::vector<Segment> sky(1, Segment{0, 0, width});
+    int used = 0;
+    for (int index : order) {
+        const RgaAtlasItem &item = items[index];
+        int bestSegment = -1, bestY = 0, bestSpan = 0;
+        for (size_t i = 0; i < sky.size(); i++) {
+            int x = sky[i].x;
+            if (x + item.width > width) {
+                break;
+            }
+            // The padding may run past the right edge, the item itself may not.
+            int span = std::min(alignUp(item.width + padding, align), width - x);
+            int y = spanTop(sky, i, span);
+            if (y + item.height > height) {
+                continue;
+            }
+            if (bestSegment < 0 || y < bestY) {
+                bestSegment = (int)i;
+                bestY = y;
+                bestSpan = span;
+            }
+        }
+        if (bestSegment < 0) {
+            return -1;
+        }
+        rects[index] = im_rect{sky[bestSegment].x, bestY, item.width, item.height};
+        used = std::max(used, bestY + item.height);
+        raise(sky, bestSegment, bestSpan, bestY + alignUp(item.height + padding, align));
+    }
+    return used;
+}
+
+IM_STATUS rgaAtlasBuild(const RgaAtlasItem *items, const im_rect *rects, int count, const rga_buffer_t &atlas,
+                        im_opt_t *opt) {
+    for (int first = 0; first < count; first += RGA_JOB_MAX_TASKS) {
+        int last = std::min(count, first + RGA_JOB_MAX_TASKS);
+        im_job_handle_t job = rgaBeginJob(0);
+        if (job == 0) {
+            return IM_STATUS_FAILED;
+        }
+        for (int i = first; i < last; i++) {
+            const RgaAtlasItem &item = items[i];
+            im_rect srect = isEmptyRect(item.srect) ? im_rect{0, 0, item.src.width, item.src.height} : item.srect;
+            IM_STATUS ret = rgaProcessTask("atlas", job, item.src, atlas, {}, srect, rects[i], {}, opt, 0);
+            if (ret != IM_STATUS_SUCCESS) {
+                rgaCancelJob(job);
+                return ret;
+            }
+        }
+        IM_STATUS ret = rgaEndJob(job, IM_SYNC, -1, NULL);
+        if (ret != IM_STATUS_SUCCESS) {
+            return ret;
+        }
+    }
+    return IM_STATUS_SUCCESS;
+}
@@ -0,0 +1,33 @@
+#ifndef _rga_atlas_h_
+#define _rga_atlas_h_
+
+#include <stdint.h>
+#include "im2d_type.h"
+
+/*
+ * Atlas batching for many small resizes/copies (thumbnail strips, sprite
+ * sheets). The items are packed into one atlas image with a skyline
+ * bottom-left packer, tallest first, and scaled in as few RGA jobs as possible,
+ * one task per item with its own srect/drect. Item i ends up in rects[i].
+ */
+
+typedef struct {
+    rga_buffer_t src;
+    im_rect srect;      /* empty = whole image */
+    int width;          /* size in the atlas */
+    int height;
+} RgaAtlasItem;
+
+/*
+ * Place count items into a width x height atlas, padding pixels apart, with
+ * positions rounded up to align (the atlas format's rectAlign). Returns the
+ * atlas height used, or -1 if the items do not fit.
+ */
+int rgaAtlasPack(int width, int height, const RgaAtlasItem *items, int count, int padding, int align,
+                 im_rect *rects);
+
+/* Scale item i into rects[i] of atlas. */
+IM_STATUS rgaAtlasBuild(const RgaAtlasItem *items, const im_rect *rects, int count, const rga_buffer_t &atlas,
+                        im_opt_t *opt);
+
+#endif
@@ -0,0 +1,92 @@
+#include "rga_backend.h"
+
+#include "rga_crossover.h"
+#include "rga_soft.h"
+#include "rga_trace.h"
+
+#if !defined(RGA_SOFTWARE_BACKEND)
+#include "im2d.h"
+#endif
+
+static inline int optCore(const im_opt_t *opt) {
+    return opt != nullptr ? opt->core : 0;
+}
+
+IM_STATUS rgaProcess(const char *name, const rga_buffer_t &src, const rga_buffer_t &dst,
+                     const rga_buffer_t &pat, const im_rect &srect, const im_rect &drect,
+                     const im_rect &prect, int acquireFence, int *releaseFence,
+                     im_opt_t *opt, int usage) {
+    return rgaProcessOn(RGA_ENGINE_AUTO, name, src, dst, pat, srect, drect, prect, acquireFence, releaseFence,
+                        opt, usage);
+}
+
+IM_STATUS rgaProcessOn(RgaEngine engine, const char *name, const rga_buffer_t &src, const rga_buffer_t &dst,
+                       const rga_buffer_t &pat, const im_rect &srect, const im_rect &drect,
+                       const im_rect &prect, int acquireFence, int *releaseFence,
+                       im_opt_t *opt, int usage) {
+#if !defined(RGA_SOFTWARE_BACKEND)
+    if (engine == RGA_ENGINE_AUTO &&
+        rgaCrossoverPreferCpu(src, dst, pat, srect, drect, acquireFence, usage)) {
+        engine = RGA_ENGINE_CPU;
+    }
+    if (engine != RGA_ENGINE_CPU) {
+        RgaTraceScope trace(name, 0, &src, &dst, usage, optCore(opt));
+        return trace.finish(improcess(src, dst, pat, srect, drect, prect, acquireFence, releaseFence, opt,
+                                      usage));
+    }
+#else
+    (void)engine;
+    (void)acquireFence;
+    (void)opt;
+#endif
+    // The CPU finishes before returning, so there is no fence to hand back.
+    RgaTraceScope trace(name, 0, &src, &dst, usage, 0);
+    if (releaseFence != nullptr) {
+        *releaseFence = -1;
+    }
+    return trace.finish(rgaSoftProcess(src, dst, pat, srect, drect, prect, usage));
+}
+
+im_job_handle_t rgaBeginJob(uint64_t flags) {
+#if defined(RGA_SOFTWARE_BACKEND)
+    im_job_handle_t job = rgaSoftBeginJob(flags);
+#else
+    im_job_handle_t job = imbeginJob(flags);
+#endif
+    RgaTraceScope trace("beginJob", job, nullptr, nullptr, 0, 0);
+    return job;
+}
+
+IM_STATUS rgaProcessTask(const char *name, im_job_handle_t job,
+                         const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                         const im_rect &srect, const im_rect &drect, const im_rect &prect,
+                         im_opt_t *opt, int usage) {
+    RgaTraceScope trace(name, job, &src, &dst, usage, optCore(opt));
+#if defined(RGA_SOFTWARE_BACKEND)
+    return trace.finish(rgaSoftProcessTask(job, src, dst, pat, srect, drect, prect, usage));
+#else
+    return trace.finish(improcessTask(job, src, dst, pat, srect, drect, prect, opt, usage));
+#endif
+}
+
+IM_STATUS rgaEndJob(im_job_handle_t job, int syncMode, int acquireFence, int *releaseFence) {
+    RgaTraceScope trace("endJob", job, nullptr, nullptr, syncMode, 0);
+#if defined(RGA_SOFTWARE_BACKEND)
+    (void)acquireFence;
+    if (releaseFence != nullptr) {
+        *releaseFence = -1;
+    }
+    return trace.finish(rgaSoftEndJob(job));
+#else
+    return trace.finish(imendJob(job, syncMode, acquireFence, releaseFence));
+#endif
+}
+
+IM_STATUS rgaCancelJob(im_job_handle_t job) {
+    RgaTraceScope trace("cancelJob", job, nullptr, nullptr, 0, 0);
+#if defined(RGA_SOFTWARE_BACKEND)
+    return trace.finish(rgaSoftCancelJob(job));
+#else
+    return trace.finish(imcancelJob(job));
+#endif
+}
@@ -0,0 +1,46 @@
+#ifndef _rga_backend_h_
+#define _rga_backend_h_
+
+#include <stdint.h>
+#include "im2d_type.h"
+
+/*
+ * Single submission point for all RGA work issued by the wrapper. Every call is
+ * traced (see rga_trace.h) under the given name and forwarded to librga, or to
+ * the software implementation in rga_soft.h when built with RGA_SOFTWARE_BACKEND
+ * (host builds without an RGA). The software backend ignores opt and fences and
+ * always completes before returning; *releaseFence is set to -1.
+ *
+ * On the RGA, rgaProcess runs small calls on the CPU instead when the
+ * calibrated crossover table says that is faster (see rga_crossover.h).
+ */
+
+typedef enum {
+    RGA_ENGINE_AUTO = 0,    /* follow the crossover table */
+    RGA_ENGINE_RGA,
+    RGA_ENGINE_CPU,         /* rga_soft.h kernels */
+} RgaEngine;
+
+IM_STATUS rgaProcess(const char *name, const rga_buffer_t &src, const rga_buffer_t &dst,
+                     const rga_buffer_t &pat, const im_rect &srect, const im_rect &drect,
+                     const im_rect &prect, int acquireFence, int *releaseFence,
+                     im_opt_t *opt, int usage);
+
+/* rgaProcess on the given engine; host builds always use the CPU. */
+IM_STATUS rgaProcessOn(RgaEngine engine, const char *name, const rga_buffer_t &src, const rga_buffer_t &dst,
+                       const rga_buffer_t &pat, const im_rect &srect, const im_rect &drect,
+                       const im_rect &prect, int acquireFence, int *releaseFence,
+                       im_opt_t *opt, int usage);
+
+/* librga rejects jobs with more tasks than this (RGA_TASK_NUM_MAX); larger batches are split into several jobs. */
+#define RGA_JOB_MAX_TASKS 50
+
+im_job_handle_t rgaBeginJob(uint64_t flags);
+IM_STATUS rgaProcessTask(const char *name, im_job_handle_t job,
+                         const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                         const im_rect &srect, const im_rect &drect, const im_rect &prect,
+                         im_opt_t *opt, int usage);
+IM_STATUS rgaEndJob(im_job_handle_t job, int syncMode, int acquireFence, int *releaseFence);
+IM_STATUS rgaCancelJob(im_job_handle_t job);
+
+#endif
@@ -0,0 +1,262 @@
+#include "rga_compositor.h"
+
+#include <string.h>
+#include <algorithm>
+#include "rga_backend.h"
+#include "rga_cpu.h"
+
+// Frames of damage kept; a dst buffer older than this is redrawn in full.
+#define RGA_COMPOSITOR_MAX_AGE 4
+
+static bool sameRect(const im_rect &a, const im_rect &b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+static bool sameLayer(const RgaLayer &a, const RgaLayer &b) {
+    const rga_buffer_t &x = a.buffer;
+    const rga_buffer_t &y = b.buffer;
+    return x.vir_addr == y.vir_addr && x.phy_addr == y.phy_addr && x.fd == y.fd &&
+           x.width == y.width && x.height == y.height && x.wstride == y.wstride &&
+           x.hstride == y.hstride && x.format == y.format &&
+           sameRect(a.srect, b.srect) && sameRect(a.drect, b.drect) && a.transform == b.transform &&
+           a.alpha == b.alpha && a.zorder == b.zorder && a.blend == b.blend;
+}
+
+static uint64_t bufferKey(const rga_buffer_t &buf) {
+    if (buf.fd > 0) {
+        return (uint64_t)buf.fd;
+    }
+    return (uint64_t)(uintptr_t)(buf.vir_addr != NULL ? buf.vir_addr : buf.phy_addr) | (1ULL << 63);
+}
+
+RgaCompositor::RgaCompositor(int width, int height, int core)
+    : mWidth(width), mHeight(height), mCore(core) {
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+RgaCompositor::Entry *RgaCompositor::find(int id) {
+    for (Entry &entry : mLayers) {
+        if (entry.id == id) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void RgaCompositor::damage(const im_rect &rect) {
+    rgaRegionAdd(mDamage, rgaRectIntersect(rect, {0, 0, mWidth, mHeight}));
+}
+
+IM_STATUS RgaCompositor::setLayer(int id, const RgaLayer &layer) {
+    RgaLayer l = layer;
+    if (rgaRectEmpty(l.srect)) {
+        l.srect = {0, 0, l.buffer.width, l.buffer.height};
+    }
+    const im_rect &s = l.srect;
+    const im_rect &d = l.drect;
+    if (rgaRectEmpty(d) || s.x < 0 || s.y < 0 || s.x + s.width > l.buffer.width ||
+        s.y + s.height > l.buffer.height || d.x < 0 || d.y < 0 || d.x + d.width > mWidth ||
+        d.y + d.height > mHeight || l.alpha < 0 || l.alpha > 255) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    Entry *entry = find(id);
+    if (entry == nullptr) {
+        mLayers.push_back({id, mNextOrder++, l});
+        damage(d);
+    } else if (!sameLayer(entry->layer, l)) {
+        damage(entry->layer.drect);
+        damage(d);
+        entry->layer = l;
+    }
+    return IM_STATUS_SUCCESS;
+}
+
+void RgaCompositor::removeLayer(int id) {
+    for (size_t i = 0; i < mLayers.size(); i++) {
+        if (mLayers[i].id == id) {
+            damage(mLayers[i].layer.drect);
+            mLayers.erase(mLayers.begin() + i);
+            return;
+        }
+    }
+}
+
+void RgaCompositor::damageLayer(int id) {
+    Entry *entry = find(id);
+    if (entry != nullptr) {
+        damage(entry->layer.drect);
+    }
+}
+
+void RgaCompositor::setBackground(uint32_t color) {
+    if (color != mBackground) {
+        mBackground = color;
+        damage({0, 0, mWidth, mHeight});
+    }
+}
+
+IM_STATUS RgaCompositor::compose(const rga_buffer_t &dst) {
+    if (dst.width != mWidth || dst.height != mHeight) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    const im_rect full = {0, 0, mWidth, mHeight};
+    int grid = rgaRegionGrid(dst.format);
+    memset(&mStats, 0, sizeof(mStats));
+
+    // What changed since dst was last composed.
+    uint64_t key = bufferKey(dst);
+    auto age = mAges.find(key);
+    RgaRegion raw;
+    if (age == mAges.end() || mFrame - age->second > mHistory.size()) {
+        raw.push_back(full);
+    } else {
+        raw = mDamage;
+        for (size_t i = mHistory.size() - (size_t)(mFrame - age->second); i < mHistory.size(); i++) {
+            rgaRegionAddRegion(raw, mHistory[i]);
+        }
+    }
+    RgaRegion damage;
+    for (const im_rect &r : raw) {
+        rgaRegionAdd(damage, rgaRectSnapOut(r, grid, full));
+    }
+
+    std::vector<const Entry *> layers;
+    for (const Entry &entry : mLayers) {
+        if (entry.layer.alpha > 0) {
+            layers.push_back(&entry);
+        }
+    }
+    std::sort(layers.begin(), layers.end(), [](const Entry *a, const Entry *b) {
+        return a->layer.zorder != b->layer.zorder ? a->layer.zorder < b->layer.zorder : a->order < b->order;
+    });
+    int count = (int)layers.size();
+    std::vector<im_rect> occluders(count);
+    for (int i = 0; i < count; i++) {
+        const RgaLayer &l = layers[i]->layer;
+        occluders[i] = l.alpha == 255 && !l.blend ? rgaRectSnapIn(l.drect, grid) : im_rect{0, 0, 0, 0};
+    }
+
+    // Visible damaged pieces of each layer. A piece that cannot be drawn on its
+    // own (scaled up, odd YUV source offset, ...) makes the layer draw whole,
+    // which turns its rect into damage and may pull in more layers, so repeat
+    // until the damage stops growing.
+    std::vector<bool> whole(count, false);
+    std::vector<RgaRegion> pieces(count);
+    std::vector<std::vector<im_rect>> sources(count);
+    for (bool grown = true; grown;) {
+        grown = false;
+        for (int i = 0; i < count && !grown; i++) {
+            const RgaLayer &l = layers[i]->layer;
+            pieces[i] = rgaRegionClip(damage, l.drect);
+            for (int j = i + 1; j < count && !pieces[i].empty(); j++) {
+                rgaRegionSubtract(pieces[i], occluders[j]);
+            }
+            sources[i].clear();
+            int srcGrid = rgaRegionGrid(l.buffer.format);
+            for (const im_rect &piece : pieces[i]) {
+                im_rect src;
+                if (whole[i] || !rgaRectMapToSource(piece, l.srect, l.drect, l.transform, &src) ||
+                    src.x % srcGrid != 0 || src.y % srcGrid != 0 ||
+                    src.width % srcGrid != 0 || src.height % srcGrid != 0) {
+                    whole[i] = true;
+                    break;
+                }
+                sources[i].push_back(src);
+            }
+            if (whole[i] && !pieces[i].empty()) {
+                RgaRegion outside(1, rgaRectSnapOut(l.drect, grid, full));
+                for (const im_rect &r : damage) {
+                    rgaRegionSubtract(outside, r);
+                }
+                if (!outside.empty()) {
+                    rgaRegionAddRegion(damage, outside);
+                    grown = true;
+                }
+                pieces[i].assign(1, l.drect);
+                sources[i].assign(1, l.srect);
+            }
+        }
+    }
+
+    // The background shows where no opaque layer covers the damage. RGA3 has no
+    // color fill, so it is filled on the CPU before the job.
+    RgaRegion background = damage;
+    for (int i = 0; i < count; i++) {
+        rgaRegionSubtract(background, occluders[i]);
+    }
+    if (!background.empty()) {
+        IM_STATUS ret = rgaCpuFill(dst, background.data(), (int)background.size(), mBackground);
+        if (ret != IM_STATUS_SUCCESS) {
+            mAges.erase(key);
+            return ret;
+        }
+    }
+    mStats.layers = (int)mLayers.size();
+    mStats.damagePixels = rgaRegionArea(damage);
+    mStats.pixelsDrawn = rgaRegionArea(background);
+    mStats.pixelsFull = (int64_t)mWidth * mHeight;
+
+    im_opt_t opt = {};
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = mCore;
+
+    // Tasks go into jobs of up to RGA_JOB_MAX_TASKS, ended in order so later layers still blend over earlier ones.
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+    im_job_handle_t job = 0;
+    int jobTasks = 0;
+    for (int i = 0; i < count && ret == IM_STATUS_SUCCESS; i++) {
+        const RgaLayer &l = layers[i]->layer;
+        mStats.pixelsFull += (int64_t)l.drect.width * l.drect.height;
+        if (pieces[i].empty()) {
+            continue;
+        }
+        rga_buffer_t src = l.buffer;
+        src.global_alpha = l.alpha;
+        int usage = l.transform | (l.blend || l.alpha < 255 ? IM_ALPHA_BLEND_SRC_OVER : 0);
+        for (size_t p = 0; p < pieces[i].size() && ret == IM_STATUS_SUCCESS; p++) {
+            if (jobTasks == RGA_JOB_MAX_TASKS) {
+                ret = rgaEndJob(job, IM_SYNC, 0, NULL);
+                job = 0;
+                if (ret != IM_STATUS_SUCCESS) {
+                    break;
+                }
+            }
+            if (job == 0) {
+                if ((job = rgaBeginJob(0)) == 0) {
+                    ret = IM_STATUS_FAILED;
+                    break;
+                }
+                jobTasks = 0;
+            }
+            ret = rgaProcessTask("compositor", job, src, dst, {}, sources[i][p], pieces[i][p], {}, &opt, usage);
+            jobTasks++;
+            mStats.tasks++;
+        }
+        mStats.layersDrawn++;
+        mStats.pixelsDrawn += rgaRegionArea(pieces[i]);
+    }
+    mStats.layersCulled = mStats.layers - mStats.layersDrawn;
+    if (job != 0) {
+        if (ret == IM_STATUS_SUCCESS) {
+            ret = rgaEndJob(job, IM_SYNC, 0, NULL);
+        } else {
+            rgaCancelJob(job);
+        }
+    }
+    if (ret != IM_STATUS_SUCCESS) {
+        mAges.erase(key);
+        return ret;
+    }
+
+    mHistory.push_back(mDamage);
+    if (mHistory.size() > RGA_COMPOSITOR_MAX_AGE) {
+        mHistory.erase(mHistory.begin());
+    }
+    mDamage.clear();
+    mFrame++;
+    mAges[key] = mFrame;
+    for (auto it = mAges.begin(); it != mAges.end();) {
+        it = mFrame - it->second > RGA_COMPOSITOR_MAX_AGE ? mAges.erase(it) : std::next(it);
+    }
+    return IM_STATUS_SUCCESS;
+}
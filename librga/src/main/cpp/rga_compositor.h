@@ -0,0 +1,97 @@
+#ifndef _rga_compositor_h_
+#define _rga_compositor_h_
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+#include "im2d_type.h"
+#include "rga_region.h"
+
+/*
+ * Composes a list of layers (video streams, overlays) onto one output frame
+ * as one RGA job: one improcessTask per visible layer piece, in z order,
+ * with a new job every RGA_JOB_MAX_TASKS tasks.
+ *
+ * Work is limited in two ways:
+ *  - occlusion: parts of a layer under an opaque layer are not drawn, and the
+ *    background is only filled where no opaque layer covers the output;
+ *  - caching: only the damage since the destination buffer was last composed
+ *    is redrawn (like EGL buffer age), so with double buffering an unchanged
+ *    layer costs nothing. A layer is damaged by setLayer() when its geometry
+ *    or buffer changes and by damageLayer() when its content changes.
+ *
+ * A layer is drawn piecewise only if the piece maps exactly onto source pixels
+ * (see rgaRectMapToSource); otherwise its whole rect is redrawn.
+ */
+
+typedef struct {
+    rga_buffer_t buffer;
+    im_rect srect;      /* empty = whole buffer */
+    im_rect drect;      /* on the output */
+    int transform;      /* IM_HAL_TRANSFORM_* */
+    int alpha;          /* plane alpha, 0 (hidden) .. 255 */
+    int zorder;         /* higher is on top; ties keep insertion order */
+    bool blend;         /* src-over with the per-pixel alpha; false replaces the pixels below */
+} RgaLayer;
+
+typedef struct {
+    int layers;
+    int layersDrawn;
+    int layersCulled;       /* hidden, occluded or outside the damage */
+    int tasks;              /* improcessTask calls, fills included */
+    int64_t damagePixels;
+    int64_t pixelsDrawn;    /* layer and background pixels written */
+    int64_t pixelsFull;     /* same for a full redraw without occlusion culling */
+} RgaCompositorStats;
+
+class RgaCompositor {
+public:
+    /* width x height is the output size; core is the im_opt_t.core mask. */
+    RgaCompositor(int width, int height, int core);
+
+    /* Add or replace layer id; the buffer must stay valid while it is used. */
+    IM_STATUS setLayer(int id, const RgaLayer &layer);
+    void removeLayer(int id);
+
+    /* The layer's buffer has new content. */
+    void damageLayer(int id);
+
+    /* Fill color (0xAABBGGRR) where no layer is drawn. */
+    void setBackground(uint32_t color);
+
+    /*
+     * Redraw the damage of dst and wait for it. The tasks go into jobs of up
+     * to RGA_JOB_MAX_TASKS each. dst must be width x height.
+     */
+    IM_STATUS compose(const rga_buffer_t &dst);
+
+    const RgaCompositorStats &stats() const {
+        return mStats;
+    }
+
+private:
+    struct Entry {
+        int id;
+        int order;          /* insertion order, breaks z ties */
+        RgaLayer layer;
+    };
+
+    void damage(const im_rect &rect);
+    Entry *find(int id);
+
+    int mWidth;
+    int mHeight;
+    int mCore;
+    uint32_t mBackground = 0;
+    int mNextOrder = 0;
+    std::vector<Entry> mLayers;
+
+    RgaRegion mDamage;                      /* since the last compose() */
+    std::vector<RgaRegion> mHistory;        /* damage of the last frames, newest last */
+    std::map<uint64_t, uint64_t> mAges;     /* dst buffer -> frame it last received */
+    uint64_t mFrame = 0;
+
+    RgaCompositorStats mStats;
+};
+
+#endif
@@ -0,0 +1,692 @@
+#include "rga_cpu.h"
+
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/dma-buf.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+IM_STATUS rgaCpuMapImage(const rga_buffer_t &buf, RgaCpuImage *img) {
+    memset(img, 0, sizeof(RgaCpuImage));
+    img->mapFd = -1;
+
+    const RgaFormatDesc *desc = rgaFormatFind(buf.format);
+    if (desc == nullptr || !rgaFormatIsRaster(buf.rd_mode)) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    int format = desc->format;
+    if (buf.width <= 0 || buf.height <= 0) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    int wstride = buf.wstride > 0 ? buf.wstride : buf.width;
+    int hstride = buf.hstride > 0 ? buf.hstride : buf.height;
+
+    uint8_t *base = (uint8_t *)buf.vir_addr;
+    if (base == nullptr && buf.fd > 0) {
+        size_t size = rgaFormatImageSize(format, wstride, hstride);
+        void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, buf.fd, 0);
+        if (addr == MAP_FAILED) {
+            return IM_STATUS_OUT_OF_MEMORY;
+        }
+        // Not every fd is a dma-buf, so a failing sync ioctl is not an error.
+        struct dma_buf_sync sync = { DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW };
+        ioctl(buf.fd, DMA_BUF_IOCTL_SYNC, &sync);
+
+        img->mapAddr = addr;
+        img->mapSize = size;
+        img->mapFd = buf.fd;
+        base = (uint8_t *)addr;
+    }
+    if (base == nullptr) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    img->format = format;
+    img->width = buf.width;
+    img->height = buf.height;
+    // Packed YUV (YUYV...) interleaves chroma within plane 0 and 10-bit samples
+    // straddle bytes; neither can be addressed per pixel, so they get bpp 0.
+    bool pixelAddressable = !(desc->yuv && desc->planeCount == 1 && desc->xshift != 0);
+    img->planeCount = desc->planeCount;
+    for (int i = 0; i < desc->planeCount; i++) {
+        RgaCpuPlane *plane = &img->planes[i];
+        plane->data = base;
+        plane->stride = rgaFormatPlaneRowBytes(*desc, i, wstride);
+        plane->xshift = i == 0 ? 0 : desc->xshift;
+        plane->yshift = i == 0 ? 0 : desc->yshift;
+        plane->width = buf.width >> plane->xshift;
+        plane->height = buf.height >> plane->yshift;
+        plane->bpp = pixelAddressable && desc->bits[i] % 8 == 0 ? desc->bits[i] / 8 : 0;
+        base += (size_t)plane->stride * rgaFormatPlaneRows(*desc, i, hstride);
+    }
+    return IM_STATUS_SUCCESS;
+}
+
+void rgaCpuUnmapImage(RgaCpuImage *img) {
+    if (img->mapAddr != nullptr) {
+        struct dma_buf_sync sync = { DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW };
+        ioctl(img->mapFd, DMA_BUF_IOCTL_SYNC, &sync);
+        munmap(img->mapAddr, img->mapSize);
+    }
+    img->mapAddr = nullptr;
+    img->mapSize = 0;
+    img->mapFd = -1;
+}
+
+static inline uint8_t clampU8(int v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+bool rgaCpuPackColor(int format, uint32_t color, uint8_t pattern[RGA_CPU_MAX_PLANES][4]) {
+    int r = color & 0xff;
+    int g = (color >> 8) & 0xff;
+    int b = (color >> 16) & 0xff;
+    int a = (color >> 24) & 0xff;
+
+    // BT.601 limited range, the RGA default for RGB -> YUV.
+    uint8_t y = clampU8(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    uint8_t u = clampU8(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    uint8_t v = clampU8(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+
+    memset(pattern, 0, RGA_CPU_MAX_PLANES * 4);
+    switch (rgaFormatNormalize(format)) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+            pattern[0][0] = r; pattern[0][1] = g; pattern[0][2] = b; pattern[0][3] = a;
+            return true;
+        case RK_FORMAT_BGRA_8888:
+        case RK_FORMAT_BGRX_8888:
+            pattern[0][0] = b; pattern[0][1] = g; pattern[0][2] = r; pattern[0][3] = a;
+            return true;
+        case RK_FORMAT_ARGB_8888:
+        case RK_FORMAT_XRGB_8888:
+            pattern[0][0] = a; pattern[0][1] = r; pattern[0][2] = g; pattern[0][3] = b;
+            return true;
+        case RK_FORMAT_ABGR_8888:
+        case RK_FORMAT_XBGR_8888:
+            pattern[0][0] = a; pattern[0][1] = b; pattern[0][2] = g; pattern[0][3] = r;
+            return true;
+        case RK_FORMAT_RGB_888:
+            pattern[0][0] = r; pattern[0][1] = g; pattern[0][2] = b;
+            return true;
+        case RK_FORMAT_BGR_888:
+            pattern[0][0] = b; pattern[0][1] = g; pattern[0][2] = r;
+            return true;
+        case RK_FORMAT_RGB_565: {
+            uint16_t px = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+            memcpy(pattern[0], &px, 2);
+            return true;
+        }
+        case RK_FORMAT_BGR_565: {
+            uint16_t px = (uint16_t)(((b >> 3) << 11) | ((g >> 2) << 5) | (r >> 3));
+            memcpy(pattern[0], &px, 2);
+            return true;
+        }
+        case RK_FORMAT_A8:
+            pattern[0][0] = a;
+            return true;
+        case RK_FORMAT_YCbCr_400:
+        case RK_FORMAT_Y8:
+            pattern[0][0] = y;
+            return true;
+        case RK_FORMAT_YCbCr_420_SP:
+        case RK_FORMAT_YCbCr_422_SP:
+        case RK_FORMAT_YCbCr_444_SP:
+            pattern[0][0] = y; pattern[1][0] = u; pattern[1][1] = v;
+            return true;
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCrCb_422_SP:
+        case RK_FORMAT_YCrCb_444_SP:
+            pattern[0][0] = y; pattern[1][0] = v; pattern[1][1] = u;
+            return true;
+        case RK_FORMAT_YCbCr_420_P:
+        case RK_FORMAT_YCbCr_422_P:
+            pattern[0][0] = y; pattern[1][0] = u; pattern[2][0] = v;
+            return true;
+        case RK_FORMAT_YCrCb_420_P:
+        case RK_FORMAT_YCrCb_422_P:
+            pattern[0][0] = y; pattern[1][0] = v; pattern[2][0] = u;
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t rgaCpuUnpackColor(int format, const uint8_t *pixel) {
+    uint32_t r = 0, g = 0, b = 0, a = 0xff;
+    switch (rgaFormatNormalize(format)) {
+        case RK_FORMAT_RGBA_8888:
+            r = pixel[0]; g = pixel[1]; b = pixel[2]; a = pixel[3];
+            break;
+        case RK_FORMAT_RGBX_8888:
+        case RK_FORMAT_RGB_888:
+            r = pixel[0]; g = pixel[1]; b = pixel[2];
+            break;
+        case RK_FORMAT_BGRA_8888:
+            b = pixel[0]; g = pixel[1]; r = pixel[2]; a = pixel[3];
+            break;
+        case RK_FORMAT_BGRX_8888:
+        case RK_FORMAT_BGR_888:
+            b = pixel[0]; g = pixel[1]; r = pixel[2];
+            break;
+        case RK_FORMAT_ARGB_8888:
+            a = pixel[0]; r = pixel[1]; g = pixel[2]; b = pixel[3];
+            break;
+        case RK_FORMAT_XRGB_8888:
+            r = pixel[1]; g = pixel[2]; b = pixel[3];
+            break;
+        case RK_FORMAT_ABGR_8888:
+            a = pixel[0]; b = pixel[1]; g = pixel[2]; r = pixel[3];
+            break;
+        case RK_FORMAT_XBGR_8888:
+            b = pixel[1]; g = pixel[2]; r = pixel[3];
+            break;
+        case RK_FORMAT_RGB_565:
+        case RK_FORMAT_BGR_565: {
+            uint16_t px;
+            memcpy(&px, pixel, 2);
+            r = ((px >> 11) & 0x1f) * 255 / 31;
+            g = ((px >> 5) & 0x3f) * 255 / 63;
+            b = (px & 0x1f) * 255 / 31;
+            if (rgaFormatNormalize(format) == RK_FORMAT_BGR_565) {
+                uint32_t t = r; r = b; b = t;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+bool rgaCpuCanLoadRgb(int format) {
+    switch (rgaFormatNormalize(format)) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+        case RK_FORMAT_BGRA_8888:
+        case RK_FORMAT_BGRX_8888:
+        case RK_FORMAT_ARGB_8888:
+        case RK_FORMAT_XRGB_8888:
+        case RK_FORMAT_ABGR_8888:
+        case RK_FORMAT_XBGR_8888:
+        case RK_FORMAT_RGB_888:
+        case RK_FORMAT_BGR_888:
+        case RK_FORMAT_RGB_565:
+        case RK_FORMAT_BGR_565:
+        case RK_FORMAT_YCbCr_400:
+        case RK_FORMAT_Y8:
+        case RK_FORMAT_YCbCr_420_SP:
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCbCr_422_SP:
+        case RK_FORMAT_YCrCb_422_SP:
+        case RK_FORMAT_YCbCr_444_SP:
+        case RK_FORMAT_YCrCb_444_SP:
+        case RK_FORMAT_YCbCr_420_P:
+        case RK_FORMAT_YCrCb_420_P:
+        case RK_FORMAT_YCbCr_422_P:
+        case RK_FORMAT_YCrCb_422_P:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// BT.601 limited range, the RGA default for YUV -> RGB.
+static inline void yuvToRgb(int y, int u, int v, uint8_t *r, uint8_t *g, uint8_t *b) {
+    int c = 298 * (y - 16);
+    u -= 128;
+    v -= 128;
+    *r = clampU8((c + 409 * v + 128) >> 8);
+    *g = clampU8((c - 100 * u - 208 * v + 128) >> 8);
+    *b = clampU8((c + 516 * u + 128) >> 8);
+}
+
+#if defined(__ARM_NEON)
+static inline uint8x8_t yuvChannel(int32x4_t lo, int32x4_t hi) {
+    return vqmovun_s16(vcombine_s16(vrshrn_n_s32(lo, 8), vrshrn_n_s32(hi, 8)));
+}
+
+// 8 pixels: y as u8, u/v already centered around 0.
+static inline void yuvToRgb8(uint8x8_t y, int16x8_t u, int16x8_t v,
+                             uint8_t *r, uint8_t *g, uint8_t *b) {
+    int16x8_t yc = vreinterpretq_s16_u16(vsubl_u8(y, vdup_n_u8(16)));
+    int32x4_t cLo = vmull_n_s16(vget_low_s16(yc), 298);
+    int32x4_t cHi = vmull_n_s16(vget_high_s16(yc), 298);
+
+    int32x4_t rLo = vmlal_n_s16(cLo, vget_low_s16(v), 409);
+    int32x4_t rHi = vmlal_n_s16(cHi, vget_high_s16(v), 409);
+    int32x4_t gLo = vmlal_n_s16(vmlal_n_s16(cLo, vget_low_s16(u), -100), vget_low_s16(v), -208);
+    int32x4_t gHi = vmlal_n_s16(vmlal_n_s16(cHi, vget_high_s16(u), -100), vget_high_s16(v), -208);
+    int32x4_t bLo = vmlal_n_s16(cLo, vget_low_s16(u), 516);
+    int32x4_t bHi = vmlal_n_s16(cHi, vget_high_s16(u), 516);
+
+    vst1_u8(r, yuvChannel(rLo, rHi));
+    vst1_u8(g, yuvChannel(gLo, gHi));
+    vst1_u8(b, yuvChannel(bLo, bHi));
+}
+#endif
+
+// Byte offsets of R, G and B inside a packed 3 or 4 byte pixel.
+static bool packedRgbOffsets(int format, int *ro, int *go, int *bo) {
+    switch (format) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_RGBX_8888:
+        case RK_FORMAT_RGB_888:
+            *ro = 0; *go = 1; *bo = 2;
+            return true;
+        case RK_FORMAT_BGRA_8888:
+        case RK_FORMAT_BGRX_8888:
+        case RK_FORMAT_BGR_888:
+            *ro = 2; *go = 1; *bo = 0;
+            return true;
+        case RK_FORMAT_ARGB_8888:
+        case RK_FORMAT_XRGB_8888:
+            *ro = 1; *go = 2; *bo = 3;
+            return true;
+        case RK_FORMAT_ABGR_8888:
+        case RK_FORMAT_XBGR_8888:
+            *ro = 3; *go = 2; *bo = 1;
+            return true;
+        default:
+            return false;
+    }
+}
+
+void rgaCpuLoadRgbRow(const RgaCpuImage &img, int y, int x, int count,
+                      uint8_t *r, uint8_t *g, uint8_t *b) {
+    const RgaCpuPlane &p0 = img.planes[0];
+    const uint8_t *row = p0.data + (size_t)y * p0.stride;
+    int i = 0;
+
+    int ro, go, bo;
+    if (packedRgbOffsets(img.format, &ro, &go, &bo)) {
+        const uint8_t *px = row + (size_t)x * p0.bpp;
+#if defined(__ARM_NEON)
+        if (p0.bpp == 4) {
+            for (; i + 16 <= count; i += 16) {
+                uint8x16x4_t v = vld4q_u8(px + i * 4);
+                vst1q_u8(r + i, v.val[ro]);
+                vst1q_u8(g + i, v.val[go]);
+                vst1q_u8(b + i, v.val[bo]);
+            }
+        } else {
+            for (; i + 16 <= count; i += 16) {
+                uint8x16x3_t v = vld3q_u8(px + i * 3);
+                vst1q_u8(r + i, v.val[ro]);
+                vst1q_u8(g + i, v.val[go]);
+                vst1q_u8(b + i, v.val[bo]);
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            const uint8_t *p = px + i * p0.bpp;
+            r[i] = p[ro];
+            g[i] = p[go];
+            b[i] = p[bo];
+        }
+        return;
+    }
+
+    if (img.format == RK_FORMAT_RGB_565 || img.format == RK_FORMAT_BGR_565) {
+        for (; i < count; i++) {
+            uint32_t c = rgaCpuUnpackColor(img.format, row + (size_t)(x + i) * 2);
+            r[i] = c & 0xff;
+            g[i] = (c >> 8) & 0xff;
+            b[i] = (c >> 16) & 0xff;
+        }
+        return;
+    }
+
+    if (img.planeCount == 1) {
+        // Y400 / Y8: gray
+        memcpy(r, row + x, count);
+        memcpy(g, row + x, count);
+        memcpy(b, row + x, count);
+        return;
+    }
+
+    const uint8_t *yRow = row + x;
+    const RgaCpuPlane &p1 = img.planes[1];
+    const uint8_t *cRow = p1.data + (size_t)(y >> p1.yshift) * p1.stride;
+    bool vFirst = img.format == RK_FORMAT_YCrCb_420_SP || img.format == RK_FORMAT_YCrCb_422_SP ||
+                  img.format == RK_FORMAT_YCrCb_444_SP || img.format == RK_FORMAT_YCrCb_420_P ||
+                  img.format == RK_FORMAT_YCrCb_422_P;
+    int xs = p1.xshift;
+
+    if (img.planeCount == 2) {
+        int uo = vFirst ? 1 : 0;
+        int vo = vFirst ? 0 : 1;
+        // Scalar up to an even column so each vector starts on a chroma sample.
+        for (; i < count && ((x + i) & xs); i++) {
+            const uint8_t *c = cRow + ((x + i) >> xs) * 2;
+            yuvToRgb(yRow[i], c[uo], c[vo], r + i, g + i, b + i);
+        }
+#if defined(__ARM_NEON)
+        for (; i + 8 <= count; i += 8) {
+            const uint8_t *c = cRow + ((x + i) >> xs) * 2;
+            uint8x8_t u8, v8;
+            if (xs) {
+                uint8x8_t raw = vld1_u8(c);     /* 4 chroma pairs */
+                uint8x8x2_t uv = vuzp_u8(raw, raw);
+                u8 = vzip_u8(uv.val[uo], uv.val[uo]).val[0];
+                v8 = vzip_u8(uv.val[vo], uv.val[vo]).val[0];
+            } else {
+                uint8x8x2_t uv = vld2_u8(c);
+                u8 = uv.val[uo];
+                v8 = uv.val[vo];
+            }
+            int16x8_t u = vreinterpretq_s16_u16(vsubl_u8(u8, vdup_n_u8(128)));
+            int16x8_t v = vreinterpretq_s16_u16(vsubl_u8(v8, vdup_n_u8(128)));
+            yuvToRgb8(vld1_u8(yRow + i), u, v, r + i, g + i, b + i);
+        }
+#endif
+        for (; i < count; i++) {
+            const uint8_t *c = cRow + ((x + i) >> xs) * 2;
+            yuvToRgb(yRow[i], c[uo], c[vo], r + i, g + i, b + i);
+        }
+        return;
+    }
+
+    const RgaCpuPlane &p2 = img.planes[2];
+    const uint8_t *uRow = cRow;
+    const uint8_t *vRow = p2.data + (size_t)(y >> p2.yshift) * p2.stride;
+    if (vFirst) {
+        const uint8_t *t = uRow; uRow = vRow; vRow = t;
+    }
+    for (; i < count && ((x + i) & xs); i++) {
+        int cx = (x + i) >> xs;
+        yuvToRgb(yRow[i], uRow[cx], vRow[cx], r + i, g + i, b + i);
+    }
+#if defined(__ARM_NEON)
+    // Each step reads 8 chroma bytes but uses 4; stop early to stay inside the row.
+    for (; i + 16 <= count; i += 8) {
+        int cx = (x + i) >> xs;
+        uint8x8_t u8 = vld1_u8(uRow + cx);
+        uint8x8_t v8 = vld1_u8(vRow + cx);
+        u8 = vzip_u8(u8, u8).val[0];
+        v8 = vzip_u8(v8, v8).val[0];
+        int16x8_t u = vreinterpretq_s16_u16(vsubl_u8(u8, vdup_n_u8(128)));
+        int16x8_t v = vreinterpretq_s16_u16(vsubl_u8(v8, vdup_n_u8(128)));
+        yuvToRgb8(vld1_u8(yRow + i), u, v, r + i, g + i, b + i);
+    }
+#endif
+    for (; i < count; i++) {
+        int cx = (x + i) >> xs;
+        yuvToRgb(yRow[i], uRow[cx], vRow[cx], r + i, g + i, b + i);
+    }
+}
+
+// Byte offset of alpha inside a packed 4 byte pixel, -1 when the format has none.
+static int packedAlphaOffset(int format) {
+    switch (format) {
+        case RK_FORMAT_RGBA_8888:
+        case RK_FORMAT_BGRA_8888:
+            return 3;
+        case RK_FORMAT_ARGB_8888:
+        case RK_FORMAT_ABGR_8888:
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+void rgaCpuLoadAlphaRow(const RgaCpuImage &img, int y, int x, int count, uint8_t *a) {
+    int ao = packedAlphaOffset(img.format);
+    if (ao < 0) {
+        memset(a, 0xff, count);
+        return;
+    }
+    const uint8_t *px = img.planes[0].data + (size_t)y * img.planes[0].stride + (size_t)x * 4 + ao;
+    for (int i = 0; i < count; i++) {
+        a[i] = px[i * 4];
+    }
+}
+
+void rgaCpuStoreRgbRow(const RgaCpuImage &img, int y, int x, int count,
+                       const uint8_t *r, const uint8_t *g, const uint8_t *b, const uint8_t *a) {
+    const RgaCpuPlane &p0 = img.planes[0];
+    uint8_t *row = p0.data + (size_t)y * p0.stride;
+
+    int ro, go, bo;
+    if (packedRgbOffsets(img.format, &ro, &go, &bo)) {
+        uint8_t *px = row + (size_t)x * p0.bpp;
+        int ao = -1;
+        if (p0.bpp == 4) {
+            // X formats still get an opaque filler byte.
+            ao = 6 - ro - go - bo;
+        }
+        bool hasAlpha = packedAlphaOffset(img.format) >= 0;
+        for (int i = 0; i < count; i++) {
+            uint8_t *p = px + i * p0.bpp;
+            p[ro] = r[i];
+            p[go] = g[i];
+            p[bo] = b[i];
+            if (ao >= 0) {
+                p[ao] = hasAlpha && a != nullptr ? a[i] : 0xff;
+            }
+        }
+        return;
+    }
+
+    if (img.format == RK_FORMAT_RGB_565 || img.format == RK_FORMAT_BGR_565) {
+        bool bgr = img.format == RK_FORMAT_BGR_565;
+        for (int i = 0; i < count; i++) {
+            int hi = bgr ? b[i] : r[i];
+            int lo = bgr ? r[i] : b[i];
+            uint16_t px = (uint16_t)(((hi >> 3) << 11) | ((g[i] >> 2) << 5) | (lo >> 3));
+            memcpy(row + (size_t)(x + i) * 2, &px, 2);
+        }
+        return;
+    }
+
+    uint8_t *yRow = row + x;
+    for (int i = 0; i < count; i++) {
+        yRow[i] = clampU8(((66 * r[i] + 129 * g[i] + 25 * b[i] + 128) >> 8) + 16);
+    }
+    if (img.planeCount == 1) {
+        return;
+    }
+
+    // Chroma comes from the top-left pixel of each subsampled block.
+    const RgaCpuPlane &p1 = img.planes[1];
+    if ((y & ((1 << p1.yshift) - 1)) != 0) {
+        return;
+    }
+    int xs = p1.xshift;
+    bool vFirst = img.format == RK_FORMAT_YCrCb_420_SP || img.format == RK_FORMAT_YCrCb_422_SP ||
+                  img.format == RK_FORMAT_YCrCb_444_SP || img.format == RK_FORMAT_YCrCb_420_P ||
+                  img.format == RK_FORMAT_YCrCb_422_P;
+    uint8_t *cRow = p1.data + (size_t)(y >> p1.yshift) * p1.stride;
+    uint8_t *c2Row = img.planeCount == 3 ?
+                     img.planes[2].data + (size_t)(y >> img.planes[2].yshift) * img.planes[2].stride : nullptr;
+    for (int i = 0; i < count; i++) {
+        if (((x + i) & ((1 << xs) - 1)) != 0) {
+            continue;
+        }
+        uint8_t u = clampU8(((-38 * r[i] - 74 * g[i] + 112 * b[i] + 128) >> 8) + 128);
+        uint8_t v = clampU8(((112 * r[i] - 94 * g[i] - 18 * b[i] + 128) >> 8) + 128);
+        int cx = (x + i) >> xs;
+        if (c2Row == nullptr) {
+            cRow[cx * 2] = vFirst ? v : u;
+            cRow[cx * 2 + 1] = vFirst ? u : v;
+        } else {
+            cRow[cx] = vFirst ? v : u;
+            c2Row[cx] = vFirst ? u : v;
+        }
+    }
+}
+
+int rgaCpuBorderIndex(int i, int n, int borderType) {
+    if (i >= 0 && i < n) {
+        return i;
+    }
+    switch (borderType) {
+        case IM_BORDER_REFLECT:
+            while (i < 0 || i >= n) {
+                i = i < 0 ? -i - 1 : 2 * n - i - 1;
+            }
+            return i;
+        case IM_BORDER_WRAP:
+            return ((i % n) + n) % n;
+        default:
+            return -1;
+    }
+}
+
+void rgaCpuFillRow(uint8_t *dst, int count, const uint8_t *pattern, int bpp) {
+    if (bpp == 1) {
+        memset(dst, pattern[0], count);
+        return;
+    }
+
+    int i = 0;
+#if defined(__ARM_NEON)
+    if (bpp == 4) {
+        uint32_t px;
+        memcpy(&px, pattern, 4);
+        uint32x4_t v = vdupq_n_u32(px);
+        for (; i + 4 <= count; i += 4) {
+            vst1q_u32((uint32_t *)(dst + i * 4), v);
+        }
+    } else if (bpp == 3) {
+        uint8x16x3_t v;
+        v.val[0] = vdupq_n_u8(pattern[0]);
+        v.val[1] = vdupq_n_u8(pattern[1]);
+        v.val[2] = vdupq_n_u8(pattern[2]);
+        for (; i + 16 <= count; i += 16) {
+            vst3q_u8(dst + i * 3, v);
+        }
+    } else if (bpp == 2) {
+        uint16_t px;
+        memcpy(&px, pattern, 2);
+        uint16x8_t v = vdupq_n_u16(px);
+        for (; i + 8 <= count; i += 8) {
+            vst1q_u16((uint16_t *)(dst + i * 2), v);
+        }
+    }
+#else
+    // 48 bytes is a whole number of 2, 3 and 4 byte elements; copying it in
+    // chunks lets the compiler emit wide vector stores.
+    uint8_t line[48];
+    for (int k = 0; k < 48; k += bpp) {
+        memcpy(line + k, pattern, bpp);
+    }
+    int perLine = 48 / bpp;
+    for (; i + perLine <= count; i += perLine) {
+        memcpy(dst + i * bpp, line, 48);
+    }
+#endif
+    for (; i < count; i++) {
+        memcpy(dst + i * bpp, pattern, bpp);
+    }
+}
+
+// Fixed pool of workers shared by all CPU kernels. One parallel job runs at a
+// time; a caller that finds the pool busy runs its job inline instead.
+class CpuWorkerPool {
+public:
+    CpuWorkerPool() {
+        unsigned n = std::thread::hardware_concurrency();
+        int workers = n > 1 ? (int)n - 1 : 0;
+        for (int i = 0; i < workers; i++) {
+            mThreads.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~CpuWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mWakeCv.notify_all();
+        for (auto &t : mThreads) {
+            t.join();
+        }
+    }
+
+    void run(int count, const std::function<void(int, int)> &fn) {
+        int chunks = (int)mThreads.size() + 1;
+        if (chunks > count) {
+            chunks = count;
+        }
+        std::unique_lock<std::mutex> busy(mJobMutex, std::try_to_lock);
+        if (chunks <= 1 || !busy.owns_lock()) {
+            fn(0, count);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFn = &fn;
+            mCount = count;
+            mChunks = chunks;
+            mNext.store(0);
+            mPending = chunks;
+            mGeneration++;
+        }
+        mWakeCv.notify_all();
+        runChunks();
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDoneCv.wait(lock, [this] { return mPending == 0; });
+        mFn = nullptr;
+    }
+
+private:
+    void runChunks() {
+        int chunk;
+        while ((chunk = mNext.fetch_add(1)) < mChunks) {
+            int begin = (int)((int64_t)mCount * chunk / mChunks);
+            int end = (int)((int64_t)mCount * (chunk + 1) / mChunks);
+            (*mFn)(begin, end);
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (--mPending == 0) {
+                mDoneCv.notify_one();
+            }
+        }
+    }
+
+    void workerLoop() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWakeCv.wait(lock, [&] { return mStop || mGeneration != seen; });
+                if (mStop) {
+                    return;
+                }
+                seen = mGeneration;
+            }
+            runChunks();
+        }
+    }
+
+    std::vector<std::thread> mThreads;
+    std::mutex mJobMutex;
+    std::mutex mMutex;
+    std::condition_variable mWakeCv;
+    std::condition_variable mDoneCv;
+    const std::function<void(int, int)> *mFn = nullptr;
+    int mCount = 0;
+    int mChunks = 0;
+    std::atomic<int> mNext{0};
+    int mPending = 0;
+    uint64_t mGeneration = 0;
+    bool mStop = false;
+};
+
+void rgaCpuParallelFor(int count, const std::function<void(int begin, int end)> &fn) {
+    static CpuWorkerPool pool;
+    if (count <= 0) {
+        return;
+    }
+    pool.run(count, fn);
+}
@@ -0,0 +1,169 @@
+#ifndef _rga_cpu_h_
+#define _rga_cpu_h_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include "im2d_type.h"
+#include "rga_format.h"
+
+/*
+ * CPU implementations of im2d operations.
+ *
+ * The JNI layer schedules everything onto the RGA3 cores, which do not
+ * implement fill, rectangle, mosaic, ROP, palette or OSD (they only exist on
+ * RGA2). These routines provide the same semantics on the CPU so those
+ * operations stay available on >4GB devices.
+ *
+ * Colors use the im_color_t layout: 0xAABBGGRR, i.e. R is the lowest byte.
+ */
+
+#define RGA_CPU_MAX_PLANES 3
+
+typedef struct {
+    uint8_t *data;
+    int stride;         /* bytes per row */
+    int width;          /* elements per row */
+    int height;         /* rows */
+    int bpp;            /* bytes per element */
+    int xshift;         /* horizontal subsampling relative to plane 0 */
+    int yshift;         /* vertical subsampling relative to plane 0 */
+} RgaCpuPlane;
+
+typedef struct {
+    int format;         /* normalized RK_FORMAT_* */
+    int width;
+    int height;
+    int planeCount;
+    RgaCpuPlane planes[RGA_CPU_MAX_PLANES];
+
+    /* Set when the buffer was mmap()ed from a dma-buf fd */
+    void *mapAddr;
+    size_t mapSize;
+    int mapFd;
+} RgaCpuImage;
+
+/* Get CPU access to a raster rga_buffer_t backed by a virtual address or dma-buf fd. */
+IM_STATUS rgaCpuMapImage(const rga_buffer_t &buf, RgaCpuImage *img);
+void rgaCpuUnmapImage(RgaCpuImage *img);
+
+/* Convert an 0xAABBGGRR color into the per-plane element bytes of format. */
+bool rgaCpuPackColor(int format, uint32_t color, uint8_t pattern[RGA_CPU_MAX_PLANES][4]);
+/* Read one packed RGB pixel back into 0xAABBGGRR. */
+uint32_t rgaCpuUnpackColor(int format, const uint8_t *pixel);
+
+/* Whether rgaCpuLoadRgbRow can read format. */
+bool rgaCpuCanLoadRgb(int format);
+/*
+ * Convert count pixels of row y starting at column x into separate R, G and B
+ * rows. YUV sources use BT.601 limited range like the RGA default.
+ */
+void rgaCpuLoadRgbRow(const RgaCpuImage &img, int y, int x, int count,
+                      uint8_t *r, uint8_t *g, uint8_t *b);
+
+/* Alpha of count pixels (0xff for formats without alpha). */
+void rgaCpuLoadAlphaRow(const RgaCpuImage &img, int y, int x, int count, uint8_t *a);
+/*
+ * Inverse of rgaCpuLoadRgbRow. YUV chroma is written on even rows/columns of
+ * each subsampled block only; a may be null (opaque).
+ */
+void rgaCpuStoreRgbRow(const RgaCpuImage &img, int y, int x, int count,
+                       const uint8_t *r, const uint8_t *g, const uint8_t *b, const uint8_t *a);
+
+/* Run fn over [0, count) split into contiguous chunks on the CPU worker pool. */
+void rgaCpuParallelFor(int count, const std::function<void(int begin, int end)> &fn);
+
+/* Map index i of an n element line through an IM_BORDER_* mode; -1 means the constant. */
+int rgaCpuBorderIndex(int i, int n, int borderType);
+
+/* Store count elements of bpp bytes from pattern at dst. */
+void rgaCpuFillRow(uint8_t *dst, int count, const uint8_t *pattern, int bpp);
+
+IM_STATUS rgaCpuFill(const rga_buffer_t &dst, const im_rect *rects, int count, uint32_t color);
+IM_STATUS rgaCpuRectangle(const rga_buffer_t &dst, const im_rect *rects, int count,
+                          uint32_t color, int thickness);
+/* The up to four strips of a width x height image around inner; returns the count. */
+int rgaCpuBorderStrips(int width, int height, const im_rect &inner, im_rect strips[4]);
+/*
+ * Fill the area of dst outside inner from the pixels inside it, like
+ * immakeBorder: IM_BORDER_CONSTANT uses color, REFLECT/WRAP mirror or repeat.
+ */
+IM_STATUS rgaCpuMakeBorder(const rga_buffer_t &dst, const im_rect &inner, int borderType, uint32_t color);
+IM_STATUS rgaCpuMosaic(const rga_buffer_t &image, const im_rect *rects, int count, int mosaicMode);
+IM_STATUS rgaCpuRop(const rga_buffer_t &src, const rga_buffer_t &dst, int ropCode);
+IM_STATUS rgaCpuPalette(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &lut);
+
+/*
+ * OSD (imosd) reference. osdRect of dst is split into block_count blocks of
+ * block_parm.width pixels along the block direction. A block's flag bit is
+ * set when the mean luma of the background under it is above
+ * invert_config.threash: the Y samples of YUV images, BT.601 luma of RGB
+ * ones. With IM_OSD_MODE_AUTO_INVERT a block is drawn inverted when its flag
+ * disagrees with the default background: bright blocks under
+ * IM_OSD_BACKGROUND_DEFAULT_DARK, dark blocks under _BRIGHT. Inversion is
+ * done on the RGB OSD colour (Y/G = G, C/RB = R and B):
+ * IM_OSD_INVERT_USE_FACTOR gives MAX(min, max - value), _USE_SWAP exchanges
+ * the bpp2 colours (plain complement for pixel colours); IM_OSD_COLOR_EXTERNAL
+ * uses invert_color instead of normal_color, with the OSD alpha as coverage.
+ * LUT block widths (IM_OSD_BLOCK_MODE_DIFFERENT) are not supported.
+ */
+#define RGA_CPU_OSD_MAX_BLOCKS 64
+
+typedef struct {
+    int blocks;
+    uint64_t flags;                             /* bit i: block i is bright */
+    uint8_t luma[RGA_CPU_OSD_MAX_BLOCKS];       /* mean per block */
+} RgaCpuOsdStatistics;
+
+/* Per-block statistics of the dst background under osdRect. */
+IM_STATUS rgaCpuOsdStatistics(const rga_buffer_t &dst, const im_rect &osdRect, const im_osd_t &config,
+                              RgaCpuOsdStatistics *stats);
+/* Whether block is drawn inverted for the given flags. */
+bool rgaCpuOsdInverted(const im_osd_t &config, uint64_t flags, int block);
+/*
+ * Blend osd (RGBA or RGBA2BPP) over osdRect of dst. IM_OSD_MODE_STATISTICS
+ * stores the flags in invert_config.current_flags and in the emulated flag
+ * RAM at flags_index, which IM_OSD_FLAGS_INTERNAL reads back on a later call;
+ * IM_OSD_FLAGS_EXTERNAL uses invert_flags instead.
+ */
+IM_STATUS rgaCpuOsd(const rga_buffer_t &osd, const rga_buffer_t &dst, const im_rect &osdRect, im_osd_t *config);
+
+/*
+ * Gaussian blur with the same parameters as im_gauss_t: either ksize plus
+ * sigma_x/sigma_y (0 derives sigma from ksize), or an explicit ksize matrix.
+ * Separable kernels run as two fixed-point passes; borderType is IM_BORDER_*.
+ * Generated kernels are scaled down on subsampled chroma planes.
+ */
+IM_STATUS rgaCpuGaussianBlur(const rga_buffer_t &src, const rga_buffer_t &dst,
+                             const im_gauss_t &gauss, int borderType);
+/* Fill matrix (ksize.width x ksize.height, row major) with the normalized kernel. */
+void rgaCpuGaussianKernel(const im_gauss_t &gauss, double *matrix);
+
+/* 10-bit YUV: RK_FORMAT_*_SP_10B (packed) or RGA_FORMAT_P010/P210. */
+bool rgaCpuIsTenBit(int format);
+/*
+ * Convert a 10-bit YUV src to 8-bit dst of the same size: NV12/NV21 (4:2:2
+ * sources average chroma row pairs), NV16/NV61, or any rgaCpuLoadRgb format
+ * via BT.601. Samples are narrowed as is, without BT.2020/PQ tone mapping;
+ * dither adds a 2x2 ordered dither against banding in flat gradients.
+ */
+IM_STATUS rgaCpuConvert10Bit(const rga_buffer_t &src, const rga_buffer_t &dst, bool dither);
+
+#define RGA_CPU_TENSOR_NHWC 0
+#define RGA_CPU_TENSOR_NCHW 1
+
+/*
+ * Crop srcRect out of src, bilinear-resize it into dstRect of an RGB_888 or
+ * BGR_888 tensor and apply the im_nn_t quantization the RGA uses:
+ * dst = (src + offset) * scale / 256 (scale 0..1023, offset -255..255).
+ * nn may be null. NCHW tensors store three wstride x hstride planes in the
+ * tensor's channel order. All-zero rects select the whole image.
+ */
+IM_STATUS rgaCpuPrepareTensor(const rga_buffer_t &src, const im_rect &srcRect,
+                              const rga_buffer_t &tensor, const im_rect &dstRect,
+                              int layout, const im_nn_t *nn);
+/* Split a packed 3-channel image into dstRect of an NCHW tensor of the same format. */
+IM_STATUS rgaCpuTensorToPlanar(const rga_buffer_t &packed, const rga_buffer_t &tensor,
+                               const im_rect &dstRect);
+
+#endif
@@ -0,0 +1,442 @@
+#include "rga_cpu.h"
+
+#include <string.h>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// A rect of all zeros addresses the whole image, like the im2d API.
+static bool clipRect(const RgaCpuImage &img, const im_rect &in, im_rect *out) {
+    if (in.x == 0 && in.y == 0 && in.width == 0 && in.height == 0) {
+        *out = {0, 0, img.width, img.height};
+        return true;
+    }
+    int x0 = in.x < 0 ? 0 : in.x;
+    int y0 = in.y < 0 ? 0 : in.y;
+    int x1 = in.x + in.width > img.width ? img.width : in.x + in.width;
+    int y1 = in.y + in.height > img.height ? img.height : in.y + in.height;
+    if (x1 <= x0 || y1 <= y0) {
+        return false;
+    }
+    *out = {x0, y0, x1 - x0, y1 - y0};
+    return true;
+}
+
+// Map a plane-0 rect onto a (possibly subsampled) plane, rounding outwards.
+static im_rect planeRect(const RgaCpuPlane &plane, const im_rect &r) {
+    int x0 = r.x >> plane.xshift;
+    int y0 = r.y >> plane.yshift;
+    int x1 = (r.x + r.width + (1 << plane.xshift) - 1) >> plane.xshift;
+    int y1 = (r.y + r.height + (1 << plane.yshift) - 1) >> plane.yshift;
+    if (x1 > plane.width) x1 = plane.width;
+    if (y1 > plane.height) y1 = plane.height;
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+static void fillMapped(const RgaCpuImage &img, const im_rect *rects, int count,
+                       uint8_t pattern[RGA_CPU_MAX_PLANES][4]) {
+    for (int i = 0; i < count; i++) {
+        im_rect r;
+        if (!clipRect(img, rects[i], &r)) {
+            continue;
+        }
+        for (int p = 0; p < img.planeCount; p++) {
+            const RgaCpuPlane &plane = img.planes[p];
+            im_rect pr = planeRect(plane, r);
+            for (int y = pr.y; y < pr.y + pr.height; y++) {
+                uint8_t *row = plane.data + (size_t)y * plane.stride + (size_t)pr.x * plane.bpp;
+                rgaCpuFillRow(row, pr.width, pattern[p], plane.bpp);
+            }
+        }
+    }
+}
+
+IM_STATUS rgaCpuFill(const rga_buffer_t &dst, const im_rect *rects, int count, uint32_t color) {
+    RgaCpuImage img;
+    IM_STATUS ret = rgaCpuMapImage(dst, &img);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    uint8_t pattern[RGA_CPU_MAX_PLANES][4];
+    if (rgaCpuPackColor(img.format, color, pattern)) {
+        fillMapped(img, rects, count, pattern);
+    } else {
+        ret = IM_STATUS_NOT_SUPPORTED;
+    }
+    rgaCpuUnmapImage(&img);
+    return ret;
+}
+
+IM_STATUS rgaCpuRectangle(const rga_buffer_t &dst, const im_rect *rects, int count,
+                          uint32_t color, int thickness) {
+    if (thickness < 0) {
+        return rgaCpuFill(dst, rects, count, color);
+    }
+
+    // Outline = four border strips drawn inside the rect.
+    std::vector<im_rect> strips;
+    strips.reserve(count * 4);
+    for (int i = 0; i < count; i++) {
+        // Resolve the whole-image rect before choosing between outline and fill;
+        // each strip is clipped to the image by rgaCpuFill.
+        im_rect r = rects[i];
+        if (r.x == 0 && r.y == 0 && r.width == 0 && r.height == 0) {
+            r = {0, 0, dst.width, dst.height};
+        }
+        if (r.width <= 0 || r.height <= 0 || r.x >= dst.width || r.y >= dst.height ||
+            r.x + r.width <= 0 || r.y + r.height <= 0) {
+            continue;
+        }
+        int t = thickness;
+        if (2 * t >= r.width || 2 * t >= r.height) {
+            strips.push_back(r);
+            continue;
+        }
+        strips.push_back({r.x, r.y, r.width, t});
+        strips.push_back({r.x, r.y + r.height - t, r.width, t});
+        strips.push_back({r.x, r.y + t, t, r.height - 2 * t});
+        strips.push_back({r.x + r.width - t, r.y + t, t, r.height - 2 * t});
+    }
+    return rgaCpuFill(dst, strips.data(), (int)strips.size(), color);
+}
+
+int rgaCpuBorderStrips(int w, int h, const im_rect &inner, im_rect strips[4]) {
+    int n = 0;
+    int bottom = inner.y + inner.height;
+    int right = inner.x + inner.width;
+    if (inner.y > 0) strips[n++] = {0, 0, w, inner.y};
+    if (bottom < h) strips[n++] = {0, bottom, w, h - bottom};
+    if (inner.x > 0) strips[n++] = {0, inner.y, inner.x, inner.height};
+    if (right < w) strips[n++] = {right, inner.y, w - right, inner.height};
+    return n;
+}
+
+IM_STATUS rgaCpuMakeBorder(const rga_buffer_t &dst, const im_rect &inner, int borderType, uint32_t color) {
+    if (inner.x < 0 || inner.y < 0 || inner.width <= 0 || inner.height <= 0 ||
+        inner.x + inner.width > dst.width || inner.y + inner.height > dst.height) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    im_rect strips[4];
+    int count = rgaCpuBorderStrips(dst.width, dst.height, inner, strips);
+    if (count == 0) {
+        return IM_STATUS_SUCCESS;
+    }
+    if (borderType == IM_BORDER_CONSTANT) {
+        return rgaCpuFill(dst, strips, count, color);
+    }
+    if (borderType != IM_BORDER_REFLECT && borderType != IM_BORDER_WRAP) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    RgaCpuImage img;
+    IM_STATUS ret = rgaCpuMapImage(dst, &img);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    for (int p = 0; p < img.planeCount; p++) {
+        const RgaCpuPlane &plane = img.planes[p];
+        if (plane.bpp == 0) {
+            ret = IM_STATUS_NOT_SUPPORTED;
+            break;
+        }
+        im_rect pr = planeRect(plane, inner);
+        // Left/right from the inner rows, then whole rows above and below.
+        for (int y = pr.y; y < pr.y + pr.height; y++) {
+            uint8_t *row = plane.data + (size_t)y * plane.stride;
+            for (int x = 0; x < plane.width; x++) {
+                if (x == pr.x) {
+                    x = pr.x + pr.width - 1;
+                    continue;
+                }
+                int sx = pr.x + rgaCpuBorderIndex(x - pr.x, pr.width, borderType);
+                memcpy(row + (size_t)x * plane.bpp, row + (size_t)sx * plane.bpp, plane.bpp);
+            }
+        }
+        size_t rowBytes = (size_t)plane.width * plane.bpp;
+        for (int y = 0; y < plane.height; y++) {
+            if (y == pr.y) {
+                y = pr.y + pr.height - 1;
+                continue;
+            }
+            int sy = pr.y + rgaCpuBorderIndex(y - pr.y, pr.height, borderType);
+            memcpy(plane.data + (size_t)y * plane.stride, plane.data + (size_t)sy * plane.stride, rowBytes);
+        }
+    }
+    rgaCpuUnmapImage(&img);
+    return ret;
+}
+
+#if defined(__ARM_NEON)
+static inline uint32_t sumLanes(uint16x8_t v) {
+    uint64x2_t s = vpaddlq_u32(vpaddlq_u16(v));
+    return (uint32_t)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+}
+#endif
+
+// Per-channel sum of n elements; n never exceeds the 128 pixel mosaic block,
+// so 16-bit lane accumulators cannot overflow.
+static void sumRow(const uint8_t *row, int n, int bpp, uint32_t sums[4]) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    if (bpp == 4) {
+        uint16x8_t acc0 = vdupq_n_u16(0), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+        for (; i + 8 <= n; i += 8) {
+            uint8x8x4_t px = vld4_u8(row + i * 4);
+            acc0 = vaddw_u8(acc0, px.val[0]);
+            acc1 = vaddw_u8(acc1, px.val[1]);
+            acc2 = vaddw_u8(acc2, px.val[2]);
+            acc3 = vaddw_u8(acc3, px.val[3]);
+        }
+        sums[0] += sumLanes(acc0); sums[1] += sumLanes(acc1);
+        sums[2] += sumLanes(acc2); sums[3] += sumLanes(acc3);
+    } else if (bpp == 3) {
+        uint16x8_t acc0 = vdupq_n_u16(0), acc1 = acc0, acc2 = acc0;
+        for (; i + 8 <= n; i += 8) {
+            uint8x8x3_t px = vld3_u8(row + i * 3);
+            acc0 = vaddw_u8(acc0, px.val[0]);
+            acc1 = vaddw_u8(acc1, px.val[1]);
+            acc2 = vaddw_u8(acc2, px.val[2]);
+        }
+        sums[0] += sumLanes(acc0); sums[1] += sumLanes(acc1); sums[2] += sumLanes(acc2);
+    } else if (bpp == 2) {
+        uint16x8_t acc0 = vdupq_n_u16(0), acc1 = acc0;
+        for (; i + 8 <= n; i += 8) {
+            uint8x8x2_t px = vld2_u8(row + i * 2);
+            acc0 = vaddw_u8(acc0, px.val[0]);
+            acc1 = vaddw_u8(acc1, px.val[1]);
+        }
+        sums[0] += sumLanes(acc0); sums[1] += sumLanes(acc1);
+    } else if (bpp == 1) {
+        uint16x8_t acc = vdupq_n_u16(0);
+        for (; i + 16 <= n; i += 16) {
+            acc = vpadalq_u8(acc, vld1q_u8(row + i));
+        }
+        sums[0] += sumLanes(acc);
+    }
+#endif
+    for (; i < n; i++) {
+        for (int c = 0; c < bpp; c++) {
+            sums[c] += row[i * bpp + c];
+        }
+    }
+}
+
+static void mosaicPlane(const RgaCpuPlane &plane, const im_rect &r, int block) {
+    int bs = block >> plane.xshift;
+    int bsy = block >> plane.yshift;
+    for (int by = r.y; by < r.y + r.height; by += bsy) {
+        int bh = by + bsy > r.y + r.height ? r.y + r.height - by : bsy;
+        for (int bx = r.x; bx < r.x + r.width; bx += bs) {
+            int bw = bx + bs > r.x + r.width ? r.x + r.width - bx : bs;
+            uint32_t sums[4] = {0, 0, 0, 0};
+            for (int y = by; y < by + bh; y++) {
+                sumRow(plane.data + (size_t)y * plane.stride + (size_t)bx * plane.bpp, bw, plane.bpp, sums);
+            }
+            uint32_t n = (uint32_t)bw * bh;
+            uint8_t avg[4];
+            for (int c = 0; c < plane.bpp; c++) {
+                avg[c] = (uint8_t)((sums[c] + n / 2) / n);
+            }
+            for (int y = by; y < by + bh; y++) {
+                rgaCpuFillRow(plane.data + (size_t)y * plane.stride + (size_t)bx * plane.bpp, bw, avg, plane.bpp);
+            }
+        }
+    }
+}
+
+IM_STATUS rgaCpuMosaic(const rga_buffer_t &image, const im_rect *rects, int count, int mosaicMode) {
+    if (mosaicMode < IM_MOSAIC_8 || mosaicMode > IM_MOSAIC_128) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    int block = 8 << mosaicMode;
+
+    RgaCpuImage img;
+    IM_STATUS ret = rgaCpuMapImage(image, &img);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    if (!rgaFormatFind(img.format)->byteSamples) {
+        rgaCpuUnmapImage(&img);
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    for (int i = 0; i < count; i++) {
+        im_rect r;
+        if (!clipRect(img, rects[i], &r)) {
+            continue;
+        }
+        for (int p = 0; p < img.planeCount; p++) {
+            mosaicPlane(img.planes[p], planeRect(img.planes[p], r), block);
+        }
+    }
+    rgaCpuUnmapImage(&img);
+    return IM_STATUS_SUCCESS;
+}
+
+struct RopAnd {
+    uint8_t operator()(uint8_t s, uint8_t d) const { return s & d; }
+#if defined(__ARM_NEON)
+    uint8x16_t operator()(uint8x16_t s, uint8x16_t d) const { return vandq_u8(s, d); }
+#endif
+};
+
+struct RopOr {
+    uint8_t operator()(uint8_t s, uint8_t d) const { return s | d; }
+#if defined(__ARM_NEON)
+    uint8x16_t operator()(uint8x16_t s, uint8x16_t d) const { return vorrq_u8(s, d); }
+#endif
+};
+
+struct RopNotDst {
+    uint8_t operator()(uint8_t, uint8_t d) const { return ~d; }
+#if defined(__ARM_NEON)
+    uint8x16_t operator()(uint8x16_t, uint8x16_t d) const { return vmvnq_u8(d); }
+#endif
+};
+
+struct RopNotSrc {
+    uint8_t operator()(uint8_t s, uint8_t) const { return ~s; }
+#if defined(__ARM_NEON)
+    uint8x16_t operator()(uint8x16_t s, uint8x16_t) const { return vmvnq_u8(s); }
+#endif
+};
+
+struct RopXor {
+    uint8_t operator()(uint8_t s, uint8_t d) const { return s ^ d; }
+#if defined(__ARM_NEON)
+    uint8x16_t operator()(uint8x16_t s, uint8x16_t d) const { return veorq_u8(s, d); }
+#endif
+};
+
+struct RopNotXor {
+    uint8_t operator()(uint8_t s, uint8_t d) const { return ~(s ^ d); }
+#if defined(__ARM_NEON)
+    uint8x16_t operator()(uint8x16_t s, uint8x16_t d) const { return vmvnq_u8(veorq_u8(s, d)); }
+#endif
+};
+
+template <typename Op>
+static void ropRows(const RgaCpuPlane &src, const RgaCpuPlane &dst, int width, int height, Op op) {
+    size_t bytes = (size_t)width * dst.bpp;
+    for (int y = 0; y < height; y++) {
+        const uint8_t *s = src.data + (size_t)y * src.stride;
+        uint8_t *d = dst.data + (size_t)y * dst.stride;
+        size_t i = 0;
+#if defined(__ARM_NEON)
+        for (; i + 16 <= bytes; i += 16) {
+            vst1q_u8(d + i, op(vld1q_u8(s + i), vld1q_u8(d + i)));
+        }
+#endif
+        for (; i < bytes; i++) {
+            d[i] = op(s[i], d[i]);
+        }
+    }
+}
+
+IM_STATUS rgaCpuRop(const rga_buffer_t &src, const rga_buffer_t &dst, int ropCode) {
+    RgaCpuImage simg, dimg;
+    IM_STATUS ret = rgaCpuMapImage(src, &simg);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    ret = rgaCpuMapImage(dst, &dimg);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&simg);
+        return ret;
+    }
+
+    // ROP is a bitwise raster op on packed RGB data of identical layout.
+    if (simg.format != dimg.format || dimg.planeCount != 1 || dimg.planes[0].bpp < 2) {
+        ret = IM_STATUS_NOT_SUPPORTED;
+    } else {
+        int width = simg.width < dimg.width ? simg.width : dimg.width;
+        int height = simg.height < dimg.height ? simg.height : dimg.height;
+        const RgaCpuPlane &s = simg.planes[0];
+        const RgaCpuPlane &d = dimg.planes[0];
+        switch (ropCode) {
+            case IM_ROP_AND: ropRows(s, d, width, height, RopAnd()); break;
+            case IM_ROP_OR: ropRows(s, d, width, height, RopOr()); break;
+            case IM_ROP_NOT_DST: ropRows(s, d, width, height, RopNotDst()); break;
+            case IM_ROP_NOT_SRC: ropRows(s, d, width, height, RopNotSrc()); break;
+            case IM_ROP_XOR: ropRows(s, d, width, height, RopXor()); break;
+            case IM_ROP_NOT_XOR: ropRows(s, d, width, height, RopNotXor()); break;
+            default: ret = IM_STATUS_INVALID_PARAM; break;
+        }
+    }
+    rgaCpuUnmapImage(&dimg);
+    rgaCpuUnmapImage(&simg);
+    return ret;
+}
+
+static int paletteBits(int format) {
+    switch (format) {
+        case RK_FORMAT_BPP1: return 1;
+        case RK_FORMAT_BPP2: return 2;
+        case RK_FORMAT_BPP4: return 4;
+        case RK_FORMAT_BPP8: return 8;
+        default: return 0;
+    }
+}
+
+IM_STATUS rgaCpuPalette(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &lut) {
+    RgaCpuImage simg, dimg, limg;
+    IM_STATUS ret = rgaCpuMapImage(src, &simg);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    ret = rgaCpuMapImage(dst, &dimg);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&simg);
+        return ret;
+    }
+    ret = rgaCpuMapImage(lut, &limg);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&dimg);
+        rgaCpuUnmapImage(&simg);
+        return ret;
+    }
+
+    int bits = paletteBits(simg.format);
+    int entries = 1 << bits;
+    const RgaCpuPlane &lp = limg.planes[0];
+    if (bits == 0 || dimg.planeCount != 1 || dimg.planes[0].bpp < 2 ||
+        lp.bpp < 2 || limg.width * limg.height < entries) {
+        ret = IM_STATUS_NOT_SUPPORTED;
+    } else {
+        // Pre-pack every LUT entry into the destination format once.
+        uint8_t table[256][4];
+        for (int i = 0; i < entries; i++) {
+            const uint8_t *entry = lp.data + (size_t)(i / limg.width) * lp.stride + (size_t)(i % limg.width) * lp.bpp;
+            uint8_t packed[RGA_CPU_MAX_PLANES][4];
+            rgaCpuPackColor(dimg.format, rgaCpuUnpackColor(limg.format, entry), packed);
+            memcpy(table[i], packed[0], 4);
+        }
+
+        const RgaCpuPlane &s = simg.planes[0];
+        const RgaCpuPlane &d = dimg.planes[0];
+        int width = simg.width < dimg.width ? simg.width : dimg.width;
+        int height = simg.height < dimg.height ? simg.height : dimg.height;
+        int mask = entries - 1;
+        for (int y = 0; y < height; y++) {
+            const uint8_t *srow = s.data + (size_t)y * s.stride;
+            uint8_t *drow = d.data + (size_t)y * d.stride;
+            if (bits == 8 && d.bpp == 4) {
+                uint32_t *out = (uint32_t *)drow;
+                for (int x = 0; x < width; x++) {
+                    memcpy(&out[x], table[srow[x]], 4);
+                }
+                continue;
+            }
+            for (int x = 0; x < width; x++) {
+                int bit = x * bits;
+                int index = (srow[bit >> 3] >> (bit & 7)) & mask;
+                memcpy(drow + (size_t)x * d.bpp, table[index], d.bpp);
+            }
+        }
+    }
+    rgaCpuUnmapImage(&limg);
+    rgaCpuUnmapImage(&dimg);
+    rgaCpuUnmapImage(&simg);
+    return ret;
+}
@@ -0,0 +1,343 @@
+#include "rga_cpu.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Separable taps are Q12; the horizontal pass keeps 8 fractional bits, so the
+// vertical pass accumulates Q20 in 32 bits. That leaves room for kernels whose
+// absolute tap sum is at most 2 per axis; anything else takes the direct path.
+#define GAUSS_TAP_BITS 12
+#define GAUSS_MID_BITS 8
+#define GAUSS_H_SHIFT (GAUSS_TAP_BITS - GAUSS_MID_BITS)
+#define GAUSS_V_SHIFT (GAUSS_TAP_BITS + GAUSS_MID_BITS)
+#define GAUSS_MAX_KSIZE 255
+
+static double defaultSigma(int ksize) {
+    return 0.3 * ((ksize - 1) * 0.5 - 1) + 0.8;
+}
+
+static void gaussian1D(int ksize, double sigma, std::vector<double> &taps) {
+    if (sigma <= 0) {
+        sigma = defaultSigma(ksize);
+    }
+    taps.resize(ksize);
+    double sum = 0;
+    int r = ksize / 2;
+    for (int i = 0; i < ksize; i++) {
+        double d = i - r;
+        taps[i] = exp(-(d * d) / (2 * sigma * sigma));
+        sum += taps[i];
+    }
+    for (int i = 0; i < ksize; i++) {
+        taps[i] /= sum;
+    }
+}
+
+void rgaCpuGaussianKernel(const im_gauss_t &gauss, double *matrix) {
+    int kw = gauss.ksize.width;
+    int kh = gauss.ksize.height;
+    if (gauss.matrix != nullptr) {
+        memcpy(matrix, gauss.matrix, sizeof(double) * kw * kh);
+        return;
+    }
+    // sigma_y defaults to sigma_x; if both are 0 each axis derives its own from ksize.
+    std::vector<double> tx, ty;
+    gaussian1D(kw, gauss.sigma_x, tx);
+    gaussian1D(kh, gauss.sigma_y > 0 ? gauss.sigma_y : gauss.sigma_x, ty);
+    for (int y = 0; y < kh; y++) {
+        for (int x = 0; x < kw; x++) {
+            matrix[y * kw + x] = ty[y] * tx[x];
+        }
+    }
+}
+
+// Split a rank-1 matrix into column and row vectors, false if it is not separable.
+static bool separate(const double *m, int kw, int kh, std::vector<double> &col, std::vector<double> &row) {
+    int pr = 0, pc = 0;
+    for (int i = 0; i < kw * kh; i++) {
+        if (fabs(m[i]) > fabs(m[pr * kw + pc])) {
+            pr = i / kw;
+            pc = i % kw;
+        }
+    }
+    double pivot = m[pr * kw + pc];
+    if (pivot == 0) {
+        return false;
+    }
+    row.assign(m + pr * kw, m + pr * kw + kw);
+    col.resize(kh);
+    for (int y = 0; y < kh; y++) {
+        col[y] = m[y * kw + pc] / pivot;
+    }
+    for (int y = 0; y < kh; y++) {
+        for (int x = 0; x < kw; x++) {
+            if (fabs(col[y] * row[x] - m[y * kw + x]) > 1e-6) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Quantize taps, pushing the rounding error into the center tap so the sum is exact.
+static bool quantize(const std::vector<double> &taps, std::vector<int32_t> &q) {
+    double sum = 0, absSum = 0;
+    int64_t qsum = 0;
+    q.resize(taps.size());
+    for (size_t i = 0; i < taps.size(); i++) {
+        q[i] = (int32_t)lround(taps[i] * (1 << GAUSS_TAP_BITS));
+        qsum += q[i];
+        sum += taps[i];
+        absSum += fabs(taps[i]);
+    }
+    if (absSum > 2) {
+        return false;
+    }
+    q[taps.size() / 2] += (int32_t)(lround(sum * (1 << GAUSS_TAP_BITS)) - qsum);
+    return true;
+}
+
+static inline uint8_t clampU8(int32_t v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+// Horizontal pass over one padded row of interleaved channels. Tap k of
+// element i reads byte i + k * bpp, so the loop is channel agnostic.
+static void convolveRow(const uint8_t *padded, int32_t *out, int bytes, int bpp,
+                        const int32_t *taps, int ntaps) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= bytes; i += 8) {
+        int32x4_t lo = vdupq_n_s32(0);
+        int32x4_t hi = vdupq_n_s32(0);
+        for (int k = 0; k < ntaps; k++) {
+            int16x8_t px = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(padded + i + k * bpp)));
+            lo = vmlal_n_s16(lo, vget_low_s16(px), (int16_t)taps[k]);
+            hi = vmlal_n_s16(hi, vget_high_s16(px), (int16_t)taps[k]);
+        }
+        vst1q_s32(out + i, vrshrq_n_s32(lo, GAUSS_H_SHIFT));
+        vst1q_s32(out + i + 4, vrshrq_n_s32(hi, GAUSS_H_SHIFT));
+    }
+#endif
+    for (; i < bytes; i++) {
+        int32_t acc = 0;
+        for (int k = 0; k < ntaps; k++) {
+            acc += taps[k] * padded[i + k * bpp];
+        }
+        out[i] = (acc + (1 << (GAUSS_H_SHIFT - 1))) >> GAUSS_H_SHIFT;
+    }
+}
+
+static void convolveColumn(int32_t *const *rows, uint8_t *out, int bytes,
+                           const int32_t *taps, int ntaps) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= bytes; i += 8) {
+        int32x4_t lo = vdupq_n_s32(0);
+        int32x4_t hi = vdupq_n_s32(0);
+        for (int k = 0; k < ntaps; k++) {
+            lo = vmlaq_n_s32(lo, vld1q_s32(rows[k] + i), taps[k]);
+            hi = vmlaq_n_s32(hi, vld1q_s32(rows[k] + i + 4), taps[k]);
+        }
+        uint16x4_t l16 = vqmovun_s32(vrshrq_n_s32(lo, GAUSS_V_SHIFT));
+        uint16x4_t h16 = vqmovun_s32(vrshrq_n_s32(hi, GAUSS_V_SHIFT));
+        vst1_u8(out + i, vqmovn_u16(vcombine_u16(l16, h16)));
+    }
+#endif
+    for (; i < bytes; i++) {
+        int32_t acc = 0;
+        for (int k = 0; k < ntaps; k++) {
+            acc += taps[k] * rows[k][i];
+        }
+        out[i] = clampU8((acc + (1 << (GAUSS_V_SHIFT - 1))) >> GAUSS_V_SHIFT);
+    }
+}
+
+typedef struct {
+    std::vector<double> matrix;
+    std::vector<int32_t> kx, ky;
+    int kw, kh;
+    bool separable;
+} PlaneKernel;
+
+static int scaledKsize(int ksize, int shift) {
+    return ((ksize / 2) >> shift) * 2 + 1;
+}
+
+// A generated kernel shrinks with the plane's subsampling so 4:2:0 / 4:2:2
+// chroma is blurred over the same image area as luma. Explicit matrices are
+// applied to every plane as given.
+static void buildPlaneKernel(const im_gauss_t &gauss, int xshift, int yshift, PlaneKernel &k) {
+    im_gauss_t g = gauss;
+    if (gauss.matrix == nullptr && (xshift > 0 || yshift > 0)) {
+        double sx = gauss.sigma_x > 0 ? gauss.sigma_x : defaultSigma(gauss.ksize.width);
+        double sy = gauss.sigma_y > 0 ? gauss.sigma_y
+                                      : (gauss.sigma_x > 0 ? gauss.sigma_x : defaultSigma(gauss.ksize.height));
+        g.ksize.width = scaledKsize(gauss.ksize.width, xshift);
+        g.ksize.height = scaledKsize(gauss.ksize.height, yshift);
+        g.sigma_x = sx / (1 << xshift);
+        g.sigma_y = sy / (1 << yshift);
+    }
+    k.kw = g.ksize.width;
+    k.kh = g.ksize.height;
+    k.matrix.resize((size_t)k.kw * k.kh);
+    rgaCpuGaussianKernel(g, k.matrix.data());
+    std::vector<double> col, row;
+    k.separable = separate(k.matrix.data(), k.kw, k.kh, col, row) && quantize(row, k.kx) && quantize(col, k.ky);
+}
+
+static void buildPaddedRow(const RgaCpuPlane &src, int sy, int radius, int borderType, uint8_t *padded) {
+    int bpp = src.bpp;
+    int total = src.width + 2 * radius;
+    if (sy < 0) {
+        memset(padded, 0, (size_t)total * bpp);
+        return;
+    }
+    const uint8_t *row = src.data + (size_t)sy * src.stride;
+    memcpy(padded + (size_t)radius * bpp, row, (size_t)src.width * bpp);
+    for (int x = 0; x < radius; x++) {
+        int l = rgaCpuBorderIndex(x - radius, src.width, borderType);
+        int r = rgaCpuBorderIndex(src.width + x, src.width, borderType);
+        uint8_t *pl = padded + (size_t)x * bpp;
+        uint8_t *pr = padded + (size_t)(radius + src.width + x) * bpp;
+        if (l < 0) memset(pl, 0, bpp); else memcpy(pl, row + (size_t)l * bpp, bpp);
+        if (r < 0) memset(pr, 0, bpp); else memcpy(pr, row + (size_t)r * bpp, bpp);
+    }
+}
+
+// Vertical taps slide over a ring of ksize.height horizontally filtered rows.
+static void separableBand(const RgaCpuPlane &src, const RgaCpuPlane &dst, int y0, int y1,
+                          const std::vector<int32_t> &kx, const std::vector<int32_t> &ky, int borderType) {
+    int rx = (int)kx.size() / 2;
+    int ry = (int)ky.size() / 2;
+    int kh = (int)ky.size();
+    int bytes = src.width * src.bpp;
+
+    std::vector<uint8_t> padded((size_t)(src.width + 2 * rx) * src.bpp);
+    std::vector<int32_t> ring((size_t)kh * bytes);
+    auto filterRow = [&](int j) {
+        buildPaddedRow(src, rgaCpuBorderIndex(y0 - ry + j, src.height, borderType), rx, borderType, padded.data());
+        convolveRow(padded.data(), ring.data() + (size_t)(j % kh) * bytes, bytes, src.bpp, kx.data(), (int)kx.size());
+    };
+
+    for (int j = 0; j < kh - 1; j++) {
+        filterRow(j);
+    }
+    std::vector<int32_t *> window(kh);
+    for (int y = y0; y < y1; y++) {
+        int r = y - y0;
+        filterRow(r + kh - 1);
+        for (int k = 0; k < kh; k++) {
+            window[k] = ring.data() + (size_t)((r + k) % kh) * bytes;
+        }
+        convolveColumn(window.data(), dst.data + (size_t)y * dst.stride, bytes, ky.data(), kh);
+    }
+}
+
+// Direct 2D convolution for explicit matrices that are not rank 1.
+static void directBand(const RgaCpuPlane &src, const RgaCpuPlane &dst, int y0, int y1,
+                       const double *m, int kw, int kh, int borderType) {
+    int rx = kw / 2;
+    int ry = kh / 2;
+    int bpp = src.bpp;
+    for (int y = y0; y < y1; y++) {
+        uint8_t *out = dst.data + (size_t)y * dst.stride;
+        for (int x = 0; x < src.width; x++) {
+            for (int c = 0; c < bpp; c++) {
+                double acc = 0;
+                for (int j = 0; j < kh; j++) {
+                    int sy = rgaCpuBorderIndex(y + j - ry, src.height, borderType);
+                    if (sy < 0) {
+                        continue;
+                    }
+                    const uint8_t *row = src.data + (size_t)sy * src.stride;
+                    for (int i = 0; i < kw; i++) {
+                        int sx = rgaCpuBorderIndex(x + i - rx, src.width, borderType);
+                        if (sx >= 0) {
+                            acc += m[j * kw + i] * row[sx * bpp + c];
+                        }
+                    }
+                }
+                out[x * bpp + c] = clampU8((int32_t)lround(acc));
+            }
+        }
+    }
+}
+
+IM_STATUS rgaCpuGaussianBlur(const rga_buffer_t &src, const rga_buffer_t &dst,
+                             const im_gauss_t &gauss, int borderType) {
+    int kw = gauss.ksize.width;
+    int kh = gauss.ksize.height;
+    if (kw <= 0 || kh <= 0 || !(kw & 1) || !(kh & 1) || kw > GAUSS_MAX_KSIZE || kh > GAUSS_MAX_KSIZE) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    if (borderType != IM_BORDER_CONSTANT && borderType != IM_BORDER_REFLECT && borderType != IM_BORDER_WRAP) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    RgaCpuImage simg, dimg;
+    IM_STATUS ret = rgaCpuMapImage(src, &simg);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    ret = rgaCpuMapImage(dst, &dimg);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&simg);
+        return ret;
+    }
+    if (simg.format != dimg.format || simg.width != dimg.width || simg.height != dimg.height ||
+        !rgaFormatFind(simg.format)->byteSamples) {
+        rgaCpuUnmapImage(&dimg);
+        rgaCpuUnmapImage(&simg);
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    // Bands read rows outside themselves, so an in-place blur needs a source copy.
+    bool inPlace = (src.vir_addr != nullptr && src.vir_addr == dst.vir_addr) ||
+                   (src.vir_addr == nullptr && src.fd > 0 && src.fd == dst.fd);
+    size_t copySize = 0;
+    for (int p = 0; p < simg.planeCount; p++) {
+        if (inPlace) {
+            copySize += (size_t)simg.planes[p].stride * simg.planes[p].height;
+        }
+    }
+    std::vector<uint8_t> copy(copySize);
+    size_t offset = 0;
+    for (int p = 0; p < simg.planeCount; p++) {
+        RgaCpuPlane &sp = simg.planes[p];
+        if (inPlace) {
+            size_t size = (size_t)sp.stride * sp.height;
+            memcpy(copy.data() + offset, sp.data, size);
+            sp.data = copy.data() + offset;
+            offset += size;
+        }
+    }
+
+    PlaneKernel kernel;
+    int kernelShift = -1;
+    for (int p = 0; p < simg.planeCount; p++) {
+        const RgaCpuPlane &sp = simg.planes[p];
+        const RgaCpuPlane &dp = dimg.planes[p];
+        int shift = sp.xshift << 8 | sp.yshift;
+        if (shift != kernelShift) {
+            buildPlaneKernel(gauss, sp.xshift, sp.yshift, kernel);
+            kernelShift = shift;
+        }
+        rgaCpuParallelFor(sp.height, [&](int begin, int end) {
+            if (kernel.separable) {
+                separableBand(sp, dp, begin, end, kernel.kx, kernel.ky, borderType);
+            } else {
+                directBand(sp, dp, begin, end, kernel.matrix.data(), kernel.kw, kernel.kh, borderType);
+            }
+        });
+    }
+
+    rgaCpuUnmapImage(&dimg);
+    rgaCpuUnmapImage(&simg);
+    return IM_STATUS_SUCCESS;
+}
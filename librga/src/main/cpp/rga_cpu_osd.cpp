@@ -0,0 +1,273 @@
+#include "rga_cpu.h"
+
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Stand-in for the RGA's flag RAM read by IM_OSD_FLAGS_INTERNAL.
+static std::mutex gFlagsMutex;
+static std::map<int, uint64_t> gFlagsRam;
+
+// The rect (all zeros = whole image, otherwise inside img), block size along
+// the block direction and the number of blocks that start inside the rect.
+static IM_STATUS osdBlocks(const RgaCpuImage &img, const im_osd_t &config, const im_rect &osdRect,
+                           im_rect *rect, int *span, int *count) {
+    const im_osd_block_t &block = config.block_parm;
+    if (block.width_mode != IM_OSD_BLOCK_MODE_NORMAL) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    if (block.block_count <= 0 || block.block_count > RGA_CPU_OSD_MAX_BLOCKS || block.width <= 0) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    bool whole = osdRect.x == 0 && osdRect.y == 0 && osdRect.width == 0 && osdRect.height == 0;
+    *rect = whole ? im_rect{0, 0, img.width, img.height} : osdRect;
+    if (rect->x < 0 || rect->y < 0 || rect->width <= 0 || rect->height <= 0 ||
+        rect->x + rect->width > img.width || rect->y + rect->height > img.height) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    int extent = block.direction == IM_OSD_MODE_VERTICAL ? rect->height : rect->width;
+    *span = block.width;
+    *count = (extent + *span - 1) / *span;
+    if (*count > block.block_count) {
+        *count = block.block_count;
+    }
+    return IM_STATUS_SUCCESS;
+}
+
+static IM_STATUS measureBlocks(const RgaCpuImage &img, const im_osd_t &config, const im_rect &osdRect,
+                               RgaCpuOsdStatistics *stats) {
+    im_rect rect;
+    int span, count;
+    IM_STATUS ret = osdBlocks(img, config, osdRect, &rect, &span, &count);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    // YUV images are judged on their Y samples as stored.
+    const RgaCpuPlane &p0 = img.planes[0];
+    bool direct = rgaFormatFind(img.format)->yuv && p0.bpp == 1;
+    if (!direct && !rgaCpuCanLoadRgb(img.format)) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    bool vertical = config.block_parm.direction == IM_OSD_MODE_VERTICAL;
+    uint64_t sums[RGA_CPU_OSD_MAX_BLOCKS] = {0};
+    std::vector<uint8_t> luma(rect.width), r(rect.width), g(rect.width), b(rect.width);
+    for (int y = 0; y < rect.height; y++) {
+        if (vertical && y / span >= count) {
+            break;
+        }
+        const uint8_t *row = luma.data();
+        if (direct) {
+            row = p0.data + (size_t)(rect.y + y) * p0.stride + rect.x;
+        } else {
+            rgaCpuLoadRgbRow(img, rect.y + y, rect.x, rect.width, r.data(), g.data(), b.data());
+            for (int x = 0; x < rect.width; x++) {
+                luma[x] = (uint8_t)((77 * r[x] + 150 * g[x] + 29 * b[x] + 128) >> 8);
+            }
+        }
+        if (vertical) {
+            uint64_t sum = 0;
+            for (int x = 0; x < rect.width; x++) {
+                sum += row[x];
+            }
+            sums[y / span] += sum;
+            continue;
+        }
+        for (int i = 0; i < count; i++) {
+            int end = (i + 1) * span < rect.width ? (i + 1) * span : rect.width;
+            uint64_t sum = 0;
+            for (int x = i * span; x < end; x++) {
+                sum += row[x];
+            }
+            sums[i] += sum;
+        }
+    }
+
+    int extent = vertical ? rect.height : rect.width;
+    int across = vertical ? rect.width : rect.height;
+    memset(stats, 0, sizeof(RgaCpuOsdStatistics));
+    stats->blocks = count;
+    for (int i = 0; i < count; i++) {
+        int length = extent - i * span < span ? extent - i * span : span;
+        uint64_t pixels = (uint64_t)length * across;
+        stats->luma[i] = (uint8_t)((sums[i] + pixels / 2) / pixels);
+        if (stats->luma[i] > config.invert_config.threash) {
+            stats->flags |= 1ULL << i;
+        }
+    }
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS rgaCpuOsdStatistics(const rga_buffer_t &dst, const im_rect &osdRect, const im_osd_t &config,
+                              RgaCpuOsdStatistics *stats) {
+    RgaCpuImage img;
+    IM_STATUS ret = rgaCpuMapImage(dst, &img);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    ret = measureBlocks(img, config, osdRect, stats);
+    rgaCpuUnmapImage(&img);
+    return ret;
+}
+
+bool rgaCpuOsdInverted(const im_osd_t &config, uint64_t flags, int block) {
+    if (block < 0 || block >= RGA_CPU_OSD_MAX_BLOCKS) {
+        return false;
+    }
+    bool bright = (flags >> block) & 1;
+    return bright == (config.block_parm.background_config == IM_OSD_BACKGROUND_DEFAULT_DARK);
+}
+
+static uint8_t invertChannel(const im_osd_invert_t &invert, uint8_t value, uint8_t max, uint8_t min) {
+    if (invert.invert_mode == IM_OSD_INVERT_USE_SWAP) {
+        return (uint8_t)(255 - value);
+    }
+    int v = max - value;
+    return (uint8_t)(v < min ? min : v);
+}
+
+// The inverted 0xAABBGGRR colour for the enabled channels.
+static uint32_t invertColor(const im_osd_invert_t &invert, uint32_t color) {
+    uint8_t c[4] = {(uint8_t)color, (uint8_t)(color >> 8), (uint8_t)(color >> 16), (uint8_t)(color >> 24)};
+    const im_osd_invert_factor_t &f = invert.factor;
+    if (invert.invert_channel & IM_OSD_INVERT_CHANNEL_C_RB) {
+        c[0] = invertChannel(invert, c[0], f.crb_max, f.crb_min);
+        c[2] = invertChannel(invert, c[2], f.crb_max, f.crb_min);
+    }
+    if (invert.invert_channel & IM_OSD_INVERT_CHANNEL_Y_G) {
+        c[1] = invertChannel(invert, c[1], f.yg_max, f.yg_min);
+    }
+    if (invert.invert_channel & IM_OSD_INVERT_CHANNEL_ALPHA) {
+        c[3] = invertChannel(invert, c[3], f.alpha_max, f.alpha_min);
+    }
+    return c[0] | c[1] << 8 | c[2] << 16 | (uint32_t)c[3] << 24;
+}
+
+// Row of an RK_FORMAT_RGBA2BPP image as 0xAABBGGRR through the bpp2 colour table.
+static void loadBpp2Row(const RgaCpuPlane &plane, const im_osd_bpp2_t &bpp2, int y, int count,
+                        const uint32_t table[2], uint32_t *out) {
+    const uint8_t *row = plane.data + (size_t)y * plane.stride;
+    for (int x = 0; x < count; x++) {
+        int shift = bpp2.endian_swap ? (x & 3) * 2 : 6 - (x & 3) * 2;
+        int v = (row[x >> 2] >> shift) & 3;
+        int color = bpp2.ac_swap ? v & 1 : v >> 1;
+        int alpha = bpp2.ac_swap ? v >> 1 : v & 1;
+        out[x] = alpha ? table[color] : 0;
+    }
+}
+
+IM_STATUS rgaCpuOsd(const rga_buffer_t &osd, const rga_buffer_t &dst, const im_rect &osdRect, im_osd_t *config) {
+    if (config == nullptr) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    RgaCpuImage simg, dimg;
+    IM_STATUS ret = rgaCpuMapImage(osd, &simg);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    ret = rgaCpuMapImage(dst, &dimg);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&simg);
+        return ret;
+    }
+
+    im_rect rect;
+    int span, count;
+    bool bpp2 = simg.format == RK_FORMAT_RGBA2BPP;
+    ret = osdBlocks(dimg, *config, osdRect, &rect, &span, &count);
+    if (ret == IM_STATUS_SUCCESS &&
+        ((!bpp2 && !rgaCpuCanLoadRgb(simg.format)) || !rgaCpuCanLoadRgb(dimg.format))) {
+        ret = IM_STATUS_NOT_SUPPORTED;
+    }
+
+    // Flags come from this frame, the caller, or an earlier statistics pass.
+    im_osd_invert_t &invert = config->invert_config;
+    uint64_t flags = 0;
+    if (ret == IM_STATUS_SUCCESS && (config->osd_mode & IM_OSD_MODE_STATISTICS)) {
+        RgaCpuOsdStatistics stats;
+        ret = measureBlocks(dimg, *config, rect, &stats);
+        flags = stats.flags;
+        invert.current_flags = flags;
+        std::lock_guard<std::mutex> lock(gFlagsMutex);
+        gFlagsRam[invert.flags_index] = flags;
+    } else if (invert.flags_mode == IM_OSD_FLAGS_INTERNAL) {
+        std::lock_guard<std::mutex> lock(gFlagsMutex);
+        auto it = gFlagsRam.find(invert.flags_index);
+        flags = it != gFlagsRam.end() ? it->second : 0;
+    }
+    if (invert.flags_mode == IM_OSD_FLAGS_EXTERNAL) {
+        flags = invert.invert_flags;
+    }
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&dimg);
+        rgaCpuUnmapImage(&simg);
+        return ret;
+    }
+
+    const im_osd_block_t &block = config->block_parm;
+    bool autoInvert = (config->osd_mode & IM_OSD_MODE_AUTO_INVERT) != 0;
+    bool vertical = block.direction == IM_OSD_MODE_VERTICAL;
+    int width = simg.width < rect.width ? simg.width : rect.width;
+    int height = simg.height < rect.height ? simg.height : rect.height;
+
+    // Colour tables per inversion state: [0] normal, [1] inverted.
+    uint32_t external[2] = {block.normal_color.value, block.invert_color.value};
+    uint32_t table[2][2] = {{config->bpp2_info.color0.value, config->bpp2_info.color1.value}, {0, 0}};
+    if (invert.invert_mode == IM_OSD_INVERT_USE_SWAP) {
+        table[1][0] = table[0][1];
+        table[1][1] = table[0][0];
+    } else {
+        table[1][0] = invertColor(invert, table[0][0]);
+        table[1][1] = invertColor(invert, table[0][1]);
+    }
+
+    std::vector<uint32_t> src(width), alt(width);
+    std::vector<uint8_t> sr(width), sg(width), sb(width), sa(width);
+    std::vector<uint8_t> dr(width), dg(width), db(width), da(width);
+    for (int y = 0; y < height; y++) {
+        if (bpp2) {
+            loadBpp2Row(simg.planes[0], config->bpp2_info, y, width, table[0], src.data());
+            loadBpp2Row(simg.planes[0], config->bpp2_info, y, width, table[1], alt.data());
+        } else {
+            rgaCpuLoadRgbRow(simg, y, 0, width, sr.data(), sg.data(), sb.data());
+            rgaCpuLoadAlphaRow(simg, y, 0, width, sa.data());
+        }
+        for (int x = 0; x < width; x++) {
+            int index = vertical ? y / span : x / span;
+            bool inverted = autoInvert && index < count && rgaCpuOsdInverted(*config, flags, index);
+            uint32_t color;
+            if (bpp2) {
+                color = inverted ? alt[x] : src[x];
+            } else {
+                color = sr[x] | sg[x] << 8 | sb[x] << 16 | (uint32_t)sa[x] << 24;
+                color = inverted ? invertColor(invert, color) : color;
+            }
+            if (block.color_mode == IM_OSD_COLOR_EXTERNAL) {
+                // The OSD image only provides coverage; the colour is configured.
+                uint32_t c = external[inverted ? 1 : 0];
+                color = (c & 0xffffff) | (uint32_t)((c >> 24) * (color >> 24) / 255) << 24;
+            }
+            src[x] = color;
+        }
+
+        // Straight-alpha src over.
+        rgaCpuLoadRgbRow(dimg, rect.y + y, rect.x, width, dr.data(), dg.data(), db.data());
+        rgaCpuLoadAlphaRow(dimg, rect.y + y, rect.x, width, da.data());
+        for (int x = 0; x < width; x++) {
+            int a = src[x] >> 24;
+            if (a == 0) {
+                continue;
+            }
+            int keep = 255 - a;
+            dr[x] = (uint8_t)(((src[x] & 0xff) * a + dr[x] * keep + 127) / 255);
+            dg[x] = (uint8_t)(((src[x] >> 8 & 0xff) * a + dg[x] * keep + 127) / 255);
+            db[x] = (uint8_t)(((src[x] >> 16 & 0xff) * a + db[x] * keep + 127) / 255);
+            da[x] = (uint8_t)(a + da[x] * keep / 255);
+        }
+        rgaCpuStoreRgbRow(dimg, rect.y + y, rect.x, width, dr.data(), dg.data(), db.data(), da.data());
+    }
+    rgaCpuUnmapImage(&dimg);
+    rgaCpuUnmapImage(&simg);
+    return IM_STATUS_SUCCESS;
+}
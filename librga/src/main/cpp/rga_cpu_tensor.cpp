@@ -0,0 +1,282 @@
+#include "rga_cpu.h"
+
+#include <string.h>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Crop + bilinear resize + color conversion + quantization in one pass.
+ *
+ * Each source row is converted to planar RGB and resampled horizontally once
+ * (kept as Q7 16-bit values in a two-row cache), then pairs of cached rows are
+ * blended vertically, quantized and stored straight into the tensor.
+ */
+
+#define WEIGHT_BITS 7
+#define WEIGHT_ONE (1 << WEIGHT_BITS)
+
+typedef struct {
+    int i0;     /* first tap, relative to the crop */
+    int i1;     /* second tap */
+    int w;      /* weight of the second tap, Q7 */
+} Tap;
+
+// Pixel-center aligned bilinear taps mapping dstLen samples onto srcLen.
+static void buildTaps(int srcLen, int dstLen, std::vector<Tap> &taps) {
+    taps.resize(dstLen);
+    for (int d = 0; d < dstLen; d++) {
+        int64_t pos = ((int64_t)(2 * d + 1) * srcLen * WEIGHT_ONE) / (2 * dstLen) - WEIGHT_ONE / 2;
+        if (pos < 0) {
+            pos = 0;
+        }
+        int i0 = (int)(pos >> WEIGHT_BITS);
+        int w = (int)(pos & (WEIGHT_ONE - 1));
+        if (i0 >= srcLen - 1) {
+            i0 = srcLen - 1;
+            w = 0;
+        }
+        taps[d].i0 = i0;
+        taps[d].i1 = i0 + 1 < srcLen ? i0 + 1 : i0;
+        taps[d].w = w;
+    }
+}
+
+static void resampleRow(const uint8_t *src, const std::vector<Tap> &taps, uint16_t *dst) {
+    int n = (int)taps.size();
+    for (int i = 0; i < n; i++) {
+        const Tap &t = taps[i];
+        dst[i] = (uint16_t)(src[t.i0] * (WEIGHT_ONE - t.w) + src[t.i1] * t.w);
+    }
+}
+
+typedef struct {
+    int scale;      /* Q8 */
+    int offset;
+} ChannelQuant;
+
+// Blend two Q7 rows with weight w (Q7), then apply (v + offset) * scale / 256.
+static void blendRow(const uint16_t *a, const uint16_t *b, int w, int count,
+                     const ChannelQuant *q, uint8_t *dst, int dstStep) {
+    int wa = WEIGHT_ONE - w;
+    int i = 0;
+#if defined(__ARM_NEON)
+    if (dstStep == 1) {
+        for (; i + 8 <= count; i += 8) {
+            uint16x8_t va = vld1q_u16(a + i);
+            uint16x8_t vb = vld1q_u16(b + i);
+            uint32x4_t lo = vmlal_n_u16(vmull_n_u16(vget_low_u16(va), wa), vget_low_u16(vb), w);
+            uint32x4_t hi = vmlal_n_u16(vmull_n_u16(vget_high_u16(va), wa), vget_high_u16(vb), w);
+            uint16x8_t v = vcombine_u16(vrshrn_n_u32(lo, 2 * WEIGHT_BITS), vrshrn_n_u32(hi, 2 * WEIGHT_BITS));
+            if (q != nullptr) {
+                int16x8_t s = vaddq_s16(vreinterpretq_s16_u16(v), vdupq_n_s16((int16_t)q->offset));
+                int32x4_t sLo = vmull_n_s16(vget_low_s16(s), (int16_t)q->scale);
+                int32x4_t sHi = vmull_n_s16(vget_high_s16(s), (int16_t)q->scale);
+                v = vcombine_u16(vqrshrun_n_s32(sLo, 8), vqrshrun_n_s32(sHi, 8));
+            }
+            vst1_u8(dst + i, vqmovn_u16(v));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        int v = (a[i] * wa + b[i] * w + (1 << (2 * WEIGHT_BITS - 1))) >> (2 * WEIGHT_BITS);
+        if (q != nullptr) {
+            v = ((v + q->offset) * q->scale + 128) >> 8;
+            v = v < 0 ? 0 : (v > 255 ? 255 : v);
+        }
+        dst[(size_t)i * dstStep] = (uint8_t)v;
+    }
+}
+
+static bool validRect(const im_rect &r, int width, int height) {
+    return r.x >= 0 && r.y >= 0 && r.width > 0 && r.height > 0 &&
+           r.x + r.width <= width && r.y + r.height <= height;
+}
+
+static im_rect wholeIfEmpty(const im_rect &r, int width, int height) {
+    if (r.x == 0 && r.y == 0 && r.width == 0 && r.height == 0) {
+        return {0, 0, width, height};
+    }
+    return r;
+}
+
+// Destination rows for the three channels of one tensor row.
+typedef struct {
+    uint8_t *base;
+    size_t channelStride;   /* NCHW: bytes between channel planes, NHWC: 1 */
+    size_t rowStride;
+    int pixelStep;          /* NHWC: 3, NCHW: 1 */
+    int channel[3];         /* tensor channel index of R, G, B */
+} TensorLayout;
+
+static IM_STATUS mapTensor(const rga_buffer_t &tensor, int layout, RgaCpuImage *img, TensorLayout *tl) {
+    int format = rgaFormatNormalize(tensor.format);
+    if (format != RK_FORMAT_RGB_888 && format != RK_FORMAT_BGR_888) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    if (layout != RGA_CPU_TENSOR_NHWC && layout != RGA_CPU_TENSOR_NCHW) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    IM_STATUS ret = rgaCpuMapImage(tensor, img);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    int wstride = tensor.wstride > 0 ? tensor.wstride : tensor.width;
+    int hstride = tensor.hstride > 0 ? tensor.hstride : tensor.height;
+    tl->base = img->planes[0].data;
+    if (layout == RGA_CPU_TENSOR_NHWC) {
+        tl->channelStride = 1;
+        tl->rowStride = img->planes[0].stride;
+        tl->pixelStep = 3;
+    } else {
+        // Same bytes as a packed wstride x hstride RGB_888 image, split into three planes.
+        tl->channelStride = (size_t)wstride * hstride;
+        tl->rowStride = wstride;
+        tl->pixelStep = 1;
+    }
+    bool bgr = format == RK_FORMAT_BGR_888;
+    tl->channel[0] = bgr ? 2 : 0;
+    tl->channel[1] = 1;
+    tl->channel[2] = bgr ? 0 : 2;
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS rgaCpuPrepareTensor(const rga_buffer_t &src, const im_rect &srcRect,
+                              const rga_buffer_t &tensor, const im_rect &dstRect,
+                              int layout, const im_nn_t *nn) {
+    if (!rgaCpuCanLoadRgb(src.format)) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    im_rect srect = wholeIfEmpty(srcRect, src.width, src.height);
+    im_rect drect = wholeIfEmpty(dstRect, tensor.width, tensor.height);
+    if (!validRect(srect, src.width, src.height) || !validRect(drect, tensor.width, tensor.height)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    ChannelQuant quant[3];
+    bool quantize = false;
+    if (nn != nullptr) {
+        quant[0] = {nn->scale_r, nn->offset_r};
+        quant[1] = {nn->scale_g, nn->offset_g};
+        quant[2] = {nn->scale_b, nn->offset_b};
+        for (int c = 0; c < 3; c++) {
+            if (quant[c].scale < 0 || quant[c].scale > 1023 ||
+                quant[c].offset < -255 || quant[c].offset > 255) {
+                return IM_STATUS_INVALID_PARAM;
+            }
+            quantize |= quant[c].scale != 256 || quant[c].offset != 0;
+        }
+    }
+
+    RgaCpuImage simg;
+    IM_STATUS ret = rgaCpuMapImage(src, &simg);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    RgaCpuImage timg;
+    TensorLayout tl;
+    ret = mapTensor(tensor, layout, &timg, &tl);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&simg);
+        return ret;
+    }
+
+    std::vector<Tap> xTaps, yTaps;
+    buildTaps(srect.width, drect.width, xTaps);
+    buildTaps(srect.height, drect.height, yTaps);
+
+    rgaCpuParallelFor(drect.height, [&](int begin, int end) {
+        int dw = drect.width;
+        int sw = srect.width;
+        std::vector<uint8_t> rgb((size_t)sw * 3);
+        // Two cached source rows, three Q7 channel rows each.
+        std::vector<uint16_t> cache((size_t)dw * 6);
+        int cachedRow[2] = {-1, -1};
+
+        auto fetch = [&](int sy) -> const uint16_t * {
+            for (int k = 0; k < 2; k++) {
+                if (cachedRow[k] == sy) {
+                    return &cache[(size_t)k * dw * 3];
+                }
+            }
+            // Output rows only move forward, so the lower cached row is the stale one.
+            int k = cachedRow[0] < cachedRow[1] ? 0 : 1;
+            uint16_t *slot = &cache[(size_t)k * dw * 3];
+            uint8_t *r = rgb.data();
+            rgaCpuLoadRgbRow(simg, srect.y + sy, srect.x, sw, r, r + sw, r + 2 * sw);
+            for (int c = 0; c < 3; c++) {
+                resampleRow(r + (size_t)c * sw, xTaps, slot + (size_t)c * dw);
+            }
+            cachedRow[k] = sy;
+            return slot;
+        };
+
+        for (int dy = begin; dy < end; dy++) {
+            const Tap &t = yTaps[dy];
+            const uint16_t *a = fetch(t.i0);
+            const uint16_t *b = t.i1 == t.i0 ? a : fetch(t.i1);
+            uint8_t *row = tl.base + (size_t)(drect.y + dy) * tl.rowStride +
+                           (size_t)drect.x * tl.pixelStep;
+            for (int c = 0; c < 3; c++) {
+                uint8_t *out = row + tl.channel[c] * tl.channelStride;
+                blendRow(a + (size_t)c * dw, b + (size_t)c * dw, t.w, dw,
+                         quantize ? &quant[c] : nullptr, out, tl.pixelStep);
+            }
+        }
+    });
+
+    rgaCpuUnmapImage(&timg);
+    rgaCpuUnmapImage(&simg);
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS rgaCpuTensorToPlanar(const rga_buffer_t &packed, const rga_buffer_t &tensor,
+                               const im_rect &dstRect) {
+    im_rect drect = wholeIfEmpty(dstRect, tensor.width, tensor.height);
+    if (!validRect(drect, tensor.width, tensor.height) ||
+        packed.width < drect.width || packed.height < drect.height ||
+        rgaFormatNormalize(packed.format) != rgaFormatNormalize(tensor.format)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    RgaCpuImage pimg;
+    IM_STATUS ret = rgaCpuMapImage(packed, &pimg);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    RgaCpuImage timg;
+    TensorLayout tl;
+    ret = mapTensor(tensor, RGA_CPU_TENSOR_NCHW, &timg, &tl);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&pimg);
+        return ret;
+    }
+
+    rgaCpuParallelFor(drect.height, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const uint8_t *in = pimg.planes[0].data + (size_t)y * pimg.planes[0].stride;
+            uint8_t *c0 = tl.base + (size_t)(drect.y + y) * tl.rowStride + drect.x;
+            uint8_t *c1 = c0 + tl.channelStride;
+            uint8_t *c2 = c1 + tl.channelStride;
+            int x = 0;
+#if defined(__ARM_NEON)
+            for (; x + 16 <= drect.width; x += 16) {
+                uint8x16x3_t v = vld3q_u8(in + x * 3);
+                vst1q_u8(c0 + x, v.val[0]);
+                vst1q_u8(c1 + x, v.val[1]);
+                vst1q_u8(c2 + x, v.val[2]);
+            }
+#endif
+            for (; x < drect.width; x++) {
+                c0[x] = in[x * 3];
+                c1[x] = in[x * 3 + 1];
+                c2[x] = in[x * 3 + 2];
+            }
+        }
+    });
+
+    rgaCpuUnmapImage(&timg);
+    rgaCpuUnmapImage(&pimg);
+    return IM_STATUS_SUCCESS;
+}
@@ -0,0 +1,229 @@
+#include "rga_cpu.h"
+
+#include <string.h>
+#include <vector>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// 2x2 ordered dither in units of the two dropped bits.
+static const uint8_t kBayer[2][2] = {{0, 2}, {3, 1}};
+
+bool rgaCpuIsTenBit(int format) {
+    const RgaFormatDesc *desc = rgaFormatFind(format);
+    return desc != nullptr && (desc->tenBit || desc->format == RGA_FORMAT_P010 || desc->format == RGA_FORMAT_P210);
+}
+
+static bool isCrFirst(int format) {
+    switch (format) {
+        case RK_FORMAT_YCrCb_420_SP:
+        case RK_FORMAT_YCrCb_422_SP:
+        case RK_FORMAT_YCrCb_420_SP_10B:
+        case RK_FORMAT_YCrCb_422_SP_10B:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// count samples of an LSB-first 10-bit stream (RK_FORMAT_*_SP_10B).
+static void unpackRow(const uint8_t *src, int count, uint16_t *out) {
+    int i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    // Eight samples come from 10 bytes: gather the byte pair holding each one,
+    // then shift it down by its bit offset within the pair.
+    static const uint8_t kPairs[16] = {0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8, 9};
+    static const int16_t kShift[8] = {0, -2, -4, -6, 0, -2, -4, -6};
+    uint8x16_t pairs = vld1q_u8(kPairs);
+    int16x8_t shift = vld1q_s16(kShift);
+    uint16x8_t mask = vdupq_n_u16(0x3ff);
+    int bytes = (count * 10 + 7) / 8;
+    for (; i + 8 <= count && i / 4 * 5 + 16 <= bytes; i += 8) {
+        uint8x16_t v = vld1q_u8(src + i / 4 * 5);
+        uint16x8_t s = vreinterpretq_u16_u8(vqtbl1q_u8(v, pairs));
+        vst1q_u16(out + i, vandq_u16(vshlq_u16(s, shift), mask));
+    }
+#endif
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t *p = src + i / 4 * 5;
+        out[i] = (uint16_t)(p[0] | (p[1] & 0x03) << 8);
+        out[i + 1] = (uint16_t)(p[1] >> 2 | (p[2] & 0x0f) << 6);
+        out[i + 2] = (uint16_t)(p[2] >> 4 | (p[3] & 0x3f) << 4);
+        out[i + 3] = (uint16_t)(p[3] >> 6 | p[4] << 2);
+    }
+    for (; i < count; i++) {
+        int bit = i * 10;
+        int v = src[bit >> 3] | src[(bit >> 3) + 1] << 8;
+        out[i] = (uint16_t)((v >> (bit & 7)) & 0x3ff);
+    }
+}
+
+// count P010 samples (10 bits in the top of 16) to 10-bit values.
+static void p010Row(const uint8_t *src, int count, uint16_t *out) {
+    const uint16_t *s = (const uint16_t *)src;
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        vst1q_u16(out + i, vshrq_n_u16(vld1q_u16(s + i), 6));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = (uint16_t)(s[i] >> 6);
+    }
+}
+
+// Swap the two samples of each chroma pair (Cb:Cr <-> Cr:Cb).
+static void swapPairs(uint16_t *row, int count) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        vst1q_u16(row + i, vrev32q_u16(vld1q_u16(row + i)));
+    }
+#endif
+    for (; i + 1 < count; i += 2) {
+        uint16_t t = row[i];
+        row[i] = row[i + 1];
+        row[i + 1] = t;
+    }
+}
+
+// 10 -> 8 bits; pattern[i & 3] is added first (all zero truncates).
+static void narrowRow(const uint16_t *in, int count, uint8_t *out, const uint8_t pattern[4]) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    const uint16_t lanes[8] = {pattern[0], pattern[1], pattern[2], pattern[3],
+                               pattern[0], pattern[1], pattern[2], pattern[3]};
+    uint16x8_t dither = vld1q_u16(lanes);
+    for (; i + 8 <= count; i += 8) {
+        vst1_u8(out + i, vqmovn_u16(vshrq_n_u16(vaddq_u16(vld1q_u16(in + i), dither), 2)));
+    }
+#endif
+    for (; i < count; i++) {
+        int v = (in[i] + pattern[i & 3]) >> 2;
+        out[i] = (uint8_t)(v > 255 ? 255 : v);
+    }
+}
+
+static void averageRows(uint16_t *a, const uint16_t *b, int count) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        vst1q_u16(a + i, vrhaddq_u16(vld1q_u16(a + i), vld1q_u16(b + i)));
+    }
+#endif
+    for (; i < count; i++) {
+        a[i] = (uint16_t)((a[i] + b[i] + 1) >> 1);
+    }
+}
+
+// 10-bit semi-planar simg -> 8-bit semi-planar dimg of the same size, with
+// 4:2:2 -> 4:2:0 by averaging chroma row pairs.
+static void narrowImage(const RgaCpuImage &simg, const RgaCpuImage &dimg, bool dither) {
+    bool p010 = simg.format == RGA_FORMAT_P010 || simg.format == RGA_FORMAT_P210;
+    bool swap = isCrFirst(simg.format) != isCrFirst(dimg.format);
+    int width = dimg.width;
+    int chroma = (width >> 1) * 2;
+    int dys = dimg.planes[1].yshift;
+    int sys = simg.planes[1].yshift;
+    auto loadRow = [&](int plane, int row, int count, uint16_t *out) {
+        const uint8_t *p = simg.planes[plane].data + (size_t)row * simg.planes[plane].stride;
+        if (p010) {
+            p010Row(p, count, out);
+        } else {
+            unpackRow(p, count, out);
+        }
+    };
+
+    rgaCpuParallelFor(dimg.height, [&](int begin, int end) {
+        std::vector<uint16_t> line(width), line2(chroma);
+        for (int y = begin; y < end; y++) {
+            uint8_t b0 = dither ? kBayer[y & 1][0] : 0;
+            uint8_t b1 = dither ? kBayer[y & 1][1] : 0;
+            const uint8_t luma[4] = {b0, b1, b0, b1};
+            loadRow(0, y, width, line.data());
+            narrowRow(line.data(), width, dimg.planes[0].data + (size_t)y * dimg.planes[0].stride, luma);
+
+            if ((y & ((1 << dys) - 1)) != 0) {
+                continue;
+            }
+            int cy = y >> dys;
+            if (sys == dys) {
+                loadRow(1, cy, chroma, line.data());
+            } else {
+                int rows = simg.planes[1].height;
+                loadRow(1, cy * 2 < rows ? cy * 2 : rows - 1, chroma, line.data());
+                loadRow(1, cy * 2 + 1 < rows ? cy * 2 + 1 : rows - 1, chroma, line2.data());
+                averageRows(line.data(), line2.data(), chroma);
+            }
+            if (swap) {
+                swapPairs(line.data(), chroma);
+            }
+            // Both samples of a pair sit at the same pixel and get the same threshold.
+            uint8_t c0 = dither ? kBayer[cy & 1][0] : 0;
+            uint8_t c1 = dither ? kBayer[cy & 1][1] : 0;
+            const uint8_t pairs[4] = {c0, c0, c1, c1};
+            narrowRow(line.data(), chroma, dimg.planes[1].data + (size_t)cy * dimg.planes[1].stride, pairs);
+        }
+    });
+}
+
+IM_STATUS rgaCpuConvert10Bit(const rga_buffer_t &src, const rga_buffer_t &dst, bool dither) {
+    if (!rgaCpuIsTenBit(src.format)) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    const RgaFormatDesc *sd = rgaFormatFind(src.format);
+    const RgaFormatDesc *dd = rgaFormatFind(dst.format);
+    if (dd == nullptr) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    bool yuvOut = dd->yuv && dd->planeCount == 2 && dd->byteSamples && dd->xshift == 1 && dd->yshift >= sd->yshift;
+    if (!yuvOut && !rgaCpuCanLoadRgb(dst.format)) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    if (src.width != dst.width || src.height != dst.height || (src.width | src.height) & 1) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    RgaCpuImage simg, dimg;
+    IM_STATUS ret = rgaCpuMapImage(src, &simg);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    ret = rgaCpuMapImage(dst, &dimg);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&simg);
+        return ret;
+    }
+
+    if (yuvOut) {
+        narrowImage(simg, dimg, dither);
+    } else {
+        // Narrow into 8-bit YUV of the source subsampling, then the regular
+        // BT.601 YUV -> RGB row conversion.
+        int format = sd->yshift ? RK_FORMAT_YCbCr_420_SP : RK_FORMAT_YCbCr_422_SP;
+        std::vector<uint8_t> scratch(rgaFormatImageSize(format, src.width, src.height));
+        rga_buffer_t mid;
+        memset(&mid, 0, sizeof(mid));
+        mid.vir_addr = scratch.data();
+        mid.width = mid.wstride = src.width;
+        mid.height = mid.hstride = src.height;
+        mid.format = format;
+        RgaCpuImage mimg;
+        ret = rgaCpuMapImage(mid, &mimg);
+        if (ret == IM_STATUS_SUCCESS) {
+            narrowImage(simg, mimg, dither);
+            rgaCpuParallelFor(dimg.height, [&](int begin, int end) {
+                int w = dimg.width;
+                std::vector<uint8_t> rgb((size_t)w * 3);
+                for (int y = begin; y < end; y++) {
+                    rgaCpuLoadRgbRow(mimg, y, 0, w, rgb.data(), rgb.data() + w, rgb.data() + 2 * w);
+                    rgaCpuStoreRgbRow(dimg, y, 0, w, rgb.data(), rgb.data() + w, rgb.data() + 2 * w, nullptr);
+                }
+            });
+        }
+    }
+    rgaCpuUnmapImage(&dimg);
+    rgaCpuUnmapImage(&simg);
+    return ret;
+}
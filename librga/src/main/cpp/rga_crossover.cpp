@@ -0,0 +1,250 @@
+#include "rga_crossover.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "rga_backend.h"
+#include "rga_cpu.h"
+#include "rga_stats.h"
+
+#define RGA_CROSSOVER_VERSION 1
+
+static std::atomic<bool> gEnabled(true);
+// Decision per op and bucket, read on every rgaProcess call.
+static std::atomic<bool> gPreferCpu[RGA_CROSSOVER_OP_COUNT][RGA_CROSSOVER_BUCKETS];
+static std::mutex gMutex;
+static RgaCrossoverEntry gTable[RGA_CROSSOVER_OP_COUNT][RGA_CROSSOVER_BUCKETS];
+
+static bool isEmptyRect(const im_rect &r) {
+    return r.x == 0 && r.y == 0 && r.width == 0 && r.height == 0;
+}
+
+static bool hostRaster(const rga_buffer_t &buf) {
+    return buf.vir_addr != nullptr && rgaFormatIsRaster(buf.rd_mode) && rgaCpuCanLoadRgb(buf.format);
+}
+
+static bool hasImage(const rga_buffer_t &buf) {
+    return buf.vir_addr != nullptr || buf.phy_addr != nullptr || buf.fd > 0 || buf.handle != 0;
+}
+
+// Publish gTable into gPreferCpu. Called with gMutex held.
+static void publish() {
+    for (int op = 0; op < RGA_CROSSOVER_OP_COUNT; op++) {
+        for (int b = 0; b < RGA_CROSSOVER_BUCKETS; b++) {
+            const RgaCrossoverEntry &e = gTable[op][b];
+            gPreferCpu[op][b].store(e.rgaNs > 0 && e.cpuNs > 0 && e.cpuNs < e.rgaNs, std::memory_order_relaxed);
+        }
+    }
+}
+
+void rgaCrossoverSetEnabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool rgaCrossoverEnabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+int rgaCrossoverClassify(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                         const im_rect &srect, const im_rect &drect, int acquireFence, int usage) {
+    if (acquireFence >= 0 || hasImage(pat) || !hostRaster(src) || !hostRaster(dst)) {
+        return -1;
+    }
+    if (usage & ~(IM_HAL_TRANSFORM_MASK | IM_ALPHA_BLEND_MASK | IM_SYNC | IM_CROP)) {
+        return -1;
+    }
+    int blend = usage & IM_ALPHA_BLEND_MASK;
+    if (blend != 0) {
+        return blend == IM_ALPHA_BLEND_SRC_OVER || blend == IM_ALPHA_BLEND_SRC ? RGA_CROSSOVER_BLEND : -1;
+    }
+    if (usage & IM_HAL_TRANSFORM_MASK) {
+        return RGA_CROSSOVER_TRANSFORM;
+    }
+    if (rgaFormatNormalize(src.format) != rgaFormatNormalize(dst.format)) {
+        return RGA_CROSSOVER_CVTCOLOR;
+    }
+    im_rect s = isEmptyRect(srect) ? im_rect{0, 0, src.width, src.height} : srect;
+    im_rect d = isEmptyRect(drect) ? im_rect{0, 0, dst.width, dst.height} : drect;
+    return s.width != d.width || s.height != d.height ? RGA_CROSSOVER_RESIZE : RGA_CROSSOVER_COPY;
+}
+
+int rgaCrossoverBucket(int64_t pixels) {
+    for (int b = 0; b < RGA_CROSSOVER_BUCKETS; b++) {
+        int64_t side = RGA_CROSSOVER_MIN_SIDE << b;
+        if (pixels <= side * side) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+bool rgaCrossoverPreferCpu(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                           const im_rect &srect, const im_rect &drect, int acquireFence, int usage) {
+    if (!rgaCrossoverEnabled()) {
+        return false;
+    }
+    int op = rgaCrossoverClassify(src, dst, pat, srect, drect, acquireFence, usage);
+    if (op < 0) {
+        return false;
+    }
+    int64_t spixels = isEmptyRect(srect) ? (int64_t)src.width * src.height : (int64_t)srect.width * srect.height;
+    int64_t dpixels = isEmptyRect(drect) ? (int64_t)dst.width * dst.height : (int64_t)drect.width * drect.height;
+    int bucket = rgaCrossoverBucket(std::max(spixels, dpixels));
+    return bucket >= 0 && gPreferCpu[op][bucket].load(std::memory_order_relaxed);
+}
+
+static rga_buffer_t wrap(uint8_t *data, int width, int height, int format) {
+    rga_buffer_t buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.vir_addr = data;
+    buf.width = buf.wstride = width;
+    buf.height = buf.hstride = height;
+    buf.format = format;
+    return buf;
+}
+
+// Median ns per call of one op on one engine, or 0 if it failed.
+static int64_t measure(RgaEngine engine, const rga_buffer_t &src, const rga_buffer_t &dst,
+                       int usage, int core, int iterations) {
+    im_opt_t opt = {};
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = core;
+    std::vector<int64_t> samples;
+    for (int i = 0; i <= iterations; i++) {
+        uint64_t start = rgaStatsNowNs();
+        IM_STATUS ret = rgaProcessOn(engine, "crossover", src, dst, {}, {}, {}, {}, -1, NULL, &opt, usage | IM_SYNC);
+        uint64_t end = rgaStatsNowNs();
+        if (ret != IM_STATUS_SUCCESS) {
+            return 0;
+        }
+        if (i > 0) {    // the first run warms up caches and the driver
+            samples.push_back((int64_t)(end - start));
+        }
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return std::max<int64_t>(samples[samples.size() / 2], 1);
+}
+
+IM_STATUS rgaCrossoverCalibrate(int core, int iterations) {
+    if (iterations < 1) {
+        iterations = 1;
+    }
+    int maxSide = RGA_CROSSOVER_MIN_SIDE << (RGA_CROSSOVER_BUCKETS - 1);
+    size_t bytes = (size_t)maxSide * maxSide * 4;
+    uint8_t *a = nullptr, *b = nullptr;
+    if (posix_memalign((void **)&a, 4096, bytes) != 0 || posix_memalign((void **)&b, 4096, bytes) != 0) {
+        free(a);
+        return IM_STATUS_OUT_OF_MEMORY;
+    }
+    // Mid-grey with half alpha keeps every op (blending included) on its general path.
+    memset(a, 0x80, bytes);
+    memset(b, 0x40, bytes);
+
+    RgaCrossoverEntry table[RGA_CROSSOVER_OP_COUNT][RGA_CROSSOVER_BUCKETS];
+    memset(table, 0, sizeof(table));
+    int measured = 0;
+    for (int op = 0; op < RGA_CROSSOVER_OP_COUNT; op++) {
+        for (int bucket = 0; bucket < RGA_CROSSOVER_BUCKETS; bucket++) {
+            int side = RGA_CROSSOVER_MIN_SIDE << bucket;
+            rga_buffer_t src = wrap(a, side, side, RK_FORMAT_RGBA_8888);
+            rga_buffer_t dst = wrap(b, side, side, RK_FORMAT_RGBA_8888);
+            int usage = 0;
+            switch (op) {
+                case RGA_CROSSOVER_RESIZE:
+                    dst = wrap(b, side / 2, side / 2, RK_FORMAT_RGBA_8888);
+                    break;
+                case RGA_CROSSOVER_CVTCOLOR:
+                    src = wrap(a, side, side, RK_FORMAT_YCbCr_420_SP);
+                    break;
+                case RGA_CROSSOVER_TRANSFORM:
+                    usage = IM_HAL_TRANSFORM_ROT_90;
+                    break;
+                case RGA_CROSSOVER_BLEND:
+                    usage = IM_ALPHA_BLEND_SRC_OVER;
+                    break;
+            }
+            RgaCrossoverEntry &e = table[op][bucket];
+            e.rgaNs = measure(RGA_ENGINE_RGA, src, dst, usage, core, iterations);
+            e.cpuNs = measure(RGA_ENGINE_CPU, src, dst, usage, core, iterations);
+            if (e.rgaNs > 0 && e.cpuNs > 0) {
+                measured++;
+            }
+        }
+    }
+    free(a);
+    free(b);
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    memcpy(gTable, table, sizeof(gTable));
+    publish();
+    return measured > 0 ? IM_STATUS_SUCCESS : IM_STATUS_FAILED;
+}
+
+void rgaCrossoverSnapshot(RgaCrossoverEntry *out) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    memcpy(out, gTable, sizeof(gTable));
+}
+
+void rgaCrossoverReset() {
+    std::lock_guard<std::mutex> lock(gMutex);
+    memset(gTable, 0, sizeof(gTable));
+    publish();
+}
+
+bool rgaCrossoverSave(const std::string &path, const std::string &key) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "w");
+    if (f == nullptr) {
+        return false;
+    }
+    fprintf(f, "rga-crossover %d\nkey %s\n", RGA_CROSSOVER_VERSION, key.c_str());
+    for (int op = 0; op < RGA_CROSSOVER_OP_COUNT; op++) {
+        for (int b = 0; b < RGA_CROSSOVER_BUCKETS; b++) {
+            fprintf(f, "%d %d %lld %lld\n", op, b, (long long)gTable[op][b].rgaNs, (long long)gTable[op][b].cpuNs);
+        }
+    }
+    bool ok = fclose(f) == 0;
+    // Rename so a crash while writing never leaves a truncated table behind.
+    return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool rgaCrossoverLoad(const std::string &path, const std::string &key) {
+    FILE *f = fopen(path.c_str(), "r");
+    if (f == nullptr) {
+        return false;
+    }
+    RgaCrossoverEntry table[RGA_CROSSOVER_OP_COUNT][RGA_CROSSOVER_BUCKETS];
+    memset(table, 0, sizeof(table));
+    char line[512];
+    int version = 0;
+    bool ok = fgets(line, sizeof(line), f) != nullptr && sscanf(line, "rga-crossover %d", &version) == 1 &&
+              version == RGA_CROSSOVER_VERSION && fgets(line, sizeof(line), f) != nullptr;
+    if (ok) {
+        line[strcspn(line, "\n")] = '\0';
+        ok = strncmp(line, "key ", 4) == 0 && key == line + 4;
+    }
+    while (ok && fgets(line, sizeof(line), f) != nullptr) {
+        int op, b;
+        long long rgaNs, cpuNs;
+        if (sscanf(line, "%d %d %lld %lld", &op, &b, &rgaNs, &cpuNs) != 4 ||
+            op < 0 || op >= RGA_CROSSOVER_OP_COUNT || b < 0 || b >= RGA_CROSSOVER_BUCKETS) {
+            ok = false;
+            break;
+        }
+        table[op][b].rgaNs = rgaNs;
+        table[op][b].cpuNs = cpuNs;
+    }
+    fclose(f);
+    if (!ok) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(gMutex);
+    memcpy(gTable, table, sizeof(gTable));
+    publish();
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef _rga_crossover_h_
+#define _rga_crossover_h_
+
+#include <stdint.h>
+#include <string>
+#include "im2d_type.h"
+
+/*
+ * RGA vs. CPU crossover for small images. For a 64x64 icon the ioctl, buffer
+ * import and cache maintenance around improcess cost more than the pixels, so
+ * rgaProcess() runs such calls on the CPU (the rga_soft.h kernels) when the
+ * calibrated table says the CPU is faster for that op and size bucket.
+ *
+ * The table is measured on the device by rgaCrossoverCalibrate() and can be
+ * saved and loaded so it is only measured once; the key (e.g. the build
+ * fingerprint) invalidates a table from another device or system image.
+ * Until a table is loaded or measured, and while disabled, everything goes to
+ * the RGA.
+ *
+ * Only synchronous calls on raster buffers with a virtual address, no fences,
+ * no pattern image and no usage beyond transforms and plain blending qualify;
+ * fd-only buffers would need a map and cache sync per call.
+ */
+
+typedef enum {
+    RGA_CROSSOVER_COPY = 0,
+    RGA_CROSSOVER_RESIZE,
+    RGA_CROSSOVER_CVTCOLOR,
+    RGA_CROSSOVER_TRANSFORM,    /* rotate / flip */
+    RGA_CROSSOVER_BLEND,
+    RGA_CROSSOVER_OP_COUNT
+} RgaCrossoverOp;
+
+/* Bucket b holds images of up to (16 << b)^2 pixels; larger ones always use the RGA. */
+#define RGA_CROSSOVER_BUCKETS       6
+#define RGA_CROSSOVER_MIN_SIDE      16
+
+typedef struct {
+    int64_t rgaNs;      /* median per call; 0 = not measured */
+    int64_t cpuNs;
+} RgaCrossoverEntry;
+
+void rgaCrossoverSetEnabled(bool enabled);
+bool rgaCrossoverEnabled();
+
+/* Op class of an rgaProcess call, or -1 if it cannot run on the CPU path. */
+int rgaCrossoverClassify(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                         const im_rect &srect, const im_rect &drect, int acquireFence, int usage);
+
+/* Size bucket for the larger of the two rects, or -1 past the last bucket. */
+int rgaCrossoverBucket(int64_t pixels);
+
+/* True if the table prefers the CPU for this call (and the crossover is enabled). */
+bool rgaCrossoverPreferCpu(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                           const im_rect &srect, const im_rect &drect, int acquireFence, int usage);
+
+/* Measure every op and bucket with iterations runs per engine (median); core is the im_opt_t.core mask. */
+IM_STATUS rgaCrossoverCalibrate(int core, int iterations);
+
+/* Copy out the table, RGA_CROSSOVER_OP_COUNT x RGA_CROSSOVER_BUCKETS in op order. */
+void rgaCrossoverSnapshot(RgaCrossoverEntry *out);
+void rgaCrossoverReset();
+
+/* Text file; load fails (and keeps the table) on a different key or version. */
+bool rgaCrossoverSave(const std::string &path, const std::string &key);
+bool rgaCrossoverLoad(const std::string &path, const std::string &key);
+
+#endif
@@ -0,0 +1,246 @@
+#include "rga_damage.h"
+
+#include <string.h>
+#include <algorithm>
+#include "rga_backend.h"
+#include "rga_cpu.h"
+#include "rga_stats.h"
+
+static uint64_t bufferKey(const rga_buffer_t &buf) {
+    if (buf.fd > 0) {
+        return (uint64_t)buf.fd;
+    }
+    return (uint64_t)(uintptr_t)(buf.vir_addr != NULL ? buf.vir_addr : buf.phy_addr) | (1ULL << 63);
+}
+
+static bool sameRect(const im_rect &a, const im_rect &b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+static inline uint64_t mix(uint64_t h, uint64_t v) {
+    h = (h ^ v) * 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 29);
+}
+
+static uint64_t hashBytes(uint64_t h, const uint8_t *p, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v;
+        memcpy(&v, p + i, 8);
+        h = mix(h, v);
+    }
+    uint64_t tail = 0;
+    for (; i < n; i++) {
+        tail = (tail << 8) | p[i];
+    }
+    return mix(h, tail ^ n);
+}
+
+RgaIncremental::RgaIncremental(int blockSize, int core) : mCore(core) {
+    mBlockSize = blockSize < 8 ? 8 : (blockSize + 1) & ~1;
+    memset(&mSetup, 0, sizeof(mSetup));
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+void RgaIncremental::invalidate() {
+    mValid = false;
+}
+
+void RgaIncremental::resetStats() {
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+// Hash every block of src and report the ones that differ from the last frame,
+// merged into rects (runs along a block row, then identical runs down the rows).
+// Without previous hashes everything is dirty.
+IM_STATUS RgaIncremental::hashDiff(const rga_buffer_t &src, RgaRegion *dirty) {
+    RgaCpuImage img;
+    IM_STATUS ret = rgaCpuMapImage(src, &img);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    for (int p = 0; p < img.planeCount; p++) {
+        if (img.planes[p].bpp == 0) {
+            rgaCpuUnmapImage(&img);
+            return IM_STATUS_NOT_SUPPORTED;
+        }
+    }
+    uint64_t start = rgaStatsNowNs();
+    int bs = mBlockSize;
+    int bx = (img.width + bs - 1) / bs;
+    int by = (img.height + bs - 1) / bs;
+    std::vector<uint64_t> hashes((size_t)bx * by);
+    rgaCpuParallelFor(by, [&](int begin, int end) {
+        for (int j = begin; j < end; j++) {
+            for (int i = 0; i < bx; i++) {
+                uint64_t h = 0;
+                for (int p = 0; p < img.planeCount; p++) {
+                    const RgaCpuPlane &pl = img.planes[p];
+                    int x0 = (i * bs) >> pl.xshift;
+                    int x1 = std::min(((i + 1) * bs) >> pl.xshift, pl.width);
+                    int y0 = (j * bs) >> pl.yshift;
+                    int y1 = std::min(((j + 1) * bs) >> pl.yshift, pl.height);
+                    for (int y = y0; y < y1; y++) {
+                        h = hashBytes(h, pl.data + (size_t)y * pl.stride + (size_t)x0 * pl.bpp,
+                                      (size_t)(x1 - x0) * pl.bpp);
+                    }
+                }
+                hashes[(size_t)j * bx + i] = h;
+            }
+        }
+    });
+    rgaCpuUnmapImage(&img);
+
+    bool compare = bx == mBlocksX && by == mBlocksY && mHashes.size() == hashes.size();
+    RgaRegion rects;
+    std::vector<int> open;      // index in rects of the run ending on the previous row, by start column
+    for (int j = 0; j < by; j++) {
+        std::vector<int> next;
+        for (int i = 0; i < bx;) {
+            size_t k = (size_t)j * bx + i;
+            if (compare && hashes[k] == mHashes[k]) {
+                i++;
+                continue;
+            }
+            int run = i;
+            while (i < bx && !(compare && hashes[(size_t)j * bx + i] == mHashes[(size_t)j * bx + i])) {
+                i++;
+            }
+            mStats.dirtyBlocks += i - run;
+            im_rect r = {run * bs, j * bs, (i - run) * bs, bs};
+            int merged = -1;
+            for (int o : open) {
+                if (rects[o].x == r.x && rects[o].width == r.width) {
+                    rects[o].height += bs;
+                    merged = o;
+                    break;
+                }
+            }
+            if (merged < 0) {
+                rects.push_back(r);
+                merged = (int)rects.size() - 1;
+            }
+            next.push_back(merged);
+        }
+        open.swap(next);
+    }
+    mStats.blocks += (int64_t)bx * by;
+    mStats.hashNs += (int64_t)(rgaStatsNowNs() - start);
+
+    mHashes.swap(hashes);
+    mBlocksX = bx;
+    mBlocksY = by;
+    const im_rect bounds = {0, 0, src.width, src.height};
+    dirty->clear();
+    for (const im_rect &r : rects) {
+        dirty->push_back(rgaRectIntersect(r, bounds));
+    }
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS RgaIncremental::process(const rga_buffer_t &src, const rga_buffer_t &dst, const im_rect &srect,
+                                  const im_rect &drect, int usage, const im_rect *dirty, int dirtyCount) {
+    if (usage & IM_ALPHA_BLEND_MASK) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    Setup setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.dstKey = bufferKey(dst);
+    setup.srcWidth = src.width;
+    setup.srcHeight = src.height;
+    setup.srcFormat = src.format;
+    setup.dstWidth = dst.width;
+    setup.dstHeight = dst.height;
+    setup.dstFormat = dst.format;
+    setup.srect = rgaRectEmpty(srect) ? im_rect{0, 0, src.width, src.height} : srect;
+    setup.drect = rgaRectEmpty(drect) ? im_rect{0, 0, dst.width, dst.height} : drect;
+    setup.usage = usage;
+    const im_rect &sr = setup.srect;
+    const im_rect &dr = setup.drect;
+
+    const Setup &last = mSetup;
+    bool full = !mValid || setup.dstKey != last.dstKey || setup.srcWidth != last.srcWidth ||
+                setup.srcHeight != last.srcHeight || setup.srcFormat != last.srcFormat ||
+                setup.dstWidth != last.dstWidth || setup.dstHeight != last.dstHeight ||
+                setup.dstFormat != last.dstFormat || !sameRect(sr, last.srect) || !sameRect(dr, last.drect) ||
+                setup.usage != last.usage;
+    RgaRegion changed;
+    if (dirty != NULL) {
+        mHashes.clear();        // they no longer describe the previous frame
+        for (int i = 0; i < dirtyCount; i++) {
+            rgaRegionAdd(changed, dirty[i]);
+        }
+    } else if (hashDiff(src, &changed) != IM_STATUS_SUCCESS) {
+        mHashes.clear();
+        full = true;
+    }
+
+    // Dst pieces affected by the change and the src rects that produce them.
+    int dstGrid = rgaRegionGrid(dst.format);
+    int srcGrid = rgaRegionGrid(src.format);
+    RgaRegion pieces;
+    std::vector<im_rect> sources;
+    if (!full) {
+        for (const im_rect &r : changed) {
+            im_rect in = rgaRectIntersect(r, sr);
+            im_rect out;
+            if (rgaRectEmpty(in)) {
+                continue;
+            }
+            if (!rgaRectMapToDest(in, sr, dr, usage & IM_HAL_TRANSFORM_MASK, &out)) {
+                full = true;
+                break;
+            }
+            rgaRegionAdd(pieces, rgaRectSnapOut(out, dstGrid, dr));
+        }
+        for (size_t i = 0; i < pieces.size() && !full; i++) {
+            im_rect s;
+            if (!rgaRectMapToSource(pieces[i], sr, dr, usage & IM_HAL_TRANSFORM_MASK, &s) ||
+                s.x % srcGrid != 0 || s.y % srcGrid != 0 || s.width % srcGrid != 0 || s.height % srcGrid != 0) {
+                full = true;
+            }
+            sources.push_back(s);
+        }
+    }
+    if (full) {
+        pieces.assign(1, dr);
+        sources.assign(1, sr);
+        mStats.fullFrames++;
+    }
+    mStats.frames++;
+    mStats.pixelsTotal += (int64_t)dr.width * dr.height;
+    if (pieces.empty()) {
+        mStats.skippedFrames++;
+        return IM_STATUS_SUCCESS;
+    }
+
+    im_opt_t opt = {};
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = mCore;
+
+    mValid = false;
+    // Fragmented damage is split into several jobs, as librga caps the tasks per job.
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+    for (size_t first = 0; first < pieces.size() && ret == IM_STATUS_SUCCESS; first += RGA_JOB_MAX_TASKS) {
+        size_t last = std::min(pieces.size(), first + RGA_JOB_MAX_TASKS);
+        im_job_handle_t job = rgaBeginJob(0);
+        if (job == 0) {
+            return IM_STATUS_FAILED;
+        }
+        for (size_t i = first; i < last && ret == IM_STATUS_SUCCESS; i++) {
+            ret = rgaProcessTask("incremental", job, src, dst, {}, sources[i], pieces[i], {}, &opt, usage);
+            mStats.tasks++;
+        }
+        if (ret != IM_STATUS_SUCCESS) {
+            rgaCancelJob(job);
+            return ret;
+        }
+        ret = rgaEndJob(job, IM_SYNC, 0, NULL);
+    }
+    if (ret == IM_STATUS_SUCCESS) {
+        mStats.pixelsProcessed += rgaRegionArea(pieces);
+        mSetup = setup;
+        mValid = true;
+    }
+    return ret;
+}
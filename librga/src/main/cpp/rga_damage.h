@@ -0,0 +1,79 @@
+#ifndef _rga_damage_h_
+#define _rga_damage_h_
+
+#include <stdint.h>
+#include <vector>
+#include "im2d_type.h"
+#include "rga_region.h"
+
+/*
+ * Incremental processing of a mostly static source (UI overlays, dashboards):
+ * only the rectangles that changed since the last frame are resubmitted, as
+ * improcessTask calls with matching srect/drect in one job (a new one every
+ * RGA_JOB_MAX_TASKS pieces), and the rest of the destination is left as it is.
+ *
+ * Dirty rects come from the caller or, if none are given, from comparing
+ * 64-bit hashes of blockSize x blockSize source blocks with the previous
+ * frame. The whole rect is processed on the first frame, when the
+ * destination, geometry or usage changed, or when a dirty piece cannot be
+ * processed on its own (see rgaRectMapToSource). Alpha blending is refused:
+ * redrawing a piece would blend onto the previous result.
+ */
+
+typedef struct {
+    int64_t frames;
+    int64_t fullFrames;         /* processed whole */
+    int64_t skippedFrames;      /* nothing changed */
+    int64_t blocks;             /* hashed */
+    int64_t dirtyBlocks;
+    int64_t tasks;
+    int64_t pixelsTotal;        /* dst pixels a full run writes */
+    int64_t pixelsProcessed;    /* dst pixels written */
+    int64_t hashNs;             /* CPU time spent hashing */
+} RgaDamageStats;
+
+class RgaIncremental {
+public:
+    /* blockSize is rounded up to an even number of at least 8; core is the im_opt_t.core mask. */
+    RgaIncremental(int blockSize, int core);
+
+    /*
+     * Process srect of src into drect of dst (empty rects = whole image) with
+     * usage (IM_HAL_TRANSFORM_*; the formats may differ). dirty (in src
+     * coordinates, dirtyCount of them) lists what changed since the last call;
+     * null diffs block hashes instead. Waits for the job.
+     */
+    IM_STATUS process(const rga_buffer_t &src, const rga_buffer_t &dst, const im_rect &srect,
+                      const im_rect &drect, int usage, const im_rect *dirty, int dirtyCount);
+
+    /* Process everything next time (e.g. dst was written by someone else). */
+    void invalidate();
+
+    const RgaDamageStats &stats() const {
+        return mStats;
+    }
+
+    void resetStats();
+
+private:
+    struct Setup {
+        uint64_t dstKey;
+        int srcWidth, srcHeight, srcFormat;
+        int dstWidth, dstHeight, dstFormat;
+        im_rect srect, drect;
+        int usage;
+    };
+
+    IM_STATUS hashDiff(const rga_buffer_t &src, RgaRegion *dirty);
+
+    int mBlockSize;
+    int mCore;
+    bool mValid = false;
+    Setup mSetup;
+    std::vector<uint64_t> mHashes;      /* previous frame, row-major blocks; empty = none */
+    int mBlocksX = 0;
+    int mBlocksY = 0;
+    RgaDamageStats mStats;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "rga_format.h"
+
+const char *rgaFormatName(int format) {
+    const RgaFormatDesc *desc = rgaFormatFind(format);
+    return desc != nullptr ? desc->name : "unknown";
+}
+
+bool rgaFormatBlockSize(int rdMode, int *blockWidth, int *blockHeight) {
+    switch (rdMode) {
+        case IM_AFBC16x16_MODE:
+            *blockWidth = 16;
+            *blockHeight = 16;
+            return true;
+        case IM_AFBC32x8_MODE:
+            *blockWidth = 32;
+            *blockHeight = 8;
+            return true;
+        case IM_RKFBC64x4_MODE:
+            *blockWidth = 64;
+            *blockHeight = 4;
+            return true;
+        case IM_TILE8x8_MODE:
+            *blockWidth = 8;
+            *blockHeight = 8;
+            return true;
+        case IM_TILE4x4_MODE:
+            *blockWidth = 4;
+            *blockHeight = 4;
+            return true;
+        default:
+            return false;
+    }
+}
+
+size_t rgaFormatBufferSize(int format, int wstride, int hstride, int rdMode) {
+    if (rgaFormatIsRaster(rdMode)) {
+        return rgaFormatImageSize(format, wstride, hstride);
+    }
+    int bw, bh;
+    if (!rgaFormatBlockSize(rdMode, &bw, &bh) || rgaFormatFind(format) == nullptr) {
+        return 0;
+    }
+    size_t cols = (size_t)(wstride + bw - 1) / bw;
+    size_t rows = (size_t)(hstride + bh - 1) / bh;
+    if (rdMode == IM_TILE8x8_MODE || rdMode == IM_TILE4x4_MODE) {
+        return rgaFormatImageSize(format, (int)(cols * bw), (int)(rows * bh));
+    }
+    size_t header = cols * rows * RGA_FORMAT_FBC_HEADER_BYTES;
+    header = (header + RGA_FORMAT_FBC_HEADER_ALIGN - 1) / RGA_FORMAT_FBC_HEADER_ALIGN * RGA_FORMAT_FBC_HEADER_ALIGN;
+    return header + cols * rows * rgaFormatImageSize(format, bw, bh);
+}
+
+IM_STATUS rgaFormatCheckBuffer(const rga_buffer_t &buffer) {
+    const RgaFormatDesc *desc = rgaFormatFind(buffer.format);
+    if (desc == nullptr) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    int wstride = buffer.wstride > 0 ? buffer.wstride : buffer.width;
+    int hstride = buffer.hstride > 0 ? buffer.hstride : buffer.height;
+    if (buffer.width <= 0 || buffer.height <= 0 || wstride < buffer.width || hstride < buffer.height ||
+        buffer.width % desc->rectAlign != 0 || buffer.height % desc->rectAlign != 0) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    return IM_STATUS_SUCCESS;
+}
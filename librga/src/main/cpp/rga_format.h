@@ -0,0 +1,214 @@
+#ifndef _rga_format_h_
+#define _rga_format_h_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "im2d_type.h"
+
+/*
+ * Compile-time descriptors of the RK_FORMAT_* pixel formats, indexed by
+ * format >> 8. Plane sizes, strides and rect alignment are derived from here
+ * instead of per-format switches; Rga.kt reads the same table through JNI.
+ */
+
+#define RGA_FORMAT_MAX_PLANES 3
+
+typedef struct {
+    int format;                 /* RK_FORMAT_* as in rga.h (shifted << 8) */
+    const char *name;
+    uint8_t planeCount;         /* 0: no pixel format has this id */
+    uint8_t bits[RGA_FORMAT_MAX_PLANES];    /* per pixel on plane 0, per subsampled element on the others */
+    uint8_t xshift;             /* chroma subsampling */
+    uint8_t yshift;
+    uint8_t rectAlign;          /* x, y, width and height must be multiples (YUV: 2) */
+    uint8_t strideAlign;        /* wstride multiple in pixels keeping rows 16-byte aligned (10-bit: 64) */
+    bool alpha;
+    bool yuv;
+    bool tenBit;                /* 10-bit samples packed without padding */
+    bool byteSamples;           /* every sample is a whole byte, so byte-wise filters apply */
+} RgaFormatDesc;
+
+#define RGA_FMT(id, name, planes, b0, b1, b2, xs, ys, ra, sa, alpha, yuv, ten, bytes) \
+    {(id) << 8, name, planes, {b0, b1, b2}, xs, ys, ra, sa, alpha, yuv, ten, bytes}
+#define RGA_FMT_NONE(id) RGA_FMT(id, "", 0, 0, 0, 0, 0, 0, 1, 1, false, false, false, false)
+
+//                         id    name               pl  bits        xs ys ra  sa  alpha  yuv    10bit  bytes
+static constexpr RgaFormatDesc RGA_FORMAT_TABLE[] = {
+    RGA_FMT(0x00, "RGBA_8888",       1, 32, 0, 0,   0, 0, 1,  4,  true,  false, false, true),
+    RGA_FMT(0x01, "RGBX_8888",       1, 32, 0, 0,   0, 0, 1,  4,  false, false, false, true),
+    RGA_FMT(0x02, "RGB_888",         1, 24, 0, 0,   0, 0, 1,  16, false, false, false, true),
+    RGA_FMT(0x03, "BGRA_8888",       1, 32, 0, 0,   0, 0, 1,  4,  true,  false, false, true),
+    RGA_FMT(0x04, "RGB_565",         1, 16, 0, 0,   0, 0, 1,  8,  false, false, false, false),
+    RGA_FMT(0x05, "RGBA_5551",       1, 16, 0, 0,   0, 0, 1,  8,  true,  false, false, false),
+    RGA_FMT(0x06, "RGBA_4444",       1, 16, 0, 0,   0, 0, 1,  8,  true,  false, false, false),
+    RGA_FMT(0x07, "BGR_888",         1, 24, 0, 0,   0, 0, 1,  16, false, false, false, true),
+    RGA_FMT(0x08, "YCbCr_422_SP",    2, 8, 16, 0,   1, 0, 2,  16, false, true,  false, true),
+    RGA_FMT(0x09, "YCbCr_422_P",     3, 8, 8, 8,    1, 0, 2,  16, false, true,  false, true),
+    RGA_FMT(0x0a, "YCbCr_420_SP",    2, 8, 16, 0,   1, 1, 2,  16, false, true,  false, true),
+    RGA_FMT(0x0b, "YCbCr_420_P",     3, 8, 8, 8,    1, 1, 2,  16, false, true,  false, true),
+    RGA_FMT(0x0c, "YCrCb_422_SP",    2, 8, 16, 0,   1, 0, 2,  16, false, true,  false, true),
+    RGA_FMT(0x0d, "YCrCb_422_P",     3, 8, 8, 8,    1, 0, 2,  16, false, true,  false, true),
+    RGA_FMT(0x0e, "YCrCb_420_SP",    2, 8, 16, 0,   1, 1, 2,  16, false, true,  false, true),
+    RGA_FMT(0x0f, "YCrCb_420_P",     3, 8, 8, 8,    1, 1, 2,  16, false, true,  false, true),
+    RGA_FMT(0x10, "BPP1",            1, 1, 0, 0,    0, 0, 8,  128, false, false, false, false),
+    RGA_FMT(0x11, "BPP2",            1, 2, 0, 0,    0, 0, 4,  64, false, false, false, false),
+    RGA_FMT(0x12, "BPP4",            1, 4, 0, 0,    0, 0, 2,  32, false, false, false, false),
+    RGA_FMT(0x13, "BPP8",            1, 8, 0, 0,    0, 0, 1,  16, false, false, false, true),
+    RGA_FMT(0x14, "Y4",              1, 4, 0, 0,    0, 0, 2,  32, false, true,  false, false),
+    RGA_FMT(0x15, "YCbCr_400",       1, 8, 0, 0,    0, 0, 1,  16, false, true,  false, true),
+    RGA_FMT(0x16, "BGRX_8888",       1, 32, 0, 0,   0, 0, 1,  4,  false, false, false, true),
+    RGA_FMT_NONE(0x17),
+    RGA_FMT(0x18, "YVYU_422",        1, 16, 0, 0,   1, 0, 2,  8,  false, true,  false, false),
+    RGA_FMT(0x19, "YVYU_420",        1, 16, 0, 0,   1, 1, 2,  8,  false, true,  false, false),
+    RGA_FMT(0x1a, "VYUY_422",        1, 16, 0, 0,   1, 0, 2,  8,  false, true,  false, false),
+    RGA_FMT(0x1b, "VYUY_420",        1, 16, 0, 0,   1, 1, 2,  8,  false, true,  false, false),
+    RGA_FMT(0x1c, "YUYV_422",        1, 16, 0, 0,   1, 0, 2,  8,  false, true,  false, false),
+    RGA_FMT(0x1d, "YUYV_420",        1, 16, 0, 0,   1, 1, 2,  8,  false, true,  false, false),
+    RGA_FMT(0x1e, "UYVY_422",        1, 16, 0, 0,   1, 0, 2,  8,  false, true,  false, false),
+    RGA_FMT(0x1f, "UYVY_420",        1, 16, 0, 0,   1, 1, 2,  8,  false, true,  false, false),
+    RGA_FMT(0x20, "YCbCr_420_SP_10B", 2, 10, 20, 0, 1, 1, 2,  64, false, true,  true,  false),
+    RGA_FMT(0x21, "YCrCb_420_SP_10B", 2, 10, 20, 0, 1, 1, 2,  64, false, true,  true,  false),
+    RGA_FMT(0x22, "YCbCr_422_SP_10B", 2, 10, 20, 0, 1, 0, 2,  64, false, true,  true,  false),
+    RGA_FMT(0x23, "YCrCb_422_SP_10B", 2, 10, 20, 0, 1, 0, 2,  64, false, true,  true,  false),
+    RGA_FMT(0x24, "BGR_565",         1, 16, 0, 0,   0, 0, 1,  8,  false, false, false, false),
+    RGA_FMT(0x25, "BGRA_5551",       1, 16, 0, 0,   0, 0, 1,  8,  true,  false, false, false),
+    RGA_FMT(0x26, "BGRA_4444",       1, 16, 0, 0,   0, 0, 1,  8,  true,  false, false, false),
+    RGA_FMT_NONE(0x27),
+    RGA_FMT(0x28, "ARGB_8888",       1, 32, 0, 0,   0, 0, 1,  4,  true,  false, false, true),
+    RGA_FMT(0x29, "XRGB_8888",       1, 32, 0, 0,   0, 0, 1,  4,  false, false, false, true),
+    RGA_FMT(0x2a, "ARGB_5551",       1, 16, 0, 0,   0, 0, 1,  8,  true,  false, false, false),
+    RGA_FMT(0x2b, "ARGB_4444",       1, 16, 0, 0,   0, 0, 1,  8,  true,  false, false, false),
+    RGA_FMT(0x2c, "ABGR_8888",       1, 32, 0, 0,   0, 0, 1,  4,  true,  false, false, true),
+    RGA_FMT(0x2d, "XBGR_8888",       1, 32, 0, 0,   0, 0, 1,  4,  false, false, false, true),
+    RGA_FMT(0x2e, "ABGR_5551",       1, 16, 0, 0,   0, 0, 1,  8,  true,  false, false, false),
+    RGA_FMT(0x2f, "ABGR_4444",       1, 16, 0, 0,   0, 0, 1,  8,  true,  false, false, false),
+    RGA_FMT(0x30, "RGBA2BPP",        1, 2, 0, 0,    0, 0, 4,  64, true,  false, false, false),
+    RGA_FMT(0x31, "A8",              1, 8, 0, 0,    0, 0, 1,  16, true,  false, false, true),
+    RGA_FMT(0x32, "YCbCr_444_SP",    2, 8, 16, 0,   0, 0, 1,  16, false, true,  false, true),
+    RGA_FMT(0x33, "YCrCb_444_SP",    2, 8, 16, 0,   0, 0, 1,  16, false, true,  false, true),
+    RGA_FMT(0x34, "Y8",              1, 8, 0, 0,    0, 0, 1,  16, false, true,  false, true),
+};
+
+/*
+ * CPU-only formats for sources the RGA cannot read (decoders emitting P010).
+ * Their ids start at RGA_FORMAT_EXT_ID, clear of the RK_FORMAT_* range, and
+ * they must never be handed to librga.
+ */
+#define RGA_FORMAT_EXT_ID 0x100
+#define RGA_FORMAT_P010 (0x100 << 8)    /* 4:2:0 SP, 16-bit LE samples, 10 bits MSB aligned */
+#define RGA_FORMAT_P210 (0x101 << 8)    /* 4:2:2 SP, same samples */
+
+static constexpr RgaFormatDesc RGA_FORMAT_EXT_TABLE[] = {
+    RGA_FMT(0x100, "P010",           2, 16, 32, 0,  1, 1, 2,  8,  false, true,  false, false),
+    RGA_FMT(0x101, "P210",           2, 16, 32, 0,  1, 0, 2,  8,  false, true,  false, false),
+};
+
+#undef RGA_FMT
+#undef RGA_FMT_NONE
+
+#define RGA_FORMAT_COUNT ((int)(sizeof(RGA_FORMAT_TABLE) / sizeof(RGA_FORMAT_TABLE[0])))
+#define RGA_FORMAT_EXT_COUNT ((int)(sizeof(RGA_FORMAT_EXT_TABLE) / sizeof(RGA_FORMAT_EXT_TABLE[0])))
+
+static constexpr bool rgaFormatTableIndexed() {
+    for (int i = 0; i < RGA_FORMAT_COUNT; i++) {
+        if (RGA_FORMAT_TABLE[i].format != i << 8) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(rgaFormatTableIndexed(), "RGA_FORMAT_TABLE must be indexed by format >> 8");
+static_assert(RGA_FORMAT_EXT_TABLE[1].format == RGA_FORMAT_P210, "RGA_FORMAT_EXT_TABLE must be indexed by id");
+static_assert(RGA_FORMAT_TABLE[RK_FORMAT_YCbCr_420_SP_10B >> 8].tenBit, "RGA_FORMAT_TABLE out of sync with rga.h");
+static_assert(RGA_FORMAT_TABLE[RK_FORMAT_Y8 >> 8].planeCount == 1, "RGA_FORMAT_TABLE out of sync with rga.h");
+
+/* Rga.kt used to declare RK_FORMAT_* without the "<< 8"; accept both. */
+constexpr int rgaFormatNormalize(int format) {
+    return format > 0 && format < (1 << 8) ? format << 8 : format;
+}
+
+/* Descriptor of format (either form), or nullptr if it is not a pixel format. */
+constexpr const RgaFormatDesc *rgaFormatFind(int format) {
+    int id = rgaFormatNormalize(format);
+    int index = id >> 8;
+    if (id < 0 || (id & 0xff) != 0) {
+        return nullptr;
+    }
+    if (index >= RGA_FORMAT_EXT_ID && index < RGA_FORMAT_EXT_ID + RGA_FORMAT_EXT_COUNT) {
+        return &RGA_FORMAT_EXT_TABLE[index - RGA_FORMAT_EXT_ID];
+    }
+    if (index >= RGA_FORMAT_COUNT || RGA_FORMAT_TABLE[index].planeCount == 0) {
+        return nullptr;
+    }
+    return &RGA_FORMAT_TABLE[index];
+}
+
+/* Elements of plane in a row of wstride pixels. */
+constexpr int rgaFormatPlaneWidth(const RgaFormatDesc &desc, int plane, int wstride) {
+    return plane == 0 ? wstride : wstride >> desc.xshift;
+}
+
+constexpr int rgaFormatPlaneRowBytes(const RgaFormatDesc &desc, int plane, int wstride) {
+    return (rgaFormatPlaneWidth(desc, plane, wstride) * desc.bits[plane] + 7) / 8;
+}
+
+constexpr int rgaFormatPlaneRows(const RgaFormatDesc &desc, int plane, int hstride) {
+    return plane == 0 ? hstride : hstride >> desc.yshift;
+}
+
+/* Bytes of a wstride x hstride image, 0 for unknown formats. */
+constexpr size_t rgaFormatImageSize(int format, int wstride, int hstride) {
+    const RgaFormatDesc *desc = rgaFormatFind(format);
+    if (desc == nullptr) {
+        return 0;
+    }
+    size_t size = 0;
+    for (int i = 0; i < desc->planeCount; i++) {
+        size += (size_t)rgaFormatPlaneRowBytes(*desc, i, wstride) * rgaFormatPlaneRows(*desc, i, hstride);
+    }
+    return size;
+}
+static_assert(rgaFormatImageSize(RK_FORMAT_YCbCr_420_SP, 16, 16) == 384, "NV12 size");
+static_assert(rgaFormatImageSize(RK_FORMAT_YCbCr_420_SP_10B, 64, 2) == 240, "NV12 10-bit size");
+static_assert(rgaFormatImageSize(RGA_FORMAT_P010, 16, 16) == 768, "P010 size");
+
+/* Smallest wstride >= width the RGA accepts for format. */
+constexpr int rgaFormatAlignStride(int format, int width) {
+    const RgaFormatDesc *desc = rgaFormatFind(format);
+    int align = desc != nullptr ? desc->strideAlign : 16;
+    return (width + align - 1) / align * align;
+}
+
+/* Header area of the FBC modes: 16 bytes per block, bodies start page aligned. */
+#define RGA_FORMAT_FBC_HEADER_BYTES 16
+#define RGA_FORMAT_FBC_HEADER_ALIGN 4096
+
+/* Whether rd_mode (IM_RD_MODE, 0 = unset) lays pixels out row by row. */
+constexpr bool rgaFormatIsRaster(int rdMode) {
+    return rdMode == 0 || rdMode == IM_RASTER_MODE;
+}
+
+/*
+ * Block size of a tiled or compressed rd_mode, false for raster and unknown
+ * modes. Tiles and FBC blocks are in pixels of plane 0.
+ */
+bool rgaFormatBlockSize(int rdMode, int *blockWidth, int *blockHeight);
+
+/*
+ * Bytes to allocate for a wstride x hstride image in rd_mode: the raster size,
+ * the tile-padded size for TILE modes, and header plus uncompressed worst case
+ * body for the FBC modes. 0 for unknown formats or modes.
+ */
+size_t rgaFormatBufferSize(int format, int wstride, int hstride, int rdMode);
+
+/* RK_FORMAT_* name without the prefix, "unknown" if not a pixel format. */
+const char *rgaFormatName(int format);
+
+/*
+ * Cheap pre-submission check: known format, positive size, strides covering
+ * the image and YUV sizes on the 2-pixel grid. Strides are not required to
+ * follow strideAlign (Bitmaps and camera buffers often do not).
+ */
+IM_STATUS rgaFormatCheckBuffer(const rga_buffer_t &buffer);
+
+#endif
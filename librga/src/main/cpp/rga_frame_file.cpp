@@ -0,0 +1,207 @@
+#include "rga_frame_file.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "rga_format.h"
+
+static size_t pageSize() {
+    static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+static IM_STATUS setupTemplate(int width, int height, int format, int wstride, int hstride, size_t frameBytes,
+                               rga_buffer_t *buffer, size_t *bytes) {
+    if (width <= 0 || height <= 0) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    wstride = wstride > 0 ? wstride : width;
+    hstride = hstride > 0 ? hstride : height;
+    if (wstride < width || hstride < height) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    size_t size = rgaFormatImageSize(format, wstride, hstride);
+    if (frameBytes == 0) {
+        if (size == 0) {
+            return IM_STATUS_NOT_SUPPORTED;
+        }
+        frameBytes = size;
+    } else if (size != 0 && frameBytes < size) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->fd = -1;
+    buffer->width = width;
+    buffer->height = height;
+    buffer->wstride = wstride;
+    buffer->hstride = hstride;
+    buffer->format = format;
+    buffer->global_alpha = 0xff;
+    *bytes = frameBytes;
+    return IM_STATUS_SUCCESS;
+}
+
+RgaFrameReader::RgaFrameReader() {
+    memset(&mTemplate, 0, sizeof(mTemplate));
+}
+
+RgaFrameReader::~RgaFrameReader() {
+    close();
+}
+
+IM_STATUS RgaFrameReader::open(const std::string &path, int width, int height, int format, int wstride,
+                               int hstride, size_t frameBytes, int prefetch) {
+    close();
+    IM_STATUS ret = setupTemplate(width, height, format, wstride, hstride, frameBytes, &mTemplate, &mFrameBytes);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    mFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (mFd < 0) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    struct stat st;
+    if (fstat(mFd, &st) != 0 || (size_t)st.st_size < mFrameBytes) {
+        close();
+        return IM_STATUS_INVALID_PARAM;
+    }
+    mSize = (size_t)st.st_size;
+    void *addr = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, mFd, 0);
+    if (addr == MAP_FAILED) {
+        mSize = 0;
+        close();
+        return IM_STATUS_OUT_OF_MEMORY;
+    }
+    mData = (uint8_t *)addr;
+    mFrameCount = (int)(mSize / mFrameBytes);
+    mPrefetch = prefetch < 0 ? 0 : prefetch;
+    madvise(mData, mSize, MADV_SEQUENTIAL);
+    return IM_STATUS_SUCCESS;
+}
+
+void RgaFrameReader::close() {
+    if (mData != nullptr) {
+        munmap(mData, mSize);
+    }
+    if (mFd >= 0) {
+        ::close(mFd);
+    }
+    mFd = -1;
+    mData = nullptr;
+    mSize = 0;
+    mFrameCount = 0;
+    mLast = -1;
+    mPrefetched = -1;
+}
+
+// madvise frames [first, first + count), widened to whole pages.
+void RgaFrameReader::advise(int first, int count, int advice) {
+    if (count <= 0) {
+        return;
+    }
+    size_t begin = (size_t)first * mFrameBytes & ~(pageSize() - 1);
+    size_t end = (size_t)(first + count) * mFrameBytes;
+    madvise(mData + begin, end - begin, advice);
+}
+
+IM_STATUS RgaFrameReader::frame(int index, rga_buffer_t *buffer) {
+    if (mData == nullptr || index < 0 || index >= mFrameCount) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    // Going forward: drop the frames behind from the page tables and ask for
+    // the next ones, only requesting what was not requested before.
+    if (index == mLast + 1 && mLast >= 1) {
+        advise(mLast - 1, 1, MADV_DONTNEED);
+    }
+    if (index <= mLast) {
+        mPrefetched = index;    // seeking back: restart the window
+    }
+    int ahead = std::min(index + mPrefetch, mFrameCount - 1);
+    int from = std::max(index + 1, mPrefetched + 1);
+    if (ahead >= from) {
+        advise(from, ahead - from + 1, MADV_WILLNEED);
+        mPrefetched = ahead;
+    }
+    mLast = index;
+
+    *buffer = mTemplate;
+    buffer->vir_addr = mData + (size_t)index * mFrameBytes;
+    return IM_STATUS_SUCCESS;
+}
+
+RgaFrameWriter::RgaFrameWriter() {
+    memset(&mTemplate, 0, sizeof(mTemplate));
+}
+
+RgaFrameWriter::~RgaFrameWriter() {
+    close();
+}
+
+IM_STATUS RgaFrameWriter::open(const std::string &path, int width, int height, int format, int wstride,
+                               int hstride, size_t frameBytes, int growFrames) {
+    close();
+    IM_STATUS ret = setupTemplate(width, height, format, wstride, hstride, frameBytes, &mTemplate, &mFrameBytes);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    mFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (mFd < 0) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    mGrowFrames = growFrames < 1 ? 1 : growFrames;
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS RgaFrameWriter::close() {
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+    if (mData != nullptr) {
+        if (msync(mData, mSize, MS_SYNC) != 0) {
+            ret = IM_STATUS_FAILED;
+        }
+        munmap(mData, mSize);
+    }
+    if (mFd >= 0) {
+        if (ftruncate(mFd, (off_t)((size_t)mFrameCount * mFrameBytes)) != 0) {
+            ret = IM_STATUS_FAILED;
+        }
+        ::close(mFd);
+    }
+    mFd = -1;
+    mData = nullptr;
+    mSize = 0;
+    mFrameCount = 0;
+    return ret;
+}
+
+IM_STATUS RgaFrameWriter::next(rga_buffer_t *buffer) {
+    if (mFd < 0) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    // Start writeback of the frame the caller just finished.
+    if (mFrameCount > 0) {
+        size_t page = pageSize();
+        size_t begin = (size_t)(mFrameCount - 1) * mFrameBytes & ~(page - 1);
+        msync(mData + begin, (size_t)mFrameCount * mFrameBytes - begin, MS_ASYNC);
+    }
+    size_t end = (size_t)(mFrameCount + 1) * mFrameBytes;
+    if (end > mSize) {
+        size_t size = mSize + (size_t)mGrowFrames * mFrameBytes;
+        if (ftruncate(mFd, (off_t)size) != 0) {
+            return IM_STATUS_OUT_OF_MEMORY;
+        }
+        void *addr = mData == nullptr ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0)
+                                      : mremap(mData, mSize, size, MREMAP_MAYMOVE);
+        if (addr == MAP_FAILED) {
+            return IM_STATUS_OUT_OF_MEMORY;
+        }
+        mData = (uint8_t *)addr;
+        mSize = size;
+    }
+    *buffer = mTemplate;
+    buffer->vir_addr = mData + (size_t)mFrameCount * mFrameBytes;
+    mFrameCount++;
+    return IM_STATUS_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#ifndef _rga_frame_file_h_
+#define _rga_frame_file_h_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "im2d_type.h"
+
+/*
+ * Raw frame sequence files (back-to-back frames of one RK_FORMAT_*, as written
+ * by output_buf_data_to_file) accessed through mmap instead of one stdio
+ * read/write per frame. Frames are rga_buffer_t views into the mapping, so
+ * they go to improcess without a copy.
+ *
+ * Frame size is rgaFormatImageSize(format, wstride, hstride) unless frameBytes is
+ * given (e.g. for FBC captures). The whole file is mapped, which needs a
+ * 64-bit process for multi-GB files.
+ */
+
+class RgaFrameReader {
+public:
+    RgaFrameReader();
+    ~RgaFrameReader();
+
+    /*
+     * wstride/hstride <= 0 mean width/height. prefetch is the number of frames
+     * ahead of the last one handed out that are requested with MADV_WILLNEED.
+     */
+    IM_STATUS open(const std::string &path, int width, int height, int format, int wstride, int hstride,
+                   size_t frameBytes, int prefetch);
+    void close();
+
+    int frameCount() const {
+        return mFrameCount;
+    }
+
+    size_t frameBytes() const {
+        return mFrameBytes;
+    }
+
+    /* Read-only view of frame index, valid until close(). */
+    IM_STATUS frame(int index, rga_buffer_t *buffer);
+
+private:
+    void advise(int first, int count, int advice);
+
+    int mFd = -1;
+    uint8_t *mData = nullptr;
+    size_t mSize = 0;
+    size_t mFrameBytes = 0;
+    int mFrameCount = 0;
+    int mPrefetch = 0;
+    int mLast = -1;
+    int mPrefetched = -1;       /* last frame requested ahead */
+    rga_buffer_t mTemplate;
+};
+
+class RgaFrameWriter {
+public:
+    RgaFrameWriter();
+    ~RgaFrameWriter();
+
+    /* Creates or truncates path; the file grows by growFrames frames at a time. */
+    IM_STATUS open(const std::string &path, int width, int height, int format, int wstride, int hstride,
+                   size_t frameBytes, int growFrames);
+
+    /* Trims the file to the frames handed out and writes it back. */
+    IM_STATUS close();
+
+    int frameCount() const {
+        return mFrameCount;
+    }
+
+    size_t frameBytes() const {
+        return mFrameBytes;
+    }
+
+    /*
+     * Append a frame and return a writable view of it, e.g. as improcess dst.
+     * Growing the file may move the mapping, so a view is only valid until the
+     * next call; the previous frames are queued for writeback at that point.
+     */
+    IM_STATUS next(rga_buffer_t *buffer);
+
+private:
+    int mFd = -1;
+    uint8_t *mData = nullptr;
+    size_t mSize = 0;
+    size_t mFrameBytes = 0;
+    int mFrameCount = 0;
+    int mGrowFrames = 0;
+    rga_buffer_t mTemplate;
+};
+
+#endif
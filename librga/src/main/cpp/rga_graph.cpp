@@ -0,0 +1,361 @@
+#include "rga_graph.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "rga_backend.h"
+#include "rga_format.h"
+
+// Scale range of one RGA pass (per axis).
+#define RGA_GRAPH_MAX_SCALE 8
+
+static int64_t imageBytes(int format, int width, int height) {
+    return (int64_t)rgaFormatImageSize(format, width, height);
+}
+
+// Pixel rect transforms within a w x h image.
+static im_rect rotateCcw(const im_rect &r, int w) {
+    return {r.y, w - r.x - r.width, r.height, r.width};
+}
+
+static im_rect mirrorH(const im_rect &r, int w) {
+    return {w - r.x - r.width, r.y, r.width, r.height};
+}
+
+static int transformUsage(int rot, bool mirror) {
+    static const int rotations[4] = {0, IM_HAL_TRANSFORM_ROT_90, IM_HAL_TRANSFORM_ROT_180, IM_HAL_TRANSFORM_ROT_270};
+    if (!mirror) {
+        return rotations[rot];
+    }
+    return rot == 0 ? IM_HAL_TRANSFORM_FLIP_H : IM_HAL_TRANSFORM_FLIP_V;     // rot == 2
+}
+
+RgaGraph::RgaGraph(int core) : mCore(core) {
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+RgaGraph::~RgaGraph() {
+    for (uint8_t *data : mScratch) {
+        free(data);
+    }
+}
+
+int RgaGraph::addNode(const Node &node) {
+    if (mCompiled) {
+        return -1;
+    }
+    mNodes.push_back(node);
+    return (int)mNodes.size() - 1;
+}
+
+int RgaGraph::input(const rga_buffer_t &buffer) {
+    if (buffer.width <= 0 || buffer.height <= 0 || imageBytes(buffer.format, 1, 1) == 0) {
+        return -1;
+    }
+    Node node;
+    memset(&node, 0, sizeof(node));
+    node.op = NODE_INPUT;
+    node.in = -1;
+    node.width = buffer.width;
+    node.height = buffer.height;
+    node.format = buffer.format;
+    node.bound = true;
+    node.buffer = buffer;
+    return addNode(node);
+}
+
+int RgaGraph::crop(int in, const im_rect &rect) {
+    if (in < 0 || in >= (int)mNodes.size()) {
+        return -1;
+    }
+    const Node &src = mNodes[in];
+    if (rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0 ||
+        rect.x + rect.width > src.width || rect.y + rect.height > src.height) {
+        return -1;
+    }
+    Node node = src;
+    node.op = NODE_CROP;
+    node.in = in;
+    node.width = rect.width;
+    node.height = rect.height;
+    node.rect = rect;
+    node.isOutput = false;
+    node.bound = false;
+    return addNode(node);
+}
+
+int RgaGraph::resize(int in, int width, int height) {
+    if (in < 0 || in >= (int)mNodes.size() || width <= 0 || height <= 0) {
+        return -1;
+    }
+    Node node = mNodes[in];
+    node.op = NODE_RESIZE;
+    node.in = in;
+    node.width = width;
+    node.height = height;
+    node.isOutput = false;
+    node.bound = false;
+    return addNode(node);
+}
+
+int RgaGraph::cvtcolor(int in, int format) {
+    if (in < 0 || in >= (int)mNodes.size() || imageBytes(format, 1, 1) == 0) {
+        return -1;
+    }
+    Node node = mNodes[in];
+    node.op = NODE_CVTCOLOR;
+    node.in = in;
+    node.format = format;
+    node.isOutput = false;
+    node.bound = false;
+    return addNode(node);
+}
+
+int RgaGraph::rotate(int in, int rotation) {
+    int rot;
+    switch (rotation) {
+    case IM_HAL_TRANSFORM_ROT_90: rot = 1; break;
+    case IM_HAL_TRANSFORM_ROT_180: rot = 2; break;
+    case IM_HAL_TRANSFORM_ROT_270: rot = 3; break;
+    default: return -1;
+    }
+    if (in < 0 || in >= (int)mNodes.size()) {
+        return -1;
+    }
+    Node node = mNodes[in];
+    node.op = NODE_TRANSFORM;
+    node.in = in;
+    node.rot = rot;
+    node.mirror = false;
+    if (rot & 1) {
+        node.width = mNodes[in].height;
+        node.height = mNodes[in].width;
+    }
+    node.isOutput = false;
+    node.bound = false;
+    return addNode(node);
+}
+
+int RgaGraph::flip(int in, int mode) {
+    if (in < 0 || in >= (int)mNodes.size()) {
+        return -1;
+    }
+    Node node = mNodes[in];
+    node.op = NODE_TRANSFORM;
+    node.in = in;
+    // A vertical flip is a horizontal one followed by half a turn.
+    switch (mode) {
+    case IM_HAL_TRANSFORM_FLIP_H: node.rot = 0; node.mirror = true; break;
+    case IM_HAL_TRANSFORM_FLIP_V: node.rot = 2; node.mirror = true; break;
+    case IM_HAL_TRANSFORM_FLIP_H_V: node.rot = 2; node.mirror = false; break;
+    default: return -1;
+    }
+    node.isOutput = false;
+    node.bound = false;
+    return addNode(node);
+}
+
+// Formats are compared normalized: Kotlin passes RK_FORMAT_* without the << 8.
+static bool sameFormat(int a, int b) {
+    return rgaFormatNormalize(a) == rgaFormatNormalize(b);
+}
+
+IM_STATUS RgaGraph::output(int id, const rga_buffer_t &buffer) {
+    if (mCompiled || id < 0 || id >= (int)mNodes.size() || mNodes[id].op == NODE_INPUT) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    Node &node = mNodes[id];
+    if (buffer.width != node.width || buffer.height != node.height || !sameFormat(buffer.format, node.format)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    node.isOutput = true;
+    node.bound = true;
+    node.buffer = buffer;
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS RgaGraph::rebind(int id, const rga_buffer_t &buffer) {
+    if (id < 0 || id >= (int)mNodes.size()) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    Node &node = mNodes[id];
+    if ((node.op != NODE_INPUT && !node.isOutput) ||
+        buffer.width != node.width || buffer.height != node.height || !sameFormat(buffer.format, node.format)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    node.buffer = buffer;
+    return IM_STATUS_SUCCESS;
+}
+
+// Fold op (whose input is the image `from` produces) into the pending pass.
+// Without strict the hardware scale limit is ignored (a single op is always one pass).
+bool RgaGraph::fold(const Pending &from, const Node &op, Pending *out, bool strict) const {
+    Pending p = from;
+    switch (op.op) {
+    case NODE_CROP: {
+        // Map the crop back through the transform, then through the scale.
+        im_rect r = op.rect;
+        int w = (p.rot & 1) ? p.height : p.width;
+        int h = (p.rot & 1) ? p.width : p.height;
+        for (int i = 0; i < p.rot; i++) {
+            r = rotateCcw(r, w);
+            int t = w;
+            w = h;
+            h = t;
+        }
+        if (p.mirror) {
+            r = mirrorH(r, w);
+        }
+        int64_t sw = p.srect.width;
+        int64_t sh = p.srect.height;
+        if ((r.x * sw) % w || (r.width * sw) % w || (r.y * sh) % h || (r.height * sh) % h) {
+            return false;       // not on source pixel boundaries
+        }
+        p.srect = {p.srect.x + (int)(r.x * sw / w), p.srect.y + (int)(r.y * sh / h),
+                   (int)(r.width * sw / w), (int)(r.height * sh / h)};
+        p.width = r.width;
+        p.height = r.height;
+        break;
+    }
+    case NODE_RESIZE:
+        p.width = (p.rot & 1) ? op.height : op.width;
+        p.height = (p.rot & 1) ? op.width : op.height;
+        if (strict && ((int64_t)p.width * RGA_GRAPH_MAX_SCALE < p.srect.width ||
+                       (int64_t)p.width > (int64_t)p.srect.width * RGA_GRAPH_MAX_SCALE ||
+                       (int64_t)p.height * RGA_GRAPH_MAX_SCALE < p.srect.height ||
+                       (int64_t)p.height > (int64_t)p.srect.height * RGA_GRAPH_MAX_SCALE)) {
+            return false;
+        }
+        break;
+    case NODE_CVTCOLOR:
+        p.format = op.format;
+        break;
+    case NODE_TRANSFORM:
+        // Mirroring after a rotation reverses it: M * R(k) = R(-k) * M.
+        p.rot = ((op.mirror ? -p.rot : p.rot) + op.rot) & 3;
+        p.mirror = p.mirror != op.mirror;
+        if (p.mirror && (p.rot & 1)) {
+            return false;       // a transpose needs two passes
+        }
+        break;
+    case NODE_INPUT:
+        return false;
+    }
+    *out = p;
+    return true;
+}
+
+RgaGraph::Pending RgaGraph::identity(int id) const {
+    const Node &node = mNodes[id];
+    return {id, {0, 0, node.width, node.height}, node.width, node.height, 0, false, node.format};
+}
+
+void RgaGraph::emit(const Pending &pending, int target) {
+    const Node &src = mNodes[pending.base];
+    const Node &dst = mNodes[target];
+    mPasses.push_back({pending.base, target, pending.srect, transformUsage(pending.rot, pending.mirror)});
+    mStats.passes++;
+    mStats.bytesFused += imageBytes(src.format, pending.srect.width, pending.srect.height) +
+                         imageBytes(dst.format, dst.width, dst.height);
+}
+
+bool RgaGraph::materialize(int id) {
+    if (mMaterialized[id]) {
+        return true;
+    }
+    Node &node = mNodes[id];
+    if (!node.bound) {
+        int wstride = rgaFormatAlignStride(node.format, node.width);
+        size_t size = rgaFormatImageSize(node.format, wstride, node.height);
+        uint8_t *data = nullptr;
+        if (size == 0 || posix_memalign((void **)&data, 4096, size) != 0) {
+            return false;
+        }
+        mScratch.push_back(data);
+        memset(&node.buffer, 0, sizeof(node.buffer));
+        node.buffer.vir_addr = data;
+        node.buffer.width = node.width;
+        node.buffer.height = node.height;
+        node.buffer.wstride = wstride;
+        node.buffer.hstride = node.height;
+        node.buffer.format = node.format;
+        node.bound = true;
+        mStats.intermediates++;
+        mStats.intermediateBytes += (int64_t)size;
+    }
+    emit(mPending[id], id);
+    mMaterialized[id] = true;
+    mPending[id] = identity(id);
+    return true;
+}
+
+IM_STATUS RgaGraph::compile() {
+    if (mCompiled) {
+        return IM_STATUS_SUCCESS;
+    }
+    int count = (int)mNodes.size();
+    std::vector<int> consumers(count, 0);
+    for (const Node &node : mNodes) {
+        if (node.in >= 0) {
+            consumers[node.in]++;
+        }
+    }
+    mPending.resize(count);
+    mMaterialized.assign(count, false);
+    memset(&mStats, 0, sizeof(mStats));
+
+    // Nodes are created after their inputs, so id order is a topological order.
+    for (int id = 0; id < count; id++) {
+        const Node &node = mNodes[id];
+        mPending[id] = identity(id);
+        if (node.op == NODE_INPUT) {
+            mMaterialized[id] = true;
+            continue;
+        }
+        const Node &in = mNodes[node.in];
+        mStats.ops++;
+        mStats.bytesUnfused += imageBytes(in.format, node.op == NODE_CROP ? node.rect.width : in.width,
+                                          node.op == NODE_CROP ? node.rect.height : in.height) +
+                               imageBytes(node.format, node.width, node.height);
+
+        if (!fold(mPending[node.in], node, &mPending[id], true)) {
+            if (!materialize(node.in)) {
+                return IM_STATUS_OUT_OF_MEMORY;
+            }
+            fold(mPending[node.in], node, &mPending[id], false);
+        }
+        if (node.isOutput || consumers[id] > 1) {
+            if (!materialize(id)) {
+                return IM_STATUS_OUT_OF_MEMORY;
+            }
+        }
+    }
+    mCompiled = true;
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS RgaGraph::run() {
+    IM_STATUS ret = compile();
+    if (ret != IM_STATUS_SUCCESS || mPasses.empty()) {
+        return ret;
+    }
+    im_opt_t opt = {};
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = mCore;
+
+    // Passes depend on each other in list order, which is how a job executes its tasks.
+    im_job_handle_t job = rgaBeginJob(0);
+    if (job == 0) {
+        return IM_STATUS_FAILED;
+    }
+    for (const Pass &pass : mPasses) {
+        const Node &src = mNodes[pass.src];
+        const Node &dst = mNodes[pass.dst];
+        ret = rgaProcessTask("graph", job, src.buffer, dst.buffer, {}, pass.srect,
+                             {0, 0, dst.width, dst.height}, {}, &opt, pass.usage);
+        if (ret != IM_STATUS_SUCCESS) {
+            rgaCancelJob(job);
+            return ret;
+        }
+    }
+    return rgaEndJob(job, IM_SYNC, 0, NULL);
+}
@@ -0,0 +1,114 @@
+#ifndef _rga_graph_h_
+#define _rga_graph_h_
+
+#include <stdint.h>
+#include <vector>
+#include "im2d_type.h"
+
+/*
+ * Small op graph that compiles chains of im2d operations into as few RGA passes
+ * as possible. One improcess() call can crop (srect), scale (srect -> drect),
+ * rotate or mirror (IM_HAL_TRANSFORM_*) and convert format at once, so a chain
+ * like cvtcolor -> resize -> rotate -> flip becomes a single pass.
+ *
+ * A node is materialized only when it is an output, feeds several consumers, or
+ * the next op cannot be folded into the pending pass. Not folded:
+ *  - a crop that does not map to whole source pixels,
+ *  - a scale beyond the hardware's 1/8 .. 8 range per pass,
+ *  - a transform that composes to a transpose (rotate 90/270 plus a mirror).
+ * Only materialized intermediates get scratch buffers.
+ *
+ * Fusing skips intermediate rounding: a chain through a narrower format (e.g.
+ * RGB_565) keeps the source precision.
+ */
+
+typedef struct {
+    int ops;                    /* op nodes in the graph */
+    int passes;                 /* RGA submissions after fusion */
+    int intermediates;          /* scratch images allocated */
+    int64_t intermediateBytes;
+    int64_t bytesUnfused;       /* read + written with one pass per op */
+    int64_t bytesFused;         /* read + written by the compiled passes */
+} RgaGraphStats;
+
+class RgaGraph {
+public:
+    explicit RgaGraph(int core);
+    ~RgaGraph();
+
+    /* Each builder returns the new node id, or -1 for invalid arguments. */
+    int input(const rga_buffer_t &buffer);
+    int crop(int node, const im_rect &rect);
+    int resize(int node, int width, int height);
+    int cvtcolor(int node, int format);
+    int rotate(int node, int rotation);     /* IM_HAL_TRANSFORM_ROT_90/180/270 */
+    int flip(int node, int mode);           /* IM_HAL_TRANSFORM_FLIP_H/V/H_V */
+
+    /* Make node an output written to buffer, which must match its size and format. */
+    IM_STATUS output(int node, const rga_buffer_t &buffer);
+
+    /* Rebind an input or output to another buffer of the same size and format. */
+    IM_STATUS rebind(int node, const rga_buffer_t &buffer);
+
+    /* Plan the passes; run() compiles on first use. */
+    IM_STATUS compile();
+
+    /* Execute all passes as one job and wait for it. */
+    IM_STATUS run();
+
+    const RgaGraphStats &stats() const {
+        return mStats;
+    }
+
+private:
+    enum NodeOp { NODE_INPUT, NODE_CROP, NODE_RESIZE, NODE_CVTCOLOR, NODE_TRANSFORM };
+
+    struct Node {
+        NodeOp op;
+        int in;
+        int width;          /* image produced by this node */
+        int height;
+        int format;
+        im_rect rect;       /* crop */
+        int rot;            /* transform: mirror horizontally, then rot quarter turns clockwise */
+        bool mirror;
+        bool isOutput;
+        bool bound;         /* buffer set: inputs, outputs and scratch */
+        rga_buffer_t buffer;
+    };
+
+    /* A pending pass: base image -> srect -> scale to w x h -> transform -> format. */
+    struct Pending {
+        int base;
+        im_rect srect;
+        int width;          /* before the transform */
+        int height;
+        int rot;
+        bool mirror;
+        int format;
+    };
+
+    struct Pass {
+        int src;
+        int dst;
+        im_rect srect;
+        int usage;
+    };
+
+    int addNode(const Node &node);
+    Pending identity(int node) const;
+    bool fold(const Pending &from, const Node &op, Pending *out, bool strict) const;
+    void emit(const Pending &pending, int target);
+    bool materialize(int node);
+
+    int mCore;
+    bool mCompiled = false;
+    std::vector<Node> mNodes;
+    std::vector<Pending> mPending;
+    std::vector<bool> mMaterialized;
+    std::vector<Pass> mPasses;
+    std::vector<uint8_t *> mScratch;
+    RgaGraphStats mStats;
+};
+
+#endif
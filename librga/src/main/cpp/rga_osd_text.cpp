@@ -0,0 +1,253 @@
+#include "rga_osd_text.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "rga_atlas.h"
+#include "rga_backend.h"
+#include "rga_format.h"
+
+// Next code point of a UTF-8 string; malformed bytes decode as themselves.
+static uint32_t nextCodepoint(const char **text) {
+    const uint8_t *p = (const uint8_t *)*text;
+    uint32_t c = *p++;
+    int extra = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+    if (extra > 0) {
+        c &= 0x3f >> extra;
+        for (int i = 0; i < extra && (*p & 0xc0) == 0x80; i++) {
+            c = c << 6 | (*p++ & 0x3f);
+        }
+    }
+    *text = (const char *)p;
+    return c;
+}
+
+// Round v toward -inf to a multiple of align.
+static int alignDown(int v, int align) {
+    return v - ((v % align) + align) % align;
+}
+
+// Straight-alpha src over the RGBA pixel d.
+static void blendPixel(uint8_t *d, const uint8_t *rgb, int a) {
+    int da = d[3] * (255 - a) / 255;
+    int oa = a + da;
+    if (oa == 0) {
+        return;
+    }
+    for (int c = 0; c < 3; c++) {
+        d[c] = (uint8_t)((rgb[c] * a + d[c] * da + oa / 2) / oa);
+    }
+    d[3] = (uint8_t)oa;
+}
+
+RgaOsdText::RgaOsdText(int atlasWidth, int atlasHeight, int maxCached, int core)
+    : mCore(core), mMaxCached(maxCached < 1 ? 1 : maxCached) {
+    int width = atlasWidth > 0 ? atlasWidth : 1;
+    int height = atlasHeight > 0 ? atlasHeight : 1;
+    mAtlas.assign((size_t)width * height, 0);
+    memset(&mAtlasBuffer, 0, sizeof(mAtlasBuffer));
+    mAtlasBuffer.vir_addr = mAtlas.data();
+    mAtlasBuffer.width = mAtlasBuffer.wstride = width;
+    mAtlasBuffer.height = mAtlasBuffer.hstride = height;
+    mAtlasBuffer.format = RK_FORMAT_A8;
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+void RgaOsdText::setMetrics(int ascent, int lineHeight) {
+    mAscent = ascent;
+    mLineHeight = lineHeight;
+    clearCache();
+}
+
+IM_STATUS RgaOsdText::addGlyph(uint32_t codepoint, const uint8_t *coverage, int width, int height,
+                               int left, int top, int advance) {
+    if (width < 0 || height < 0 || ((width | height) != 0 && coverage == nullptr)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    int atlasWidth = mAtlasBuffer.width;
+    if (width > atlasWidth) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    // Shelf packing: glyphs arrive one at a time and are never removed.
+    if (mShelfX + width > atlasWidth) {
+        mShelfY += mShelfHeight + 1;
+        mShelfX = 0;
+        mShelfHeight = 0;
+    }
+    if (mShelfY + height > mAtlasBuffer.height) {
+        return IM_STATUS_OUT_OF_MEMORY;
+    }
+    Glyph glyph = {mShelfX, mShelfY, width, height, left, top, advance};
+    for (int y = 0; y < height; y++) {
+        memcpy(mAtlas.data() + (size_t)(glyph.y + y) * atlasWidth + glyph.x, coverage + (size_t)y * width, width);
+    }
+    mShelfX += width + 1;
+    mShelfHeight = std::max(mShelfHeight, height);
+
+    bool replaced = mGlyphs.count(codepoint) != 0;
+    mGlyphs[codepoint] = glyph;
+    mStats.glyphs = (int)mGlyphs.size();
+    mStats.atlasRows = mShelfY + mShelfHeight;
+    if (replaced) {
+        clearCache();
+    }
+    return IM_STATUS_SUCCESS;
+}
+
+const RgaOsdText::Glyph *RgaOsdText::findGlyph(uint32_t codepoint) const {
+    auto it = mGlyphs.find(codepoint);
+    if (it == mGlyphs.end()) {
+        it = mGlyphs.find('?');
+    }
+    return it != mGlyphs.end() ? &it->second : nullptr;
+}
+
+void RgaOsdText::measure(const char *text, int padding, int *width, int *height) const {
+    int pen = 0;
+    while (*text != '\0') {
+        const Glyph *glyph = findGlyph(nextCodepoint(&text));
+        pen += glyph != nullptr ? glyph->advance : 0;
+    }
+    // Even sizes keep the box usable on 4:2:0 frames.
+    *width = (pen + 2 * padding + 1) & ~1;
+    *height = (mLineHeight + 2 * padding + 1) & ~1;
+}
+
+const RgaOsdText::Rendered &RgaOsdText::render(const RgaOsdLabel &label) {
+    char suffix[40];
+    snprintf(suffix, sizeof(suffix), "\n%08x %08x %d", label.color, label.background, label.padding);
+    std::string key = std::string(label.text) + suffix;
+
+    auto found = mCacheIndex.find(key);
+    if (found != mCacheIndex.end()) {
+        mStats.cacheHits++;
+        mCache.splice(mCache.begin(), mCache, found->second);
+        return mCache.front();
+    }
+    mStats.cacheMisses++;
+
+    mCache.emplace_front();
+    Rendered &r = mCache.front();
+    r.key = key;
+    int width, height;
+    measure(label.text, label.padding, &width, &height);
+    width = std::max(width, 2);
+    height = std::max(height, 2);
+    r.pixels.resize((size_t)width * height * 4);
+    uint8_t bg[4] = {(uint8_t)label.background, (uint8_t)(label.background >> 8),
+                     (uint8_t)(label.background >> 16), (uint8_t)(label.background >> 24)};
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+        memcpy(&r.pixels[i * 4], bg, 4);
+    }
+
+    uint8_t rgb[3] = {(uint8_t)label.color, (uint8_t)(label.color >> 8), (uint8_t)(label.color >> 16)};
+    int alpha = (int)(label.color >> 24);
+    int pen = label.padding;
+    int baseline = label.padding + mAscent;
+    for (const char *p = label.text; *p != '\0';) {
+        const Glyph *glyph = findGlyph(nextCodepoint(&p));
+        if (glyph == nullptr) {
+            continue;
+        }
+        int gx = pen + glyph->left;
+        int gy = baseline - glyph->top;
+        for (int y = 0; y < glyph->height; y++) {
+            if (gy + y < 0 || gy + y >= height) {
+                continue;
+            }
+            const uint8_t *cov = mAtlas.data() + (size_t)(glyph->y + y) * mAtlasBuffer.width + glyph->x;
+            uint8_t *row = r.pixels.data() + (size_t)(gy + y) * width * 4;
+            for (int x = 0; x < glyph->width; x++) {
+                if (cov[x] != 0 && gx + x >= 0 && gx + x < width) {
+                    blendPixel(row + (gx + x) * 4, rgb, cov[x] * alpha / 255);
+                }
+            }
+        }
+        pen += glyph->advance;
+    }
+
+    memset(&r.buffer, 0, sizeof(r.buffer));
+    r.buffer.vir_addr = r.pixels.data();
+    r.buffer.width = r.buffer.wstride = width;
+    r.buffer.height = r.buffer.hstride = height;
+    r.buffer.format = RK_FORMAT_RGBA_8888;
+    mCacheIndex[key] = mCache.begin();
+    return r;
+}
+
+IM_STATUS RgaOsdText::draw(const rga_buffer_t &dst, const RgaOsdLabel *labels, int count, bool cpu) {
+    mStats.tasks = 0;
+    const RgaFormatDesc *desc = rgaFormatFind(dst.format);
+    // The CPU path blends raster pixels only; AFBC/tiled frames need the RGA.
+    if (desc == nullptr || (cpu && !rgaFormatIsRaster(dst.rd_mode))) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    int align = desc->rectAlign;
+
+    struct Task {
+        const rga_buffer_t *src;
+        im_rect srect;
+        im_rect drect;
+    };
+    std::vector<Task> tasks;
+    for (int i = 0; i < count; i++) {
+        if (labels[i].text == nullptr || labels[i].text[0] == '\0') {
+            continue;
+        }
+        const Rendered &r = render(labels[i]);
+        // Clip to dst; the origin snaps down (toward -inf, labels may hang off
+        // the top/left edge) to the format's alignment.
+        int x = alignDown(labels[i].x, align);
+        int y = alignDown(labels[i].y, align);
+        int sx = std::max(0, -x), sy = std::max(0, -y);
+        int width = std::min(r.buffer.width - sx, dst.width - (x + sx)) / align * align;
+        int height = std::min(r.buffer.height - sy, dst.height - (y + sy)) / align * align;
+        if (width <= 0 || height <= 0) {
+            continue;
+        }
+        tasks.push_back({&r.buffer, {sx, sy, width, height}, {x + sx, y + sy, width, height}});
+    }
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+    im_opt_t opt = {};
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = mCore;
+    for (size_t first = 0; first < tasks.size() && ret == IM_STATUS_SUCCESS; first += RGA_JOB_MAX_TASKS) {
+        size_t last = std::min(tasks.size(), first + RGA_JOB_MAX_TASKS);
+        if (cpu) {
+            for (size_t i = first; i < last && ret == IM_STATUS_SUCCESS; i++) {
+                ret = rgaProcessOn(RGA_ENGINE_CPU, "osdText", *tasks[i].src, dst, {}, tasks[i].srect, tasks[i].drect,
+                                   {}, -1, NULL, &opt, IM_ALPHA_BLEND_SRC_OVER);
+            }
+            continue;
+        }
+        im_job_handle_t job = rgaBeginJob(0);
+        if (job == 0) {
+            ret = IM_STATUS_FAILED;
+            break;
+        }
+        for (size_t i = first; i < last && ret == IM_STATUS_SUCCESS; i++) {
+            ret = rgaProcessTask("osdText", job, *tasks[i].src, dst, {}, tasks[i].srect, tasks[i].drect, {}, &opt,
+                                 IM_ALPHA_BLEND_SRC_OVER);
+        }
+        if (ret == IM_STATUS_SUCCESS) {
+            ret = rgaEndJob(job, IM_SYNC, -1, NULL);
+        } else {
+            rgaCancelJob(job);
+        }
+    }
+    mStats.tasks = (int)tasks.size();
+
+    // Evict only now: this frame's strings had to stay alive until the job was done.
+    while ((int)mCache.size() > mMaxCached) {
+        mCacheIndex.erase(mCache.back().key);
+        mCache.pop_back();
+    }
+    mStats.cachedStrings = (int)mCache.size();
+    return ret;
+}
+
+void RgaOsdText::clearCache() {
+    mCache.clear();
+    mCacheIndex.clear();
+    mStats.cachedStrings = 0;
+}
@@ -0,0 +1,112 @@
+#ifndef _rga_osd_text_h_
+#define _rga_osd_text_h_
+
+#include <stdint.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "im2d_type.h"
+
+/*
+ * OSD text overlays (timestamps, channel names, box labels) drawn with RGA
+ * blending instead of a Canvas pass per frame.
+ *
+ * Glyphs are rasterized once, by the caller's font engine, and kept in an
+ * RK_FORMAT_A8 coverage atlas. A label string is rendered from the atlas into
+ * an RGBA_8888 image (colour, optional background box) the first time it is
+ * drawn and cached, so a label that does not change between frames costs one
+ * blend task. draw() blends all labels onto the frame as one job
+ * (IM_ALPHA_BLEND_SRC_OVER, one task per label), or on the CPU with cpu set.
+ */
+
+typedef struct {
+    const char *text;       /* UTF-8 */
+    int x;                  /* top-left of the label box in dst */
+    int y;
+    uint32_t color;         /* 0xAABBGGRR */
+    uint32_t background;    /* box colour; alpha 0 = none */
+    int padding;            /* around the text, inside the box */
+} RgaOsdLabel;
+
+typedef struct {
+    int glyphs;
+    int atlasRows;          /* rows of the glyph atlas in use */
+    int cachedStrings;
+    int64_t cacheHits;      /* over all draw() calls */
+    int64_t cacheMisses;
+    int tasks;              /* blend tasks of the last draw() */
+} RgaOsdTextStats;
+
+class RgaOsdText {
+public:
+    /* maxCached: rendered strings kept, least recently drawn evicted first. */
+    RgaOsdText(int atlasWidth, int atlasHeight, int maxCached, int core);
+
+    /* Line metrics in pixels: baseline below the top, and the line height. */
+    void setMetrics(int ascent, int lineHeight);
+
+    /*
+     * Add a glyph: width x height coverage bytes (A8, stride width), drawn
+     * left/top relative to the pen position on the baseline, then advancing
+     * the pen by advance. IM_STATUS_OUT_OF_MEMORY once the atlas is full.
+     */
+    IM_STATUS addGlyph(uint32_t codepoint, const uint8_t *coverage, int width, int height,
+                       int left, int top, int advance);
+
+    /* Size of the label box for text with the given padding. */
+    void measure(const char *text, int padding, int *width, int *height) const;
+
+    /*
+     * Blend the labels onto dst; labels are clipped to dst. With cpu set, dst
+     * must be raster (IM_STATUS_NOT_SUPPORTED otherwise).
+     */
+    IM_STATUS draw(const rga_buffer_t &dst, const RgaOsdLabel *labels, int count, bool cpu);
+
+    void clearCache();
+
+    /* The glyph atlas (RK_FORMAT_A8). */
+    const rga_buffer_t &atlas() const {
+        return mAtlasBuffer;
+    }
+
+    const RgaOsdTextStats &stats() const {
+        return mStats;
+    }
+
+private:
+    struct Glyph {
+        int x;              /* in the atlas */
+        int y;
+        int width;
+        int height;
+        int left;
+        int top;
+        int advance;
+    };
+
+    struct Rendered {
+        std::string key;
+        std::vector<uint8_t> pixels;
+        rga_buffer_t buffer;
+    };
+
+    const Glyph *findGlyph(uint32_t codepoint) const;
+    const Rendered &render(const RgaOsdLabel &label);
+
+    int mCore;
+    int mMaxCached;
+    int mAscent = 0;
+    int mLineHeight = 0;
+    std::vector<uint8_t> mAtlas;
+    rga_buffer_t mAtlasBuffer;
+    int mShelfX = 0;        /* next free spot on the current shelf */
+    int mShelfY = 0;
+    int mShelfHeight = 0;
+    std::unordered_map<uint32_t, Glyph> mGlyphs;
+    std::list<Rendered> mCache;     /* most recently drawn first */
+    std::unordered_map<std::string, std::list<Rendered>::iterator> mCacheIndex;
+    RgaOsdTextStats mStats;
+};
+
+#endif
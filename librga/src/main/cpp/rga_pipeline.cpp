@@ -0,0 +1,262 @@
+#include "rga_pipeline.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include "rga_backend.h"
+#include "rga_cpu.h"
+#include "rga_stats.h"
+
+// A job that has not signaled after this long is reported as failed.
+#define RGA_PIPELINE_FENCE_TIMEOUT_MS 3000
+
+static bool isEmptyRect(const im_rect &r) {
+    return r.width <= 0 || r.height <= 0;
+}
+
+static bool waitFence(int fence, int timeoutMs) {
+    struct pollfd pfd;
+    pfd.fd = fence;
+    pfd.events = POLLIN;
+    for (;;) {
+        int ret = poll(&pfd, 1, timeoutMs);
+        if (ret > 0) {
+            return (pfd.revents & (POLLERR | POLLNVAL)) == 0;
+        }
+        if (ret == 0 || errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+// Wait on cond until pred holds; timeoutMs < 0 waits forever.
+template <typename Pred>
+static bool waitFor(std::condition_variable &cond, std::unique_lock<std::mutex> &lock, int timeoutMs, Pred pred) {
+    if (timeoutMs < 0) {
+        cond.wait(lock, pred);
+        return true;
+    }
+    return cond.wait_for(lock, std::chrono::milliseconds(timeoutMs), pred);
+}
+
+RgaPipeline::RgaPipeline(const std::vector<RgaPipelineStage> &stages, int depth, int outputSlots, int core)
+    : mStages(stages), mDepth(depth < 1 ? 1 : depth), mCore(core) {
+    if (outputSlots < mDepth + 1) {
+        outputSlots = mDepth + 1;
+    }
+    mOutputs.resize(outputSlots);
+    mHeld.assign(outputSlots, false);
+    for (Image &image : mOutputs) {
+        image.data = nullptr;
+    }
+}
+
+RgaPipeline::~RgaPipeline() {
+    if (mThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mCond.notify_all();
+        mThread.join();
+    }
+    for (auto &scratch : mScratch) {
+        for (Image &image : scratch) {
+            free(image.data);
+        }
+    }
+    for (Image &image : mOutputs) {
+        free(image.data);
+    }
+}
+
+bool RgaPipeline::allocate(Image &image, int width, int height, int format, int rdMode) {
+    int wstride = rgaFormatAlignStride(format, width);
+    size_t size = rgaFormatBufferSize(format, wstride, height, rdMode);
+    image.data = nullptr;
+    if (size == 0 || posix_memalign((void **)&image.data, 4096, size) != 0) {
+        image.data = nullptr;
+        return false;
+    }
+    if (!rgaFormatIsRaster(rdMode)) {
+        // Zeroed FBC headers decode as a black image rather than garbage.
+        memset(image.data, 0, size);
+    }
+    memset(&image.buffer, 0, sizeof(image.buffer));
+    image.buffer.vir_addr = image.data;
+    image.buffer.width = width;
+    image.buffer.height = height;
+    image.buffer.wstride = wstride;
+    image.buffer.hstride = height;
+    image.buffer.format = format;
+    image.buffer.rd_mode = rdMode;
+    return true;
+}
+
+IM_STATUS RgaPipeline::init() {
+    if (mStages.empty()) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    for (const RgaPipelineStage &stage : mStages) {
+        if (stage.width <= 0 || stage.height <= 0) {
+            return IM_STATUS_INVALID_PARAM;
+        }
+    }
+    const RgaPipelineStage &last = mStages.back();
+    for (size_t i = 0; i < mOutputs.size(); i++) {
+        if (!allocate(mOutputs[i], last.width, last.height, last.format, last.rdMode)) {
+            return IM_STATUS_OUT_OF_MEMORY;
+        }
+        mFreeOutputs.push_back((int)i);
+    }
+    mScratch.resize(mDepth);
+    for (int i = 0; i < mDepth; i++) {
+        mScratch[i].resize(mStages.size() - 1);
+        for (Image &image : mScratch[i]) {
+            image.data = nullptr;
+        }
+        for (size_t s = 0; s + 1 < mStages.size(); s++) {
+            if (!allocate(mScratch[i][s], mStages[s].width, mStages[s].height, mStages[s].format,
+                              mStages[s].rdMode)) {
+                return IM_STATUS_OUT_OF_MEMORY;
+            }
+        }
+        mFreeScratch.push_back(i);
+    }
+    mThread = std::thread(&RgaPipeline::completionLoop, this);
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS RgaPipeline::submit(const rga_buffer_t &input, int acquireFence, int64_t tag, int timeoutMs) {
+    std::lock_guard<std::mutex> submitLock(mSubmitMutex);
+
+    InFlight frame;
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mThread.joinable()) {
+            return IM_STATUS_FAILED;
+        }
+        // Backpressure: a free in-flight slot and an output the consumer is not holding.
+        if (!waitFor(mCond, lock, timeoutMs, [this] {
+                return !mFreeScratch.empty() && !mFreeOutputs.empty();
+            })) {
+            return RGA_PIPELINE_TIMEOUT;
+        }
+        frame.seq = mNextSeq++;
+        frame.scratch = mFreeScratch.back();
+        mFreeScratch.pop_back();
+        frame.slot = mFreeOutputs.back();
+        mFreeOutputs.pop_back();
+    }
+    frame.tag = tag;
+    frame.fence = -1;
+    frame.submitNs = rgaStatsNowNs();
+
+    im_opt_t opt = {};
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = mCore;
+
+    IM_STATUS ret = IM_STATUS_FAILED;
+    im_job_handle_t job = rgaBeginJob(0);
+    if (job != 0) {
+        rga_buffer_t src = input;
+        ret = IM_STATUS_SUCCESS;
+        for (size_t s = 0; s < mStages.size() && ret == IM_STATUS_SUCCESS; s++) {
+            const RgaPipelineStage &stage = mStages[s];
+            const rga_buffer_t &dst = s + 1 < mStages.size() ? mScratch[frame.scratch][s].buffer
+                                                              : mOutputs[frame.slot].buffer;
+            im_rect srect = isEmptyRect(stage.srect) ? im_rect{0, 0, src.width, src.height} : stage.srect;
+            im_rect drect = isEmptyRect(stage.drect) ? im_rect{0, 0, dst.width, dst.height} : stage.drect;
+            ret = rgaProcessTask("pipeline", job, src, dst, {}, srect, drect, {}, &opt, stage.usage);
+            src = dst;
+        }
+        if (ret == IM_STATUS_SUCCESS) {
+            ret = rgaEndJob(job, IM_ASYNC, acquireFence, &frame.fence);
+        } else {
+            rgaCancelJob(job);
+        }
+    }
+    frame.status = ret;
+
+    // Failed frames are queued as well so results stay in order; the consumer
+    // sees the status and recycles the slot like any other frame.
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mInFlight.push_back(frame);
+    }
+    mCond.notify_all();
+    return ret;
+}
+
+void RgaPipeline::completionLoop() {
+    for (;;) {
+        InFlight frame;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [this] { return !mInFlight.empty() || mStopping; });
+            if (mInFlight.empty()) {
+                return;
+            }
+            frame = mInFlight.front();
+        }
+
+        IM_STATUS status = frame.status;
+        if (frame.fence >= 0) {
+            if (!waitFence(frame.fence, RGA_PIPELINE_FENCE_TIMEOUT_MS)) {
+                status = IM_STATUS_FAILED;
+            } else {
+                rgaStatsRecordFence(RGA_STATS_JOB, frame.fence, frame.submitNs);
+            }
+            close(frame.fence);
+        }
+
+        RgaPipelineFrame done;
+        done.seq = frame.seq;
+        done.tag = frame.tag;
+        done.status = status;
+        done.slot = frame.slot;
+        done.buffer = mOutputs[frame.slot].buffer;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mInFlight.pop_front();
+            mFreeScratch.push_back(frame.scratch);
+            mDone.push_back(done);
+        }
+        mCond.notify_all();
+    }
+}
+
+IM_STATUS RgaPipeline::dequeue(RgaPipelineFrame *frame, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (!waitFor(mCond, lock, timeoutMs, [this] { return !mDone.empty(); })) {
+        return RGA_PIPELINE_TIMEOUT;
+    }
+    *frame = mDone.front();
+    mDone.pop_front();
+    mHeld[frame->slot] = true;
+    return IM_STATUS_SUCCESS;
+}
+
+void RgaPipeline::recycle(int slot) {
+    if (slot < 0 || slot >= (int)mOutputs.size()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // A second recycle would hand the slot to two frames at once.
+        if (!mHeld[slot]) {
+            return;
+        }
+        mHeld[slot] = false;
+        mFreeOutputs.push_back(slot);
+    }
+    mCond.notify_all();
+}
+
+void RgaPipeline::flush() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCond.wait(lock, [this] { return mInFlight.empty(); });
+}
@@ -0,0 +1,109 @@
+#ifndef _rga_pipeline_h_
+#define _rga_pipeline_h_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "im2d_type.h"
+
+/*
+ * Asynchronous frame pipeline: every submitted frame runs a fixed chain of
+ * stages as one RGA job (imbeginJob, one improcessTask per stage, imendJob with
+ * IM_ASYNC), so the caller only blocks when `depth` frames are already in
+ * flight or every output buffer is held by the consumer (backpressure).
+ *
+ * A completion thread waits on the release fences oldest-first and queues
+ * finished frames, so dequeue() returns them in submission order. Stage
+ * intermediates and outputs come from pools allocated up front; an output
+ * stays valid until it is handed back with recycle().
+ */
+
+/* Returned by submit() and dequeue() when the timeout expires. */
+#define RGA_PIPELINE_TIMEOUT ((IM_STATUS)0)
+
+typedef struct {
+    int width;          /* output image of this stage */
+    int height;
+    int format;
+    im_rect srect;      /* on the stage input; empty = whole image */
+    im_rect drect;      /* on the stage output; empty = whole image */
+    int usage;          /* IM_HAL_TRANSFORM_* etc. */
+    int rdMode;         /* IM_RD_MODE of the stage output; 0 = raster */
+} RgaPipelineStage;
+
+typedef struct {
+    uint64_t seq;       /* submission order, from 0 */
+    int64_t tag;        /* as passed to submit() */
+    IM_STATUS status;   /* of the whole chain */
+    int slot;           /* hand back with recycle() */
+    rga_buffer_t buffer;
+} RgaPipelineFrame;
+
+class RgaPipeline {
+public:
+    /* outputSlots < depth + 1 is raised to depth + 1; core is the im_opt_t.core mask. */
+    RgaPipeline(const std::vector<RgaPipelineStage> &stages, int depth, int outputSlots, int core);
+    /* Waits for all frames in flight; outputs not yet recycled are freed too. */
+    ~RgaPipeline();
+
+    /* Allocates the pools and starts the completion thread. */
+    IM_STATUS init();
+
+    /*
+     * Queue a frame. input must stay valid until the frame is dequeued.
+     * acquireFence (or -1) is passed to imendJob. timeoutMs < 0 waits forever.
+     */
+    IM_STATUS submit(const rga_buffer_t &input, int acquireFence, int64_t tag, int timeoutMs);
+
+    /* Next finished frame in submission order; RGA_PIPELINE_TIMEOUT if none in time. */
+    IM_STATUS dequeue(RgaPipelineFrame *frame, int timeoutMs);
+
+    /* Ignored unless slot came from dequeue() and was not recycled since. */
+    void recycle(int slot);
+
+    /* Wait until nothing is in flight (finished frames stay queued). */
+    void flush();
+
+private:
+    struct Image {
+        uint8_t *data;
+        rga_buffer_t buffer;
+    };
+
+    struct InFlight {
+        uint64_t seq;
+        int64_t tag;
+        IM_STATUS status;
+        int fence;
+        int scratch;        /* index into mScratch */
+        int slot;           /* index into mOutputs */
+        uint64_t submitNs;
+    };
+
+    bool allocate(Image &image, int width, int height, int format, int rdMode);
+    void completionLoop();
+
+    std::vector<RgaPipelineStage> mStages;
+    int mDepth;
+    int mCore;
+
+    std::vector<std::vector<Image>> mScratch;   /* per in-flight frame: stage outputs but the last */
+    std::vector<Image> mOutputs;
+    std::vector<int> mFreeScratch;
+    std::vector<int> mFreeOutputs;
+    std::vector<bool> mHeld;                    /* per output: dequeued, not recycled yet */
+
+    std::mutex mSubmitMutex;    /* keeps job submission order == queue order */
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    std::deque<InFlight> mInFlight;
+    std::deque<RgaPipelineFrame> mDone;
+    uint64_t mNextSeq = 0;
+    bool mStopping = false;
+    std::thread mThread;
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "rga_region.h"
+
+#include <algorithm>
+#include "rga_format.h"
+
+bool rgaRectEmpty(const im_rect &r) {
+    return r.width <= 0 || r.height <= 0;
+}
+
+im_rect rgaRectIntersect(const im_rect &a, const im_rect &b) {
+    int x0 = std::max(a.x, b.x);
+    int y0 = std::max(a.y, b.y);
+    int x1 = std::min(a.x + a.width, b.x + b.width);
+    int y1 = std::min(a.y + a.height, b.y + b.height);
+    if (x1 <= x0 || y1 <= y0) {
+        return {0, 0, 0, 0};
+    }
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+// Pieces of r outside hole: a full-width band above and below, then left and right.
+static void subtractRect(const im_rect &r, const im_rect &hole, RgaRegion &out) {
+    im_rect in = rgaRectIntersect(r, hole);
+    if (rgaRectEmpty(in)) {
+        out.push_back(r);
+        return;
+    }
+    if (in.y > r.y) {
+        out.push_back({r.x, r.y, r.width, in.y - r.y});
+    }
+    if (in.y + in.height < r.y + r.height) {
+        out.push_back({r.x, in.y + in.height, r.width, r.y + r.height - in.y - in.height});
+    }
+    if (in.x > r.x) {
+        out.push_back({r.x, in.y, in.x - r.x, in.height});
+    }
+    if (in.x + in.width < r.x + r.width) {
+        out.push_back({in.x + in.width, in.y, r.x + r.width - in.x - in.width, in.height});
+    }
+}
+
+void rgaRegionSubtract(RgaRegion &region, const im_rect &rect) {
+    if (rgaRectEmpty(rect)) {
+        return;
+    }
+    RgaRegion out;
+    out.reserve(region.size() + 4);
+    for (const im_rect &r : region) {
+        subtractRect(r, rect, out);
+    }
+    region.swap(out);
+}
+
+void rgaRegionAdd(RgaRegion &region, const im_rect &rect) {
+    if (rgaRectEmpty(rect)) {
+        return;
+    }
+    RgaRegion pieces(1, rect);
+    for (const im_rect &r : region) {
+        rgaRegionSubtract(pieces, r);
+        if (pieces.empty()) {
+            return;
+        }
+    }
+    region.insert(region.end(), pieces.begin(), pieces.end());
+}
+
+void rgaRegionAddRegion(RgaRegion &region, const RgaRegion &other) {
+    for (const im_rect &r : other) {
+        rgaRegionAdd(region, r);
+    }
+}
+
+RgaRegion rgaRegionClip(const RgaRegion &region, const im_rect &rect) {
+    RgaRegion out;
+    for (const im_rect &r : region) {
+        im_rect in = rgaRectIntersect(r, rect);
+        if (!rgaRectEmpty(in)) {
+            out.push_back(in);
+        }
+    }
+    return out;
+}
+
+bool rgaRegionIntersects(const RgaRegion &region, const im_rect &rect) {
+    for (const im_rect &r : region) {
+        if (!rgaRectEmpty(rgaRectIntersect(r, rect))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t rgaRegionArea(const RgaRegion &region) {
+    int64_t area = 0;
+    for (const im_rect &r : region) {
+        area += (int64_t)r.width * r.height;
+    }
+    return area;
+}
+
+int rgaRegionGrid(int format) {
+    const RgaFormatDesc *desc = rgaFormatFind(format);
+    return desc != nullptr ? desc->rectAlign : 1;
+}
+
+im_rect rgaRectSnapOut(const im_rect &r, int grid, const im_rect &bounds) {
+    int x0 = r.x / grid * grid;
+    int y0 = r.y / grid * grid;
+    int x1 = (r.x + r.width + grid - 1) / grid * grid;
+    int y1 = (r.y + r.height + grid - 1) / grid * grid;
+    return rgaRectIntersect({x0, y0, x1 - x0, y1 - y0}, bounds);
+}
+
+im_rect rgaRectSnapIn(const im_rect &r, int grid) {
+    int x0 = (r.x + grid - 1) / grid * grid;
+    int y0 = (r.y + grid - 1) / grid * grid;
+    int x1 = (r.x + r.width) / grid * grid;
+    int y1 = (r.y + r.height) / grid * grid;
+    if (x1 <= x0 || y1 <= y0) {
+        return {0, 0, 0, 0};
+    }
+    return {x0, y0, x1 - x0, y1 - y0};
+}
+
+// How the dst axes read the src: with swap the dst columns (u) walk src rows.
+// Rotation combined with a flip is left out: the order the hardware applies
+// the two in is not pinned down (the op graph does not fuse it either).
+static bool transformAxes(int transform, bool *swap, bool *reverseU, bool *reverseV) {
+    *swap = transform == IM_HAL_TRANSFORM_ROT_90 || transform == IM_HAL_TRANSFORM_ROT_270;
+    switch (transform) {
+    case 0:                             *reverseU = false; *reverseV = false; return true;
+    case IM_HAL_TRANSFORM_ROT_90:       *reverseU = true;  *reverseV = false; return true;
+    case IM_HAL_TRANSFORM_ROT_180:      *reverseU = true;  *reverseV = true;  return true;
+    case IM_HAL_TRANSFORM_ROT_270:      *reverseU = false; *reverseV = true;  return true;
+    case IM_HAL_TRANSFORM_FLIP_H:       *reverseU = true;  *reverseV = false; return true;
+    case IM_HAL_TRANSFORM_FLIP_V:       *reverseU = false; *reverseV = true;  return true;
+    case IM_HAL_TRANSFORM_FLIP_H_V:     *reverseU = true;  *reverseV = true;  return true;
+    default:
+        return false;
+    }
+}
+
+// Map [offset, offset + length) of a dst axis of dstLen pixels onto a src axis of srcLen.
+static bool mapAxis(int offset, int length, int dstLen, int srcLen, bool reverse, int *srcOffset, int *srcLength) {
+    if (srcLen % dstLen != 0) {
+        return false;       // upscale or fractional downscale: taps cross the piece edge
+    }
+    int k = srcLen / dstLen;
+    *srcOffset = (reverse ? dstLen - offset - length : offset) * k;
+    *srcLength = length * k;
+    return true;
+}
+
+// Inverse of mapAxis, rounding outward to whole dst pixels.
+static bool mapAxisBack(int offset, int length, int srcLen, int dstLen, bool reverse, int *dstOffset, int *dstLength) {
+    if (srcLen % dstLen != 0) {
+        return false;
+    }
+    int k = srcLen / dstLen;
+    int d0 = offset / k;
+    int d1 = (offset + length + k - 1) / k;
+    *dstOffset = reverse ? dstLen - d1 : d0;
+    *dstLength = d1 - d0;
+    return true;
+}
+
+bool rgaRectMapToSource(const im_rect &piece, const im_rect &srect, const im_rect &drect, int transform,
+                        im_rect *out) {
+    bool swap, reverseU, reverseV;
+    if (!transformAxes(transform, &swap, &reverseU, &reverseV)) {
+        return false;
+    }
+    int u, du, v, dv;
+    if (!mapAxis(piece.x - drect.x, piece.width, drect.width, swap ? srect.height : srect.width, reverseU, &u, &du) ||
+        !mapAxis(piece.y - drect.y, piece.height, drect.height, swap ? srect.width : srect.height, reverseV, &v, &dv)) {
+        return false;
+    }
+    *out = swap ? im_rect{srect.x + v, srect.y + u, dv, du} : im_rect{srect.x + u, srect.y + v, du, dv};
+    return true;
+}
+
+bool rgaRectMapToDest(const im_rect &piece, const im_rect &srect, const im_rect &drect, int transform,
+                      im_rect *out) {
+    bool swap, reverseU, reverseV;
+    if (!transformAxes(transform, &swap, &reverseU, &reverseV)) {
+        return false;
+    }
+    // Source offsets along the dst u and v axes.
+    int su = swap ? piece.y - srect.y : piece.x - srect.x;
+    int lu = swap ? piece.height : piece.width;
+    int sv = swap ? piece.x - srect.x : piece.y - srect.y;
+    int lv = swap ? piece.width : piece.height;
+    int u, du, v, dv;
+    if (!mapAxisBack(su, lu, swap ? srect.height : srect.width, drect.width, reverseU, &u, &du) ||
+        !mapAxisBack(sv, lv, swap ? srect.width : srect.height, drect.height, reverseV, &v, &dv)) {
+        return false;
+    }
+    *out = {drect.x + u, drect.y + v, du, dv};
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef _rga_region_h_
+#define _rga_region_h_
+
+#include <stdint.h>
+#include <vector>
+#include "im2d_type.h"
+
+/*
+ * Pixel regions as lists of non-overlapping rectangles. Good enough for the
+ * handful of layers and damage rects a frame has; no banding or merging.
+ */
+typedef std::vector<im_rect> RgaRegion;
+
+bool rgaRectEmpty(const im_rect &r);
+im_rect rgaRectIntersect(const im_rect &a, const im_rect &b);
+
+/* Add rect without overlapping what the region already covers. */
+void rgaRegionAdd(RgaRegion &region, const im_rect &rect);
+void rgaRegionAddRegion(RgaRegion &region, const RgaRegion &other);
+
+/* Remove rect from the region (each piece splits into up to four). */
+void rgaRegionSubtract(RgaRegion &region, const im_rect &rect);
+
+/* Part of the region inside rect. */
+RgaRegion rgaRegionClip(const RgaRegion &region, const im_rect &rect);
+
+bool rgaRegionIntersects(const RgaRegion &region, const im_rect &rect);
+int64_t rgaRegionArea(const RgaRegion &region);
+
+/* Coordinate grid rects on format need: 2 for YUV, else 1. */
+int rgaRegionGrid(int format);
+/* Grow r to the grid and clip it to bounds. */
+im_rect rgaRectSnapOut(const im_rect &r, int grid, const im_rect &bounds);
+/* Largest grid-aligned rect inside r (may be empty). */
+im_rect rgaRectSnapIn(const im_rect &r, int grid);
+
+/*
+ * Source rect sampled for a piece of drect when srect is drawn to drect with
+ * transform (IM_HAL_TRANSFORM_*). Only succeeds when drawing the piece alone
+ * gives exactly the pixels drawing the whole layer would: per axis 1:1 or an
+ * integer downscale, and a pure rotation or a pure flip.
+ */
+bool rgaRectMapToSource(const im_rect &piece, const im_rect &srect, const im_rect &drect, int transform,
+                        im_rect *out);
+
+/* The dst rect that a piece of srect affects, under the same conditions (rounded outward). */
+bool rgaRectMapToDest(const im_rect &piece, const im_rect &srect, const im_rect &drect, int transform,
+                      im_rect *out);
+
+#endif
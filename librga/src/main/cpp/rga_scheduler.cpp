@@ -0,0 +1,292 @@
+#include "rga_scheduler.h"
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "rga_backend.h"
+#include "rga_stats.h"
+
+static bool isEmptyRect(const im_rect &r) {
+    return r.width <= 0 || r.height <= 0;
+}
+
+// A submission with deadline 0 sorts after every real deadline.
+static uint64_t sortKey(uint64_t deadlineNs) {
+    return deadlineNs != 0 ? deadlineNs : UINT64_MAX;
+}
+
+static bool missesDeadline(uint64_t deadlineNs, uint64_t now, uint64_t estimateNs) {
+    return deadlineNs != 0 && now + estimateNs > deadlineNs;
+}
+
+RgaScheduler::RgaScheduler(int workers, int core)
+    : mWorkers(workers < 1 ? 1 : workers), mCore(core) {
+}
+
+RgaScheduler::~RgaScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+        for (size_t s = 0; s < mStreams.size(); s++) {
+            mStreams[s].queue.clear();
+        }
+    }
+    mCond.notify_all();
+    for (std::thread &thread : mThreads) {
+        thread.join();
+    }
+}
+
+IM_STATUS RgaScheduler::init() {
+    if (!mThreads.empty()) {
+        return IM_STATUS_SUCCESS;
+    }
+    for (int i = 0; i < mWorkers; i++) {
+        mThreads.emplace_back(&RgaScheduler::workerLoop, this);
+    }
+    return IM_STATUS_SUCCESS;
+}
+
+int RgaScheduler::addStream(int maxQueued) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Stream stream;
+    stream.maxQueued = maxQueued < 1 ? 1 : maxQueued;
+    stream.running = false;
+    memset(&stream.stats, 0, sizeof(stream.stats));
+    mStreams.push_back(stream);
+    return (int)mStreams.size() - 1;
+}
+
+IM_STATUS RgaScheduler::submit(int stream, const std::vector<RgaSchedulerTask> &tasks, uint64_t deadlineNs,
+                               int64_t tag) {
+    // Each submission runs as one job, which holds at most RGA_JOB_MAX_TASKS.
+    if (tasks.empty() || tasks.size() > RGA_JOB_MAX_TASKS) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    Entry entry;
+    entry.tasks = tasks;
+    entry.deadlineNs = deadlineNs;
+    entry.submitNs = rgaStatsNowNs();
+    entry.tag = tag;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (stream < 0 || stream >= (int)mStreams.size() || mThreads.empty() || mStopping) {
+            return IM_STATUS_INVALID_PARAM;
+        }
+        Stream &s = mStreams[stream];
+        s.stats.submitted++;
+        s.queue.push_back(std::move(entry));
+        // The newest frame wins: drop the oldest waiting one past the limit.
+        while ((int)s.queue.size() > s.maxQueued) {
+            drop(stream, s.queue.front(), false);
+            s.queue.pop_front();
+        }
+    }
+    mCond.notify_all();
+    return IM_STATUS_SUCCESS;
+}
+
+// Queue the result of a submission that will not run. Called with mMutex held.
+void RgaScheduler::drop(int stream, const Entry &entry, bool cancelled) {
+    Stream &s = mStreams[stream];
+    s.stats.dropped++;
+    if (cancelled) {
+        s.stats.cancelled++;
+    }
+    uint64_t now = rgaStatsNowNs();
+    RgaSchedulerResult result;
+    result.stream = stream;
+    result.tag = entry.tag;
+    result.status = RGA_SCHEDULER_DROPPED;
+    result.late = false;
+    result.waitNs = now - entry.submitNs;
+    result.latencyNs = result.waitNs;
+    mDone.push_back(result);
+}
+
+// Drop waiting submissions that can no longer finish in time. Called with mMutex held.
+void RgaScheduler::dropStale(uint64_t now) {
+    for (size_t i = 0; i < mStreams.size(); i++) {
+        Stream &s = mStreams[i];
+        for (auto it = s.queue.begin(); it != s.queue.end();) {
+            if (missesDeadline(it->deadlineNs, now, (uint64_t)s.stats.jobNs)) {
+                drop((int)i, *it, false);
+                it = s.queue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+// Stream whose head has the earliest deadline, ties to the oldest; -1 if none can run.
+int RgaScheduler::pick() const {
+    int best = -1;
+    for (size_t i = 0; i < mStreams.size(); i++) {
+        const Stream &s = mStreams[i];
+        if (s.running || s.queue.empty()) {
+            continue;
+        }
+        if (best < 0) {
+            best = (int)i;
+            continue;
+        }
+        const Entry &a = s.queue.front();
+        const Entry &b = mStreams[best].queue.front();
+        uint64_t ka = sortKey(a.deadlineNs), kb = sortKey(b.deadlineNs);
+        if (ka < kb || (ka == kb && a.submitNs < b.submitNs)) {
+            best = (int)i;
+        }
+    }
+    return best;
+}
+
+IM_STATUS RgaScheduler::run(const Entry &entry, uint64_t estimateNs, bool *cancelled) {
+    *cancelled = false;
+    im_opt_t opt = {};
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = mCore;
+
+    im_job_handle_t job = rgaBeginJob(0);
+    if (job == 0) {
+        return IM_STATUS_FAILED;
+    }
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+    for (size_t i = 0; i < entry.tasks.size() && ret == IM_STATUS_SUCCESS; i++) {
+        const RgaSchedulerTask &task = entry.tasks[i];
+        im_rect srect = isEmptyRect(task.srect) ? im_rect{0, 0, task.src.width, task.src.height} : task.srect;
+        im_rect drect = isEmptyRect(task.drect) ? im_rect{0, 0, task.dst.width, task.dst.height} : task.drect;
+        ret = rgaProcessTask("scheduler", job, task.src, task.dst, {}, srect, drect, {}, &opt, task.usage);
+    }
+    if (ret == IM_STATUS_SUCCESS && missesDeadline(entry.deadlineNs, rgaStatsNowNs(), estimateNs)) {
+        *cancelled = true;
+        ret = RGA_SCHEDULER_DROPPED;
+    }
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCancelJob(job);
+        return ret;
+    }
+    return rgaEndJob(job, IM_SYNC, -1, NULL);
+}
+
+void RgaScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (;;) {
+        uint64_t now = rgaStatsNowNs();
+        size_t done = mDone.size();
+        dropStale(now);
+        if (mDone.size() != done) {
+            mCond.notify_all();
+        }
+
+        int stream = pick();
+        if (stream < 0) {
+            if (mStopping) {
+                return;
+            }
+            // Sleep until the next deadline so stale work is reported without new submissions.
+            uint64_t next = UINT64_MAX;
+            for (const Stream &s : mStreams) {
+                for (const Entry &entry : s.queue) {
+                    next = std::min(next, sortKey(entry.deadlineNs));
+                }
+            }
+            if (next == UINT64_MAX) {
+                mCond.wait(lock);
+            } else {
+                mCond.wait_for(lock, std::chrono::nanoseconds(next > now ? next - now : 0));
+            }
+            continue;
+        }
+
+        Stream &s = mStreams[stream];
+        Entry entry = std::move(s.queue.front());
+        s.queue.pop_front();
+        s.running = true;
+        mRunning++;
+        uint64_t estimateNs = (uint64_t)s.stats.jobNs;
+        lock.unlock();
+
+        uint64_t start = rgaStatsNowNs();
+        bool cancelled;
+        IM_STATUS status = run(entry, estimateNs, &cancelled);
+        uint64_t end = rgaStatsNowNs();
+
+        lock.lock();
+        Stream &t = mStreams[stream];     // addStream() may have moved it
+        t.running = false;
+        mRunning--;
+        if (cancelled) {
+            drop(stream, entry, true);
+        } else {
+            RgaSchedulerResult result;
+            result.stream = stream;
+            result.tag = entry.tag;
+            result.status = status;
+            result.late = status == IM_STATUS_SUCCESS && entry.deadlineNs != 0 && end > entry.deadlineNs;
+            result.waitNs = start - entry.submitNs;
+            result.latencyNs = end - entry.submitNs;
+            if (status == IM_STATUS_SUCCESS) {
+                int64_t jobNs = (int64_t)(end - start);
+                t.stats.jobNs = t.stats.jobNs != 0 ? (t.stats.jobNs * 7 + jobNs) / 8 : jobNs;
+                t.stats.completed++;
+                if (result.late) {
+                    t.stats.late++;
+                }
+            } else {
+                t.stats.failed++;
+            }
+            mDone.push_back(result);
+        }
+        mCond.notify_all();
+    }
+}
+
+IM_STATUS RgaScheduler::poll(RgaSchedulerResult *result, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto ready = [this] { return !mDone.empty(); };
+    if (timeoutMs < 0) {
+        mCond.wait(lock, ready);
+    } else if (!mCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready)) {
+        return RGA_SCHEDULER_TIMEOUT;
+    }
+    *result = mDone.front();
+    mDone.pop_front();
+    return IM_STATUS_SUCCESS;
+}
+
+RgaSchedulerStats RgaScheduler::stats(int stream) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    RgaSchedulerStats total;
+    memset(&total, 0, sizeof(total));
+    for (size_t i = 0; i < mStreams.size(); i++) {
+        if (stream >= 0 && (int)i != stream) {
+            continue;
+        }
+        const RgaSchedulerStats &s = mStreams[i].stats;
+        total.submitted += s.submitted;
+        total.completed += s.completed;
+        total.late += s.late;
+        total.dropped += s.dropped;
+        total.cancelled += s.cancelled;
+        total.failed += s.failed;
+        total.jobNs = std::max(total.jobNs, s.jobNs);
+        total.queued += (int64_t)mStreams[i].queue.size();
+    }
+    return total;
+}
+
+void RgaScheduler::flush() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCond.wait(lock, [this] {
+        if (mRunning != 0) {
+            return false;
+        }
+        for (const Stream &s : mStreams) {
+            if (!s.queue.empty()) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
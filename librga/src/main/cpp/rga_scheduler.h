@@ -0,0 +1,124 @@
+#ifndef _rga_scheduler_h_
+#define _rga_scheduler_h_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "im2d_type.h"
+
+/*
+ * Deadline-aware submission queue. submit() never waits for the RGA: work is
+ * queued per stream and worker threads run each submission as one job
+ * (imbeginJob, one improcessTask per task, imendJob). A stream has at most one
+ * job running, so its results come back in order.
+ *
+ * A submission may carry a deadline (CLOCK_MONOTONIC ns, as System.nanoTime()).
+ * Under overload streams lose frames instead of falling behind:
+ *  - a stream holds at most maxQueued waiting submissions; one more drops the
+ *    oldest, so the newest frame wins,
+ *  - workers take the waiting submission with the earliest deadline first,
+ *  - a submission that cannot finish in time, judging by its stream's recent
+ *    job time, is dropped before it reaches the RGA; if that becomes clear
+ *    while its tasks are being added, the job is cancelled (imcancelJob),
+ *  - a job that finishes after its deadline is delivered and counted late.
+ *
+ * Every submission is returned by poll() exactly once, dropped ones with
+ * RGA_SCHEDULER_DROPPED; its buffers may be reused from then on.
+ */
+
+/* Status of a submission dropped or cancelled by the scheduler. */
+#define RGA_SCHEDULER_DROPPED ((IM_STATUS)3)
+/* Returned by poll() when nothing finished in time. */
+#define RGA_SCHEDULER_TIMEOUT ((IM_STATUS)0)
+
+typedef struct {
+    rga_buffer_t src;
+    rga_buffer_t dst;
+    im_rect srect;      /* empty = whole image */
+    im_rect drect;
+    int usage;
+} RgaSchedulerTask;
+
+typedef struct {
+    int stream;
+    int64_t tag;        /* as passed to submit() */
+    IM_STATUS status;
+    bool late;          /* finished after its deadline */
+    uint64_t waitNs;    /* submit -> job start (or drop) */
+    uint64_t latencyNs; /* submit -> result */
+} RgaSchedulerResult;
+
+typedef struct {
+    int64_t submitted;
+    int64_t completed;  /* ran to the end, late ones included */
+    int64_t late;
+    int64_t dropped;    /* never ran, cancelled ones included */
+    int64_t cancelled;  /* dropped after the job was built */
+    int64_t failed;
+    int64_t jobNs;      /* running average of the job time; the slowest stream for -1 */
+    int64_t queued;     /* waiting now */
+} RgaSchedulerStats;
+
+class RgaScheduler {
+public:
+    /* workers: jobs run at once (e.g. one per RGA core); core is the im_opt_t.core mask. */
+    RgaScheduler(int workers, int core);
+    /* Drops what is still waiting and waits for the running jobs. */
+    ~RgaScheduler();
+
+    IM_STATUS init();
+
+    /* New stream id, or -1. maxQueued < 1 is raised to 1. */
+    int addStream(int maxQueued);
+
+    /*
+     * Queue tasks (1 to RGA_JOB_MAX_TASKS) as one job; deadlineNs 0 = none.
+     * The buffers must stay valid until poll() returns it.
+     */
+    IM_STATUS submit(int stream, const std::vector<RgaSchedulerTask> &tasks, uint64_t deadlineNs, int64_t tag);
+
+    /* Next result; RGA_SCHEDULER_TIMEOUT if none within timeoutMs (< 0 waits forever). */
+    IM_STATUS poll(RgaSchedulerResult *result, int timeoutMs);
+
+    /* Counters of one stream, or of all for stream -1. */
+    RgaSchedulerStats stats(int stream);
+
+    /* Wait until nothing is waiting or running (results stay queued). */
+    void flush();
+
+private:
+    struct Entry {
+        std::vector<RgaSchedulerTask> tasks;
+        uint64_t deadlineNs;
+        uint64_t submitNs;
+        int64_t tag;
+    };
+
+    struct Stream {
+        int maxQueued;
+        bool running;
+        std::deque<Entry> queue;
+        RgaSchedulerStats stats;
+    };
+
+    void drop(int stream, const Entry &entry, bool cancelled);
+    void dropStale(uint64_t now);
+    int pick() const;
+    IM_STATUS run(const Entry &entry, uint64_t estimateNs, bool *cancelled);
+    void workerLoop();
+
+    int mWorkers;
+    int mCore;
+    std::vector<std::thread> mThreads;
+    std::vector<Stream> mStreams;
+    std::deque<RgaSchedulerResult> mDone;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    int mRunning = 0;
+    bool mStopping = false;
+};
+
+#endif
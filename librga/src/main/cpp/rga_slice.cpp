@@ -0,0 +1,147 @@
+#include "rga_slice.h"
+
+#include <time.h>
+#include <algorithm>
+#include "rga_backend.h"
+#include "rga_format.h"
+
+static int64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static bool isEmptyRect(const im_rect &r) {
+    return r.width <= 0 || r.height <= 0;
+}
+
+static int alignUp(int v, int align) {
+    return (v + align - 1) / align * align;
+}
+
+void RgaSliceProgress::setCallback(Callback callback) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCallback = std::move(callback);
+}
+
+void RgaSliceProgress::begin(int totalRows) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRows.store(0, std::memory_order_release);
+    mTotalRows = totalRows;
+    mDone = false;
+    mStatus = IM_STATUS_NOERROR;
+    mBeginNs = nowNs();
+    mSlices.clear();
+}
+
+void RgaSliceProgress::publish(int rows) {
+    Callback callback;
+    int total;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSlices.push_back({rows, nowNs() - mBeginNs});
+        mRows.store(rows, std::memory_order_release);
+        callback = mCallback;
+        total = mTotalRows;
+    }
+    mCond.notify_all();
+    if (callback) {
+        callback(rows, total);
+    }
+}
+
+void RgaSliceProgress::finish(IM_STATUS status) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDone = true;
+        mStatus = status;
+    }
+    mCond.notify_all();
+}
+
+int RgaSliceProgress::totalRows() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTotalRows;
+}
+
+bool RgaSliceProgress::done() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mDone;
+}
+
+IM_STATUS RgaSliceProgress::status() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStatus;
+}
+
+bool RgaSliceProgress::waitRows(int rows, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto ready = [this, rows] { return mDone || mRows.load(std::memory_order_relaxed) >= rows; };
+    if (timeoutMs < 0) {
+        mCond.wait(lock, ready);
+        return true;
+    }
+    return mCond.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready);
+}
+
+int64_t RgaSliceProgress::latencyNs(int rows) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const Slice &slice : mSlices) {
+        if (slice.rows >= rows) {
+            return slice.ns;
+        }
+    }
+    return -1;
+}
+
+IM_STATUS rgaProcessSliced(const char *name, const rga_buffer_t &src, const rga_buffer_t &dst,
+                           const im_rect &srect, const im_rect &drect, im_opt_t *opt, int usage,
+                           const im_intr_config_t &intr, RgaSliceProgress *progress) {
+    const RgaFormatDesc *srcDesc = rgaFormatFind(src.format);
+    const RgaFormatDesc *dstDesc = rgaFormatFind(dst.format);
+    if (srcDesc == nullptr || dstDesc == nullptr) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    im_rect s = isEmptyRect(srect) ? im_rect{0, 0, src.width, src.height} : srect;
+    im_rect d = isEmptyRect(drect) ? im_rect{0, 0, dst.width, dst.height} : drect;
+    int align = std::max(srcDesc->rectAlign, dstDesc->rectAlign);
+    // Rows of dst map to rows of src unless the transform turns them into columns.
+    bool sliced = (intr.flags & IM_INTR_WRITE_INTR) != 0 &&
+                  (usage & (IM_HAL_TRANSFORM_ROT_90 | IM_HAL_TRANSFORM_ROT_270)) == 0;
+    bool mirror = (usage & (IM_HAL_TRANSFORM_FLIP_V | IM_HAL_TRANSFORM_FLIP_H_V | IM_HAL_TRANSFORM_ROT_180)) != 0;
+    int first = intr.write_start > 0 ? intr.write_start : intr.write_step;
+    int step = intr.write_step > 0 ? alignUp(intr.write_step, align) : d.height;
+    first = sliced && first > 0 ? alignUp(first, align) : d.height;
+
+    RgaSliceProgress local;
+    if (progress == nullptr) {
+        progress = &local;
+    }
+    progress->begin(d.height);
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+    int y0 = 0, sy0 = 0;
+    for (int y1 = first; y0 < d.height; y1 += step) {
+        // The source rows of a slice end on an aligned row; slices that get no
+        // source row of their own (strong downscales) are merged into the next.
+        int sy1 = s.height;
+        if (y1 >= d.height) {
+            y1 = d.height;
+        } else {
+            sy1 = (int)((int64_t)y1 * s.height / d.height) / align * align;
+            if (sy1 <= sy0) {
+                continue;
+            }
+        }
+        im_rect sr = {s.x, mirror ? s.y + s.height - sy1 : s.y + sy0, s.width, sy1 - sy0};
+        im_rect dr = {d.x, d.y + y0, d.width, y1 - y0};
+        ret = rgaProcess(name, src, dst, {}, sr, dr, {}, -1, NULL, opt, usage);
+        if (ret != IM_STATUS_SUCCESS) {
+            break;
+        }
+        progress->publish(y1);
+        y0 = y1;
+        sy0 = sy1;
+    }
+    progress->finish(ret);
+    return ret;
+}
@@ -0,0 +1,87 @@
+#ifndef _rga_slice_h_
+#define _rga_slice_h_
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "im2d_type.h"
+
+/*
+ * Written-row progress for low-latency handoff, e.g. to a video encoder that
+ * can start on the top of a frame while the RGA is still writing the rest.
+ *
+ * The frame is written in horizontal slices laid out like the RGA's write
+ * pre-interrupt (im_intr_config_t): write_start rows first, then write_step
+ * rows per slice. Every finished slice is published to a RgaSliceProgress,
+ * which consumers poll (rows()) or block on (waitRows()), or which calls back
+ * on the writing thread.
+ *
+ * librga does not deliver IM_PRE_INTR interrupts to user space (they pace a
+ * hardware consumer in the kernel), so each slice is its own submission. The
+ * software backend runs the same slices, which makes the time to the first
+ * rows measurable on a host (latencyNs()).
+ */
+
+class RgaSliceProgress {
+public:
+    /* Called on the writing thread after each slice, outside the lock. */
+    typedef std::function<void(int rows, int totalRows)> Callback;
+
+    void setCallback(Callback callback);
+
+    void begin(int totalRows);
+    void publish(int rows);
+    void finish(IM_STATUS status);
+
+    /* Rows written so far, from the top of the destination rect. */
+    int rows() const {
+        return mRows.load(std::memory_order_acquire);
+    }
+    int totalRows() const;
+    bool done() const;
+    /* Result of the frame, IM_STATUS_NOERROR while it is being written. */
+    IM_STATUS status() const;
+
+    /*
+     * Wait until at least rows are written or the frame is done; false on
+     * timeout (timeoutMs < 0 waits forever).
+     */
+    bool waitRows(int rows, int timeoutMs);
+
+    /* ns from begin() until at least rows were written, -1 if not yet. */
+    int64_t latencyNs(int rows) const;
+
+private:
+    struct Slice {
+        int rows;
+        int64_t ns;
+    };
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCond;
+    std::atomic<int> mRows{0};
+    int mTotalRows = 0;
+    bool mDone = false;
+    IM_STATUS mStatus = IM_STATUS_NOERROR;
+    int64_t mBeginNs = 0;
+    std::vector<Slice> mSlices;
+    Callback mCallback;
+};
+
+/*
+ * src (srect of it) into drect of dst like rgaProcess, written in the slices
+ * intr describes (IM_INTR_WRITE_INTR) and published to progress. Slices are
+ * rounded to the formats' rect alignment. Same-size conversions and integer
+ * downscales match an unsliced call exactly; upscales and other ratios
+ * filter each slice on its own and can differ in the rows next to a slice
+ * edge. 90/270 degree rotations, and intr without IM_INTR_WRITE_INTR, write
+ * the frame as one slice.
+ */
+IM_STATUS rgaProcessSliced(const char *name, const rga_buffer_t &src, const rga_buffer_t &dst,
+                           const im_rect &srect, const im_rect &drect, im_opt_t *opt, int usage,
+                           const im_intr_config_t &intr, RgaSliceProgress *progress);
+
+#endif
@@ -0,0 +1,365 @@
+#include "rga_soft.h"
+
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "rga_afbc.h"
+#include "rga_backend.h"
+#include "rga_cpu.h"
+
+#define SOFT_SUPPORTED_USAGE (IM_HAL_TRANSFORM_MASK | IM_ALPHA_BLEND_MASK | IM_SYNC | IM_ASYNC | \
+                              IM_CROP | IM_COLOR_FILL | IM_NN_QUANTIZE)
+
+typedef struct {
+    int i0;
+    int i1;
+    int w;      /* weight of i1, Q8 */
+} Tap;
+
+static bool isEmptyRect(const im_rect &r) {
+    return r.x == 0 && r.y == 0 && r.width == 0 && r.height == 0;
+}
+
+static im_rect rectOrWhole(const im_rect &r, const rga_buffer_t &buf) {
+    return isEmptyRect(r) ? im_rect{0, 0, buf.width, buf.height} : r;
+}
+
+static bool rectInside(const im_rect &r, const rga_buffer_t &buf) {
+    return r.x >= 0 && r.y >= 0 && r.width > 0 && r.height > 0 &&
+           r.x + r.width <= buf.width && r.y + r.height <= buf.height;
+}
+
+static bool hasImage(const rga_buffer_t &buf) {
+    return (buf.vir_addr != nullptr || buf.fd > 0) && buf.width > 0 && buf.height > 0;
+}
+
+// Pixel-center aligned bilinear taps; reverse walks the source backwards.
+static void axisTaps(int srcLen, int dstLen, bool reverse, std::vector<Tap> &taps) {
+    taps.resize(dstLen);
+    for (int d = 0; d < dstLen; d++) {
+        int k = reverse ? dstLen - 1 - d : d;
+        int64_t pos = ((int64_t)(2 * k + 1) * srcLen * 256) / (2 * dstLen) - 128;
+        if (pos < 0) {
+            pos = 0;
+        }
+        int i0 = (int)(pos >> 8);
+        int w = (int)(pos & 255);
+        if (i0 >= srcLen - 1) {
+            i0 = srcLen - 1;
+            w = 0;
+        }
+        taps[d] = {i0, i0 + 1 < srcLen ? i0 + 1 : i0, w};
+    }
+}
+
+// Same format, same size, no transform: plain row copies per plane.
+static bool copyRects(const RgaCpuImage &simg, const im_rect &srect,
+                      const RgaCpuImage &dimg, const im_rect &drect) {
+    for (int p = 0; p < simg.planeCount; p++) {
+        const RgaCpuPlane &sp = simg.planes[p];
+        int xm = (1 << sp.xshift) - 1;
+        int ym = (1 << sp.yshift) - 1;
+        if (sp.bpp == 0 || ((srect.x | srect.width | drect.x) & xm) || ((srect.y | srect.height | drect.y) & ym)) {
+            return false;
+        }
+    }
+    for (int p = 0; p < simg.planeCount; p++) {
+        const RgaCpuPlane &sp = simg.planes[p];
+        const RgaCpuPlane &dp = dimg.planes[p];
+        int rows = srect.height >> sp.yshift;
+        size_t bytes = (size_t)(srect.width >> sp.xshift) * sp.bpp;
+        const uint8_t *s = sp.data + (size_t)(srect.y >> sp.yshift) * sp.stride + (size_t)(srect.x >> sp.xshift) * sp.bpp;
+        uint8_t *d = dp.data + (size_t)(drect.y >> dp.yshift) * dp.stride + (size_t)(drect.x >> dp.xshift) * dp.bpp;
+        rgaCpuParallelFor(rows, [&](int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                memmove(d + (size_t)y * dp.stride, s + (size_t)y * sp.stride, bytes);
+            }
+        });
+    }
+    return true;
+}
+
+typedef struct {
+    rga_buffer_t buffer;
+    std::vector<uint8_t> data;
+} RasterCopy;
+
+// Raster scratch image for an AFBC buffer, decoded unless the caller overwrites it.
+static IM_STATUS unpack(const rga_buffer_t &afbc, bool decode, RasterCopy *copy) {
+    if (afbc.rd_mode != IM_AFBC16x16_MODE || !rgaAfbcSupported(afbc.format)) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    copy->data.resize(rgaFormatImageSize(afbc.format, afbc.width, afbc.height));
+    memset(&copy->buffer, 0, sizeof(copy->buffer));
+    copy->buffer.vir_addr = copy->data.data();
+    copy->buffer.width = afbc.width;
+    copy->buffer.height = afbc.height;
+    copy->buffer.wstride = afbc.width;
+    copy->buffer.hstride = afbc.height;
+    copy->buffer.format = afbc.format;
+    copy->buffer.global_alpha = afbc.global_alpha;
+    copy->buffer.color = afbc.color;
+    copy->buffer.nn = afbc.nn;
+    return decode ? rgaAfbcDecode(afbc, copy->buffer) : IM_STATUS_SUCCESS;
+}
+
+static IM_STATUS processRaster(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                               const im_rect &srcRect, const im_rect &dstRect, const im_rect &patRect, int usage);
+
+// The hardware reads and writes AFBC directly; here the AFBC images are
+// expanded to raster scratch, processed, and the destination compressed again.
+static IM_STATUS processCompressed(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                                   const im_rect &srcRect, const im_rect &dstRect, const im_rect &patRect,
+                                   int usage) {
+    RasterCopy s, d, p;
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+    const rga_buffer_t *srcBuf = &src;
+    const rga_buffer_t *patBuf = &pat;
+    const rga_buffer_t *dstBuf = &dst;
+    if (!rgaFormatIsRaster(src.rd_mode) && !(usage & IM_COLOR_FILL)) {
+        ret = unpack(src, true, &s);
+        srcBuf = &s.buffer;
+    }
+    if (ret == IM_STATUS_SUCCESS && hasImage(pat) && !rgaFormatIsRaster(pat.rd_mode)) {
+        ret = unpack(pat, true, &p);
+        patBuf = &p.buffer;
+    }
+    if (ret == IM_STATUS_SUCCESS && !rgaFormatIsRaster(dst.rd_mode)) {
+        // Pixels outside drect, or under a blend, have to survive the round trip.
+        im_rect drect = rectOrWhole(dstRect, dst);
+        bool whole = drect.x == 0 && drect.y == 0 && drect.width == dst.width && drect.height == dst.height;
+        bool keep = !whole || (usage & IM_ALPHA_BLEND_MASK) != 0;
+        ret = unpack(dst, keep, &d);
+        dstBuf = &d.buffer;
+    }
+    if (ret == IM_STATUS_SUCCESS) {
+        ret = processRaster(*srcBuf, *dstBuf, *patBuf, srcRect, dstRect, patRect, usage);
+    }
+    if (ret == IM_STATUS_SUCCESS && dstBuf != &dst) {
+        ret = rgaAfbcEncode(d.buffer, dst, nullptr);
+    }
+    return ret;
+}
+
+IM_STATUS rgaSoftProcess(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                         const im_rect &srcRect, const im_rect &dstRect, const im_rect &patRect, int usage) {
+    if (!rgaFormatIsRaster(src.rd_mode) || !rgaFormatIsRaster(dst.rd_mode) || !rgaFormatIsRaster(pat.rd_mode)) {
+        return processCompressed(src, dst, pat, srcRect, dstRect, patRect, usage);
+    }
+    return processRaster(src, dst, pat, srcRect, dstRect, patRect, usage);
+}
+
+static IM_STATUS processRaster(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                               const im_rect &srcRect, const im_rect &dstRect, const im_rect &patRect, int usage) {
+    if (usage & ~SOFT_SUPPORTED_USAGE) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    im_rect drect = rectOrWhole(dstRect, dst);
+    if (!rectInside(drect, dst)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    if (usage & IM_COLOR_FILL) {
+        return rgaCpuFill(dst, &drect, 1, (uint32_t)dst.color);
+    }
+    im_rect srect = rectOrWhole(srcRect, src);
+    if (!rectInside(srect, src)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    int transform = usage & IM_HAL_TRANSFORM_MASK;
+    int blend = usage & IM_ALPHA_BLEND_MASK;
+    bool hasPat = hasImage(pat);
+    if (usage & IM_NN_QUANTIZE) {
+        if (transform != 0 || blend != 0) {
+            return IM_STATUS_NOT_SUPPORTED;
+        }
+        return rgaCpuPrepareTensor(src, srect, dst, drect, RGA_CPU_TENSOR_NHWC, &dst.nn);
+    }
+    if (blend == IM_ALPHA_BLEND_DST && !hasPat) {
+        return IM_STATUS_SUCCESS;
+    }
+    bool over = blend == IM_ALPHA_BLEND_SRC_OVER;
+    if (blend != 0 && blend != IM_ALPHA_BLEND_SRC && !over) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    if (!rgaCpuCanLoadRgb(src.format) || !rgaCpuCanLoadRgb(dst.format) ||
+        (hasPat && !rgaCpuCanLoadRgb(pat.format))) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+
+    RgaCpuImage simg, dimg, pimg;
+    IM_STATUS ret = rgaCpuMapImage(src, &simg);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    ret = rgaCpuMapImage(dst, &dimg);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&simg);
+        return ret;
+    }
+    memset(&pimg, 0, sizeof(pimg));
+    im_rect prect = {0, 0, 0, 0};
+    if (hasPat && over) {
+        prect = rectOrWhole(patRect, pat);
+        if (!rectInside(prect, pat) || prect.width < drect.width || prect.height < drect.height) {
+            ret = IM_STATUS_INVALID_PARAM;
+        } else {
+            ret = rgaCpuMapImage(pat, &pimg);
+        }
+        if (ret != IM_STATUS_SUCCESS) {
+            rgaCpuUnmapImage(&dimg);
+            rgaCpuUnmapImage(&simg);
+            return ret;
+        }
+    }
+
+    if (transform == 0 && !over && simg.format == dimg.format &&
+        srect.width == drect.width && srect.height == drect.height &&
+        copyRects(simg, srect, dimg, drect)) {
+        rgaCpuUnmapImage(&dimg);
+        rgaCpuUnmapImage(&simg);
+        return IM_STATUS_SUCCESS;
+    }
+
+    // Source rect as planar RGBA.
+    int sw = srect.width;
+    int sh = srect.height;
+    size_t n = (size_t)sw * sh;
+    std::vector<uint8_t> rgba(n * 4);
+    uint8_t *planes[4] = {rgba.data(), rgba.data() + n, rgba.data() + 2 * n, rgba.data() + 3 * n};
+    rgaCpuParallelFor(sh, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            size_t o = (size_t)y * sw;
+            rgaCpuLoadRgbRow(simg, srect.y + y, srect.x, sw, planes[0] + o, planes[1] + o, planes[2] + o);
+            rgaCpuLoadAlphaRow(simg, srect.y + y, srect.x, sw, planes[3] + o);
+        }
+    });
+
+    // Inverse transform as two axis maps: mapU is indexed by the dst column and
+    // mapV by the dst row; with a 90/270 rotation they address src y and x.
+    bool flipH = (transform & (IM_HAL_TRANSFORM_FLIP_H | IM_HAL_TRANSFORM_FLIP_H_V)) != 0;
+    bool flipV = (transform & (IM_HAL_TRANSFORM_FLIP_V | IM_HAL_TRANSFORM_FLIP_H_V)) != 0;
+    int rot = transform & IM_HAL_TRANSFORM_ROT_MASK;
+    bool swap = rot == IM_HAL_TRANSFORM_ROT_90 || rot == IM_HAL_TRANSFORM_ROT_270;
+    std::vector<Tap> mapU, mapV;
+    if (rot == IM_HAL_TRANSFORM_ROT_90) {
+        axisTaps(sh, drect.width, !flipH, mapU);
+        axisTaps(sw, drect.height, flipV, mapV);
+    } else if (rot == IM_HAL_TRANSFORM_ROT_270) {
+        axisTaps(sh, drect.width, flipH, mapU);
+        axisTaps(sw, drect.height, !flipV, mapV);
+    } else {
+        bool r180 = rot == IM_HAL_TRANSFORM_ROT_180;
+        axisTaps(sw, drect.width, flipH != r180, mapU);
+        axisTaps(sh, drect.height, flipV != r180, mapV);
+    }
+
+    // global_alpha scales the source alpha when blending; 0 is taken as unset.
+    int planeAlpha = src.global_alpha > 0 && src.global_alpha < 255 ? src.global_alpha : 255;
+    rgaCpuParallelFor(drect.height, [&](int begin, int end) {
+        int dw = drect.width;
+        std::vector<uint8_t> out((size_t)dw * 4);
+        std::vector<uint8_t> bg(over ? (size_t)dw * 4 : 0);
+        uint8_t *o[4] = {out.data(), out.data() + dw, out.data() + 2 * dw, out.data() + 3 * dw};
+        for (int v = begin; v < end; v++) {
+            for (int u = 0; u < dw; u++) {
+                const Tap &tx = swap ? mapV[v] : mapU[u];
+                const Tap &ty = swap ? mapU[u] : mapV[v];
+                size_t r0 = (size_t)ty.i0 * sw;
+                size_t r1 = (size_t)ty.i1 * sw;
+                for (int c = 0; c < 4; c++) {
+                    const uint8_t *pl = planes[c];
+                    int top = pl[r0 + tx.i0] * (256 - tx.w) + pl[r0 + tx.i1] * tx.w;
+                    int bot = pl[r1 + tx.i0] * (256 - tx.w) + pl[r1 + tx.i1] * tx.w;
+                    o[c][u] = (uint8_t)((top * (256 - ty.w) + bot * ty.w + 32768) >> 16);
+                }
+            }
+            if (over) {
+                uint8_t *b[4] = {bg.data(), bg.data() + dw, bg.data() + 2 * dw, bg.data() + 3 * dw};
+                const RgaCpuImage &bimg = hasPat ? pimg : dimg;
+                int bx = hasPat ? prect.x : drect.x;
+                int by = (hasPat ? prect.y : drect.y) + v;
+                rgaCpuLoadRgbRow(bimg, by, bx, dw, b[0], b[1], b[2]);
+                rgaCpuLoadAlphaRow(bimg, by, bx, dw, b[3]);
+                for (int u = 0; u < dw; u++) {
+                    int a = planeAlpha < 255 ? (o[3][u] * planeAlpha + 127) / 255 : o[3][u];
+                    for (int c = 0; c < 3; c++) {
+                        o[c][u] = (uint8_t)((o[c][u] * a + b[c][u] * (255 - a) + 127) / 255);
+                    }
+                    o[3][u] = (uint8_t)(a + (b[3][u] * (255 - a) + 127) / 255);
+                }
+            }
+            rgaCpuStoreRgbRow(dimg, drect.y + v, drect.x, dw, o[0], o[1], o[2], o[3]);
+        }
+    });
+
+    if (pimg.planeCount > 0) {
+        rgaCpuUnmapImage(&pimg);
+    }
+    rgaCpuUnmapImage(&dimg);
+    rgaCpuUnmapImage(&simg);
+    return IM_STATUS_SUCCESS;
+}
+
+typedef struct {
+    rga_buffer_t src;
+    rga_buffer_t dst;
+    rga_buffer_t pat;
+    im_rect srect;
+    im_rect drect;
+    im_rect prect;
+    int usage;
+} SoftTask;
+
+static std::mutex gJobMutex;
+static std::map<im_job_handle_t, std::vector<SoftTask>> gJobs;
+static im_job_handle_t gNextJob = 1;
+
+im_job_handle_t rgaSoftBeginJob(uint64_t /* flags */) {
+    std::lock_guard<std::mutex> lock(gJobMutex);
+    im_job_handle_t job = gNextJob++;
+    if (gNextJob == 0) {
+        gNextJob = 1;
+    }
+    gJobs[job];
+    return job;
+}
+
+IM_STATUS rgaSoftProcessTask(im_job_handle_t job,
+                             const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                             const im_rect &srect, const im_rect &drect, const im_rect &prect, int usage) {
+    std::lock_guard<std::mutex> lock(gJobMutex);
+    auto it = gJobs.find(job);
+    // Same limit as librga, so host runs catch oversized jobs.
+    if (it == gJobs.end() || it->second.size() >= RGA_JOB_MAX_TASKS) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    it->second.push_back({src, dst, pat, srect, drect, prect, usage});
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS rgaSoftEndJob(im_job_handle_t job) {
+    std::vector<SoftTask> tasks;
+    {
+        std::lock_guard<std::mutex> lock(gJobMutex);
+        auto it = gJobs.find(job);
+        if (it == gJobs.end()) {
+            return IM_STATUS_INVALID_PARAM;
+        }
+        tasks.swap(it->second);
+        gJobs.erase(it);
+    }
+    for (const SoftTask &t : tasks) {
+        IM_STATUS ret = rgaSoftProcess(t.src, t.dst, t.pat, t.srect, t.drect, t.prect, t.usage);
+        if (ret != IM_STATUS_SUCCESS) {
+            return ret;
+        }
+    }
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS rgaSoftCancelJob(im_job_handle_t job) {
+    std::lock_guard<std::mutex> lock(gJobMutex);
+    return gJobs.erase(job) != 0 ? IM_STATUS_SUCCESS : IM_STATUS_INVALID_PARAM;
+}
@@ -0,0 +1,28 @@
+#ifndef _rga_soft_h_
+#define _rga_soft_h_
+
+#include <stdint.h>
+#include "im2d_type.h"
+
+/*
+ * Software implementation of improcess and the job API, used as the backend
+ * on hosts without an RGA (tests, tracing, benchmarks) and as the CPU engine
+ * for small images on the device (rga_crossover.h).
+ *
+ * Covers copy, crop, bilinear resize, format conversion, rotation/flip,
+ * SRC / SRC_OVER / DST blending (with pat as the composite background) and
+ * IM_COLOR_FILL. Anything else returns IM_STATUS_NOT_SUPPORTED.
+ */
+
+IM_STATUS rgaSoftProcess(const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                         const im_rect &srect, const im_rect &drect, const im_rect &prect, int usage);
+
+im_job_handle_t rgaSoftBeginJob(uint64_t flags);
+IM_STATUS rgaSoftProcessTask(im_job_handle_t job,
+                             const rga_buffer_t &src, const rga_buffer_t &dst, const rga_buffer_t &pat,
+                             const im_rect &srect, const im_rect &drect, const im_rect &prect, int usage);
+/* Runs the queued tasks in order; software jobs always complete synchronously. */
+IM_STATUS rgaSoftEndJob(im_job_handle_t job);
+IM_STATUS rgaSoftCancelJob(im_job_handle_t job);
+
+#endif
@@ -0,0 +1,123 @@
+#include "rga_staging.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "rga_format.h"
+
+#define RGA_STAGING_ALIGN 4096
+
+RgaStagingPool::RgaStagingPool(int maxFree) : mMaxFree(maxFree) {}
+
+RgaStagingPool::~RgaStagingPool() {
+    for (Entry &entry : mEntries) {
+        free(entry.data);
+    }
+}
+
+IM_STATUS RgaStagingPool::acquire(int width, int height, int format, im_job_handle_t job, rga_buffer_t *buffer) {
+    format = rgaFormatNormalize(format);
+    if (rgaFormatFind(format) == nullptr) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    if (width <= 0 || height <= 0) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    size_t size = rgaFormatImageSize(format, width, height);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    Entry *best = nullptr;
+    for (Entry &entry : mEntries) {
+        if (!entry.busy && entry.size >= size && (best == nullptr || entry.size < best->size)) {
+            best = &entry;
+        }
+    }
+    if (best == nullptr) {
+        // Free buffers too small for this frame are left over from another resolution.
+        for (size_t i = 0; i < mEntries.size();) {
+            if (!mEntries[i].busy && mEntries[i].size < size) {
+                mStats.bytes -= mEntries[i].size;
+                free(mEntries[i].data);
+                mEntries.erase(mEntries.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        size_t allocSize = (size + RGA_STAGING_ALIGN - 1) / RGA_STAGING_ALIGN * RGA_STAGING_ALIGN;
+        void *data = nullptr;
+        if (posix_memalign(&data, RGA_STAGING_ALIGN, allocSize) != 0) {
+            return IM_STATUS_OUT_OF_MEMORY;
+        }
+        mEntries.push_back({(uint8_t *)data, allocSize, 0, false});
+        best = &mEntries.back();
+        mStats.allocated++;
+        mStats.bytes += allocSize;
+    }
+    best->busy = true;
+    best->job = job;
+    mStats.acquired++;
+
+    memset(buffer, 0, sizeof(rga_buffer_t));
+    buffer->vir_addr = best->data;
+    buffer->width = width;
+    buffer->height = height;
+    buffer->wstride = width;
+    buffer->hstride = height;
+    buffer->format = format;
+    return IM_STATUS_SUCCESS;
+}
+
+void RgaStagingPool::release(const rga_buffer_t &buffer) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (Entry &entry : mEntries) {
+        if (entry.data == buffer.vir_addr) {
+            entry.busy = false;
+            entry.job = 0;
+            break;
+        }
+    }
+    trim();
+}
+
+void RgaStagingPool::releaseJob(im_job_handle_t job) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (Entry &entry : mEntries) {
+        if (entry.busy && entry.job == job) {
+            entry.busy = false;
+            entry.job = 0;
+        }
+    }
+    trim();
+}
+
+bool RgaStagingPool::holds(im_job_handle_t job) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const Entry &entry : mEntries) {
+        if (entry.busy && entry.job == job) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RgaStagingStats RgaStagingPool::stats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+// Called with mMutex held.
+void RgaStagingPool::trim() {
+    int freeCount = 0;
+    for (const Entry &entry : mEntries) {
+        freeCount += entry.busy ? 0 : 1;
+    }
+    for (size_t i = 0; i < mEntries.size() && freeCount > mMaxFree;) {
+        if (!mEntries[i].busy) {
+            mStats.bytes -= mEntries[i].size;
+            free(mEntries[i].data);
+            mEntries.erase(mEntries.begin() + i);
+            freeCount--;
+        } else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef _rga_staging_h_
+#define _rga_staging_h_
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+#include "im2d_type.h"
+
+/*
+ * Pooled host buffers for pixels the app hands over in Java arrays, such as
+ * NV21 camera preview frames. Each frame is copied once into a buffer that
+ * is reused, instead of into a newly allocated direct ByteBuffer.
+ *
+ * Buffers are page aligned and passed to librga by virtual address. librga
+ * rejects calls that mix imported (handle) buffers with fd or address
+ * buffers, and the other side of these calls comes from Rga.kt as one of
+ * those, so the buffers are not imported. A buffer acquired for a job stays
+ * out of the pool until releaseJob() is called for that job.
+ */
+
+typedef struct {
+    int64_t acquired;
+    int64_t allocated;      /* acquires that needed a new buffer */
+    int64_t bytes;          /* held by the pool, free or in use */
+} RgaStagingStats;
+
+class RgaStagingPool {
+public:
+    /* Keeps up to maxFree released buffers. */
+    explicit RgaStagingPool(int maxFree);
+    ~RgaStagingPool();
+
+    /*
+     * A buffer for a width x height image in format with strides equal to
+     * the size, its memory at buffer->vir_addr. With job != 0 the buffer is
+     * held until releaseJob(job); otherwise hand it back with release().
+     */
+    IM_STATUS acquire(int width, int height, int format, im_job_handle_t job, rga_buffer_t *buffer);
+    void release(const rga_buffer_t &buffer);
+    void releaseJob(im_job_handle_t job);
+    bool holds(im_job_handle_t job) const;
+
+    RgaStagingStats stats() const;
+
+private:
+    struct Entry {
+        uint8_t *data;
+        size_t size;
+        im_job_handle_t job;
+        bool busy;
+    };
+
+    void trim();
+
+    int mMaxFree;
+    mutable std::mutex mMutex;
+    std::vector<Entry> mEntries;
+    RgaStagingStats mStats = {};
+};
+
+#endif
@@ -0,0 +1,282 @@
+#include "rga_stats.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/sync_file.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "rga_format.h"
+
+std::atomic<bool> gRgaStatsEnabled{false};
+
+#define SUB_BITS 4
+#define SUB_COUNT (1 << SUB_BITS)
+#define MAX_SHIFT 37
+#define BUCKET_COUNT (SUB_COUNT + (MAX_SHIFT + 1) * SUB_COUNT)
+
+static const char *const kOpNames[RGA_STATS_OP_COUNT] = {
+    "copy", "resize", "crop", "rotate", "flip", "translate", "blend", "composite",
+    "cvtcolor", "fill", "rectangle", "mosaic", "rop", "palette", "osd", "gaussian",
+    "tensor", "border", "letterbox", "batch", "job",
+};
+
+class Histogram {
+public:
+    void record(uint64_t ns) {
+        mBuckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        mSum.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t max = mMax.load(std::memory_order_relaxed);
+        while (ns > max && !mMax.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    void reset() {
+        for (auto &b : mBuckets) {
+            b.store(0, std::memory_order_relaxed);
+        }
+        mSum.store(0, std::memory_order_relaxed);
+        mMax.store(0, std::memory_order_relaxed);
+    }
+
+    // count, sum, p50, p90, p99, p99.9, max
+    void snapshot(int64_t *out) const {
+        uint64_t counts[BUCKET_COUNT];
+        uint64_t total = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            counts[i] = mBuckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        static const double kQuantiles[4] = {0.5, 0.9, 0.99, 0.999};
+        out[0] = (int64_t)total;
+        out[1] = (int64_t)mSum.load(std::memory_order_relaxed);
+        uint64_t max = mMax.load(std::memory_order_relaxed);
+        for (int q = 0; q < 4; q++) {
+            out[2 + q] = total == 0 ? 0 : (int64_t)valueAt(counts, total, kQuantiles[q], max);
+        }
+        out[6] = (int64_t)max;
+    }
+
+private:
+    static int bucketOf(uint64_t v) {
+        if (v < SUB_COUNT) {
+            return (int)v;
+        }
+        int shift = (63 - __builtin_clzll(v)) - SUB_BITS;
+        if (shift > MAX_SHIFT) {
+            return BUCKET_COUNT - 1;
+        }
+        return SUB_COUNT + shift * SUB_COUNT + (int)((v >> shift) - SUB_COUNT);
+    }
+
+    // Midpoint of a bucket's value range.
+    static uint64_t bucketValue(int index) {
+        if (index < SUB_COUNT) {
+            return index;
+        }
+        int shift = (index - SUB_COUNT) / SUB_COUNT;
+        uint64_t low = (uint64_t)(SUB_COUNT + (index - SUB_COUNT) % SUB_COUNT) << shift;
+        return low + ((1ull << shift) >> 1);
+    }
+
+    static uint64_t valueAt(const uint64_t *counts, uint64_t total, double quantile, uint64_t max) {
+        uint64_t rank = (uint64_t)(quantile * total + 0.5);
+        if (rank == 0) {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                uint64_t v = bucketValue(i);
+                return v > max ? max : v;
+            }
+        }
+        return max;
+    }
+
+    std::atomic<uint64_t> mBuckets[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> mSum{0};
+    std::atomic<uint64_t> mMax{0};
+};
+
+struct OpStats {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> bytesIn{0};
+    std::atomic<uint64_t> bytesOut{0};
+    std::atomic<uint64_t> pixels{0};
+    std::atomic<uint64_t> status[RGA_STATS_STATUS_COUNT] = {};
+    Histogram latency;
+    Histogram completion;
+};
+
+static OpStats gStats[RGA_STATS_OP_COUNT];
+
+void rgaStatsSetEnabled(bool enabled) {
+    gRgaStatsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void rgaStatsReset() {
+    for (auto &s : gStats) {
+        s.count.store(0, std::memory_order_relaxed);
+        s.failures.store(0, std::memory_order_relaxed);
+        s.bytesIn.store(0, std::memory_order_relaxed);
+        s.bytesOut.store(0, std::memory_order_relaxed);
+        s.pixels.store(0, std::memory_order_relaxed);
+        for (auto &c : s.status) {
+            c.store(0, std::memory_order_relaxed);
+        }
+        s.latency.reset();
+        s.completion.reset();
+    }
+}
+
+const char *rgaStatsOpName(int op) {
+    return op >= 0 && op < RGA_STATS_OP_COUNT ? kOpNames[op] : "unknown";
+}
+
+void rgaStatsSnapshot(int64_t *out) {
+    for (int op = 0; op < RGA_STATS_OP_COUNT; op++) {
+        const OpStats &s = gStats[op];
+        int64_t *o = out + op * RGA_STATS_FIELDS;
+        o[RGA_STATS_COUNT] = (int64_t)s.count.load(std::memory_order_relaxed);
+        o[RGA_STATS_FAILURES] = (int64_t)s.failures.load(std::memory_order_relaxed);
+        o[RGA_STATS_BYTES_IN] = (int64_t)s.bytesIn.load(std::memory_order_relaxed);
+        o[RGA_STATS_BYTES_OUT] = (int64_t)s.bytesOut.load(std::memory_order_relaxed);
+        o[RGA_STATS_PIXELS] = (int64_t)s.pixels.load(std::memory_order_relaxed);
+        s.latency.snapshot(o + RGA_STATS_LATENCY);
+        s.completion.snapshot(o + RGA_STATS_COMPLETION);
+        for (int i = 0; i < RGA_STATS_STATUS_COUNT; i++) {
+            o[RGA_STATS_STATUS + i] = (int64_t)s.status[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t rgaStatsNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void rgaStatsRecord(RgaStatsOp op, IM_STATUS status, uint64_t latencyNs,
+                    uint64_t bytesIn, uint64_t bytesOut, uint64_t pixels) {
+    OpStats &s = gStats[op];
+    s.count.fetch_add(1, std::memory_order_relaxed);
+    s.latency.record(latencyNs);
+    if (status == IM_STATUS_SUCCESS || status == IM_STATUS_NOERROR) {
+        s.bytesIn.fetch_add(bytesIn, std::memory_order_relaxed);
+        s.bytesOut.fetch_add(bytesOut, std::memory_order_relaxed);
+        s.pixels.fetch_add(pixels, std::memory_order_relaxed);
+        return;
+    }
+    s.failures.fetch_add(1, std::memory_order_relaxed);
+    int index = (int)status - RGA_STATS_STATUS_MIN;
+    if (index >= 0 && index < RGA_STATS_STATUS_COUNT) {
+        s.status[index].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool rgaStatsRecordFence(RgaStatsOp op, int fenceFd, uint64_t submitNs) {
+    if (fenceFd < 0 || !rgaStatsEnabled()) {
+        return false;
+    }
+    struct sync_fence_info fences[4];
+    struct sync_file_info info;
+    memset(&info, 0, sizeof(info));
+    memset(fences, 0, sizeof(fences));
+    info.num_fences = 4;
+    info.sync_fence_info = (uint64_t)(uintptr_t)fences;
+    if (ioctl(fenceFd, SYNC_IOC_FILE_INFO, &info) < 0 || info.status != 1) {
+        return false;
+    }
+    // The file signals with its last fence; timestamps are CLOCK_MONOTONIC.
+    uint64_t signaled = 0;
+    uint32_t n = info.num_fences < 4 ? info.num_fences : 4;
+    for (uint32_t i = 0; i < n; i++) {
+        if (fences[i].timestamp_ns > signaled) {
+            signaled = fences[i].timestamp_ns;
+        }
+    }
+    if (signaled < submitNs) {
+        return false;
+    }
+    gStats[op].completion.record(signaled - submitNs);
+    return true;
+}
+
+#define FENCE_WATCH_TIMEOUT_MS 1000
+
+struct WatchedFence {
+    RgaStatsOp op;
+    int fd;
+    uint64_t submitNs;
+};
+
+// Never destroyed: the watcher thread may still be waiting on it at exit.
+struct FenceWatcher {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<WatchedFence> fences;
+    bool running = false;
+};
+
+static FenceWatcher &fenceWatcher() {
+    static FenceWatcher *watcher = new FenceWatcher();
+    return *watcher;
+}
+
+// Waits for watched fences one at a time; a fence that does not signal
+// within FENCE_WATCH_TIMEOUT_MS is dropped without a sample.
+static void watchFences() {
+    FenceWatcher &w = fenceWatcher();
+    for (;;) {
+        WatchedFence fence;
+        {
+            std::unique_lock<std::mutex> lock(w.mutex);
+            w.cond.wait(lock, [&w] { return !w.fences.empty(); });
+            fence = w.fences.front();
+            w.fences.pop_front();
+        }
+        struct pollfd pfd = {fence.fd, POLLIN, 0};
+        int ret;
+        do {
+            ret = poll(&pfd, 1, FENCE_WATCH_TIMEOUT_MS);
+        } while (ret < 0 && errno == EINTR);
+        if (ret > 0) {
+            rgaStatsRecordFence(fence.op, fence.fd, fence.submitNs);
+        }
+        close(fence.fd);
+    }
+}
+
+void rgaStatsWatchFence(RgaStatsOp op, int fenceFd, uint64_t submitNs) {
+    if (fenceFd < 0) {
+        return;
+    }
+    FenceWatcher &w = fenceWatcher();
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.fences.push_back({op, fenceFd, submitNs});
+        if (!w.running) {
+            w.running = true;
+            std::thread(watchFences).detach();
+        }
+    }
+    w.cond.notify_one();
+}
+
+void RgaStatsScope::setBuffers(const rga_buffer_t &src, const rga_buffer_t &dst) {
+    mBytesIn = rgaFormatImageSize(src.format, src.wstride, src.hstride);
+    setOutput(dst);
+}
+
+void RgaStatsScope::setOutput(const rga_buffer_t &dst) {
+    mBytesOut = rgaFormatImageSize(dst.format, dst.wstride, dst.hstride);
+    mPixels = (uint64_t)dst.width * dst.height;
+}
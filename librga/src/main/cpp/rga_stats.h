@@ -0,0 +1,129 @@
+#ifndef _rga_stats_h_
+#define _rga_stats_h_
+
+#include <stdint.h>
+#include <atomic>
+#include "im2d_type.h"
+
+/*
+ * Per-operation instrumentation: latency histograms, bytes, pixels and
+ * failures by IM_STATUS. All counters are relaxed atomics, so recording is
+ * lock-free; when disabled a scope costs a single relaxed load.
+ *
+ * Histograms are log-linear (HDR style) over nanoseconds: 16 sub-buckets per
+ * power of two, i.e. about 6% relative precision up to ~18 minutes.
+ */
+
+typedef enum {
+    RGA_STATS_COPY = 0,
+    RGA_STATS_RESIZE,
+    RGA_STATS_CROP,
+    RGA_STATS_ROTATE,
+    RGA_STATS_FLIP,
+    RGA_STATS_TRANSLATE,
+    RGA_STATS_BLEND,
+    RGA_STATS_COMPOSITE,
+    RGA_STATS_CVTCOLOR,
+    RGA_STATS_FILL,
+    RGA_STATS_RECTANGLE,
+    RGA_STATS_MOSAIC,
+    RGA_STATS_ROP,
+    RGA_STATS_PALETTE,
+    RGA_STATS_OSD,
+    RGA_STATS_GAUSSIAN,
+    RGA_STATS_TENSOR,
+    RGA_STATS_BORDER,
+    RGA_STATS_LETTERBOX,
+    RGA_STATS_BATCH,
+    RGA_STATS_JOB,
+    RGA_STATS_OP_COUNT
+} RgaStatsOp;
+
+/*
+ * Snapshot layout: RGA_STATS_FIELDS int64 values per op, in RgaStatsOp order.
+ * A latency block is count, sum, p50, p90, p99, p99.9, max (nanoseconds).
+ */
+#define RGA_STATS_COUNT             0
+#define RGA_STATS_FAILURES          1
+#define RGA_STATS_BYTES_IN          2
+#define RGA_STATS_BYTES_OUT         3
+#define RGA_STATS_PIXELS            4
+#define RGA_STATS_LATENCY           5   /* call entry -> result (sync) or submit (async) */
+#define RGA_STATS_COMPLETION        12  /* submit -> hardware done, from release fences */
+#define RGA_STATS_LATENCY_FIELDS    7
+#define RGA_STATS_STATUS            19  /* failures per IM_STATUS, -6 .. 2 */
+#define RGA_STATS_STATUS_MIN        (-6)
+#define RGA_STATS_STATUS_COUNT      9
+#define RGA_STATS_FIELDS            (RGA_STATS_STATUS + RGA_STATS_STATUS_COUNT)
+
+extern std::atomic<bool> gRgaStatsEnabled;
+
+static inline bool rgaStatsEnabled() {
+    return gRgaStatsEnabled.load(std::memory_order_relaxed);
+}
+
+void rgaStatsSetEnabled(bool enabled);
+void rgaStatsReset();
+const char *rgaStatsOpName(int op);
+/* Fill out[RGA_STATS_OP_COUNT * RGA_STATS_FIELDS]. */
+void rgaStatsSnapshot(int64_t *out);
+
+uint64_t rgaStatsNowNs();
+void rgaStatsRecord(RgaStatsOp op, IM_STATUS status, uint64_t latencyNs,
+                    uint64_t bytesIn, uint64_t bytesOut, uint64_t pixels);
+/*
+ * Record hardware completion of an async submit from its release fence: the
+ * fence signal timestamp minus submitNs. Returns false if the fence has not
+ * signaled (nothing recorded). Does not close the fence.
+ */
+bool rgaStatsRecordFence(RgaStatsOp op, int fenceFd, uint64_t submitNs);
+/*
+ * rgaStatsRecordFence for a fence nobody waits on (async JNI submits): takes
+ * ownership of fenceFd, waits for it on a background thread and closes it.
+ */
+void rgaStatsWatchFence(RgaStatsOp op, int fenceFd, uint64_t submitNs);
+
+/* Times one call; finish() records it (when enabled) and passes the status through. */
+class RgaStatsScope {
+public:
+    explicit RgaStatsScope(RgaStatsOp op)
+        : mOp(op), mStart(rgaStatsEnabled() ? rgaStatsNowNs() : 0) {}
+
+    RgaStatsScope(RgaStatsOp op, const rga_buffer_t &src, const rga_buffer_t &dst)
+        : RgaStatsScope(op) {
+        if (mStart != 0) {
+            setBuffers(src, dst);
+        }
+    }
+
+    /* For operations that only write dst (fill, draw, mosaic). */
+    RgaStatsScope(RgaStatsOp op, const rga_buffer_t &dst)
+        : RgaStatsScope(op) {
+        if (mStart != 0) {
+            setOutput(dst);
+        }
+    }
+
+    void setBuffers(const rga_buffer_t &src, const rga_buffer_t &dst);
+    void setOutput(const rga_buffer_t &dst);
+
+    IM_STATUS finish(IM_STATUS status) {
+        if (mStart != 0) {
+            rgaStatsRecord(mOp, status, rgaStatsNowNs() - mStart, mBytesIn, mBytesOut, mPixels);
+        }
+        return status;
+    }
+
+    int finish(int status) {
+        return finish((IM_STATUS)status);
+    }
+
+private:
+    RgaStatsOp mOp;
+    uint64_t mStart;
+    uint64_t mBytesIn = 0;
+    uint64_t mBytesOut = 0;
+    uint64_t mPixels = 0;
+};
+
+#endif
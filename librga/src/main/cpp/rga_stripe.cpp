@@ -0,0 +1,193 @@
+#include "rga_stripe.h"
+
+#include <string.h>
+#include <algorithm>
+#include "rga_backend.h"
+#include "rga_cpu.h"
+#include "rga_format.h"
+
+static bool isEmptyRect(const im_rect &r) {
+    return r.width <= 0 || r.height <= 0;
+}
+
+static int gcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+RgaStripeStream::RgaStripeStream(int srcWidth, int srcHeight, int srcFormat, int minOutputRows, int core)
+    : mSrcWidth(srcWidth), mSrcHeight(srcHeight), mSrcFormat(rgaFormatNormalize(srcFormat)),
+      mMinOutputRows(minOutputRows < 1 ? 1 : minOutputRows), mCore(core) {
+    memset(&mDst, 0, sizeof(mDst));
+    memset(&mDrect, 0, sizeof(mDrect));
+    memset(&mCarryBuffer, 0, sizeof(mCarryBuffer));
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+IM_STATUS RgaStripeStream::begin(const rga_buffer_t &dst, const im_rect &drect, int usage,
+                                 RgaSliceProgress *progress) {
+    abort();
+    const RgaFormatDesc *srcDesc = rgaFormatFind(mSrcFormat);
+    const RgaFormatDesc *dstDesc = rgaFormatFind(dst.format);
+    if (srcDesc == nullptr || dstDesc == nullptr || (usage & IM_HAL_TRANSFORM_MASK & ~IM_HAL_TRANSFORM_FLIP_H)) {
+        return IM_STATUS_NOT_SUPPORTED;
+    }
+    im_rect d = isEmptyRect(drect) ? im_rect{0, 0, dst.width, dst.height} : drect;
+    if (mSrcWidth <= 0 || mSrcHeight <= 0 || isEmptyRect(d) || d.y % dstDesc->rectAlign != 0) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+
+    // Smallest step that maps whole, aligned dst rows onto whole, aligned src rows.
+    int g = gcd(mSrcHeight, d.height);
+    int baseIn = mSrcHeight / g, baseOut = d.height / g;
+    int m = 1;
+    while (m <= 64 && ((baseIn * m) % srcDesc->rectAlign != 0 || (baseOut * m) % dstDesc->rectAlign != 0)) {
+        m++;
+    }
+    int64_t inputStep = (int64_t)baseIn * m, outputStep = (int64_t)baseOut * m;
+    if (outputStep < mMinOutputRows) {
+        int64_t k = (mMinOutputRows + outputStep - 1) / outputStep;
+        inputStep *= k;
+        outputStep *= k;
+    }
+    if (m > 64 || outputStep >= d.height) {
+        inputStep = mSrcHeight;
+        outputStep = d.height;
+    }
+    mInputStep = (int)inputStep;
+    mOutputStep = (int)outputStep;
+
+    int wstride = rgaFormatAlignStride(mSrcFormat, mSrcWidth);
+    mCarry.resize(rgaFormatImageSize(mSrcFormat, wstride, mInputStep));
+    mCarryBuffer.vir_addr = mCarry.data();
+    mCarryBuffer.width = mSrcWidth;
+    mCarryBuffer.height = mInputStep;
+    mCarryBuffer.wstride = wstride;
+    mCarryBuffer.hstride = mInputStep;
+    mCarryBuffer.format = mSrcFormat;
+
+    mDst = dst;
+    mDrect = d;
+    mUsage = usage;
+    mProgress = progress;
+    mReceived = mConsumed = mWritten = mCarryRows = 0;
+    mActive = true;
+    if (mProgress != nullptr) {
+        mProgress->begin(d.height);
+    }
+    return IM_STATUS_SUCCESS;
+}
+
+// Append count rows of stripe, from fromRow on, to the carry buffer.
+IM_STATUS RgaStripeStream::carry(const rga_buffer_t &stripe, int fromRow, int count) {
+    if (count <= 0) {
+        return IM_STATUS_SUCCESS;
+    }
+    RgaCpuImage src, dst;
+    IM_STATUS ret = rgaCpuMapImage(stripe, &src);
+    if (ret != IM_STATUS_SUCCESS) {
+        return ret;
+    }
+    ret = rgaCpuMapImage(mCarryBuffer, &dst);
+    if (ret != IM_STATUS_SUCCESS) {
+        rgaCpuUnmapImage(&src);
+        return ret;
+    }
+    const RgaFormatDesc *desc = rgaFormatFind(mSrcFormat);
+    for (int p = 0; p < desc->planeCount; p++) {
+        int shift = p == 0 ? 0 : desc->yshift;
+        int rowBytes = rgaFormatPlaneRowBytes(*desc, p, mSrcWidth);
+        for (int y = fromRow >> shift; y < (fromRow + count) >> shift; y++) {
+            int to = (mCarryRows >> shift) + y - (fromRow >> shift);
+            memcpy(dst.planes[p].data + (size_t)to * dst.planes[p].stride,
+                   src.planes[p].data + (size_t)y * src.planes[p].stride, rowBytes);
+        }
+    }
+    rgaCpuUnmapImage(&dst);
+    rgaCpuUnmapImage(&src);
+    mCarryRows += count;
+    mStats.copiedRows += count;
+    return IM_STATUS_SUCCESS;
+}
+
+IM_STATUS RgaStripeStream::push(const rga_buffer_t &stripe) {
+    if (!mActive) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    int rows = stripe.height;
+    int align = rgaFormatFind(mSrcFormat)->rectAlign;
+    if (rgaFormatNormalize(stripe.format) != mSrcFormat || stripe.width != mSrcWidth || rows <= 0 ||
+        mReceived + rows > mSrcHeight || (rows % align != 0 && mReceived + rows != mSrcHeight)) {
+        return IM_STATUS_INVALID_PARAM;
+    }
+    mStats.stripes++;
+    int start = mReceived;
+    mReceived += rows;
+
+    im_opt_t opt = {};
+    opt.version = RGA_CURRENT_API_VERSION;
+    opt.core = mCore;
+    IM_STATUS ret = IM_STATUS_SUCCESS;
+    while (mWritten < mDrect.height) {
+        int oy1 = std::min(mDrect.height, mWritten + mOutputStep);
+        int sy1 = oy1 == mDrect.height ? mSrcHeight : (int)((int64_t)oy1 * mSrcHeight / mDrect.height);
+        if (sy1 > mReceived) {
+            break;
+        }
+        const rga_buffer_t *src = &stripe;
+        im_rect srect = {0, mConsumed - start, mSrcWidth, sy1 - mConsumed};
+        if (mCarryRows > 0) {
+            // The footprint starts in rows carried over from earlier stripes.
+            ret = carry(stripe, 0, sy1 - start);
+            src = &mCarryBuffer;
+            srect.y = 0;
+            mStats.stitched++;
+        } else {
+            mStats.inPlace++;
+        }
+        im_rect drect = {mDrect.x, mDrect.y + mWritten, mDrect.width, oy1 - mWritten};
+        if (ret == IM_STATUS_SUCCESS) {
+            ret = rgaProcess("stripe", *src, mDst, {}, srect, drect, {}, -1, NULL, &opt, mUsage);
+        }
+        if (ret != IM_STATUS_SUCCESS) {
+            end(ret);
+            return ret;
+        }
+        mStats.outputs++;
+        mCarryRows = 0;
+        mConsumed = sy1;
+        mWritten = oy1;
+        if (mProgress != nullptr) {
+            mProgress->publish(mWritten);
+        }
+    }
+    if (mWritten == mDrect.height) {
+        end(IM_STATUS_SUCCESS);
+        return IM_STATUS_SUCCESS;
+    }
+
+    // Rows the next footprint needs from this stripe; older ones are carried already.
+    int from = std::max(mConsumed, start);
+    ret = carry(stripe, from - start, mReceived - from);
+    if (ret != IM_STATUS_SUCCESS) {
+        end(ret);
+    }
+    return ret;
+}
+
+void RgaStripeStream::abort() {
+    if (mActive) {
+        end(IM_STATUS_FAILED);
+    }
+}
+
+void RgaStripeStream::end(IM_STATUS status) {
+    mActive = false;
+    if (mProgress != nullptr) {
+        mProgress->finish(status);
+    }
+}
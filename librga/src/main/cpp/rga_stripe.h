@@ -0,0 +1,102 @@
+#ifndef _rga_stripe_h_
+#define _rga_stripe_h_
+
+#include <stdint.h>
+#include <vector>
+#include "im2d_type.h"
+#include "rga_slice.h"
+
+/*
+ * Streaming resize + format conversion for sources that arrive in horizontal
+ * stripes (line-based sensors, scanners), so the output does not wait a
+ * whole frame.
+ *
+ * Output stripes are placed where the scale maps a destination row exactly
+ * onto a source row and both sit on their format's rect alignment
+ * (RgaFormatDesc.rectAlign): output stripe k covers dst rows
+ * [k * outputStep, (k + 1) * outputStep) and its source footprint is rows
+ * [k * inputStep, (k + 1) * inputStep). Each output stripe is one RGA call
+ * (scale and convert at once) submitted as soon as its footprint has been
+ * pushed, and is published to an optional RgaSliceProgress.
+ *
+ * A footprint that lies in one pushed stripe is read from it in place. The
+ * rows a stripe leaves unconsumed are carried over into a buffer of
+ * inputStep rows, and the next footprint is stitched there from the carry
+ * and the new stripe. Stripes may have any height that keeps the source
+ * alignment, and the caller may reuse a stripe once push() returns.
+ *
+ * The RGA filters each output stripe on its own, so same-size conversions
+ * and integer downscales match a whole-frame call, while upscales can differ
+ * next to stripe edges. Scales without a small common step, such as 1080 to
+ * 719 rows, degrade to a single stripe.
+ */
+
+typedef struct {
+    int64_t stripes;        /* pushed */
+    int64_t outputs;        /* output stripes submitted */
+    int64_t inPlace;        /* outputs read straight from a pushed stripe */
+    int64_t stitched;       /* outputs read from the carry buffer */
+    int64_t copiedRows;     /* source rows copied into the carry buffer */
+} RgaStripeStats;
+
+class RgaStripeStream {
+public:
+    /* Frames of srcWidth x srcHeight in srcFormat; output stripes of at least minOutputRows. */
+    RgaStripeStream(int srcWidth, int srcHeight, int srcFormat, int minOutputRows, int core);
+
+    /*
+     * Start a frame written into drect of dst (empty = whole image). usage
+     * takes IM_HAL_TRANSFORM_FLIP_H; transforms that reorder rows are not
+     * supported. progress, if set, receives every finished output stripe.
+     */
+    IM_STATUS begin(const rga_buffer_t &dst, const im_rect &drect, int usage, RgaSliceProgress *progress);
+
+    /* The next stripe.height rows of the frame. */
+    IM_STATUS push(const rga_buffer_t &stripe);
+
+    /* Cancel the current frame. */
+    void abort();
+
+    int inputStep() const {
+        return mInputStep;
+    }
+    int outputStep() const {
+        return mOutputStep;
+    }
+    /* Source rows pushed and dst rows written in the current frame. */
+    int receivedRows() const {
+        return mReceived;
+    }
+    int writtenRows() const {
+        return mWritten;
+    }
+    const RgaStripeStats &stats() const {
+        return mStats;
+    }
+
+private:
+    IM_STATUS carry(const rga_buffer_t &stripe, int fromRow, int count);
+    void end(IM_STATUS status);
+
+    int mSrcWidth;
+    int mSrcHeight;
+    int mSrcFormat;
+    int mMinOutputRows;
+    int mCore;
+    bool mActive = false;
+    rga_buffer_t mDst;
+    im_rect mDrect;
+    int mUsage = 0;
+    RgaSliceProgress *mProgress = nullptr;
+    int mInputStep = 0;
+    int mOutputStep = 0;
+    int mReceived = 0;      /* source rows pushed */
+    int mConsumed = 0;      /* source rows behind the last output stripe */
+    int mWritten = 0;       /* dst rows written */
+    int mCarryRows = 0;     /* rows [mConsumed, mConsumed + mCarryRows) held in mCarry */
+    std::vector<uint8_t> mCarry;
+    rga_buffer_t mCarryBuffer;
+    RgaStripeStats mStats;
+};
+
+#endif
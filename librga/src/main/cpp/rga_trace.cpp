@@ -0,0 +1,252 @@
+#include "rga_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__ANDROID__)
+#include <android/trace.h>
+#endif
+
+std::atomic<bool> gRgaTraceEnabled{false};
+
+typedef struct {
+    uint64_t ts;            /* CLOCK_MONOTONIC ns */
+    const char *name;       /* static string */
+    uint32_t job;
+    int32_t usage;
+    int32_t core;
+    int32_t status;
+    int32_t srcWidth;
+    int32_t srcHeight;
+    int32_t srcFormat;
+    int32_t dstWidth;
+    int32_t dstHeight;
+    int32_t dstFormat;
+    char phase;             /* 'B' or 'E' */
+} TraceEvent;
+
+// A slot is a seqlock: the owning thread makes seq odd, writes the event and
+// publishes seq = 2 * (index + 1). A reader keeps an event only if seq held that
+// value before and after copying it. Indices never repeat, so a slot rewritten
+// in between is always detected.
+#define TRACE_EVENT_WORDS ((sizeof(TraceEvent) + sizeof(uint64_t) - 1) / sizeof(uint64_t))
+
+struct TraceSlot {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> words[TRACE_EVENT_WORDS];
+};
+
+struct TraceSlots {
+    explicit TraceSlots(int capacity) : capacity(capacity), slots(new TraceSlot[capacity]()) {}
+
+    const uint64_t capacity;
+    std::unique_ptr<TraceSlot[]> slots;
+};
+
+struct ThreadRing {
+    ThreadRing(int capacity, int tid) : slots(new TraceSlots(capacity)), tid(tid) {}
+
+    // Storage replaced by a capacity change is never freed: a dump may still be
+    // reading it.
+    std::atomic<TraceSlots *> slots;
+    std::atomic<uint64_t> head{0};      /* index of the next event */
+    std::atomic<uint64_t> start{0};     /* first event of the current generation */
+    std::atomic<uint32_t> generation{0};
+    const int tid;
+};
+
+// Rings are never freed so a dump still sees threads that have exited. The
+// mutex only guards the list; recording never takes it.
+static std::mutex gRingsMutex;
+static std::vector<std::unique_ptr<ThreadRing>> gRings;
+static std::atomic<int> gCapacity{4096};
+static std::atomic<uint32_t> gGeneration{0};
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static ThreadRing *threadRing() {
+    thread_local ThreadRing *ring = nullptr;
+    if (ring == nullptr) {
+        std::lock_guard<std::mutex> lock(gRingsMutex);
+        gRings.emplace_back(new ThreadRing(gCapacity.load(std::memory_order_relaxed), (int)syscall(SYS_gettid)));
+        ring = gRings.back().get();
+    }
+    return ring;
+}
+
+static void record(char phase, const char *name, im_job_handle_t job, const rga_buffer_t *src,
+                   const rga_buffer_t *dst, int usage, int core, int status) {
+    ThreadRing *ring = threadRing();
+    TraceSlots *slots = ring->slots.load(std::memory_order_relaxed);
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    // A new session (rgaTraceStart) is picked up lazily by the owning thread. The
+    // dump skips the ring until it has been reset for the new generation.
+    uint32_t generation = gGeneration.load(std::memory_order_acquire);
+    if (ring->generation.load(std::memory_order_relaxed) != generation) {
+        int capacity = gCapacity.load(std::memory_order_relaxed);
+        if (slots->capacity != (uint64_t)capacity) {
+            slots = new TraceSlots(capacity);
+            ring->slots.store(slots, std::memory_order_relaxed);
+        }
+        ring->start.store(head, std::memory_order_relaxed);
+        ring->generation.store(generation, std::memory_order_release);
+    }
+
+    TraceEvent e;
+    memset(&e, 0, sizeof(e));
+    e.ts = nowNs();
+    e.name = name;
+    e.job = job;
+    e.usage = usage;
+    e.core = core;
+    e.status = status;
+    e.srcWidth = src != nullptr ? src->width : 0;
+    e.srcHeight = src != nullptr ? src->height : 0;
+    e.srcFormat = src != nullptr ? src->format : 0;
+    e.dstWidth = dst != nullptr ? dst->width : 0;
+    e.dstHeight = dst != nullptr ? dst->height : 0;
+    e.dstFormat = dst != nullptr ? dst->format : 0;
+    e.phase = phase;
+    uint64_t words[TRACE_EVENT_WORDS] = {};
+    memcpy(words, &e, sizeof(e));
+
+    TraceSlot &slot = slots->slots[head % slots->capacity];
+    slot.seq.store(2 * head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < TRACE_EVENT_WORDS; i++) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.seq.store(2 * head + 2, std::memory_order_release);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+// Copy event index out of its slot; false if it is being written or was overwritten.
+static bool readEvent(const TraceSlots &slots, uint64_t index, TraceEvent *e) {
+    const TraceSlot &slot = slots.slots[index % slots.capacity];
+    uint64_t seq = 2 * index + 2;
+    if (slot.seq.load(std::memory_order_acquire) != seq) {
+        return false;
+    }
+    uint64_t words[TRACE_EVENT_WORDS];
+    for (size_t i = 0; i < TRACE_EVENT_WORDS; i++) {
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != seq) {
+        return false;
+    }
+    memcpy(e, words, sizeof(*e));
+    return true;
+}
+
+void rgaTraceStart(int capacityPerThread) {
+    if (capacityPerThread > 0) {
+        gCapacity.store(capacityPerThread, std::memory_order_relaxed);
+    }
+    gGeneration.fetch_add(1, std::memory_order_acq_rel);
+    gRgaTraceEnabled.store(true, std::memory_order_release);
+}
+
+void rgaTraceStop() {
+    gRgaTraceEnabled.store(false, std::memory_order_release);
+}
+
+std::string rgaTraceDumpJson() {
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+    char line[512];
+    int pid = (int)getpid();
+    uint32_t generation = gGeneration.load(std::memory_order_acquire);
+
+    std::vector<ThreadRing *> rings;
+    {
+        std::lock_guard<std::mutex> lock(gRingsMutex);
+        for (const auto &ring : gRings) {
+            rings.push_back(ring.get());
+        }
+    }
+    std::vector<TraceEvent> events;
+    for (const ThreadRing *ring : rings) {
+        if (ring->generation.load(std::memory_order_acquire) != generation) {
+            continue;
+        }
+        // Oldest first; events torn by a concurrent write are skipped.
+        const TraceSlots *slots = ring->slots.load(std::memory_order_acquire);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = ring->start.load(std::memory_order_relaxed);
+        if (head > slots->capacity && head - slots->capacity > begin) {
+            begin = head - slots->capacity;
+        }
+        events.clear();
+        for (uint64_t i = begin; i < head; i++) {
+            TraceEvent e;
+            if (readEvent(*slots, i, &e)) {
+                events.push_back(e);
+            }
+        }
+        for (const TraceEvent &e : events) {
+            int n;
+            if (e.phase == 'B') {
+                n = snprintf(line, sizeof(line),
+                             "%s{\"name\":\"%s\",\"cat\":\"rga\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                             "\"args\":{\"job\":%u,\"usage\":\"0x%x\",\"core\":\"0x%x\","
+                             "\"src\":\"%dx%d fmt 0x%x\",\"dst\":\"%dx%d fmt 0x%x\"}}",
+                             first ? "" : ",", e.name, e.ts / 1000.0, pid, ring->tid,
+                             e.job, (unsigned)e.usage, (unsigned)e.core,
+                             e.srcWidth, e.srcHeight, (unsigned)e.srcFormat,
+                             e.dstWidth, e.dstHeight, (unsigned)e.dstFormat);
+            } else {
+                n = snprintf(line, sizeof(line),
+                             "%s{\"name\":\"%s\",\"cat\":\"rga\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                             "\"args\":{\"status\":%d}}",
+                             first ? "" : ",", e.name, e.ts / 1000.0, pid, ring->tid, e.status);
+            }
+            if (n > 0) {
+                json.append(line, n < (int)sizeof(line) ? n : (int)sizeof(line) - 1);
+                first = false;
+            }
+        }
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}";
+    return json;
+}
+
+RgaTraceScope::RgaTraceScope(const char *name, im_job_handle_t job, const rga_buffer_t *src,
+                             const rga_buffer_t *dst, int usage, int core)
+    : mName(name), mJob(job), mRecording(rgaTraceEnabled()), mSection(false) {
+#if defined(__ANDROID__)
+    if (ATrace_isEnabled()) {
+        char section[128];
+        snprintf(section, sizeof(section), "RGA %s %dx%d->%dx%d usage=0x%x job=%u", name,
+                 src != nullptr ? src->width : 0, src != nullptr ? src->height : 0,
+                 dst != nullptr ? dst->width : 0, dst != nullptr ? dst->height : 0,
+                 (unsigned)usage, job);
+        ATrace_beginSection(section);
+        mSection = true;
+    }
+#endif
+    if (mRecording) {
+        record('B', name, job, src, dst, usage, core, 0);
+    }
+}
+
+RgaTraceScope::~RgaTraceScope() {
+    if (mRecording) {
+        record('E', mName, mJob, nullptr, nullptr, 0, 0, mStatus);
+    }
+#if defined(__ANDROID__)
+    if (mSection) {
+        ATrace_endSection();
+    }
+#endif
+}
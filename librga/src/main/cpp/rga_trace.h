@@ -0,0 +1,52 @@
+#ifndef _rga_trace_h_
+#define _rga_trace_h_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include "im2d_type.h"
+
+/*
+ * Opt-in tracing of RGA submissions. Each thread records begin/end events into
+ * its own fixed-size ring buffer without locks (single writer, one sequence
+ * number per slot); the newest events win when a ring wraps. rgaTraceDumpJson()
+ * renders every ring as Chrome trace JSON (chrome://tracing, ui.perfetto.dev),
+ * skipping events that are being written while it reads them.
+ *
+ * On Android each span is also emitted as an ATrace section whenever systrace /
+ * Perfetto is capturing, independent of rgaTraceStart().
+ */
+
+extern std::atomic<bool> gRgaTraceEnabled;
+
+static inline bool rgaTraceEnabled() {
+    return gRgaTraceEnabled.load(std::memory_order_relaxed);
+}
+
+/* Clear all rings and start recording; capacity is in events per thread. */
+void rgaTraceStart(int capacityPerThread);
+void rgaTraceStop();
+/* Dump after rgaTraceStop() for a consistent snapshot. */
+std::string rgaTraceDumpJson();
+
+/* One traced submission; the end event carries the returned status. */
+class RgaTraceScope {
+public:
+    RgaTraceScope(const char *name, im_job_handle_t job, const rga_buffer_t *src,
+                  const rga_buffer_t *dst, int usage, int core);
+    ~RgaTraceScope();
+
+    IM_STATUS finish(IM_STATUS status) {
+        mStatus = status;
+        return status;
+    }
+
+private:
+    const char *mName;
+    im_job_handle_t mJob;
+    int mStatus = IM_STATUS_SUCCESS;
+    bool mRecording;
+    bool mSection;
+};
+
+#endif
@@ -0,0 +1,840 @@
+/*
+ * Host checks of the software backend and the CPU reference kernels, built
+ * with the host CMake configuration and run by ctest (one test per case):
+ *
+ *   rga_host_test [CASE]
+ *
+ * Without CASE every case runs. Exits with the number of failed checks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "im2d_type.h"
+#include "rga_afbc.h"
+#include "rga_backend.h"
+#include "rga_compositor.h"
+#include "rga_cpu.h"
+#include "rga_damage.h"
+#include "rga_format.h"
+#include "rga_graph.h"
+#include "rga_osd_text.h"
+#include "rga_slice.h"
+#include "rga_stripe.h"
+#include "rga_trace.h"
+
+static std::atomic<int> gFailures{0};
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                    #cond);                                                 \
+            gFailures++;                                                    \
+        }                                                                   \
+    } while (0)
+
+static rga_buffer_t makeBuffer(void *data, int width, int height, int format) {
+    rga_buffer_t buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.vir_addr = data;
+    buf.width = width;
+    buf.height = height;
+    buf.wstride = width;
+    buf.hstride = height;
+    buf.format = format;
+    return buf;
+}
+
+static void fillPattern(std::vector<uint8_t> &data, int seed) {
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(i * 31 + (i >> 7) + seed);
+    }
+}
+
+static int maxDiff(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+    int diff = 0;
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+        diff = std::max(diff, abs(a[i] - b[i]));
+    }
+    return diff;
+}
+
+// One rgaProcess call on packed buffers, the step-by-step reference for chains.
+static void reference(const std::vector<uint8_t> &src, int sw, int sh, int sfmt, std::vector<uint8_t> &dst,
+                      int dw, int dh, int dfmt, const im_rect &srect, int usage) {
+    CHECK(rgaProcess("ref", makeBuffer((void *)src.data(), sw, sh, sfmt), makeBuffer(dst.data(), dw, dh, dfmt), {},
+                     srect, {}, {}, -1, NULL, NULL, usage) == IM_STATUS_SUCCESS);
+}
+
+// Outline, filled and whole-image rectangles against the pixels they should cover.
+static void testCpuDraw() {
+    const int W = 16, H = 12;
+    const uint32_t color = 0xff3366cc;
+    uint32_t pixel = 0;
+    im_rect one = {0, 0, 1, 1};
+    CHECK(rgaCpuFill(makeBuffer(&pixel, 1, 1, RK_FORMAT_RGBA_8888), &one, 1, color) == IM_STATUS_SUCCESS);
+
+    struct {
+        im_rect rect;
+        int thickness;
+        im_rect inner;      /* left untouched inside rect; empty when filled */
+    } cases[] = {
+            {{2, 2, 10, 8}, 2, {4, 4, 6, 4}},
+            {{2, 2, 10, 8}, 4, {0, 0, 0, 0}},
+            {{2, 2, 10, 8}, -1, {0, 0, 0, 0}},
+            {{0, 0, 0, 0}, 1, {1, 1, W - 2, H - 2}},
+            {{-4, -4, 10, 10}, 2, {-2, -2, 6, 6}},
+    };
+    for (const auto &c : cases) {
+        std::vector<uint32_t> image(W * H, 0);
+        CHECK(rgaCpuRectangle(makeBuffer(image.data(), W, H, RK_FORMAT_RGBA_8888), &c.rect, 1, color,
+                              c.thickness) == IM_STATUS_SUCCESS);
+        im_rect r = c.rect.width == 0 ? im_rect{0, 0, W, H} : c.rect;
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                bool inRect = x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height;
+                bool inInner = x >= c.inner.x && x < c.inner.x + c.inner.width && y >= c.inner.y &&
+                               y < c.inner.y + c.inner.height;
+                CHECK(image[y * W + x] == (inRect && !inInner ? pixel : 0u));
+            }
+        }
+    }
+}
+
+// An impulse spreads into the kernel; flat planes stay flat; 4:2:0 chroma gets a halved kernel.
+static void testGaussian() {
+    const int W = 64, H = 48;
+    im_gauss_t gauss;
+    memset(&gauss, 0, sizeof(gauss));
+    gauss.ksize.width = 5;
+    gauss.ksize.height = 5;
+    gauss.sigma_x = 1.2;
+    gauss.sigma_y = 1.2;
+    double kernel[25];
+    rgaCpuGaussianKernel(gauss, kernel);
+    double sum = 0;
+    for (int i = 0; i < 25; i++) {
+        sum += kernel[i];
+        CHECK(kernel[i] == kernel[24 - i]);
+    }
+    CHECK(sum > 0.999 && sum < 1.001);
+
+    const int borders[] = {IM_BORDER_REFLECT, IM_BORDER_WRAP};
+    for (int border : borders) {
+        std::vector<uint8_t> src(W * H * 4), dst(src.size());
+        for (size_t i = 0; i < src.size(); i++) {
+            src[i] = i % 4 == 3 ? 255 : 40;
+        }
+        src[(20 * W + 30) * 4] = 240;
+        CHECK(rgaCpuGaussianBlur(makeBuffer(src.data(), W, H, RK_FORMAT_RGBA_8888),
+                                 makeBuffer(dst.data(), W, H, RK_FORMAT_RGBA_8888), gauss,
+                                 border) == IM_STATUS_SUCCESS);
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                int dx = x - 30, dy = y - 20;
+                double expected = 40;
+                if (abs(dx) <= 2 && abs(dy) <= 2) {
+                    expected += 200 * kernel[(dy + 2) * 5 + dx + 2];
+                }
+                const uint8_t *p = &dst[(y * W + x) * 4];
+                CHECK(abs(p[0] - expected) <= 1);
+                CHECK(p[1] == 40 && p[2] == 40 && p[3] == 255);
+            }
+        }
+    }
+
+    // A chroma impulse spreads over the 3x3 kernel of the half-resolution plane.
+    std::vector<uint8_t> nv12(W * H * 3 / 2, 128), blurred(nv12.size());
+    uint8_t *chroma = nv12.data() + W * H;
+    chroma[10 * W + 2 * 12] = 228;
+    CHECK(rgaCpuGaussianBlur(makeBuffer(nv12.data(), W, H, RK_FORMAT_YCbCr_420_SP),
+                             makeBuffer(blurred.data(), W, H, RK_FORMAT_YCbCr_420_SP), gauss,
+                             IM_BORDER_REFLECT) == IM_STATUS_SUCCESS);
+    for (int i = 0; i < W * H; i++) {
+        CHECK(blurred[i] == 128);
+    }
+    for (int y = 0; y < H / 2; y++) {
+        for (int x = 0; x < W / 2; x++) {
+            int u = blurred[W * H + y * W + 2 * x], v = blurred[W * H + y * W + 2 * x + 1];
+            bool inKernel = abs(x - 12) <= 1 && abs(y - 10) <= 1;
+            CHECK(v == 128);
+            CHECK(inKernel ? u > 128 : u == 128);
+        }
+    }
+}
+
+// Copy and resize through rgaProcess, the CPU engine and a job against plain loops.
+static void testSoftProcess() {
+    const int W = 64, H = 48;
+    std::vector<uint8_t> src(W * H * 4);
+    fillPattern(src, 3);
+    rga_buffer_t s = makeBuffer(src.data(), W, H, RK_FORMAT_RGBA_8888);
+
+    std::vector<uint8_t> copy(src.size()), cpuCopy(src.size());
+    CHECK(rgaProcess("copy", s, makeBuffer(copy.data(), W, H, RK_FORMAT_RGBA_8888), {}, {}, {}, {}, -1, NULL,
+                     NULL, 0) == IM_STATUS_SUCCESS);
+    CHECK(rgaProcessOn(RGA_ENGINE_CPU, "copy", s, makeBuffer(cpuCopy.data(), W, H, RK_FORMAT_RGBA_8888), {}, {}, {},
+                       {}, -1, NULL, NULL, 0) == IM_STATUS_SUCCESS);
+    CHECK(copy == src);
+    CHECK(cpuCopy == src);
+
+    // An exact 2x downscale samples between the pixels of each 2x2 block.
+    const int DW = W / 2, DH = H / 2;
+    std::vector<uint8_t> half(DW * DH * 4), cpuHalf(half.size()), jobHalf(half.size());
+    CHECK(rgaProcess("resize", s, makeBuffer(half.data(), DW, DH, RK_FORMAT_RGBA_8888), {}, {}, {}, {}, -1, NULL,
+                     NULL, 0) == IM_STATUS_SUCCESS);
+    CHECK(rgaProcessOn(RGA_ENGINE_CPU, "resize", s, makeBuffer(cpuHalf.data(), DW, DH, RK_FORMAT_RGBA_8888), {}, {},
+                       {}, {}, -1, NULL, NULL, 0) == IM_STATUS_SUCCESS);
+    im_job_handle_t job = rgaBeginJob(0);
+    CHECK(job != 0);
+    CHECK(rgaProcessTask("resize", job, s, makeBuffer(jobHalf.data(), DW, DH, RK_FORMAT_RGBA_8888), {}, {}, {}, {},
+                         NULL, 0) == IM_STATUS_SUCCESS);
+    CHECK(rgaEndJob(job, IM_SYNC, -1, NULL) == IM_STATUS_SUCCESS);
+    CHECK(cpuHalf == half);
+    CHECK(jobHalf == half);
+    int diff = 0;
+    for (int y = 0; y < DH; y++) {
+        for (int x = 0; x < DW; x++) {
+            for (int c = 0; c < 4; c++) {
+                int sum = 0;
+                for (int j = 0; j < 4; j++) {
+                    sum += src[((y * 2 + j / 2) * W + x * 2 + j % 2) * 4 + c];
+                }
+                diff = std::max(diff, abs(half[(y * DW + x) * 4 + c] - (sum + 2) / 4));
+            }
+        }
+    }
+    CHECK(diff <= 1);
+}
+
+static int countOf(const std::string &text, const char *needle) {
+    int count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+// Traced submissions dump as matched B/E spans; dumping while threads record is safe.
+static void testTrace() {
+    const int W = 16, H = 16;
+    std::vector<uint8_t> src(W * H * 4), dst(src.size());
+    fillPattern(src, 4);
+    rga_buffer_t s = makeBuffer(src.data(), W, H, RK_FORMAT_RGBA_8888);
+    rga_buffer_t d = makeBuffer(dst.data(), W, H, RK_FORMAT_RGBA_8888);
+
+    rgaTraceStart(256);
+    CHECK(rgaProcess("copy", s, d, {}, {}, {}, {}, -1, NULL, NULL, 0) == IM_STATUS_SUCCESS);
+    im_job_handle_t job = rgaBeginJob(0);
+    CHECK(rgaProcessTask("flipTask", job, s, d, {}, {}, {}, {}, NULL, IM_HAL_TRANSFORM_FLIP_H) ==
+          IM_STATUS_SUCCESS);
+    CHECK(rgaEndJob(job, IM_SYNC, -1, NULL) == IM_STATUS_SUCCESS);
+    rgaTraceStop();
+    CHECK(rgaProcess("untraced", s, d, {}, {}, {}, {}, -1, NULL, NULL, 0) == IM_STATUS_SUCCESS);
+
+    std::string json = rgaTraceDumpJson();
+    const char *names[] = {"copy", "beginJob", "flipTask", "endJob"};
+    for (const char *name : names) {
+        std::string span = std::string("\"name\":\"") + name + "\",\"cat\":\"rga\",\"ph\":\"";
+        CHECK(countOf(json, (span + "B").c_str()) == 1);
+        CHECK(countOf(json, (span + "E").c_str()) == 1);
+    }
+    CHECK(countOf(json, "\"ph\":\"B\"") == 4);
+    CHECK(countOf(json, "\"ph\":\"E\"") == 4);
+    CHECK(json.find("untraced") == std::string::npos);
+    CHECK(json.find("\"usage\":\"0x8\"") != std::string::npos);
+
+    // Writers never wait for a dump; dumps skip torn slots instead.
+    rgaTraceStart(64);
+    std::atomic<int> running{4};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&running] {
+            uint32_t pixel = 0;
+            rga_buffer_t one = makeBuffer(&pixel, 1, 1, RK_FORMAT_RGBA_8888);
+            for (int i = 0; i < 5000; i++) {
+                rgaProcess("stress", one, one, {}, {}, {}, {}, -1, NULL, NULL, 0);
+            }
+            running--;
+        });
+    }
+    int dumps = 0;
+    while (running > 0 || dumps == 0) {
+        json = rgaTraceDumpJson();
+        CHECK(json.compare(0, 15, "{\"traceEvents\":") == 0);
+        CHECK(countOf(json, "\"name\":\"stress\"") <= 4 * 64);
+        dumps++;
+    }
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+    rgaTraceStop();
+    json = rgaTraceDumpJson();
+    CHECK(countOf(json, "\"name\":\"stress\"") == 4 * 64);
+}
+
+// Fused graph passes against the same ops run one rgaProcess call at a time.
+static void testGraph() {
+    const int W = 64, H = 48;
+    std::vector<uint8_t> src(W * H * 4);
+    fillPattern(src, 1);
+    rga_buffer_t s = makeBuffer(src.data(), W, H, RK_FORMAT_RGBA_8888);
+
+    // crop -> rotate -> crop -> flip -> cvtcolor is a single pass.
+    {
+        RgaGraph graph(0);
+        int n = graph.input(s);
+        n = graph.crop(n, {8, 4, 32, 24});
+        n = graph.rotate(n, IM_HAL_TRANSFORM_ROT_90);
+        n = graph.crop(n, {4, 8, 16, 16});
+        n = graph.flip(n, IM_HAL_TRANSFORM_FLIP_H_V);
+        n = graph.cvtcolor(n, RK_FORMAT_RGB_888);
+        std::vector<uint8_t> out(16 * 16 * 3);
+        graph.output(n, makeBuffer(out.data(), 16, 16, RK_FORMAT_RGB_888));
+        CHECK(graph.run() == IM_STATUS_SUCCESS);
+        CHECK(graph.stats().passes == 1);
+
+        std::vector<uint8_t> a(32 * 24 * 4), b(24 * 32 * 4), c(16 * 16 * 4), d(16 * 16 * 4), e(16 * 16 * 3);
+        reference(src, W, H, RK_FORMAT_RGBA_8888, a, 32, 24, RK_FORMAT_RGBA_8888, {8, 4, 32, 24}, 0);
+        reference(a, 32, 24, RK_FORMAT_RGBA_8888, b, 24, 32, RK_FORMAT_RGBA_8888, {}, IM_HAL_TRANSFORM_ROT_90);
+        reference(b, 24, 32, RK_FORMAT_RGBA_8888, c, 16, 16, RK_FORMAT_RGBA_8888, {4, 8, 16, 16}, 0);
+        reference(c, 16, 16, RK_FORMAT_RGBA_8888, d, 16, 16, RK_FORMAT_RGBA_8888, {}, IM_HAL_TRANSFORM_ROT_180);
+        reference(d, 16, 16, RK_FORMAT_RGBA_8888, e, 16, 16, RK_FORMAT_RGB_888, {}, 0);
+        CHECK(out == e);
+    }
+    // A mirror followed by a 90 degree turn and a shared node split into three passes.
+    {
+        RgaGraph graph(0);
+        int n = graph.input(s);
+        int flipped = graph.flip(n, IM_HAL_TRANSFORM_FLIP_H);
+        int half = graph.resize(flipped, 32, 24);
+        int rotated = graph.rotate(half, IM_HAL_TRANSFORM_ROT_90);
+        int quarter = graph.resize(half, 16, 12);
+        std::vector<uint8_t> rotatedOut(24 * 32 * 4), quarterOut(16 * 12 * 4);
+        graph.output(rotated, makeBuffer(rotatedOut.data(), 24, 32, RK_FORMAT_RGBA_8888));
+        graph.output(quarter, makeBuffer(quarterOut.data(), 16, 12, RK_FORMAT_RGBA_8888));
+        CHECK(graph.run() == IM_STATUS_SUCCESS);
+        CHECK(graph.stats().passes == 3);
+
+        std::vector<uint8_t> a(W * H * 4), b(32 * 24 * 4), c(24 * 32 * 4), d(16 * 12 * 4);
+        reference(src, W, H, RK_FORMAT_RGBA_8888, a, W, H, RK_FORMAT_RGBA_8888, {}, IM_HAL_TRANSFORM_FLIP_H);
+        reference(a, W, H, RK_FORMAT_RGBA_8888, b, 32, 24, RK_FORMAT_RGBA_8888, {}, 0);
+        reference(b, 32, 24, RK_FORMAT_RGBA_8888, c, 24, 32, RK_FORMAT_RGBA_8888, {}, IM_HAL_TRANSFORM_ROT_90);
+        reference(b, 32, 24, RK_FORMAT_RGBA_8888, d, 16, 12, RK_FORMAT_RGBA_8888, {}, 0);
+        CHECK(maxDiff(rotatedOut, c) <= 1);
+        CHECK(maxDiff(quarterOut, d) <= 1);
+    }
+    // Two 4x downscales exceed the RGA's 8x limit when fused.
+    {
+        RgaGraph graph(0);
+        int n = graph.resize(graph.resize(graph.input(s), 16, 12), 4, 3);
+        std::vector<uint8_t> out(4 * 3 * 4);
+        graph.output(n, makeBuffer(out.data(), 4, 3, RK_FORMAT_RGBA_8888));
+        CHECK(graph.run() == IM_STATUS_SUCCESS);
+        CHECK(graph.stats().passes == 2);
+    }
+}
+
+// Composed frames, with layers added, moved, damaged and removed, against a
+// full redraw of every layer in z order.
+static void testCompositor() {
+    const int W = 128, H = 96;
+    const int dims[4][2] = {{64, 48}, {32, 32}, {40, 30}, {16, 16}};
+    std::vector<uint8_t> pixels[4];
+    RgaLayer layers[4];
+    memset(layers, 0, sizeof(layers));
+    for (int i = 0; i < 4; i++) {
+        pixels[i].resize(dims[i][0] * dims[i][1] * 4);
+        fillPattern(pixels[i], i * 11);
+        layers[i].buffer = makeBuffer(pixels[i].data(), dims[i][0], dims[i][1], RK_FORMAT_RGBA_8888);
+        layers[i].alpha = 255;
+        layers[i].zorder = i;
+    }
+    layers[0].drect = {0, 0, W, H};
+    layers[1].drect = {10, 10, 32, 32};
+    layers[1].transform = IM_HAL_TRANSFORM_ROT_90;
+    layers[2].drect = {50, 20, 20, 15};
+    layers[2].alpha = 200;
+    layers[3].drect = {20, 20, 16, 16};
+    layers[3].transform = IM_HAL_TRANSFORM_FLIP_H;
+    layers[3].blend = true;
+
+    RgaCompositor compositor(W, H, 0);
+    compositor.setBackground(0xff102030);
+    for (int i = 1; i < 4; i++) {
+        compositor.setLayer(i, layers[i]);
+    }
+    std::vector<uint8_t> out(W * H * 4), ref(W * H * 4);
+    bool background = false;
+    for (int frame = 0; frame < 10; frame++) {
+        if (frame == 3) {
+            compositor.setLayer(0, layers[0]);
+            background = true;
+        } else if (frame == 5) {
+            layers[1].drect.x = 70;
+            compositor.setLayer(1, layers[1]);
+        } else if (frame == 7) {
+            fillPattern(pixels[2], 99);
+            compositor.damageLayer(2);
+        } else if (frame == 9) {
+            compositor.removeLayer(0);
+            background = false;
+        }
+        CHECK(compositor.compose(makeBuffer(out.data(), W, H, RK_FORMAT_RGBA_8888)) == IM_STATUS_SUCCESS);
+
+        rga_buffer_t r = makeBuffer(ref.data(), W, H, RK_FORMAT_RGBA_8888);
+        im_rect whole = {0, 0, W, H};
+        rgaCpuFill(r, &whole, 1, 0xff102030);
+        for (int i = background ? 0 : 1; i < 4; i++) {
+            rga_buffer_t layer = layers[i].buffer;
+            layer.global_alpha = layers[i].alpha;
+            int usage = layers[i].transform |
+                        (layers[i].blend || layers[i].alpha < 255 ? IM_ALPHA_BLEND_SRC_OVER : 0);
+            CHECK(rgaProcess("ref", layer, r, {}, {0, 0, layer.width, layer.height}, layers[i].drect, {}, -1, NULL,
+                             NULL, usage) == IM_STATUS_SUCCESS);
+        }
+        CHECK(out == ref);
+    }
+    // The dst alternates between two buffers in real use; nothing changed, nothing drawn.
+    CHECK(compositor.compose(makeBuffer(out.data(), W, H, RK_FORMAT_RGBA_8888)) == IM_STATUS_SUCCESS);
+    CHECK(compositor.stats().tasks == 0);
+}
+
+// Incremental updates of a changing source against full-frame processing.
+static void testDamage() {
+    const int SW = 256, SH = 128;
+    struct {
+        int dw, dh, usage, format;
+    } cases[] = {
+            {256, 128, 0, RK_FORMAT_RGBA_8888},
+            {128, 256, IM_HAL_TRANSFORM_ROT_90, RK_FORMAT_RGBA_8888},
+            {128, 64, IM_HAL_TRANSFORM_FLIP_H, RK_FORMAT_YCbCr_420_SP},
+            {96, 48, 0, RK_FORMAT_RGBA_8888},
+    };
+    for (const auto &c : cases) {
+        std::vector<uint8_t> src(SW * SH * 4);
+        fillPattern(src, 0);
+        rga_buffer_t s = makeBuffer(src.data(), SW, SH, RK_FORMAT_RGBA_8888);
+        std::vector<uint8_t> out(c.dw * c.dh * 4), ref(out.size());
+        rga_buffer_t o = makeBuffer(out.data(), c.dw, c.dh, c.format);
+        rga_buffer_t r = makeBuffer(ref.data(), c.dw, c.dh, c.format);
+        RgaIncremental incremental(32, 0);
+        for (int frame = 0; frame < 5; frame++) {
+            if (frame == 2) {
+                for (int y = 40; y < 50; y++) {
+                    for (int x = 70; x < 90; x++) {
+                        src[(y * SW + x) * 4] ^= 0x5a;
+                    }
+                }
+            }
+            if (frame == 4) {
+                // A caller-supplied dirty rect skips the hashing.
+                for (int y = 100; y < SH; y++) {
+                    for (int x = 0; x < 33; x++) {
+                        src[(y * SW + x) * 4 + 2] += 9;
+                    }
+                }
+                im_rect dirty = {0, 100, 33, 28};
+                CHECK(incremental.process(s, o, {}, {}, c.usage, &dirty, 1) == IM_STATUS_SUCCESS);
+            } else {
+                CHECK(incremental.process(s, o, {}, {}, c.usage, NULL, 0) == IM_STATUS_SUCCESS);
+            }
+            CHECK(rgaProcess("ref", s, r, {}, {}, {}, {}, -1, NULL, NULL, c.usage) == IM_STATUS_SUCCESS);
+            CHECK(out == ref);
+        }
+        const RgaDamageStats &stats = incremental.stats();
+        CHECK(stats.frames == 5);
+        CHECK(stats.skippedFrames >= 1);
+    }
+}
+
+// Raster -> AFBC -> raster is lossless, including the padding outside width x height.
+static void testAfbcRoundTrip() {
+    const int formats[] = {RK_FORMAT_RGBA_8888, RK_FORMAT_YCbCr_420_SP};
+    const int W = 70, H = 38, WS = 72, HS = 40;
+    for (int format : formats) {
+        std::vector<uint8_t> src(rgaFormatImageSize(format, WS, HS));
+        fillPattern(src, 0);
+        rga_buffer_t raster = makeBuffer(src.data(), W, H, format);
+        raster.wstride = WS;
+        raster.hstride = HS;
+        // A flat top row of superblocks, so solid blocks are exercised as well.
+        RgaCpuImage flat;
+        CHECK(rgaCpuMapImage(raster, &flat) == IM_STATUS_SUCCESS);
+        for (int p = 0; p < flat.planeCount; p++) {
+            memset(flat.planes[p].data, 7, (size_t)flat.planes[p].stride * (RGA_AFBC_BLOCK >> flat.planes[p].yshift));
+        }
+        rgaCpuUnmapImage(&flat);
+
+        std::vector<uint8_t> compressed(rgaFormatBufferSize(format, WS, HS, IM_AFBC16x16_MODE), 0xcd);
+        rga_buffer_t afbc = raster;
+        afbc.vir_addr = compressed.data();
+        afbc.rd_mode = IM_AFBC16x16_MODE;
+        RgaAfbcStats stats;
+        CHECK(rgaAfbcEncode(raster, afbc, &stats) == IM_STATUS_SUCCESS);
+        CHECK(stats.solidBlocks > 0 && stats.solidBlocks < stats.blocks);
+
+        std::vector<uint8_t> back(src.size(), 0);
+        rga_buffer_t decoded = raster;
+        decoded.vir_addr = back.data();
+        CHECK(rgaAfbcDecode(afbc, decoded) == IM_STATUS_SUCCESS);
+
+        RgaCpuImage a, b;
+        CHECK(rgaCpuMapImage(raster, &a) == IM_STATUS_SUCCESS);
+        CHECK(rgaCpuMapImage(decoded, &b) == IM_STATUS_SUCCESS);
+        const RgaFormatDesc *desc = rgaFormatFind(format);
+        for (int p = 0; p < a.planeCount; p++) {
+            int rowBytes = rgaFormatPlaneRowBytes(*desc, p, W);
+            for (int y = 0; y < a.planes[p].height; y++) {
+                CHECK(memcmp(a.planes[p].data + (size_t)y * a.planes[p].stride,
+                             b.planes[p].data + (size_t)y * b.planes[p].stride, rowBytes) == 0);
+            }
+        }
+        rgaCpuUnmapImage(&b);
+        rgaCpuUnmapImage(&a);
+
+        // A body offset past the buffer is corrupt; a header without the tag is
+        // not ours (e.g. written by the hardware) and is refused.
+        memset(compressed.data(), 0xff, 4);
+        CHECK(rgaAfbcDecode(afbc, decoded) == IM_STATUS_FAILED);
+        memset(compressed.data(), 0, 16);
+        CHECK(rgaAfbcDecode(afbc, decoded) == IM_STATUS_NOT_SUPPORTED);
+    }
+}
+
+// Little-endian packing of 10-bit samples, as in RK_FORMAT_YCbCr_4xx_SP_10B rows.
+static void pack10(uint8_t *dst, const uint16_t *samples, int count) {
+    memset(dst, 0, (count * 10 + 7) / 8);
+    for (int i = 0; i < count; i++) {
+        for (int b = 0; b < 10; b++) {
+            if (samples[i] >> b & 1) {
+                dst[(i * 10 + b) >> 3] |= 1 << ((i * 10 + b) & 7);
+            }
+        }
+    }
+}
+
+// Packed 10-bit and P010 sources down to 8-bit NV12/NV21.
+static void testYuv10() {
+    const int W = 132, H = 6;
+    std::vector<uint16_t> luma(W * H), chroma(W * H / 2), chroma422(W * H);
+    for (int i = 0; i < W * H; i++) {
+        luma[i] = (i * 37) % 1024;
+        chroma422[i] = (i * 29 + 3) % 1024;
+    }
+    for (int i = 0; i < W * H / 2; i++) {
+        chroma[i] = (i * 53 + 7) % 1024;
+    }
+    int rowBytes = (W * 10 + 7) / 8;
+    std::vector<uint8_t> packed(rgaFormatImageSize(RK_FORMAT_YCbCr_420_SP_10B, W, H));
+    for (int y = 0; y < H; y++) {
+        pack10(packed.data() + y * rowBytes, &luma[y * W], W);
+    }
+    for (int y = 0; y < H / 2; y++) {
+        pack10(packed.data() + (H + y) * rowBytes, &chroma[y * W], W);
+    }
+    rga_buffer_t src = makeBuffer(packed.data(), W, H, RK_FORMAT_YCbCr_420_SP_10B);
+
+    // Without dithering every sample is truncated to its top 8 bits.
+    std::vector<uint8_t> nv12(W * H * 3 / 2), nv21(nv12.size()), fromP010(nv12.size());
+    CHECK(rgaCpuConvert10Bit(src, makeBuffer(nv12.data(), W, H, RK_FORMAT_YCbCr_420_SP), false) == IM_STATUS_SUCCESS);
+    for (int i = 0; i < W * H; i++) {
+        CHECK(nv12[i] == luma[i] >> 2);
+    }
+    for (int i = 0; i < W * H / 2; i++) {
+        CHECK(nv12[W * H + i] == chroma[i] >> 2);
+    }
+    CHECK(rgaCpuConvert10Bit(src, makeBuffer(nv21.data(), W, H, RK_FORMAT_YCrCb_420_SP), false) == IM_STATUS_SUCCESS);
+    for (int i = 0; i < W * H / 2; i++) {
+        CHECK(nv21[W * H + (i ^ 1)] == chroma[i] >> 2);
+    }
+
+    std::vector<uint16_t> p010(W * H * 3 / 2);
+    for (int i = 0; i < W * H; i++) {
+        p010[i] = luma[i] << 6;
+    }
+    for (int i = 0; i < W * H / 2; i++) {
+        p010[W * H + i] = chroma[i] << 6;
+    }
+    rga_buffer_t p010Src = makeBuffer(p010.data(), W, H, RGA_FORMAT_P010);
+    CHECK(rgaCpuConvert10Bit(p010Src, makeBuffer(fromP010.data(), W, H, RK_FORMAT_YCbCr_420_SP), false) ==
+          IM_STATUS_SUCCESS);
+    CHECK(fromP010 == nv12);
+
+    // Dithering keeps the mean of a flat 10-bit level (513 = 128.25 in 8 bits).
+    for (int i = 0; i < W * H; i++) {
+        p010[i] = 513 << 6;
+    }
+    CHECK(rgaCpuConvert10Bit(p010Src, makeBuffer(fromP010.data(), W, H, RK_FORMAT_YCbCr_420_SP), true) ==
+          IM_STATUS_SUCCESS);
+    double sum = 0;
+    for (int i = 0; i < W * 4; i++) {
+        sum += fromP010[i];
+    }
+    CHECK(sum / (W * 4) > 128.2 && sum / (W * 4) < 128.3);
+
+    // 4:2:2 chroma rows are averaged in pairs.
+    std::vector<uint8_t> packed422(rgaFormatImageSize(RK_FORMAT_YCbCr_422_SP_10B, W, H));
+    for (int y = 0; y < H; y++) {
+        pack10(packed422.data() + y * rowBytes, &luma[y * W], W);
+        pack10(packed422.data() + (H + y) * rowBytes, &chroma422[y * W], W);
+    }
+    CHECK(rgaCpuConvert10Bit(makeBuffer(packed422.data(), W, H, RK_FORMAT_YCbCr_422_SP_10B),
+                             makeBuffer(nv12.data(), W, H, RK_FORMAT_YCbCr_420_SP), false) == IM_STATUS_SUCCESS);
+    for (int y = 0; y < H / 2; y++) {
+        for (int x = 0; x < W; x++) {
+            int average = (chroma422[2 * y * W + x] + chroma422[(2 * y + 1) * W + x] + 1) >> 1;
+            CHECK(nv12[W * H + y * W + x] == average >> 2);
+        }
+    }
+}
+
+// Statistics and auto-invert decisions over blocks of known luma.
+static void testOsdInvert() {
+    // 32x8 RGBA: four 8-pixel blocks of luma 0, 100, 160, 255.
+    const int W = 32, H = 8;
+    const uint8_t levels[4] = {0, 100, 160, 255};
+    std::vector<uint8_t> bg(W * H * 4);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            uint8_t *p = &bg[(y * W + x) * 4];
+            p[0] = p[1] = p[2] = levels[x / 8];
+            p[3] = 255;
+        }
+    }
+    im_osd_t config;
+    memset(&config, 0, sizeof(config));
+    config.osd_mode = IM_OSD_MODE_STATISTICS | IM_OSD_MODE_AUTO_INVERT;
+    config.block_parm.width = 8;
+    config.block_parm.block_count = 4;
+    config.block_parm.background_config = IM_OSD_BACKGROUND_DEFAULT_DARK;
+    config.invert_config.invert_channel = IM_OSD_INVERT_CHANNEL_COLOR;
+    config.invert_config.threash = 128;
+
+    RgaCpuOsdStatistics stats;
+    rga_buffer_t dst = makeBuffer(bg.data(), W, H, RK_FORMAT_RGBA_8888);
+    CHECK(rgaCpuOsdStatistics(dst, {0, 0, W, H}, config, &stats) == IM_STATUS_SUCCESS);
+    CHECK(stats.blocks == 4);
+    for (int i = 0; i < 4; i++) {
+        CHECK(abs(stats.luma[i] - levels[i]) <= 1);
+    }
+    CHECK(stats.flags == 0xc);
+    // Over a dark default, bright blocks invert; over a bright one, dark blocks do.
+    for (int i = 0; i < 4; i++) {
+        CHECK(rgaCpuOsdInverted(config, stats.flags, i) == (i >= 2));
+    }
+    config.block_parm.background_config = IM_OSD_BACKGROUND_DEFAULT_BRIGHT;
+    for (int i = 0; i < 4; i++) {
+        CHECK(rgaCpuOsdInverted(config, stats.flags, i) == (i < 2));
+    }
+
+    // White text comes out white on the dark blocks and black on the bright ones.
+    config.block_parm.background_config = IM_OSD_BACKGROUND_DEFAULT_DARK;
+    config.invert_config.factor = {255, 0, 255, 0, 255, 0};
+    std::vector<uint8_t> osd(W * H * 4, 255);
+    CHECK(rgaCpuOsd(makeBuffer(osd.data(), W, H, RK_FORMAT_RGBA_8888), dst, {0, 0, W, H}, &config) ==
+          IM_STATUS_SUCCESS);
+    CHECK(config.invert_config.current_flags == 0xc);
+    for (int i = 0; i < 4; i++) {
+        CHECK(bg[(i * 8 + 4) * 4 + 1] == (i >= 2 ? 0 : 255));
+    }
+}
+
+// A glyph run blended onto a raster frame on the CPU, pixel by pixel.
+static void testOsdText() {
+    const int W = 16, H = 8;
+    // 'A' is a solid 4x4 block, 'B' the same with a half-covered right column.
+    uint8_t solid[16], half[16];
+    memset(solid, 255, sizeof(solid));
+    memset(half, 255, sizeof(half));
+    for (int y = 0; y < 4; y++) {
+        half[y * 4 + 3] = 128;
+    }
+    RgaOsdText text(64, 16, 4, 0);
+    text.setMetrics(4, 4);
+    CHECK(text.addGlyph('A', solid, 4, 4, 0, 4, 4) == IM_STATUS_SUCCESS);
+    CHECK(text.addGlyph('B', half, 4, 4, 0, 4, 4) == IM_STATUS_SUCCESS);
+
+    std::vector<uint8_t> frame(W * H * 4);
+    for (size_t i = 0; i < frame.size(); i += 4) {
+        frame[i] = frame[i + 1] = frame[i + 2] = 0;
+        frame[i + 3] = 255;
+    }
+    rga_buffer_t dst = makeBuffer(frame.data(), W, H, RK_FORMAT_RGBA_8888);
+    RgaOsdLabel label = {"AB", 2, 3, 0xff0000ff, 0, 0};
+    CHECK(text.draw(dst, &label, 1, true) == IM_STATUS_SUCCESS);
+    CHECK(text.stats().tasks == 1 && text.stats().cacheMisses == 1);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            const uint8_t *p = &frame[(y * W + x) * 4];
+            int red = 0;
+            if (y >= 3 && y < 7 && x >= 2 && x < 10) {
+                red = x == 9 ? 128 : 255;
+            }
+            CHECK(abs(p[0] - red) <= 1 && p[1] == 0 && p[2] == 0 && p[3] == 255);
+        }
+    }
+
+    // The same label again comes from the cache.
+    CHECK(text.draw(dst, &label, 1, true) == IM_STATUS_SUCCESS);
+    CHECK(text.stats().cacheHits == 1 && text.stats().cacheMisses == 1);
+
+    // The CPU path cannot blend into a compressed frame.
+    dst.rd_mode = IM_AFBC16x16_MODE;
+    CHECK(text.draw(dst, &label, 1, true) == IM_STATUS_NOT_SUPPORTED);
+}
+
+// A consumer woken by waitRows(rows) sees those rows written, in publish order.
+static void testSliceProgress() {
+    const int W = 64, H = 256;
+    std::vector<uint8_t> src(W * H * 4), ref(W * H * 3 / 2), dst(ref.size(), 0);
+    fillPattern(src, 5);
+    rga_buffer_t s = makeBuffer(src.data(), W, H, RK_FORMAT_RGBA_8888);
+    CHECK(rgaProcess("ref", s, makeBuffer(ref.data(), W, H, RK_FORMAT_YCbCr_420_SP), {}, {}, {}, {}, -1, NULL, NULL,
+                     0) == IM_STATUS_SUCCESS);
+
+    RgaSliceProgress progress;
+    std::vector<int> published;
+    progress.setCallback([&published](int rows, int) { published.push_back(rows); });
+    CHECK(!progress.waitRows(1, 0));
+
+    im_intr_config_t intr;
+    memset(&intr, 0, sizeof(intr));
+    intr.flags = IM_INTR_WRITE_INTR;
+    intr.write_start = 16;
+    intr.write_step = 32;
+    std::atomic<int> seen{0};
+    std::thread consumer([&] {
+        for (int rows = 16; rows <= H; rows += 16) {
+            if (!progress.waitRows(rows, 5000)) {
+                return;
+            }
+            int ready = progress.rows();
+            CHECK(ready >= rows || progress.done());
+            CHECK(memcmp(dst.data(), ref.data(), (size_t)ready * W) == 0);
+            seen = ready;
+        }
+    });
+    CHECK(rgaProcessSliced("sliced", s, makeBuffer(dst.data(), W, H, RK_FORMAT_YCbCr_420_SP), {}, {}, NULL, 0, intr,
+                           &progress) == IM_STATUS_SUCCESS);
+    consumer.join();
+
+    CHECK(seen == H);
+    CHECK(progress.done() && progress.status() == IM_STATUS_SUCCESS);
+    CHECK(dst == ref);
+    CHECK(!published.empty() && published.front() == 16 && published.back() == H);
+    for (size_t i = 1; i < published.size(); i++) {
+        CHECK(published[i] > published[i - 1]);
+        CHECK(progress.latencyNs(published[i]) >= progress.latencyNs(published[i - 1]));
+    }
+    CHECK(progress.waitRows(H + 1, 0));
+}
+
+// Rows [y, y + count) of a packed RGBA or NV12 frame as a standalone stripe.
+static std::vector<uint8_t> cutStripe(const std::vector<uint8_t> &frame, int format, int width, int height, int y,
+                                      int count) {
+    std::vector<uint8_t> stripe(rgaFormatImageSize(format, width, count));
+    if (format == RK_FORMAT_RGBA_8888) {
+        memcpy(stripe.data(), frame.data() + (size_t)y * width * 4, (size_t)count * width * 4);
+    } else {
+        memcpy(stripe.data(), frame.data() + (size_t)y * width, (size_t)count * width);
+        memcpy(stripe.data() + (size_t)count * width, frame.data() + (size_t)width * height + (size_t)y / 2 * width,
+               (size_t)count / 2 * width);
+    }
+    return stripe;
+}
+
+// Frames pushed in stripes against whole-frame calls, for scales that match exactly.
+static void testStripe() {
+    const int W = 64, H = 64;
+    struct {
+        int srcFormat, dw, dh, dstFormat, step, minOutputRows;
+    } cases[] = {
+            {RK_FORMAT_RGBA_8888, 64, 64, RK_FORMAT_YCbCr_420_SP, 16, 8},
+            {RK_FORMAT_RGBA_8888, 64, 64, RK_FORMAT_YCbCr_420_SP, 10, 8},
+            {RK_FORMAT_YCbCr_420_SP, 32, 32, RK_FORMAT_RGBA_8888, 10, 4},
+            {RK_FORMAT_YCbCr_420_SP, 32, 32, RK_FORMAT_RGBA_8888, 24, 6},
+    };
+    for (const auto &c : cases) {
+        std::vector<uint8_t> src(rgaFormatImageSize(c.srcFormat, W, H));
+        fillPattern(src, 2);
+        std::vector<uint8_t> whole(rgaFormatImageSize(c.dstFormat, c.dw, c.dh)), striped(whole.size());
+        CHECK(rgaProcess("whole", makeBuffer(src.data(), W, H, c.srcFormat),
+                         makeBuffer(whole.data(), c.dw, c.dh, c.dstFormat), {}, {}, {}, {}, -1, NULL, NULL,
+                         0) == IM_STATUS_SUCCESS);
+
+        RgaStripeStream stream(W, H, c.srcFormat, c.minOutputRows, 0);
+        RgaSliceProgress progress;
+        CHECK(stream.begin(makeBuffer(striped.data(), c.dw, c.dh, c.dstFormat), {}, 0, &progress) ==
+              IM_STATUS_SUCCESS);
+        for (int y = 0; y < H; y += c.step) {
+            int rows = std::min(c.step, H - y);
+            std::vector<uint8_t> stripe = cutStripe(src, c.srcFormat, W, H, y, rows);
+            CHECK(stream.push(makeBuffer(stripe.data(), W, rows, c.srcFormat)) == IM_STATUS_SUCCESS);
+            // The caller may reuse the stripe as soon as push() returns.
+            memset(stripe.data(), 0xee, stripe.size());
+        }
+        CHECK(striped == whole);
+        CHECK(progress.done() && progress.status() == IM_STATUS_SUCCESS && progress.rows() == c.dh);
+        const RgaStripeStats &stats = stream.stats();
+        CHECK(stats.outputs == stats.inPlace + stats.stitched);
+        CHECK(stream.push(makeBuffer(src.data(), W, 16, c.srcFormat)) == IM_STATUS_INVALID_PARAM);
+    }
+
+    // Misaligned stripes are refused; abort() finishes the progress as failed.
+    std::vector<uint8_t> dst(64 * 64 * 4), stripe(64 * 8 * 3 / 2);
+    RgaStripeStream stream(64, 64, RK_FORMAT_YCbCr_420_SP, 8, 0);
+    RgaSliceProgress progress;
+    CHECK(stream.begin(makeBuffer(dst.data(), 64, 64, RK_FORMAT_RGBA_8888), {}, IM_HAL_TRANSFORM_ROT_90, NULL) ==
+          IM_STATUS_NOT_SUPPORTED);
+    CHECK(stream.begin(makeBuffer(dst.data(), 64, 64, RK_FORMAT_RGBA_8888), {}, 0, &progress) == IM_STATUS_SUCCESS);
+    CHECK(stream.push(makeBuffer(stripe.data(), 64, 7, RK_FORMAT_YCbCr_420_SP)) == IM_STATUS_INVALID_PARAM);
+    CHECK(stream.push(makeBuffer(stripe.data(), 64, 8, RK_FORMAT_YCbCr_420_SP)) == IM_STATUS_SUCCESS);
+    stream.abort();
+    CHECK(progress.done() && progress.status() == IM_STATUS_FAILED && progress.rows() == 8);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)();
+} TestCase;
+
+static const TestCase kCases[] = {
+        {"cpu_draw", testCpuDraw},
+        {"gaussian", testGaussian},
+        {"soft_process", testSoftProcess},
+        {"trace", testTrace},
+        {"graph", testGraph},
+        {"compositor", testCompositor},
+        {"damage", testDamage},
+        {"afbc_round_trip", testAfbcRoundTrip},
+        {"yuv10", testYuv10},
+        {"osd_invert", testOsdInvert},
+        {"osd_text", testOsdText},
+        {"slice_progress", testSliceProgress},
+        {"stripe", testStripe},
+};
+
+int main(int argc, char **argv) {
+    bool found = false;
+    for (const TestCase &test : kCases) {
+        if (argc > 1 && strcmp(argv[1], test.name) != 0) {
+            continue;
+        }
+        found = true;
+        int before = gFailures;
+        test.run();
+        printf("%s %s\n", gFailures == before ? "PASS" : "FAIL", test.name);
+    }
+    if (!found) {
+        fprintf(stderr, "unknown case %s\n", argv[1]);
+        return 1;
+    }
+    return gFailures;
+}
@@ -0,0 +1,155 @@
+package com.rockchip.librga
+
+import android.os.Bundle
+import android.util.Log
+import android.widget.*
+import androidx.appcompat.app.AppCompatActivity
+import java.io.File
+import java.text.SimpleDateFormat
+import java.util.Date
+import java.util.Locale
+
+/**
+ * UI and adb front end for [RgaBenchmark]. Results are shown and written as JSON
+ * to the app's external files dir, e.g.
+ *
+ *   adb shell am start -n com.rockchip.librga/.BenchmarkActivity \
+ *       --ei threads 4 --ei duration 30 --es resolution 1080p --es format NV12 \
+ *       --es mix resize:2,cvtcolor --ez autorun true
+ *   adb pull /sdcard/Android/data/com.rockchip.librga/files/
+ */
+class BenchmarkActivity : AppCompatActivity() {
+
+    private lateinit var etThreads: EditText
+    private lateinit var etDuration: EditText
+    private lateinit var etMix: EditText
+    private lateinit var spResolution: Spinner
+    private lateinit var spFormat: Spinner
+    private lateinit var btnRun: Button
+    private lateinit var btnStop: Button
+    private lateinit var tvResult: TextView
+
+    private var running: RgaBenchmark? = null
+
+    private val resolutions = linkedMapOf(
+        "480p" to (640 to 480),
+        "720p" to (1280 to 720),
+        "1080p" to (1920 to 1080),
+        "4K" to (3840 to 2160),
+        "8K" to (7680 to 4320)
+    )
+
+    private val formats = linkedMapOf(
+        "RGBA_8888" to Rga.RK_FORMAT_RGBA_8888,
+        "RGB_888" to Rga.RK_FORMAT_RGB_888,
+        "RGB_565" to Rga.RK_FORMAT_RGB_565,
+        "NV12" to Rga.RK_FORMAT_YCbCr_420_SP,
+        "NV21" to Rga.RK_FORMAT_YCrCb_420_SP
+    )
+
+    override fun onCreate(savedInstanceState: Bundle?) {
+        super.onCreate(savedInstanceState)
+        setContentView(R.layout.activity_benchmark)
+
+        etThreads = findViewById(R.id.etThreads)
+        etDuration = findViewById(R.id.etDuration)
+        etMix = findViewById(R.id.etMix)
+        spResolution = findViewById(R.id.spResolution)
+        spFormat = findViewById(R.id.spFormat)
+        btnRun = findViewById(R.id.btnRunBenchmark)
+        btnStop = findViewById(R.id.btnStopBenchmark)
+        tvResult = findViewById(R.id.tvBenchmarkResult)
+
+        spResolution.adapter = ArrayAdapter(this, android.R.layout.simple_spinner_dropdown_item, resolutions.keys.toList())
+        spFormat.adapter = ArrayAdapter(this, android.R.layout.simple_spinner_dropdown_item, formats.keys.toList())
+        spResolution.setSelection(resolutions.keys.indexOf("1080p"))
+
+        btnRun.setOnClickListener { startBenchmark() }
+        btnStop.setOnClickListener { running?.cancel() }
+
+        intent.extras?.let { extras ->
+            if (extras.containsKey("threads")) etThreads.setText(extras.getInt("threads").toString())
+            if (extras.containsKey("duration")) etDuration.setText(extras.getInt("duration").toString())
+            extras.getString("mix")?.let { etMix.setText(it) }
+            extras.getString("resolution")?.let { spResolution.setSelection(resolutions.keys.indexOf(it).coerceAtLeast(0)) }
+            extras.getString("format")?.let { spFormat.setSelection(formats.keys.indexOf(it).coerceAtLeast(0)) }
+            if (extras.getBoolean("autorun", false)) startBenchmark()
+        }
+    }
+
+    override fun onDestroy() {
+        running?.cancel()
+        super.onDestroy()
+    }
+
+    private fun startBenchmark() {
+        val config = try {
+            val (width, height) = resolutions.getValue(spResolution.selectedItem as String)
+            RgaBenchmark.Config(
+                threads = etThreads.text.toString().toInt(),
+                durationMs = etDuration.text.toString().toLong() * 1000,
+                width = width,
+                height = height,
+                format = formats.getValue(spFormat.selectedItem as String),
+                mix = RgaBenchmark.Config.parseMix(etMix.text.toString())
+            )
+        } catch (e: Exception) {
+            tvResult.text = "Invalid configuration: ${e.message}"
+            return
+        }
+
+        val benchmark = RgaBenchmark(config)
+        running = benchmark
+        btnRun.isEnabled = false
+        btnStop.isEnabled = true
+        tvResult.text = "Running ${config.threads} thread(s) for ${config.durationMs / 1000}s " +
+                "at ${config.width}x${config.height}..."
+
+        Thread {
+            val text = try {
+                val result = benchmark.run()
+                val stamp = SimpleDateFormat("yyyyMMdd_HHmmss", Locale.US).format(Date())
+                val file = File(getExternalFilesDir(null), "rga_bench_$stamp.json")
+                result.writeJson(file)
+                Log.i(TAG, result.toJson().toString())
+                format(result) + "\nSaved to ${file.absolutePath}"
+            } catch (e: Exception) {
+                Log.e(TAG, "Benchmark failed", e)
+                "Benchmark failed: ${e.message}"
+            }
+            runOnUiThread {
+                tvResult.text = text
+                btnRun.isEnabled = true
+                btnStop.isEnabled = false
+                running = null
+            }
+        }.start()
+    }
+
+    private fun format(r: RgaBenchmark.Result): String {
+        val sb = StringBuilder()
+        sb.append("Elapsed: ${r.elapsedMs} ms\n")
+        sb.append("Frames/s: ${"%.1f".format(r.framesPerSecond)}  (${"%.1f".format(r.megapixelsPerSecond)} MP/s)\n")
+        sb.append("Latency p50/p99/max: ${"%.0f".format(r.latency.p50Us)} / ${"%.0f".format(r.latency.p99Us)} / " +
+                "${"%.0f".format(r.latency.maxUs)} us\n")
+        sb.append("Failures: ${r.failures}\n")
+        sb.append("CPU: ${"%.2f".format(r.cpuCores)} cores (${"%.0f".format(r.cpuUtilization * 100)}%)\n")
+        if (r.rgaLoad.isEmpty()) {
+            sb.append("RGA load: unavailable (debugfs not readable)\n")
+        } else {
+            r.rgaLoad.forEach { (core, load) -> sb.append("RGA $core: ${"%.0f".format(load)}%\n") }
+        }
+        sb.append("\n")
+        for (op in r.perOp) {
+            sb.append("${op.op.label.padEnd(13)} ${"%8.1f".format(op.opsPerSecond)}/s  " +
+                    "p50 ${"%6.0f".format(op.latency.p50Us)}us  p99 ${"%6.0f".format(op.latency.p99Us)}us" +
+                    (if (op.failures > 0) "  fail ${op.failures}" else "") + "\n")
+        }
+        sb.append("\nPer-second frames: ${r.timeline.joinToString(" ")}\n")
+        return sb.toString()
+    }
+
+    companion object {
+        private const val TAG = "RgaBenchmark"
+    }
+}
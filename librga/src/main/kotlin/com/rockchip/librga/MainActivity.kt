@@ -1,5 +1,6 @@
 package com.rockchip.librga
 
+import android.content.Intent
 import android.graphics.Bitmap
 import android.graphics.Canvas
 import android.graphics.Color
@@ -17,6 +18,7 @@ class MainActivity : AppCompatActivity() {
     private lateinit var ivOriginal: ImageView
     private lateinit var ivProcessed: ImageView
     private lateinit var btnRunAllTests: Button
+    private lateinit var btnBenchmark: Button
     private lateinit var btnTestCopy: Button
     private lateinit var btnTestResize: Button
     private lateinit var btnTestRescale: Button
@@ -28,6 +30,7 @@ class MainActivity : AppCompatActivity() {
     private lateinit var btnTestConvertColor: Button
     private lateinit var btnTestYuvToBitmap: Button
     private lateinit var btnTestJob: Button
+    private lateinit var btnTestFillMosaic: Button
     private lateinit var btnTestCopyTask: Button
     private lateinit var btnTestResizeTask: Button
     private lateinit var btnTestCropTask: Button
@@ -60,6 +63,7 @@ class MainActivity : AppCompatActivity() {
         ivOriginal = findViewById(R.id.ivOriginal)
         ivProcessed = findViewById(R.id.ivProcessed)
         btnRunAllTests = findViewById(R.id.btnRunAllTests)
+        btnBenchmark = findViewById(R.id.btnBenchmark)
         btnTestCopy = findViewById(R.id.btnTestCopy)
         btnTestResize = findViewById(R.id.btnTestResize)
         btnTestRescale = findViewById(R.id.btnTestRescale)
@@ -71,6 +75,7 @@ class MainActivity : AppCompatActivity() {
         btnTestConvertColor = findViewById(R.id.btnTestConvertColor)
         btnTestYuvToBitmap = findViewById(R.id.btnTestYuvToBitmap)
         btnTestJob = findViewById(R.id.btnTestJob)
+        btnTestFillMosaic = findViewById(R.id.btnTestFillMosaic)
         btnTestCopyTask = findViewById(R.id.btnTestCopyTask)
         btnTestResizeTask = findViewById(R.id.btnTestResizeTask)
         btnTestCropTask = findViewById(R.id.btnTestCropTask)
@@ -83,6 +88,7 @@ class MainActivity : AppCompatActivity() {
 
     private fun setupClickListeners() {
         btnRunAllTests.setOnClickListener { runAllTests() }
+        btnBenchmark.setOnClickListener { startActivity(Intent(this, BenchmarkActivity::class.java)) }
         btnTestCopy.setOnClickListener { testCopy() }
         btnTestResize.setOnClickListener { testResize() }
         btnTestRescale.setOnClickListener { testRescale() }
@@ -94,6 +100,7 @@ class MainActivity : AppCompatActivity() {
         btnTestConvertColor.setOnClickListener { testConvertColor() }
         btnTestYuvToBitmap.setOnClickListener { testYuvToBitmap() }
         btnTestJob.setOnClickListener { testJob() }
+        btnTestFillMosaic.setOnClickListener { testFillMosaic() }
         btnTestCopyTask.setOnClickListener { testCopyTask() }
         btnTestResizeTask.setOnClickListener { testResizeTask() }
         btnTestCropTask.setOnClickListener { testCropTask() }
@@ -190,6 +197,8 @@ class MainActivity : AppCompatActivity() {
                 Thread.sleep(1000)
                 testYuvToBitmapOnUiThread()
                 Thread.sleep(1000)
+                testFillMosaicOnUiThread()
+                Thread.sleep(1000)
 
                 // Run new Multi-task Job test
                 testJobOnUiThread()
@@ -345,6 +354,46 @@ class MainActivity : AppCompatActivity() {
         }.start()
     }
 
+    private fun testFillMosaicOnUiThread() {
+        runOnUiThread { testFillMosaic() }
+    }
+
+    private fun testFillMosaic() {
+        updateResultTextOnUiThread("Running Fill/Rectangle/Mosaic test...")
+        Thread {
+            try {
+                val srcBitmap = originalBitmap ?: return@Thread
+                val dstBitmap = srcBitmap.copy(Bitmap.Config.ARGB_8888, true)
+                val dstBuffer = Rga.createRgaBufferFromBitmap(dstBitmap)
+
+                // Colors are 0xAABBGGRR
+                var result = Rga.imfill(dstBuffer, Rga.RgaRect(20, 20, 80, 80), 0xff0000ff.toInt())
+                if (result == Rga.IM_STATUS_SUCCESS) {
+                    result = Rga.imrectangleArray(
+                        dstBuffer,
+                        arrayOf(Rga.RgaRect(150, 20, 100, 60), Rga.RgaRect(280, 20, 100, 60)),
+                        0xff00ff00.toInt(),
+                        4
+                    )
+                }
+                if (result == Rga.IM_STATUS_SUCCESS) {
+                    result = Rga.immosaic(dstBuffer, Rga.RgaRect(100, 150, 200, 200), Rga.IM_MOSAIC_16)
+                }
+
+                if (result == Rga.IM_STATUS_SUCCESS) {
+                    Rga.copyRgaBufferToBitmap(dstBuffer, dstBitmap)
+                    updateProcessedBitmapWithErrorHandling(dstBitmap)
+                    updateResultTextOnUiThread("Fill/Rectangle/Mosaic test: SUCCESS")
+                } else {
+                    updateResultTextOnUiThread("Fill/Rectangle/Mosaic test: FAILED (result: $result)")
+                }
+            } catch (e: Exception) {
+                Log.e("MainActivity", "Error in testFillMosaic", e)
+                updateResultTextOnUiThread("Fill/Rectangle/Mosaic test: ERROR - ${e.message}")
+            }
+        }.start()
+    }
+
     private fun testCopyOnUiThread() {
         runOnUiThread { testCopy() }
     }
@@ -14,6 +14,7 @@ object Rga {
 
     // Constants from RgaUtils.h / im2d_type.h (Simplified for common usage)
     const val IM_STATUS_SUCCESS = 1
+    const val IM_STATUS_NOERROR = 2
 
     // Rotation
     const val IM_HAL_TRANSFORM_ROT_90     = 1 shl 0
@@ -36,24 +37,106 @@ object Rga {
     const val IM_ALPHA_BLEND_DST_ATOP     = 1 shl 15
     const val IM_ALPHA_BLEND_XOR          = 1 shl 16
 
-    // Common Formats (Add more as needed from rk_drm_rga.h or similar)
-    const val RK_FORMAT_RGBA_8888 = 0x0
-    const val RK_FORMAT_RGBX_8888 = 0x1
-    const val RK_FORMAT_RGB_888 = 0x2
-    const val RK_FORMAT_BGRA_8888 = 0x3
-    const val RK_FORMAT_RGB_565 = 0x4
-    const val RK_FORMAT_RGBA_5551 = 0x5
-    const val RK_FORMAT_RGBA_4444 = 0x6
-    const val RK_FORMAT_BGR_888 = 0x7
-
-    const val RK_FORMAT_YCbCr_422_SP = 0x8
-    const val RK_FORMAT_YCbCr_422_P  = 0x9
-    const val RK_FORMAT_YCbCr_420_SP = 0xa
-    const val RK_FORMAT_YCbCr_420_P  = 0xb
-    const val RK_FORMAT_YCrCb_422_SP = 0xc
-    const val RK_FORMAT_YCrCb_422_P  = 0xd
-    const val RK_FORMAT_YCrCb_420_SP = 0xe
-    const val RK_FORMAT_YCrCb_420_P  = 0xf
+    // Pixel formats, same values as rga.h (id << 8). The native side still
+    // accepts the bare ids older releases of this file declared.
+    const val RK_FORMAT_RGBA_8888 = 0x0 shl 8
+    const val RK_FORMAT_RGBX_8888 = 0x1 shl 8
+    const val RK_FORMAT_RGB_888 = 0x2 shl 8
+    const val RK_FORMAT_BGRA_8888 = 0x3 shl 8
+    const val RK_FORMAT_RGB_565 = 0x4 shl 8
+    const val RK_FORMAT_RGBA_5551 = 0x5 shl 8
+    const val RK_FORMAT_RGBA_4444 = 0x6 shl 8
+    const val RK_FORMAT_BGR_888 = 0x7 shl 8
+    const val RK_FORMAT_BGRX_8888 = 0x16 shl 8
+    const val RK_FORMAT_BGR_565 = 0x24 shl 8
+    const val RK_FORMAT_BGRA_5551 = 0x25 shl 8
+    const val RK_FORMAT_BGRA_4444 = 0x26 shl 8
+    const val RK_FORMAT_ARGB_8888 = 0x28 shl 8
+    const val RK_FORMAT_XRGB_8888 = 0x29 shl 8
+    const val RK_FORMAT_ABGR_8888 = 0x2c shl 8
+    const val RK_FORMAT_XBGR_8888 = 0x2d shl 8
+    const val RK_FORMAT_A8 = 0x31 shl 8
+
+    const val RK_FORMAT_YCbCr_422_SP = 0x8 shl 8
+    const val RK_FORMAT_YCbCr_422_P  = 0x9 shl 8
+    const val RK_FORMAT_YCbCr_420_SP = 0xa shl 8
+    const val RK_FORMAT_YCbCr_420_P  = 0xb shl 8
+    const val RK_FORMAT_YCrCb_422_SP = 0xc shl 8
+    const val RK_FORMAT_YCrCb_422_P  = 0xd shl 8
+    const val RK_FORMAT_YCrCb_420_SP = 0xe shl 8
+    const val RK_FORMAT_YCrCb_420_P  = 0xf shl 8
+    const val RK_FORMAT_YCbCr_400    = 0x15 shl 8
+    const val RK_FORMAT_YUYV_422     = 0x1c shl 8
+    const val RK_FORMAT_UYVY_422     = 0x1e shl 8
+    const val RK_FORMAT_YCbCr_420_SP_10B = 0x20 shl 8
+    const val RK_FORMAT_YCrCb_420_SP_10B = 0x21 shl 8
+    const val RK_FORMAT_YCbCr_422_SP_10B = 0x22 shl 8
+    const val RK_FORMAT_YCrCb_422_SP_10B = 0x23 shl 8
+    const val RK_FORMAT_YCbCr_444_SP = 0x32 shl 8
+    const val RK_FORMAT_YCrCb_444_SP = 0x33 shl 8
+    const val RK_FORMAT_Y8           = 0x34 shl 8
+
+    // CPU-only 10-bit formats (16-bit samples, 10 bits MSB aligned); never sent to the RGA
+    const val RGA_FORMAT_P010 = 0x100 shl 8
+    const val RGA_FORMAT_P210 = 0x101 shl 8
+
+    // Palette index formats (used as impalette source)
+    const val RK_FORMAT_BPP1 = 0x10 shl 8
+    const val RK_FORMAT_BPP2 = 0x11 shl 8
+    const val RK_FORMAT_BPP4 = 0x12 shl 8
+    const val RK_FORMAT_BPP8 = 0x13 shl 8
+
+    // ROP codes
+    const val IM_ROP_AND     = 0x88
+    const val IM_ROP_OR      = 0xee
+    const val IM_ROP_NOT_DST = 0x55
+    const val IM_ROP_NOT_SRC = 0x33
+    const val IM_ROP_XOR     = 0xf6
+    const val IM_ROP_NOT_XOR = 0xf9
+
+    // Mosaic block sizes
+    const val IM_MOSAIC_8   = 0x0
+    const val IM_MOSAIC_16  = 0x1
+    const val IM_MOSAIC_32  = 0x2
+    const val IM_MOSAIC_64  = 0x3
+    const val IM_MOSAIC_128 = 0x4
+
+    // OSD (imosd), im_osd_t in im2d_type.h
+    const val IM_OSD_MODE_STATISTICS  = 1 shl 0
+    const val IM_OSD_MODE_AUTO_INVERT = 1 shl 1
+    const val IM_OSD_INVERT_CHANNEL_NONE  = 0x0
+    const val IM_OSD_INVERT_CHANNEL_Y_G   = 1 shl 0
+    const val IM_OSD_INVERT_CHANNEL_C_RB  = 1 shl 1
+    const val IM_OSD_INVERT_CHANNEL_ALPHA = 1 shl 2
+    const val IM_OSD_INVERT_CHANNEL_COLOR = IM_OSD_INVERT_CHANNEL_Y_G or IM_OSD_INVERT_CHANNEL_C_RB
+    const val IM_OSD_INVERT_CHANNEL_BOTH  = IM_OSD_INVERT_CHANNEL_COLOR or IM_OSD_INVERT_CHANNEL_ALPHA
+    const val IM_OSD_FLAGS_INTERNAL = 0
+    const val IM_OSD_FLAGS_EXTERNAL = 1
+    const val IM_OSD_INVERT_USE_FACTOR = 0
+    const val IM_OSD_INVERT_USE_SWAP   = 1
+    const val IM_OSD_BACKGROUND_DEFAULT_BRIGHT = 0
+    const val IM_OSD_BACKGROUND_DEFAULT_DARK   = 1
+    const val IM_OSD_BLOCK_MODE_NORMAL    = 0
+    const val IM_OSD_BLOCK_MODE_DIFFERENT = 1
+    const val IM_OSD_MODE_HORIZONTAL = 0
+    const val IM_OSD_MODE_VERTICAL   = 1
+    const val IM_OSD_COLOR_PIXEL    = 0
+    const val IM_OSD_COLOR_EXTERNAL = 1
+
+    // Border types (Gaussian blur)
+    const val IM_BORDER_CONSTANT = 0
+    const val IM_BORDER_REFLECT  = 2
+    const val IM_BORDER_WRAP     = 3
+
+    // Tensor layouts (prepareTensor)
+    const val RGA_TENSOR_NHWC = 0
+    const val RGA_TENSOR_NCHW = 1
+
+    // Returned by RgaPipeline.submit() when no slot frees up within the timeout
+    const val RGA_PIPELINE_TIMEOUT = 0
+
+    // Status of an RgaScheduler submission dropped to keep up with its deadline
+    const val RGA_SCHEDULER_DROPPED = 3
 
     // Sync modes
     const val IM_SYNC = 1 shl 19
@@ -66,9 +149,18 @@ object Rga {
     const val IM_SCHEDULER_RGA2_CORE0 = 1 shl 2
     const val IM_SCHEDULER_RGA2_CORE1 = 1 shl 3
 
+    // Buffer layouts (RgaBuffer.rdMode), IM_RD_MODE in im2d_type.h
+    const val IM_RASTER_MODE    = 1 shl 0
+    const val IM_AFBC16x16_MODE = 1 shl 1
+    const val IM_TILE8x8_MODE   = 1 shl 2
+    const val IM_TILE4x4_MODE   = 1 shl 3
+    const val IM_RKFBC64x4_MODE = 1 shl 4
+    const val IM_AFBC32x8_MODE  = 1 shl 5
+
     /**
      * Represents an image buffer for RGA.
-     * Use helper methods to construct.
+     * Use helper methods to construct. [rdMode] is the memory layout (IM_*_MODE):
+     * a decoder's AFBC output can be passed as is instead of converting it to raster.
      */
     data class RgaBuffer(
         val width: Int,
@@ -79,7 +171,8 @@ object Rga {
         val fd: Int = -1,
         val handle: Int = 0, // buffer_handle_t
         val ptr: ByteBuffer? = null, // Direct ByteBuffer
-        val hardwareBuffer: Any? = null // android.hardware.HardwareBuffer (Type Any to avoid build issues if class not found in older contexts, but expected HardwareBuffer)
+        val hardwareBuffer: Any? = null, // android.hardware.HardwareBuffer (Type Any to avoid build issues if class not found in older contexts, but expected HardwareBuffer)
+        val rdMode: Int = IM_RASTER_MODE
     )
 
     data class RgaRect(
@@ -89,6 +182,168 @@ object Rga {
         val height: Int
     )
 
+    /**
+     * Per-channel NN quantization: dst = (src + offset) * scale / 256.
+     * scale is 0..1023 (256 = 1.0), offset is -255..255.
+     */
+    data class RgaNn(
+        val scaleR: Int = 256,
+        val scaleG: Int = 256,
+        val scaleB: Int = 256,
+        val offsetR: Int = 0,
+        val offsetG: Int = 0,
+        val offsetB: Int = 0
+    )
+
+    /**
+     * Result of letterbox(): status plus the placement of the scaled image in dst.
+     * Map a dst coordinate back to src with (x - offsetX) / scaleX.
+     */
+    data class RgaLetterbox(
+        val status: Int,
+        val scaleX: Float,
+        val scaleY: Float,
+        val offsetX: Int,
+        val offsetY: Int,
+        val width: Int,
+        val height: Int
+    ) {
+        fun toSrcX(x: Float): Float = (x - offsetX) / scaleX
+        fun toSrcY(y: Float): Float = (y - offsetY) / scaleY
+    }
+
+    /**
+     * One step of an RgaPipeline: the previous stage's output (or the input frame)
+     * is processed into a new width x height image of [format].
+     * Null rects mean the whole image; [usage] takes IM_HAL_TRANSFORM_* flags.
+     * [rdMode] is the layout of the stage output, e.g. IM_AFBC16x16_MODE for a
+     * stage that feeds a display or encoder reading AFBC.
+     */
+    data class RgaPipelineStage(
+        val width: Int,
+        val height: Int,
+        val format: Int,
+        val srcRect: RgaRect? = null,
+        val dstRect: RgaRect? = null,
+        val usage: Int = 0,
+        val rdMode: Int = IM_RASTER_MODE
+    )
+
+    /**
+     * One operation of an RgaScheduler submission: [src] (or [srcRect] of it)
+     * scaled into [dstRect] of [dst]. Null rects mean the whole image; [usage]
+     * takes IM_HAL_TRANSFORM_* flags. Formats are converted as needed.
+     */
+    data class RgaSchedulerTask(
+        val src: RgaBuffer,
+        val dst: RgaBuffer,
+        val srcRect: RgaRect? = null,
+        val dstRect: RgaRect? = null,
+        val usage: Int = 0
+    )
+
+    /** One image for imresizeAtlas(): [src] (or [srcRect] of it) scaled to width x height. */
+    data class RgaAtlasItem(
+        val src: RgaBuffer,
+        val width: Int,
+        val height: Int,
+        val srcRect: RgaRect? = null
+    )
+
+    /** Result of imresizeAtlas(): item i was written to rects[i] of [atlas]; [height] rows are used. */
+    data class RgaAtlas(
+        val status: Int,
+        val atlas: RgaBuffer,
+        val rects: List<RgaRect>,
+        val height: Int
+    ) {
+        /**
+         * Item i as a buffer sharing the atlas memory (wstride of the atlas), or
+         * null if the atlas is not a single-plane ByteBuffer image.
+         */
+        fun view(i: Int): RgaBuffer? {
+            val info = formatInfo(atlas.format) ?: return null
+            val ptr = atlas.ptr ?: return null
+            if (info.planes != 1 || info.bits[0] % 8 != 0) return null
+            val r = rects[i]
+            val bpp = info.bits[0] / 8
+            val offset = (r.y * atlas.wstride + r.x) * bpp
+            val size = ((r.height - 1) * atlas.wstride + r.width) * bpp
+            val slice = ptr.duplicate().apply { position(offset); limit(offset + size) }.slice()
+            return RgaBuffer(r.width, r.height, atlas.format, atlas.wstride, r.height, ptr = slice)
+        }
+    }
+
+    /**
+     * OSD block layout: [count] blocks of [width] pixels (even) along [direction]
+     * from the OSD rect origin; with IM_OSD_BLOCK_MODE_DIFFERENT, [width] is the
+     * index of a width table in the RGA instead. [background] is the background
+     * the OSD colours are meant for (IM_OSD_BACKGROUND_DEFAULT_*).
+     * IM_OSD_COLOR_EXTERNAL draws [normalColor] / [invertColor] (0xAABBGGRR)
+     * with the OSD image as coverage instead of its own colours.
+     */
+    data class RgaOsdBlock(
+        val width: Int,
+        val count: Int,
+        val direction: Int = IM_OSD_MODE_HORIZONTAL,
+        val background: Int = IM_OSD_BACKGROUND_DEFAULT_DARK,
+        val colorMode: Int = IM_OSD_COLOR_PIXEL,
+        val normalColor: Int = 0xFFFFFFFF.toInt(),
+        val invertColor: Int = 0xFF000000.toInt(),
+        val widthMode: Int = IM_OSD_BLOCK_MODE_NORMAL
+    )
+
+    /** Inverted channel value = max(min, max - value), per channel group. */
+    data class RgaOsdInvertFactor(
+        val alphaMax: Int = 255,
+        val alphaMin: Int = 0,
+        val ygMax: Int = 255,
+        val ygMin: Int = 0,
+        val crbMax: Int = 255,
+        val crbMin: Int = 0
+    )
+
+    /**
+     * Auto-invert settings: a block is bright when the mean luma under it is
+     * above [threshold]. Flags come from a statistics pass stored in the RGA at
+     * [flagsIndex] (IM_OSD_FLAGS_INTERNAL) or from [flags] (IM_OSD_FLAGS_EXTERNAL,
+     * bit i = block i is bright, e.g. from osdStatistics()).
+     */
+    data class RgaOsdInvert(
+        val channel: Int = IM_OSD_INVERT_CHANNEL_COLOR,
+        val threshold: Int = 128,
+        val mode: Int = IM_OSD_INVERT_USE_FACTOR,
+        val factor: RgaOsdInvertFactor = RgaOsdInvertFactor(),
+        val flagsMode: Int = IM_OSD_FLAGS_INTERNAL,
+        val flagsIndex: Int = 0,
+        val flags: Long = 0
+    )
+
+    /** Colour table of RK_FORMAT_RGBA2BPP OSD images: one colour bit and one alpha bit per pixel. */
+    data class RgaOsdBpp2(
+        val color0: Int,
+        val color1: Int,
+        val acSwap: Boolean = false,
+        val littleEndian: Boolean = true
+    )
+
+    /** im_osd_t: [mode] is a mask of IM_OSD_MODE_STATISTICS / IM_OSD_MODE_AUTO_INVERT. */
+    data class RgaOsdConfig(
+        val mode: Int,
+        val block: RgaOsdBlock,
+        val invert: RgaOsdInvert = RgaOsdInvert(),
+        val bpp2: RgaOsdBpp2? = null
+    )
+
+    /** Result of osdStatistics(): mean luma per block and the bright flags (bit i = block i). */
+    data class RgaOsdStatistics(
+        val status: Int,
+        val flags: Long,
+        val luma: IntArray
+    ) {
+        fun isBright(block: Int): Boolean = (flags shr block) and 1L != 0L
+    }
+
     // --- Native Methods ---
 
     /**
@@ -200,24 +455,594 @@ object Rga {
 
     /**
      * Convert color format.
+     * 10-bit sources (RK_FORMAT_*_SP_10B, RGA_FORMAT_P010/P210) that the RGA
+     * cannot read are converted on the CPU instead; see [setTenBitDither].
      */
     external fun imcvtcolor(src: RgaBuffer, dst: RgaBuffer, sfmt: Int, dfmt: Int): Int
 
+    /** Dither the CPU 10 -> 8 bit conversion of [imcvtcolor] (off by default). */
+    external fun setTenBitDither(enabled: Boolean)
+
+    /**
+     * Convert a 10-bit YUV image to 8-bit NV12/NV21/NV16/NV61 or RGB of the same
+     * size with the CPU (NEON) kernels, bypassing the RGA. No tone mapping is
+     * applied; [dither] uses a 2x2 ordered dither against banding.
+     */
+    external fun convertTenBitCpu(src: RgaBuffer, dst: RgaBuffer, dither: Boolean = false): Int
+
     /**
      * Add an image format conversion operation to the specified job.
      */
     external fun imcvtcolorTask(jobHandle: Long, src: RgaBuffer, dst: RgaBuffer, sfmt: Int, dfmt: Int): Int
 
+    private external fun improcessArrayNative(
+        src: ByteArray, width: Int, height: Int, format: Int, dst: RgaBuffer, srcRect: RgaRect?, dstRect: RgaRect?,
+        usage: Int, pin: Boolean
+    ): Int
+    private external fun improcessArrayTaskNative(
+        jobHandle: Long, src: ByteArray, width: Int, height: Int, format: Int, dst: RgaBuffer,
+        srcRect: RgaRect?, dstRect: RgaRect?, usage: Int
+    ): Int
+
+    /**
+     * Process a tightly packed [width] x [height] frame held in a ByteArray,
+     * e.g. NV21 from a camera preview callback, into [dstRect] of [dst] (null
+     * rects mean the whole image) without first copying it into a direct
+     * ByteBuffer. [pin] lets the RGA read the array in place, pinned with
+     * GetPrimitiveArrayCritical for the call, which holds off the GC until
+     * the RGA is done. Pass false to copy the frame into a pooled native
+     * buffer instead. Always synchronous; fails with IM_STATUS_INVALID_PARAM
+     * if [src] is too short for the frame.
+     */
+    fun improcess(
+        src: ByteArray, width: Int, height: Int, dst: RgaBuffer, format: Int = RK_FORMAT_YCrCb_420_SP,
+        srcRect: RgaRect? = null, dstRect: RgaRect? = null, usage: Int = 0, pin: Boolean = true
+    ): Int = improcessArrayNative(src, width, height, format, dst, srcRect, dstRect, usage, pin)
+
+    /** Convert a ByteArray frame (NV21 by default) to dst's format; see the ByteArray [improcess]. */
+    fun imcvtcolor(
+        src: ByteArray, width: Int, height: Int, dst: RgaBuffer, sfmt: Int = RK_FORMAT_YCrCb_420_SP,
+        pin: Boolean = true
+    ): Int = improcessArrayNative(src, width, height, sfmt, dst, null, null, 0, pin)
+
+    /** Resize a ByteArray frame (NV21 by default) to dst; see the ByteArray [improcess]. */
+    fun imresize(
+        src: ByteArray, width: Int, height: Int, dst: RgaBuffer, format: Int = RK_FORMAT_YCrCb_420_SP,
+        pin: Boolean = true
+    ): Int = improcessArrayNative(src, width, height, format, dst, null, null, 0, pin)
+
+    /**
+     * Add a conversion of a ByteArray frame to the specified job. The job runs
+     * later, so the frame is copied into a pooled native buffer held until
+     * [imendJob] or [imcancelJob], and [src] may be reused right away. A job
+     * holding such copies is always ended synchronously.
+     */
+    fun imcvtcolorTask(
+        jobHandle: Long, src: ByteArray, width: Int, height: Int, dst: RgaBuffer,
+        sfmt: Int = RK_FORMAT_YCrCb_420_SP
+    ): Int = improcessArrayTaskNative(jobHandle, src, width, height, sfmt, dst, null, null, 0)
+
+    /**
+     * Crop each rect from src and resize it to outWidth x outHeight, all in one job.
+     * A job holds at most 50 tasks (librga's limit), so larger batches return
+     * IM_STATUS_INVALID_PARAM without writing anything; split them in the caller.
+     * Crop i is written to rows [i * outHeight, (i + 1) * outHeight) of dstTensor, so a
+     * dstTensor of outWidth x (outHeight * rects.size) holds the batch contiguously.
+     * The dst format may differ from src (e.g. NV12 -> RGB_888).
+     */
+    external fun cropResizeBatch(src: RgaBuffer, rects: Array<RgaRect>, outWidth: Int, outHeight: Int, dstTensor: RgaBuffer): Int
+
+    private external fun imresizeAtlasNative(items: Array<RgaAtlasItem>, atlas: RgaBuffer, padding: Int, rects: IntArray): Int
+
+    /**
+     * Pack items into [atlas] (skyline packer, tallest first, [padding] pixels
+     * apart) and scale them all in one job per 50 items instead of one call
+     * each, e.g. for thumbnail strips or sprite sheets. Sizes must follow the
+     * atlas format's rectAlign. Fails with IM_STATUS_INVALID_PARAM if they do
+     * not fit. Pixels between items are left as they were.
+     */
+    fun imresizeAtlas(items: List<RgaAtlasItem>, atlas: RgaBuffer, padding: Int = 0): RgaAtlas {
+        val values = IntArray(items.size * 4)
+        val status = imresizeAtlasNative(items.toTypedArray(), atlas, padding, values)
+        val rects = items.indices.map { i -> RgaRect(values[4 * i], values[4 * i + 1], values[4 * i + 2], values[4 * i + 3]) }
+        return RgaAtlas(status, atlas, rects, rects.maxOfOrNull { it.y + it.height } ?: 0)
+    }
+
+    // --- RGA2-only operations ---
+    // RGA3 cannot fill, draw, mosaic, ROP, palette or OSD, so with RGA3 forced these run on the CPU.
+    // Colors are 0xAABBGGRR (R in the lowest byte).
+
+    /**
+     * Fill rect of dst with color.
+     */
+    external fun imfill(dst: RgaBuffer, rect: RgaRect, color: Int): Int
+
+    /**
+     * Fill every rect of dst with color.
+     */
+    external fun imfillArray(dst: RgaBuffer, rects: Array<RgaRect>, color: Int): Int
+
+    /**
+     * Draw a rectangle outline of the given thickness, or a filled rectangle when thickness < 0.
+     */
+    external fun imrectangle(dst: RgaBuffer, rect: RgaRect, color: Int, thickness: Int): Int
+
+    /**
+     * Draw several rectangles, see [imrectangle].
+     */
+    external fun imrectangleArray(dst: RgaBuffer, rects: Array<RgaRect>, color: Int, thickness: Int): Int
+
+    /**
+     * Mosaic rect of image in place.
+     * mode: One of IM_MOSAIC_*
+     */
+    external fun immosaic(image: RgaBuffer, rect: RgaRect, mode: Int): Int
+
+    /**
+     * Mosaic every rect of image in place.
+     */
+    external fun immosaicArray(image: RgaBuffer, rects: Array<RgaRect>, mode: Int): Int
+
+    /**
+     * Raster operation dst = rop(src, dst).
+     * ropCode: One of IM_ROP_*
+     */
+    external fun imrop(src: RgaBuffer, dst: RgaBuffer, ropCode: Int): Int
+
+    /**
+     * Expand an RK_FORMAT_BPP* index image through lut into dst.
+     */
+    external fun impalette(src: RgaBuffer, dst: RgaBuffer, lut: RgaBuffer): Int
+
+    private external fun imosdNative(
+        osd: RgaBuffer, dst: RgaBuffer, osdRect: RgaRect, params: IntArray, invertFlags: Long, cpu: Boolean
+    ): Int
+    private external fun osdStatisticsNative(
+        dst: RgaBuffer, osdRect: RgaRect, params: IntArray, luma: IntArray, flags: LongArray
+    ): Int
+
+    // Must match RGA_JNI_OSD_PARAMS in librga_jni.cpp
+    private fun packOsdConfig(config: RgaOsdConfig): IntArray {
+        val b = config.block
+        val i = config.invert
+        val f = i.factor
+        val p = config.bpp2
+        return intArrayOf(
+            config.mode,
+            b.widthMode, b.width, b.count, b.background, b.direction, b.colorMode, b.normalColor, b.invertColor,
+            i.channel, i.flagsMode, i.flagsIndex, i.mode, i.threshold,
+            f.alphaMax, f.alphaMin, f.ygMax, f.ygMin, f.crbMax, f.crbMin,
+            if (p?.acSwap == true) 1 else 0, if (p?.littleEndian != false) 1 else 0, p?.color0 ?: 0, p?.color1 ?: 0
+        )
+    }
+
+    /**
+     * Blend the osd image (RGBA, or RK_FORMAT_RGBA2BPP with [RgaOsdConfig.bpp2])
+     * over osdRect of dst, inverting the blocks whose background brightness does
+     * not match [RgaOsdBlock.background] in IM_OSD_MODE_AUTO_INVERT, so text
+     * stays readable without a CPU pass over the frame. [cpu] (or RGA3 forced)
+     * runs the CPU reference, which emulates the RGA's flag store for
+     * IM_OSD_FLAGS_INTERNAL but has no width tables (IM_OSD_BLOCK_MODE_DIFFERENT).
+     */
+    fun imosd(osd: RgaBuffer, dst: RgaBuffer, osdRect: RgaRect, config: RgaOsdConfig, cpu: Boolean = false): Int =
+        imosdNative(osd, dst, osdRect, packOsdConfig(config), config.invert.flags, cpu)
+
+    /**
+     * Per-block mean luma of dst under osdRect and the resulting bright flags,
+     * computed on the CPU the way the statistics mode does (Y samples of YUV
+     * frames, BT.601 luma of RGB). Usable as IM_OSD_FLAGS_EXTERNAL flags.
+     */
+    fun osdStatistics(dst: RgaBuffer, osdRect: RgaRect, config: RgaOsdConfig): RgaOsdStatistics {
+        val luma = IntArray(config.block.count.coerceIn(0, 64))
+        val flags = LongArray(1)
+        val status = osdStatisticsNative(dst, osdRect, packOsdConfig(config), luma, flags)
+        return RgaOsdStatistics(status, flags[0], luma)
+    }
+
+    /**
+     * Gaussian blur. src and dst must have the same size and format.
+     * Sigmas of 0 are derived from the kernel size; matrix (ksizeWidth * ksizeHeight, row major)
+     * overrides the sigmas. Runs on the RGA only when RGA2 cores are scheduled and borderType is
+     * IM_BORDER_REFLECT, otherwise on the CPU.
+     * borderType: One of IM_BORDER_*
+     */
+    external fun imgaussianBlur(
+        src: RgaBuffer,
+        dst: RgaBuffer,
+        ksizeWidth: Int,
+        ksizeHeight: Int,
+        sigmaX: Double = 0.0,
+        sigmaY: Double = 0.0,
+        matrix: DoubleArray? = null,
+        borderType: Int = IM_BORDER_REFLECT
+    ): Int
+
+    /**
+     * Crop srcRect from src, resize it into dstRect of tensor, convert to the tensor format
+     * (RK_FORMAT_RGB_888 / RK_FORMAT_BGR_888, which sets the channel order) and quantize with nn,
+     * in as few RGA passes as the core allows. Falls back to the CPU.
+     * Null rects select the whole image. NCHW tensors hold three wstride x hstride planes.
+     * layout: RGA_TENSOR_NHWC or RGA_TENSOR_NCHW
+     */
+    external fun prepareTensor(
+        src: RgaBuffer,
+        tensor: RgaBuffer,
+        srcRect: RgaRect? = null,
+        dstRect: RgaRect? = null,
+        layout: Int = RGA_TENSOR_NHWC,
+        nn: RgaNn? = null
+    ): Int
+
+    /**
+     * Pad src to dst: top/bottom/left/right pixels of border around a copy of src.
+     * borderType: One of IM_BORDER_*; value is the 0xAABBGGRR color for IM_BORDER_CONSTANT.
+     */
+    external fun immakeBorder(
+        src: RgaBuffer,
+        dst: RgaBuffer,
+        top: Int,
+        bottom: Int,
+        left: Int,
+        right: Int,
+        borderType: Int,
+        value: Int = 0
+    ): Int
+
+    /**
+     * Aspect-preserving resize of src into the center of dst, filling only the
+     * uncovered strips with padColor (0xAABBGGRR). Offsets and size are rounded
+     * down to multiples of align (keep it even for YUV).
+     */
+    external fun letterbox(src: RgaBuffer, dst: RgaBuffer, padColor: Int = 0, align: Int = 2): RgaLetterbox
+
+    // --- Instrumentation ---
+
+    /** Latency summary in nanoseconds (percentiles have ~6% resolution). */
+    data class RgaLatency(
+        val count: Long,
+        val totalNs: Long,
+        val p50Ns: Long,
+        val p90Ns: Long,
+        val p99Ns: Long,
+        val p999Ns: Long,
+        val maxNs: Long
+    ) {
+        val meanNs: Long get() = if (count == 0L) 0 else totalNs / count
+    }
+
+    /**
+     * Counters of one operation type since the last statsReset().
+     * latency: call entry to result (submission only for IM_ASYNC jobs).
+     * completion: submission to hardware completion, taken from release fences
+     * (imendJob(IM_ASYNC) and RgaPipeline frames).
+     * failuresByStatus: IM_STATUS code -> count.
+     */
+    data class RgaOpStats(
+        val op: String,
+        val count: Long,
+        val failures: Long,
+        val bytesIn: Long,
+        val bytesOut: Long,
+        val pixels: Long,
+        val latency: RgaLatency,
+        val completion: RgaLatency,
+        val failuresByStatus: Map<Int, Long>
+    ) {
+        /** Output megapixels per second of busy time (successful calls only). */
+        val megapixelsPerSecond: Double
+            get() = if (latency.totalNs == 0L) 0.0 else pixels * 1000.0 / latency.totalNs
+    }
+
+    /** Enable or disable recording. Disabled recording costs one atomic load per call. */
+    external fun statsSetEnabled(enabled: Boolean)
+
+    /** Clear all counters and histograms. */
+    external fun statsReset()
+
+    private external fun statsOpNames(): Array<String>
+    private external fun statsSnapshotNative(): LongArray
+
+    // Must match rga_stats.h
+    private const val STATS_FIELDS = 28
+    private const val STATS_LATENCY = 5
+    private const val STATS_COMPLETION = 12
+    private const val STATS_STATUS = 19
+    private const val STATS_STATUS_MIN = -6
+    private const val STATS_STATUS_COUNT = 9
+
+    /** Snapshot of every operation type that has been called at least once. */
+    fun statsSnapshot(): List<RgaOpStats> {
+        val names = statsOpNames()
+        val values = statsSnapshotNative()
+        fun latency(base: Int) = RgaLatency(
+            values[base], values[base + 1], values[base + 2], values[base + 3],
+            values[base + 4], values[base + 5], values[base + 6]
+        )
+        return names.indices.mapNotNull { op ->
+            val base = op * STATS_FIELDS
+            if (values[base] == 0L) return@mapNotNull null
+            val byStatus = (0 until STATS_STATUS_COUNT)
+                .filter { values[base + STATS_STATUS + it] != 0L }
+                .associate { (it + STATS_STATUS_MIN) to values[base + STATS_STATUS + it] }
+            RgaOpStats(
+                op = names[op],
+                count = values[base],
+                failures = values[base + 1],
+                bytesIn = values[base + 2],
+                bytesOut = values[base + 3],
+                pixels = values[base + 4],
+                latency = latency(base + STATS_LATENCY),
+                completion = latency(base + STATS_COMPLETION),
+                failuresByStatus = byStatus
+            )
+        }
+    }
+
+    /**
+     * Start recording every RGA submission (begin/end, job, buffers, usage, core, status)
+     * into per-thread ring buffers of [capacityPerThread] events. Clears the previous trace.
+     */
+    external fun traceStart(capacityPerThread: Int = 4096)
+
+    /** Stop recording; the rings keep their contents until the next traceStart(). */
+    external fun traceStop()
+
+    /** The recorded trace as Chrome trace JSON, loadable in ui.perfetto.dev or chrome://tracing. */
+    external fun traceDumpJson(): String
+
+    // --- Small-image CPU fast path ---
+    // Small synchronous calls on ByteBuffer-backed images run on the CPU when the
+    // calibrated table (rga_crossover.h) says that beats the RGA round trip.
+
+    // Op classes of the crossover table
+    const val RGA_CROSSOVER_COPY = 0
+    const val RGA_CROSSOVER_RESIZE = 1
+    const val RGA_CROSSOVER_CVTCOLOR = 2
+    const val RGA_CROSSOVER_TRANSFORM = 3
+    const val RGA_CROSSOVER_BLEND = 4
+
+    /** Measured cost of one op class for images up to maxSide x maxSide; 0 ns = not measured. */
+    data class RgaCrossover(
+        val op: Int,
+        val maxSide: Int,
+        val rgaNs: Long,
+        val cpuNs: Long
+    ) {
+        val useCpu: Boolean
+            get() = rgaNs > 0 && cpuNs > 0 && cpuNs < rgaNs
+    }
+
+    /** Turn the CPU fast path on or off (on by default; it does nothing until a table is loaded or measured). */
+    external fun setCpuFastPath(enabled: Boolean)
+
+    /** Measure RGA and CPU time per op class and size bucket (median of [iterations]); takes about a second. */
+    external fun calibrateCpuFastPath(iterations: Int = 20): Int
+
+    /** Write the table to [path]; [key] identifies the device and system (e.g. Build.FINGERPRINT). */
+    external fun saveCpuFastPath(path: String, key: String): Boolean
+
+    /** Read a table written by [saveCpuFastPath]; false if missing, corrupt or saved under another [key]. */
+    external fun loadCpuFastPath(path: String, key: String): Boolean
+
+    private external fun cpuFastPathTableNative(): LongArray
+
+    // Must match rga_crossover.h
+    private const val CROSSOVER_BUCKETS = 6
+    private const val CROSSOVER_MIN_SIDE = 16
+
+    val cpuFastPathTable: List<RgaCrossover>
+        get() {
+            val v = cpuFastPathTableNative()
+            return (0 until v.size / 2).map { i ->
+                RgaCrossover(i / CROSSOVER_BUCKETS, CROSSOVER_MIN_SIDE shl (i % CROSSOVER_BUCKETS), v[2 * i], v[2 * i + 1])
+            }
+        }
+
+    /**
+     * Load the table from [file], or measure it once and save it there.
+     * Returns false only if calibration failed.
+     */
+    fun initCpuFastPath(file: java.io.File, key: String = android.os.Build.FINGERPRINT): Boolean {
+        if (loadCpuFastPath(file.path, key)) return true
+        if (calibrateCpuFastPath() != IM_STATUS_SUCCESS) return false
+        if (!saveCpuFastPath(file.path, key)) Log.w("Rga", "Could not save ${file.path}")
+        return true
+    }
+
+    /**
+     * Layout of one RK_FORMAT_*, read from the native format table (rga_format.h).
+     * bits: per pixel on plane 0, per subsampled element on the chroma planes.
+     * rectAlign: x, y, width and height must be multiples of it.
+     * strideAlign: wstride multiple, in pixels, the RGA is happiest with.
+     */
+    data class RgaFormatInfo(
+        val format: Int,
+        val name: String,
+        val planes: Int,
+        val bits: List<Int>,
+        val xshift: Int,
+        val yshift: Int,
+        val rectAlign: Int,
+        val strideAlign: Int,
+        val hasAlpha: Boolean,
+        val isYuv: Boolean,
+        val isTenBit: Boolean,
+        val byteSamples: Boolean
+    ) {
+        /** Bytes of a wstride x hstride image. */
+        fun imageSize(wstride: Int, hstride: Int): Int = Rga.imageSize(format, wstride, hstride)
+
+        /** Smallest wstride >= width that follows strideAlign. */
+        fun alignStride(width: Int): Int = (width + strideAlign - 1) / strideAlign * strideAlign
+    }
+
+    private external fun formatTableNative(): IntArray
+    private external fun formatNames(): Array<String>
+
+    // Must match librga_jni.cpp
+    private const val FORMAT_FIELDS = 13
+
+    private val formatTable: Map<Int, RgaFormatInfo> by lazy {
+        val names = formatNames()
+        val values = formatTableNative()
+        names.indices.mapNotNull { i ->
+            val base = i * FORMAT_FIELDS
+            if (values[base + 1] == 0) return@mapNotNull null
+            RgaFormatInfo(
+                format = values[base],
+                name = names[i],
+                planes = values[base + 1],
+                bits = listOf(values[base + 2], values[base + 3], values[base + 4]),
+                xshift = values[base + 5],
+                yshift = values[base + 6],
+                rectAlign = values[base + 7],
+                strideAlign = values[base + 8],
+                hasAlpha = values[base + 9] != 0,
+                isYuv = values[base + 10] != 0,
+                isTenBit = values[base + 11] != 0,
+                byteSamples = values[base + 12] != 0
+            )
+        }.associateBy { it.format }
+    }
+
+    /** Layout of format (with or without the "shl 8"), or null if it is not a pixel format. */
+    fun formatInfo(format: Int): RgaFormatInfo? =
+        formatTable[if (format in 1..0xff) format shl 8 else format]
+
+    /**
+     * Bytes to allocate for a wstride x hstride image of format in layout rdMode:
+     * tile-padded for the TILE modes, header plus uncompressed worst case for
+     * the AFBC/RKFBC modes. 0 if the format or mode is unknown.
+     */
+    external fun bufferSize(format: Int, wstride: Int, hstride: Int, rdMode: Int = IM_RASTER_MODE): Long
+
+    /** Bytes of a wstride x hstride raster image of format, 0 if the format is unknown. */
+    external fun imageSize(format: Int, wstride: Int, hstride: Int): Int
+
+    // Backing calls of RgaPipeline
+    internal external fun pipelineCreate(stages: Array<RgaPipelineStage>, depth: Int, outputSlots: Int): Long
+    internal external fun pipelineSubmit(handle: Long, input: RgaBuffer, acquireFence: Int, tag: Long, timeoutMs: Int): Int
+    internal external fun pipelineDequeueNative(handle: Long, timeoutMs: Int, meta: LongArray): ByteBuffer?
+    internal external fun pipelineRecycle(handle: Long, slot: Int)
+    internal external fun pipelineFlush(handle: Long)
+    internal external fun pipelineDestroy(handle: Long)
+
+    // Backing calls of RgaScheduler
+    internal external fun schedulerCreate(workers: Int): Long
+    internal external fun schedulerAddStream(handle: Long, maxQueued: Int): Int
+    internal external fun schedulerSubmit(
+        handle: Long, stream: Int, tasks: Array<RgaSchedulerTask>, deadlineNs: Long, tag: Long
+    ): Int
+    internal external fun schedulerPollNative(handle: Long, timeoutMs: Int, meta: LongArray): Boolean
+    internal external fun schedulerStatsNative(handle: Long, stream: Int): LongArray
+    internal external fun schedulerFlush(handle: Long)
+    internal external fun schedulerDestroy(handle: Long)
+
+    // Backing calls of RgaOsdText
+    internal external fun osdTextCreate(atlasWidth: Int, atlasHeight: Int, maxCached: Int): Long
+    internal external fun osdTextSetMetrics(handle: Long, ascent: Int, lineHeight: Int)
+    internal external fun osdTextAddGlyph(
+        handle: Long, codepoint: Int, coverage: ByteArray, width: Int, height: Int, left: Int, top: Int, advance: Int
+    ): Int
+    internal external fun osdTextMeasure(handle: Long, text: String, padding: Int): IntArray
+    internal external fun osdTextDraw(handle: Long, dst: RgaBuffer, texts: Array<String>, params: IntArray, cpu: Boolean): Int
+    internal external fun osdTextStatsNative(handle: Long): LongArray
+    internal external fun osdTextClearCache(handle: Long)
+    internal external fun osdTextDestroy(handle: Long)
+
+    // Backing calls of RgaSliceProgress
+    internal external fun sliceProgressCreate(): Long
+    internal external fun sliceProgressRows(handle: Long): Int
+    internal external fun sliceProgressTotalRows(handle: Long): Int
+    internal external fun sliceProgressStatus(handle: Long): Int
+    internal external fun sliceProgressWait(handle: Long, rows: Int, timeoutMs: Int): Boolean
+    internal external fun sliceProgressLatencyNs(handle: Long, rows: Int): Long
+    internal external fun sliceProgressDestroy(handle: Long)
+    internal external fun improcessSlicedNative(
+        handle: Long, src: RgaBuffer, dst: RgaBuffer, srcRect: RgaRect?, dstRect: RgaRect?,
+        usage: Int, writeStart: Int, writeStep: Int
+    ): Int
+
+    // Backing calls of RgaStripeStream
+    internal external fun stripeCreate(srcWidth: Int, srcHeight: Int, srcFormat: Int, minOutputRows: Int): Long
+    internal external fun stripeBegin(handle: Long, dst: RgaBuffer, dstRect: RgaRect?, usage: Int, progress: Long): Int
+    internal external fun stripePush(handle: Long, stripe: RgaBuffer): Int
+    internal external fun stripeAbort(handle: Long)
+    internal external fun stripeInputStep(handle: Long): Int
+    internal external fun stripeOutputStep(handle: Long): Int
+    internal external fun stripeWrittenRows(handle: Long): Int
+    internal external fun stripeStatsNative(handle: Long): LongArray
+    internal external fun stripeDestroy(handle: Long)
+
+    // Backing calls of RgaGraph
+    internal external fun graphCreate(): Long
+    internal external fun graphInput(handle: Long, buffer: RgaBuffer): Int
+    internal external fun graphCrop(handle: Long, node: Int, rect: RgaRect): Int
+    internal external fun graphResize(handle: Long, node: Int, width: Int, height: Int): Int
+    internal external fun graphCvtcolor(handle: Long, node: Int, format: Int): Int
+    internal external fun graphRotate(handle: Long, node: Int, rotation: Int): Int
+    internal external fun graphFlip(handle: Long, node: Int, mode: Int): Int
+    internal external fun graphOutput(handle: Long, node: Int, buffer: RgaBuffer): Int
+    internal external fun graphRebind(handle: Long, node: Int, buffer: RgaBuffer): Int
+    internal external fun graphCompile(handle: Long): Int
+    internal external fun graphRun(handle: Long): Int
+    internal external fun graphStatsNative(handle: Long): LongArray
+    internal external fun graphDestroy(handle: Long)
+
+    // Backing calls of RgaCompositor
+    internal external fun compositorCreate(width: Int, height: Int): Long
+    internal external fun compositorSetLayer(
+        handle: Long, id: Int, buffer: RgaBuffer, srcRect: RgaRect?, dstRect: RgaRect,
+        transform: Int, alpha: Int, zOrder: Int, blend: Boolean
+    ): Int
+    internal external fun compositorRemoveLayer(handle: Long, id: Int)
+    internal external fun compositorDamageLayer(handle: Long, id: Int)
+    internal external fun compositorSetBackground(handle: Long, color: Int)
+    internal external fun compositorCompose(handle: Long, dst: RgaBuffer): Int
+    internal external fun compositorStatsNative(handle: Long): LongArray
+    internal external fun compositorDestroy(handle: Long)
+
+    // Backing calls of RgaIncremental
+    internal external fun incrementalCreate(blockSize: Int): Long
+    internal external fun incrementalProcess(
+        handle: Long, src: RgaBuffer, dst: RgaBuffer, srcRect: RgaRect?, dstRect: RgaRect?,
+        usage: Int, dirty: Array<RgaRect>?
+    ): Int
+    internal external fun incrementalInvalidate(handle: Long)
+    internal external fun incrementalStatsNative(handle: Long): LongArray
+    internal external fun incrementalResetStats(handle: Long)
+    internal external fun incrementalDestroy(handle: Long)
+
+    // Backing calls of RgaFrameReader / RgaFrameWriter
+    internal external fun frameReaderOpen(
+        path: String, width: Int, height: Int, format: Int, wstride: Int, hstride: Int, frameBytes: Long, prefetch: Int
+    ): Long
+    internal external fun frameReaderCount(handle: Long): Int
+    internal external fun frameReaderFrame(handle: Long, index: Int): ByteBuffer?
+    internal external fun frameReaderClose(handle: Long)
+    internal external fun frameWriterOpen(
+        path: String, width: Int, height: Int, format: Int, wstride: Int, hstride: Int, frameBytes: Long, growFrames: Int
+    ): Long
+    internal external fun frameWriterNext(handle: Long): ByteBuffer?
+    internal external fun frameWriterCount(handle: Long): Int
+    internal external fun frameWriterClose(handle: Long): Int
+
     // Helpers to create RgaBuffer
-    fun createBufferFromFd(fd: Int, width: Int, height: Int, format: Int, wstride: Int = width, hstride: Int = height): RgaBuffer {
-        return RgaBuffer(width, height, format, wstride, hstride, fd = fd)
+    fun createBufferFromFd(
+        fd: Int, width: Int, height: Int, format: Int, wstride: Int = width, hstride: Int = height,
+        rdMode: Int = IM_RASTER_MODE
+    ): RgaBuffer {
+        return RgaBuffer(width, height, format, wstride, hstride, fd = fd, rdMode = rdMode)
     }
 
-    fun createBufferFromByteBuffer(buffer: ByteBuffer, width: Int, height: Int, format: Int, wstride: Int = width, hstride: Int = height): RgaBuffer {
+    fun createBufferFromByteBuffer(
+        buffer: ByteBuffer, width: Int, height: Int, format: Int, wstride: Int = width, hstride: Int = height,
+        rdMode: Int = IM_RASTER_MODE
+    ): RgaBuffer {
         if (!buffer.isDirect) {
             throw kotlin.IllegalArgumentException("ByteBuffer must be direct")
         }
-        return RgaBuffer(width, height, format, wstride, hstride, ptr = buffer)
+        return RgaBuffer(width, height, format, wstride, hstride, ptr = buffer, rdMode = rdMode)
     }
 
     // Helper methods for Android Bitmap integration
@@ -231,7 +1056,9 @@ object Rga {
         )
     }
 
-    // Helper methods for NV21 data integration
+    // Helper methods for NV21 data integration. These copy the array into a
+    // direct ByteBuffer; per-frame callers can pass the ByteArray to
+    // improcess/imcvtcolor/imresize instead.
     fun createRgaBufferFromNv21(nv21Data: ByteArray, width: Int, height: Int, format: Int = Rga.RK_FORMAT_YCrCb_420_SP): RgaBuffer {
         val byteBuffer = java.nio.ByteBuffer.allocateDirect(nv21Data.size)
         byteBuffer.put(nv21Data)
@@ -0,0 +1,341 @@
+package com.rockchip.librga
+
+import android.os.Build
+import android.os.Process
+import android.os.SystemClock
+import org.json.JSONArray
+import org.json.JSONObject
+import java.io.File
+import java.nio.ByteBuffer
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicLongArray
+
+/**
+ * Sustained-load benchmark: [Config.threads] callers each run a weighted mix of
+ * operations on their own buffers for a fixed duration.
+ *
+ * Reports per-call latency percentiles, operations (frames) per second overall,
+ * per op and per one-second window (to expose thermal throttling), process CPU
+ * utilization and, when the driver's debugfs is readable, the load of each RGA core.
+ */
+class RgaBenchmark(private val config: Config) {
+
+    enum class Op(val label: String) {
+        COPY("copy"),
+        RESIZE("resize"),
+        CROP("crop"),
+        ROTATE("rotate"),
+        FLIP("flip"),
+        BLEND("blend"),
+        CVTCOLOR("cvtcolor"),
+        COPY_TASK("copyTask"),
+        RESIZE_TASK("resizeTask"),
+        CVTCOLOR_TASK("cvtcolorTask");
+
+        companion object {
+            fun fromLabel(label: String): Op? = values().firstOrNull { it.label.equals(label, ignoreCase = true) }
+        }
+    }
+
+    data class Config(
+        val threads: Int = 1,
+        val durationMs: Long = 10_000,
+        val warmupMs: Long = 1_000,
+        val width: Int = 1920,
+        val height: Int = 1080,
+        val format: Int = Rga.RK_FORMAT_RGBA_8888,
+        /** Relative weight of each op; ops are interleaved in proportion to their weight. */
+        val mix: Map<Op, Int> = mapOf(Op.RESIZE to 1)
+    ) {
+        companion object {
+            /** Parse "resize:2,cvtcolor,copyTask:1"; a missing weight counts as 1. */
+            fun parseMix(text: String): Map<Op, Int> {
+                val mix = LinkedHashMap<Op, Int>()
+                for (item in text.split(',').map { it.trim() }.filter { it.isNotEmpty() }) {
+                    val parts = item.split(':')
+                    val op = Op.fromLabel(parts[0].trim())
+                        ?: throw IllegalArgumentException("Unknown op '${parts[0]}'")
+                    val weight = parts.getOrNull(1)?.trim()?.toInt() ?: 1
+                    require(weight > 0) { "Weight of $op must be positive" }
+                    mix[op] = weight
+                }
+                require(mix.isNotEmpty()) { "Empty op mix" }
+                return mix
+            }
+        }
+    }
+
+    data class Latency(val count: Int, val p50Us: Double, val p99Us: Double, val maxUs: Double, val meanUs: Double)
+
+    data class OpResult(val op: Op, val latency: Latency, val failures: Long, val opsPerSecond: Double)
+
+    data class Result(
+        val config: Config,
+        val elapsedMs: Long,
+        val latency: Latency,
+        val failures: Long,
+        val framesPerSecond: Double,
+        val megapixelsPerSecond: Double,
+        val perOp: List<OpResult>,
+        /** Successful operations in each one-second window of the measured run. */
+        val timeline: List<Long>,
+        /** Process CPU time over wall time, 1.0 = one core busy. */
+        val cpuCores: Double,
+        val cpuUtilization: Double,
+        /** Average load in percent per RGA core, empty if the debugfs node is not readable. */
+        val rgaLoad: Map<String, Double>
+    ) {
+        fun toJson(): JSONObject {
+            fun latencyJson(l: Latency) = JSONObject()
+                .put("count", l.count)
+                .put("p50_us", l.p50Us)
+                .put("p99_us", l.p99Us)
+                .put("max_us", l.maxUs)
+                .put("mean_us", l.meanUs)
+
+            val device = JSONObject()
+                .put("manufacturer", Build.MANUFACTURER)
+                .put("model", Build.MODEL)
+                .put("hardware", Build.HARDWARE)
+                .put("board", Build.BOARD)
+                .put("sdk", Build.VERSION.SDK_INT)
+                .put("cpus", Runtime.getRuntime().availableProcessors())
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.S) {
+                device.put("soc", Build.SOC_MODEL)
+            }
+            val mix = JSONObject()
+            config.mix.forEach { (op, weight) -> mix.put(op.label, weight) }
+            val ops = JSONArray()
+            perOp.forEach {
+                ops.put(JSONObject()
+                    .put("op", it.op.label)
+                    .put("ops_per_second", it.opsPerSecond)
+                    .put("failures", it.failures)
+                    .put("latency", latencyJson(it.latency)))
+            }
+            val load = JSONObject()
+            rgaLoad.forEach { (core, percent) -> load.put(core, percent) }
+
+            return JSONObject()
+                .put("device", device)
+                .put("config", JSONObject()
+                    .put("threads", config.threads)
+                    .put("duration_ms", config.durationMs)
+                    .put("warmup_ms", config.warmupMs)
+                    .put("width", config.width)
+                    .put("height", config.height)
+                    .put("format", config.format)
+                    .put("mix", mix))
+                .put("elapsed_ms", elapsedMs)
+                .put("frames_per_second", framesPerSecond)
+                .put("megapixels_per_second", megapixelsPerSecond)
+                .put("failures", failures)
+                .put("latency", latencyJson(latency))
+                .put("ops", ops)
+                .put("timeline_fps", JSONArray(timeline))
+                .put("cpu_cores", cpuCores)
+                .put("cpu_utilization", cpuUtilization)
+                .put("rga_load_percent", if (rgaLoad.isEmpty()) JSONObject.NULL else load)
+        }
+
+        fun writeJson(file: File) {
+            file.writeText(toJson().toString(2))
+        }
+    }
+
+    private val stop = AtomicBoolean(false)
+
+    /** Ask a running [run] to finish early; results cover the time measured so far. */
+    fun cancel() {
+        stop.set(true)
+    }
+
+    /** Blocks for warmupMs + durationMs; call from a background thread. */
+    fun run(): Result {
+        require(config.threads > 0) { "threads must be positive" }
+        val schedule = config.mix.flatMap { (op, weight) -> List(weight) { op } }
+        val windows = ((config.durationMs + 999) / 1000).toInt().coerceAtLeast(1)
+        val timeline = AtomicLongArray(windows)
+        val workers = List(config.threads) { Worker(it, schedule) }
+        val started = CountDownLatch(config.threads)
+        val sampler = RgaLoadSampler()
+
+        stop.set(false)
+        val threads = workers.map { worker ->
+            Thread({
+                started.countDown()
+                worker.loop(timeline)
+            }, "RgaBench-${worker.index}")
+        }
+        threads.forEach { it.start() }
+        started.await()
+
+        SystemClock.sleep(config.warmupMs)
+        val cpuStart = Process.getElapsedCpuTime()
+        val begin = SystemClock.elapsedRealtimeNanos()
+        workers.forEach { it.startMeasuring(begin) }
+        sampler.start()
+
+        val end = begin + config.durationMs * 1_000_000
+        while (!stop.get() && SystemClock.elapsedRealtimeNanos() < end) {
+            SystemClock.sleep(minOf(100L, (end - SystemClock.elapsedRealtimeNanos()) / 1_000_000 + 1))
+        }
+        stop.set(true)
+        val elapsedNs = SystemClock.elapsedRealtimeNanos() - begin
+        threads.forEach { it.join() }
+        val cpuMs = Process.getElapsedCpuTime() - cpuStart
+        val rgaLoad = sampler.stop()
+
+        val elapsedSec = elapsedNs / 1e9
+        val all = workers.flatMap { w -> w.samples.flatMap { it.value } }.toLongArray()
+        val perOp = config.mix.keys.map { op ->
+            val samples = workers.flatMap { it.samples[op] ?: emptyList() }.toLongArray()
+            OpResult(op, latency(samples), workers.sumOf { it.failures[op] ?: 0L }, samples.size / elapsedSec)
+        }
+        val pixels = workers.sumOf { it.pixels }
+        val cores = Runtime.getRuntime().availableProcessors()
+        val measuredWindows = ((elapsedNs + 999_999_999) / 1_000_000_000).toInt().coerceIn(1, windows)
+        return Result(
+            config = config,
+            elapsedMs = elapsedNs / 1_000_000,
+            latency = latency(all),
+            failures = workers.sumOf { w -> w.failures.values.sum() },
+            framesPerSecond = all.size / elapsedSec,
+            megapixelsPerSecond = pixels / 1e6 / elapsedSec,
+            perOp = perOp,
+            timeline = List(measuredWindows) { timeline.get(it) },
+            cpuCores = cpuMs / 1000.0 / elapsedSec,
+            cpuUtilization = cpuMs / 1000.0 / elapsedSec / cores,
+            rgaLoad = rgaLoad
+        )
+    }
+
+    private fun latency(samplesNs: LongArray): Latency {
+        if (samplesNs.isEmpty()) return Latency(0, 0.0, 0.0, 0.0, 0.0)
+        samplesNs.sort()
+        fun at(q: Double) = samplesNs[((samplesNs.size - 1) * q).toInt()] / 1000.0
+        return Latency(samplesNs.size, at(0.50), at(0.99), samplesNs.last() / 1000.0, samplesNs.average() / 1000.0)
+    }
+
+    /** One caller thread with private buffers, so threads only contend inside librga. */
+    private inner class Worker(val index: Int, private val schedule: List<Op>) {
+        val samples = HashMap<Op, MutableList<Long>>()
+        val failures = HashMap<Op, Long>()
+        var pixels = 0L
+
+        @Volatile
+        private var measureFrom = Long.MAX_VALUE
+
+        private val w = config.width
+        private val h = config.height
+        private val isYuv = config.format == Rga.RK_FORMAT_YCbCr_420_SP || config.format == Rga.RK_FORMAT_YCrCb_420_SP
+        private val src = buffer(w, h, config.format)
+        private val dst = buffer(w, h, config.format)
+        private val half = buffer(w / 2, h / 2, config.format)
+        private val rotated = buffer(h, w, config.format)
+        private val converted = if (isYuv) buffer(w, h, Rga.RK_FORMAT_RGBA_8888) else buffer(w, h, Rga.RK_FORMAT_YCbCr_420_SP)
+        private val cropRect = Rga.RgaRect(w / 4 and 1.inv(), h / 4 and 1.inv(), w / 2, h / 2)
+
+        fun startMeasuring(fromNs: Long) {
+            measureFrom = fromNs
+        }
+
+        fun loop(timeline: AtomicLongArray) {
+            var i = index    // stagger the threads through the schedule
+            while (!stop.get()) {
+                val op = schedule[i++ % schedule.size]
+                val t0 = SystemClock.elapsedRealtimeNanos()
+                val ret = execute(op)
+                val t1 = SystemClock.elapsedRealtimeNanos()
+                if (t0 < measureFrom) continue
+                if (ret == Rga.IM_STATUS_SUCCESS) {
+                    samples.getOrPut(op) { ArrayList() }.add(t1 - t0)
+                    pixels += outputPixels(op)
+                    val window = ((t1 - measureFrom) / 1_000_000_000).toInt()
+                    if (window < timeline.length()) timeline.incrementAndGet(window)
+                } else {
+                    failures[op] = (failures[op] ?: 0L) + 1
+                }
+            }
+        }
+
+        private fun execute(op: Op): Int = when (op) {
+            Op.COPY -> Rga.imcopy(src, dst)
+            Op.RESIZE -> Rga.imresize(src, half)
+            Op.CROP -> Rga.imcrop(src, half, cropRect)
+            Op.ROTATE -> Rga.imrotate(src, rotated, Rga.IM_HAL_TRANSFORM_ROT_90)
+            Op.FLIP -> Rga.imflip(src, dst, Rga.IM_HAL_TRANSFORM_FLIP_H)
+            Op.BLEND -> Rga.imblend(src, dst, Rga.IM_ALPHA_BLEND_SRC_OVER)
+            Op.CVTCOLOR -> Rga.imcvtcolor(src, converted, src.format, converted.format)
+            Op.COPY_TASK -> job { Rga.imcopyTask(it, src, dst) }
+            Op.RESIZE_TASK -> job { Rga.imresizeTask(it, src, half) }
+            Op.CVTCOLOR_TASK -> job { Rga.imcvtcolorTask(it, src, converted, src.format, converted.format) }
+        }
+
+        private inline fun job(task: (Long) -> Int): Int {
+            val handle = Rga.imbeginJob()
+            if (handle == 0L) return -1
+            val ret = task(handle)
+            if (ret != Rga.IM_STATUS_SUCCESS) {
+                Rga.imcancelJob(handle)
+                return ret
+            }
+            return Rga.imendJob(handle)
+        }
+
+        private fun outputPixels(op: Op): Long = when (op) {
+            Op.RESIZE, Op.RESIZE_TASK, Op.CROP -> (w / 2).toLong() * (h / 2)
+            else -> w.toLong() * h
+        }
+
+        private fun buffer(width: Int, height: Int, format: Int): Rga.RgaBuffer {
+            val info = requireNotNull(Rga.formatInfo(format)) { "unknown format $format" }
+            val wstride = info.alignStride(width)
+            val bytes = info.imageSize(wstride, height)
+            val data = ByteBuffer.allocateDirect(bytes)
+            for (i in 0 until bytes step 64) data.put(i, (i * 7).toByte())
+            return Rga.createBufferFromByteBuffer(data, width, height, format, wstride, height)
+        }
+    }
+
+    /**
+     * Polls the rockchip RGA driver's load report (debugfs, usually root only) and
+     * averages the per-core load over the run.
+     */
+    private class RgaLoadSampler {
+        private val paths = listOf("/sys/kernel/debug/rkrga/load", "/proc/rkrga/load")
+        private val pattern = Regex("""scheduler\[\d+\]:\s*(\S+)\s+load\s*=\s*(\d+)%""")
+        private val sums = LinkedHashMap<String, Double>()
+        private var samples = 0
+        private var thread: Thread? = null
+        private val running = AtomicBoolean(false)
+
+        fun start() {
+            val node = paths.map { File(it) }.firstOrNull { it.canRead() } ?: return
+            running.set(true)
+            thread = Thread({
+                while (running.get()) {
+                    val text = runCatching { node.readText() }.getOrNull() ?: break
+                    synchronized(sums) {
+                        pattern.findAll(text).forEach {
+                            val core = it.groupValues[1]
+                            sums[core] = (sums[core] ?: 0.0) + it.groupValues[2].toDouble()
+                        }
+                        samples++
+                    }
+                    SystemClock.sleep(500)
+                }
+            }, "RgaBenchLoad").apply { start() }
+        }
+
+        fun stop(): Map<String, Double> {
+            running.set(false)
+            thread?.join()
+            synchronized(sums) {
+                if (samples == 0) return emptyMap()
+                return sums.mapValues { it.value / samples }
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+package com.rockchip.librga
+
+/**
+ * Composes N layers (video streams, overlays) onto one [width] x [height]
+ * output with one RGA job per frame, split every 50 tasks (librga's limit).
+ *
+ * Layers under an opaque layer are not drawn there, and only what changed since
+ * the destination buffer was last composed is redrawn: call [damageLayer] when
+ * a layer's buffer has a new frame; geometry changes via [setLayer] are tracked
+ * automatically. Destinations are recognized by fd or address, so a
+ * double-buffered output only redraws the damage of the last two frames.
+ */
+class RgaCompositor(val width: Int, val height: Int) : AutoCloseable {
+
+    /**
+     * One layer. [srcRect] null means the whole buffer; [transform] takes
+     * IM_HAL_TRANSFORM_* flags. [alpha] below 255 or [blend] (per-pixel alpha,
+     * src-over) make the layer translucent; higher [zOrder] is on top.
+     */
+    data class Layer(
+        val buffer: Rga.RgaBuffer,
+        val dstRect: Rga.RgaRect,
+        val srcRect: Rga.RgaRect? = null,
+        val transform: Int = 0,
+        val alpha: Int = 255,
+        val zOrder: Int = 0,
+        val blend: Boolean = false
+    )
+
+    /** Work done by the last [compose] compared with redrawing everything. */
+    data class Stats(
+        val layers: Int,
+        val layersDrawn: Int,
+        val layersCulled: Int,
+        val tasks: Int,
+        val damagePixels: Long,
+        val pixelsDrawn: Long,
+        val pixelsFull: Long
+    )
+
+    private var handle: Long = Rga.compositorCreate(width, height)
+
+    // Layer buffers are referenced by address from native code.
+    private val layers = HashMap<Int, Layer>()
+
+    /** Add or replace layer [id]. */
+    fun setLayer(id: Int, layer: Layer): Int {
+        val ret = Rga.compositorSetLayer(
+            handle, id, layer.buffer, layer.srcRect, layer.dstRect,
+            layer.transform, layer.alpha, layer.zOrder, layer.blend
+        )
+        if (ret == Rga.IM_STATUS_SUCCESS) layers[id] = layer
+        return ret
+    }
+
+    fun removeLayer(id: Int) {
+        Rga.compositorRemoveLayer(handle, id)
+        layers.remove(id)
+    }
+
+    /** Layer [id] has new content (e.g. the next video frame was written to its buffer). */
+    fun damageLayer(id: Int) = Rga.compositorDamageLayer(handle, id)
+
+    /** Color (0xAABBGGRR) where no layer is drawn. */
+    fun setBackground(color: Int) = Rga.compositorSetBackground(handle, color)
+
+    /** Redraw what changed on [dst] and wait for it. */
+    fun compose(dst: Rga.RgaBuffer): Int = Rga.compositorCompose(handle, dst)
+
+    val stats: Stats
+        get() {
+            val v = Rga.compositorStatsNative(handle)
+            return Stats(v[0].toInt(), v[1].toInt(), v[2].toInt(), v[3].toInt(), v[4], v[5], v[6])
+        }
+
+    override fun close() {
+        if (handle != 0L) {
+            Rga.compositorDestroy(handle)
+            handle = 0L
+            layers.clear()
+        }
+    }
+}
@@ -0,0 +1,44 @@
+package com.rockchip.librga
+
+/**
+ * Memory-mapped reader for raw frame files (back-to-back frames of one
+ * RK_FORMAT_*, e.g. a YUV capture). [frame] returns a buffer that points into
+ * the mapping, so it can be passed to any Rga operation without a copy.
+ *
+ * [frameBytes] 0 derives the frame size from format and strides; set it for
+ * padded or FBC captures. [prefetch] frames ahead are requested from the page
+ * cache as the file is read.
+ */
+class RgaFrameReader(
+    path: String,
+    val width: Int,
+    val height: Int,
+    val format: Int,
+    val wstride: Int = width,
+    val hstride: Int = height,
+    frameBytes: Long = 0,
+    prefetch: Int = 4
+) : AutoCloseable {
+
+    private var handle: Long = Rga.frameReaderOpen(path, width, height, format, wstride, hstride, frameBytes, prefetch)
+
+    init {
+        require(handle != 0L) { "Failed to map $path" }
+    }
+
+    val frameCount: Int = Rga.frameReaderCount(handle)
+
+    /** Read-only view of frame [index], valid until [close]. */
+    fun frame(index: Int): Rga.RgaBuffer {
+        val pixels = Rga.frameReaderFrame(handle, index)
+            ?: throw IndexOutOfBoundsException("Frame $index of $frameCount")
+        return Rga.createBufferFromByteBuffer(pixels.asReadOnlyBuffer(), width, height, format, wstride, hstride)
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            Rga.frameReaderClose(handle)
+            handle = 0L
+        }
+    }
+}
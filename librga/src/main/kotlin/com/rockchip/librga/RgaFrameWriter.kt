@@ -0,0 +1,45 @@
+package com.rockchip.librga
+
+/**
+ * Memory-mapped writer for raw frame files. [next] appends a frame and returns
+ * a buffer inside the mapping that an Rga operation can write to directly.
+ * The file grows [growFrames] frames at a time and is trimmed on [close].
+ */
+class RgaFrameWriter(
+    path: String,
+    val width: Int,
+    val height: Int,
+    val format: Int,
+    val wstride: Int = width,
+    val hstride: Int = height,
+    frameBytes: Long = 0,
+    growFrames: Int = 16
+) : AutoCloseable {
+
+    private var handle: Long = Rga.frameWriterOpen(path, width, height, format, wstride, hstride, frameBytes, growFrames)
+
+    init {
+        require(handle != 0L) { "Failed to create $path" }
+    }
+
+    val frameCount: Int
+        get() = if (handle != 0L) Rga.frameWriterCount(handle) else 0
+
+    /** Append a frame; the buffer is only valid until the next call (the mapping may move). */
+    fun next(): Rga.RgaBuffer {
+        val pixels = Rga.frameWriterNext(handle) ?: throw java.io.IOException("Failed to grow frame file")
+        return Rga.createBufferFromByteBuffer(pixels, width, height, format, wstride, hstride)
+    }
+
+    /** Flushes and trims the file; returns the status of the writeback. */
+    fun finish(): Int {
+        if (handle == 0L) return Rga.IM_STATUS_SUCCESS
+        val ret = Rga.frameWriterClose(handle)
+        handle = 0L
+        return ret
+    }
+
+    override fun close() {
+        finish()
+    }
+}
@@ -0,0 +1,76 @@
+package com.rockchip.librga
+
+/**
+ * Builds a chain of RGA operations and compiles it into as few hardware passes
+ * as possible: crop, resize, rotate/flip and cvtcolor steps are folded into a
+ * single improcess() call until a step cannot be fused (a crop that does not
+ * map to whole source pixels, a scale beyond 1/8..8, or rotate 90/270 combined
+ * with a mirror). Only images that must exist get scratch buffers.
+ *
+ * The graph is fixed once compiled; rebind inputs and outputs to process the
+ * next frame with the same plan.
+ */
+class RgaGraph : AutoCloseable {
+
+    /** Compilation result: [passes] submissions instead of one per op. */
+    data class Stats(
+        val ops: Int,
+        val passes: Int,
+        val intermediates: Int,
+        val intermediateBytes: Long,
+        val bytesUnfused: Long,
+        val bytesFused: Long
+    ) {
+        val bytesSaved: Long
+            get() = bytesUnfused - bytesFused
+    }
+
+    private var handle: Long = Rga.graphCreate()
+
+    // The native graph keeps raw buffer addresses; hold the Kotlin objects.
+    private val bound = HashMap<Int, Rga.RgaBuffer>()
+
+    fun input(buffer: Rga.RgaBuffer): Int = node(Rga.graphInput(handle, buffer)).also { bound[it] = buffer }
+    fun crop(node: Int, rect: Rga.RgaRect): Int = node(Rga.graphCrop(handle, node, rect))
+    fun resize(node: Int, width: Int, height: Int): Int = node(Rga.graphResize(handle, node, width, height))
+    fun cvtcolor(node: Int, format: Int): Int = node(Rga.graphCvtcolor(handle, node, format))
+
+    /** [rotation]: IM_HAL_TRANSFORM_ROT_90/180/270. */
+    fun rotate(node: Int, rotation: Int): Int = node(Rga.graphRotate(handle, node, rotation))
+
+    /** [mode]: IM_HAL_TRANSFORM_FLIP_H/V/H_V. */
+    fun flip(node: Int, mode: Int): Int = node(Rga.graphFlip(handle, node, mode))
+
+    /** Write [node] to [buffer], which must match its size and format. */
+    fun output(node: Int, buffer: Rga.RgaBuffer): Int =
+        Rga.graphOutput(handle, node, buffer).also { if (it == Rga.IM_STATUS_SUCCESS) bound[node] = buffer }
+
+    /** Point an input or output at another buffer of the same size and format. */
+    fun rebind(node: Int, buffer: Rga.RgaBuffer): Int =
+        Rga.graphRebind(handle, node, buffer).also { if (it == Rga.IM_STATUS_SUCCESS) bound[node] = buffer }
+
+    /** Plan the passes; [run] compiles on first use. */
+    fun compile(): Int = Rga.graphCompile(handle)
+
+    /** Run all passes as one job and wait for it. */
+    fun run(): Int = Rga.graphRun(handle)
+
+    val stats: Stats
+        get() {
+            val v = Rga.graphStatsNative(handle)
+            return Stats(v[0].toInt(), v[1].toInt(), v[2].toInt(), v[3], v[4], v[5])
+        }
+
+    override fun close() {
+        if (handle != 0L) {
+            Rga.graphDestroy(handle)
+            handle = 0L
+            bound.clear()
+        }
+    }
+
+    private fun node(id: Int): Int {
+        require(id >= 0) { "Invalid RgaGraph operation" }
+        return id
+    }
+}
@@ -0,0 +1,64 @@
+package com.rockchip.librga
+
+/**
+ * Damage-tracked processing for mostly static content (UI overlays,
+ * dashboards): each [process] call only resubmits the rectangles that changed
+ * since the previous call and leaves the rest of the destination untouched.
+ *
+ * Pass the changed source rects as `dirty`, or leave it null to have them
+ * found by hashing [blockSize] x [blockSize] blocks of the source on the CPU.
+ * Changing the destination, rects or usage processes everything once.
+ * Blending is not supported (a piece would be blended twice).
+ */
+class RgaIncremental(val blockSize: Int = 32) : AutoCloseable {
+
+    /** Totals since creation or [resetStats]. */
+    data class Stats(
+        val frames: Long,
+        val fullFrames: Long,
+        val skippedFrames: Long,
+        val blocks: Long,
+        val dirtyBlocks: Long,
+        val tasks: Long,
+        val pixelsTotal: Long,
+        val pixelsProcessed: Long,
+        val hashNs: Long
+    ) {
+        /** Fraction of destination pixels that did not have to be written. */
+        val savedRatio: Double
+            get() = if (pixelsTotal == 0L) 0.0 else 1.0 - pixelsProcessed.toDouble() / pixelsTotal
+    }
+
+    private var handle: Long = Rga.incrementalCreate(blockSize)
+
+    /**
+     * Process [srcRect] of [src] into [dstRect] of [dst] (null = whole image) with
+     * [usage] (IM_HAL_TRANSFORM_* flags; formats may differ). Blocks until done.
+     */
+    fun process(
+        src: Rga.RgaBuffer,
+        dst: Rga.RgaBuffer,
+        srcRect: Rga.RgaRect? = null,
+        dstRect: Rga.RgaRect? = null,
+        usage: Int = 0,
+        dirty: Array<Rga.RgaRect>? = null
+    ): Int = Rga.incrementalProcess(handle, src, dst, srcRect, dstRect, usage, dirty)
+
+    /** Process everything on the next call, e.g. after [dst] was written elsewhere. */
+    fun invalidate() = Rga.incrementalInvalidate(handle)
+
+    val stats: Stats
+        get() {
+            val v = Rga.incrementalStatsNative(handle)
+            return Stats(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8])
+        }
+
+    fun resetStats() = Rga.incrementalResetStats(handle)
+
+    override fun close() {
+        if (handle != 0L) {
+            Rga.incrementalDestroy(handle)
+            handle = 0L
+        }
+    }
+}
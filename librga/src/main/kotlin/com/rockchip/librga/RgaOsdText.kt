@@ -0,0 +1,134 @@
+package com.rockchip.librga
+
+import android.graphics.Bitmap
+import android.graphics.Canvas
+import android.graphics.Paint
+import android.graphics.Rect
+import android.graphics.Typeface
+import java.nio.ByteBuffer
+
+/**
+ * OSD text (timestamps, channel names, box labels) blended onto frames by the
+ * RGA instead of drawn through a Canvas every frame.
+ *
+ * Glyphs are rasterized once into an A8 atlas of [atlasWidth] x [atlasHeight].
+ * Each distinct label (text, colors, padding) is rendered into an RGBA image
+ * the first time it is drawn and cached, up to [maxCached] of them, so
+ * unchanged labels cost one blend task per frame. [draw] blends all labels
+ * as one job.
+ */
+class RgaOsdText(
+    val atlasWidth: Int = 1024,
+    val atlasHeight: Int = 512,
+    val maxCached: Int = 256
+) : AutoCloseable {
+
+    /** Colors are 0xAABBGGRR; a [background] with alpha 0 draws no box. */
+    data class Label(
+        val text: String,
+        val x: Int,
+        val y: Int,
+        val color: Int = 0xFFFFFFFF.toInt(),
+        val background: Int = 0,
+        val padding: Int = 2
+    )
+
+    data class Stats(
+        val glyphs: Int,
+        val atlasRows: Int,
+        val cachedStrings: Int,
+        val cacheHits: Long,
+        val cacheMisses: Long,
+        val tasks: Int
+    )
+
+    private var handle: Long = Rga.osdTextCreate(atlasWidth, atlasHeight, maxCached)
+
+    /**
+     * Rasterize [chars] with [typeface] at [textSize] px. Characters missing
+     * from later labels are drawn as '?' if it was loaded.
+     */
+    fun loadFont(
+        typeface: Typeface = Typeface.MONOSPACE,
+        textSize: Float = 32f,
+        chars: String = (32..126).map { it.toChar() }.joinToString("")
+    ): Int {
+        val paint = Paint(Paint.ANTI_ALIAS_FLAG).apply {
+            this.typeface = typeface
+            this.textSize = textSize
+            color = android.graphics.Color.WHITE
+        }
+        val metrics = paint.fontMetricsInt
+        Rga.osdTextSetMetrics(handle, -metrics.ascent, metrics.descent - metrics.ascent)
+        val bounds = Rect()
+        var ret = Rga.IM_STATUS_SUCCESS
+        var i = 0
+        while (i < chars.length && ret == Rga.IM_STATUS_SUCCESS) {
+            val codepoint = chars.codePointAt(i)
+            val glyph = String(Character.toChars(codepoint))
+            i += Character.charCount(codepoint)
+            paint.getTextBounds(glyph, 0, glyph.length, bounds)
+            val advance = Math.round(paint.measureText(glyph))
+            if (bounds.isEmpty) {
+                ret = addGlyph(codepoint, ByteArray(0), 0, 0, 0, 0, advance)
+                continue
+            }
+            val bitmap = Bitmap.createBitmap(bounds.width(), bounds.height(), Bitmap.Config.ALPHA_8)
+            Canvas(bitmap).drawText(glyph, -bounds.left.toFloat(), -bounds.top.toFloat(), paint)
+            val coverage = ByteBuffer.allocate(bitmap.rowBytes * bitmap.height)
+            bitmap.copyPixelsToBuffer(coverage)
+            bitmap.recycle()
+            val packed = ByteArray(bounds.width() * bounds.height())
+            for (row in 0 until bounds.height()) {
+                System.arraycopy(coverage.array(), row * bitmap.rowBytes, packed, row * bounds.width(), bounds.width())
+            }
+            ret = addGlyph(codepoint, packed, bounds.width(), bounds.height(), bounds.left, -bounds.top, advance)
+        }
+        return ret
+    }
+
+    /** Line metrics for glyphs added with [addGlyph]: baseline below the top, and line height. */
+    fun setMetrics(ascent: Int, lineHeight: Int) = Rga.osdTextSetMetrics(handle, ascent, lineHeight)
+
+    /**
+     * Add one glyph from another rasterizer: width x height coverage bytes,
+     * placed [left]/[top] from the pen on the baseline, advancing by [advance].
+     */
+    fun addGlyph(codepoint: Int, coverage: ByteArray, width: Int, height: Int, left: Int, top: Int, advance: Int): Int =
+        Rga.osdTextAddGlyph(handle, codepoint, coverage, width, height, left, top, advance)
+
+    /** Width and height of the label box for [text]. */
+    fun measure(text: String, padding: Int = 2): Pair<Int, Int> {
+        val size = Rga.osdTextMeasure(handle, text, padding)
+        return Pair(size[0], size[1])
+    }
+
+    /** Blend [labels] onto [dst] (clipped to it); [cpu] blends on the CPU instead. */
+    fun draw(dst: Rga.RgaBuffer, labels: List<Label>, cpu: Boolean = false): Int {
+        val params = IntArray(labels.size * 5)
+        labels.forEachIndexed { i, l ->
+            params[5 * i] = l.x
+            params[5 * i + 1] = l.y
+            params[5 * i + 2] = l.color
+            params[5 * i + 3] = l.background
+            params[5 * i + 4] = l.padding
+        }
+        return Rga.osdTextDraw(handle, dst, labels.map { it.text }.toTypedArray(), params, cpu)
+    }
+
+    /** Drop all rendered strings, e.g. after many one-off labels. */
+    fun clearCache() = Rga.osdTextClearCache(handle)
+
+    val stats: Stats
+        get() {
+            val v = Rga.osdTextStatsNative(handle)
+            return Stats(v[0].toInt(), v[1].toInt(), v[2].toInt(), v[3], v[4], v[5].toInt())
+        }
+
+    override fun close() {
+        if (handle != 0L) {
+            Rga.osdTextDestroy(handle)
+            handle = 0L
+        }
+    }
+}
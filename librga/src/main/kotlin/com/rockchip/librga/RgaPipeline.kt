@@ -0,0 +1,88 @@
+package com.rockchip.librga
+
+/**
+ * Asynchronous RGA frame pipeline. Each submitted frame runs [stages] as one
+ * hardware job; up to [depth] frames are in flight at once and results come
+ * back from [dequeue] in submission order.
+ *
+ * submit() blocks (backpressure) while [depth] frames are in flight or every
+ * output buffer is held by the consumer. Outputs live in an internal pool of
+ * [outputSlots] buffers: close each [Frame] once done with it.
+ *
+ * Typically one thread submits and another dequeues.
+ */
+class RgaPipeline(
+    stages: List<Rga.RgaPipelineStage>,
+    val depth: Int = 3,
+    val outputSlots: Int = depth + 2
+) : AutoCloseable {
+
+    /** A finished frame; [buffer] is only valid until [close]. */
+    inner class Frame internal constructor(
+        val seq: Long,
+        val tag: Long,
+        val status: Int,
+        private val slot: Int,
+        val buffer: Rga.RgaBuffer
+    ) : AutoCloseable {
+        private var recycled = false
+
+        val isSuccess: Boolean
+            get() = status == Rga.IM_STATUS_SUCCESS
+
+        override fun close() {
+            if (!recycled && handle != 0L) {
+                recycled = true
+                Rga.pipelineRecycle(handle, slot)
+            }
+        }
+    }
+
+    private var handle: Long = Rga.pipelineCreate(stages.toTypedArray(), depth, outputSlots)
+
+    // Inputs must outlive their job; they complete in order, so a FIFO suffices.
+    private val pendingInputs = ArrayDeque<Rga.RgaBuffer>()
+
+    init {
+        require(handle != 0L) { "Failed to create RGA pipeline" }
+    }
+
+    /**
+     * Queue [input], which must stay valid until its frame is dequeued.
+     * Returns the submit status, or RGA_PIPELINE_TIMEOUT if no slot freed up
+     * within [timeoutMs] (negative waits forever). A failed frame is still
+     * delivered by [dequeue] with its status.
+     */
+    fun submit(input: Rga.RgaBuffer, tag: Long = 0, acquireFence: Int = -1, timeoutMs: Int = -1): Int {
+        synchronized(pendingInputs) { pendingInputs.addLast(input) }
+        val ret = Rga.pipelineSubmit(handle, input, acquireFence, tag, timeoutMs)
+        if (ret == Rga.RGA_PIPELINE_TIMEOUT) {
+            synchronized(pendingInputs) { pendingInputs.removeLast() }
+        }
+        return ret
+    }
+
+    /** Next finished frame in submission order, or null after [timeoutMs] (negative waits forever). */
+    fun dequeue(timeoutMs: Int = -1): Frame? {
+        val meta = LongArray(10)
+        val pixels = Rga.pipelineDequeueNative(handle, timeoutMs, meta) ?: return null
+        synchronized(pendingInputs) { pendingInputs.removeFirstOrNull() }
+        val buffer = Rga.createBufferFromByteBuffer(
+            pixels, meta[4].toInt(), meta[5].toInt(), meta[8].toInt(), meta[6].toInt(), meta[7].toInt(),
+            meta[9].toInt()
+        )
+        return Frame(meta[0], meta[1], meta[2].toInt(), meta[3].toInt(), buffer)
+    }
+
+    /** Wait until no frame is in flight; finished frames stay queued for [dequeue]. */
+    fun flush() = Rga.pipelineFlush(handle)
+
+    /** Waits for frames in flight and frees all buffers, including undelivered outputs. */
+    override fun close() {
+        if (handle != 0L) {
+            Rga.pipelineDestroy(handle)
+            handle = 0L
+            synchronized(pendingInputs) { pendingInputs.clear() }
+        }
+    }
+}
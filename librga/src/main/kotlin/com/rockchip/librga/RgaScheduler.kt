@@ -0,0 +1,104 @@
+package com.rockchip.librga
+
+/**
+ * Deadline-aware RGA submission. [submit] only queues work; [workers] threads
+ * (one per RGA core by default) run each submission as one hardware job, and
+ * results come back from [poll].
+ *
+ * Under overload a stream drops frames instead of falling behind: it keeps at
+ * most `maxQueued` waiting submissions (older ones are dropped for the newest),
+ * work with the earliest deadline runs first, and a submission that can no
+ * longer meet its deadline is dropped or its job cancelled. Dropped results
+ * have status [Rga.RGA_SCHEDULER_DROPPED]; [stats] counts drops and late jobs.
+ */
+class RgaScheduler(val workers: Int = 2) : AutoCloseable {
+
+    /** Outcome of one submission; its buffers may be reused once it is returned. */
+    data class Result(
+        val stream: Int,
+        val tag: Long,
+        val status: Int,
+        val late: Boolean,
+        val waitNs: Long,
+        val latencyNs: Long
+    ) {
+        val isSuccess: Boolean
+            get() = status == Rga.IM_STATUS_SUCCESS
+
+        val isDropped: Boolean
+            get() = status == Rga.RGA_SCHEDULER_DROPPED
+    }
+
+    /** [dropped] includes [cancelled]; [completed] includes [late]. */
+    data class Stats(
+        val submitted: Long,
+        val completed: Long,
+        val late: Long,
+        val dropped: Long,
+        val cancelled: Long,
+        val failed: Long,
+        val jobNs: Long,
+        val queued: Long
+    )
+
+    private var handle: Long = Rga.schedulerCreate(workers)
+
+    // Buffers are referenced by address from native code until their result is polled.
+    private val pending = HashMap<Long, Pair<Long, List<Rga.RgaSchedulerTask>>>()
+    private var nextKey = 0L
+
+    init {
+        require(handle != 0L) { "Failed to create RGA scheduler" }
+    }
+
+    /** New stream keeping at most [maxQueued] submissions waiting; 1 always runs the newest frame. */
+    fun addStream(maxQueued: Int = 1): Int = Rga.schedulerAddStream(handle, maxQueued)
+
+    /**
+     * Queue [tasks] as one job on [stream]. [deadlineNs] is a System.nanoTime()
+     * value (0 = none). The buffers must stay valid until [poll] returns the result.
+     * A job holds at most 50 tasks; more return IM_STATUS_INVALID_PARAM.
+     */
+    fun submit(stream: Int, tasks: List<Rga.RgaSchedulerTask>, deadlineNs: Long = 0, tag: Long = 0): Int {
+        val key = synchronized(pending) {
+            val key = nextKey++
+            pending[key] = Pair(tag, tasks)
+            key
+        }
+        val ret = Rga.schedulerSubmit(handle, stream, tasks.toTypedArray(), deadlineNs, key)
+        if (ret != Rga.IM_STATUS_SUCCESS) {
+            synchronized(pending) { pending.remove(key) }
+        }
+        return ret
+    }
+
+    /** [submit] with a deadline [budgetMs] from now. */
+    fun submitWithin(stream: Int, tasks: List<Rga.RgaSchedulerTask>, budgetMs: Long, tag: Long = 0): Int =
+        submit(stream, tasks, System.nanoTime() + budgetMs * 1_000_000L, tag)
+
+    /** Next result, or null after [timeoutMs] (negative waits forever). */
+    fun poll(timeoutMs: Int = -1): Result? {
+        val meta = LongArray(6)
+        if (!Rga.schedulerPollNative(handle, timeoutMs, meta)) return null
+        val tag = synchronized(pending) { pending.remove(meta[1])?.first ?: 0L }
+        return Result(meta[0].toInt(), tag, meta[2].toInt(), meta[3] != 0L, meta[4], meta[5])
+    }
+
+    /** Counters of [stream], or of all streams for -1. */
+    fun stats(stream: Int = -1): Stats {
+        val v = Rga.schedulerStatsNative(handle, stream)
+        return Stats(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7])
+    }
+
+    /** Wait until nothing is waiting or running; results stay queued for [poll]. */
+    fun flush() = Rga.schedulerFlush(handle)
+
+    /** Drops waiting submissions and waits for running jobs. */
+    override fun close() {
+        if (handle != 0L) {
+            Rga.schedulerDestroy(handle)
+            handle = 0L
+            synchronized(pending) { pending.clear() }
+        }
+    }
+}
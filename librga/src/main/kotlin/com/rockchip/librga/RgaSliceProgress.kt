@@ -0,0 +1,58 @@
+package com.rockchip.librga
+
+/**
+ * Written-row progress of a frame, for handing the top of a frame to a
+ * consumer (typically a video encoder) before the RGA has written the rest.
+ *
+ * [process] writes the frame in horizontal slices laid out like the RGA write
+ * pre-interrupt (IM_PRE_INTR): `writeStart` rows, then `writeStep` rows per
+ * slice. It blocks until the frame is done, so run it on a worker thread
+ * while the consumer polls [rows] or blocks in [awaitRows]. librga does not
+ * report pre-interrupts to apps, so every slice is its own RGA call; the
+ * host build runs the same slices on the CPU, and [latencyNs] gives the time
+ * to the first rows either way.
+ */
+class RgaSliceProgress : AutoCloseable {
+
+    internal var handle: Long = Rga.sliceProgressCreate()
+        private set
+
+    /**
+     * Convert/scale [src] (or [srcRect] of it) into [dstRect] of [dst] slice by
+     * slice. Null rects mean the whole image; [usage] takes
+     * IM_HAL_TRANSFORM_* flags (90/270 degree rotations run as one slice).
+     */
+    fun process(
+        src: Rga.RgaBuffer,
+        dst: Rga.RgaBuffer,
+        writeStart: Int,
+        writeStep: Int,
+        srcRect: Rga.RgaRect? = null,
+        dstRect: Rga.RgaRect? = null,
+        usage: Int = 0
+    ): Int = Rga.improcessSlicedNative(handle, src, dst, srcRect, dstRect, usage, writeStart, writeStep)
+
+    /** Rows written so far, from the top of the destination rect. */
+    val rows: Int
+        get() = Rga.sliceProgressRows(handle)
+
+    val totalRows: Int
+        get() = Rga.sliceProgressTotalRows(handle)
+
+    /** Result of the last [process], IM_STATUS_NOERROR while it is running. */
+    val status: Int
+        get() = Rga.sliceProgressStatus(handle)
+
+    /** Wait until [rows] rows are written or the frame is done; false on timeout (-1 waits forever). */
+    fun awaitRows(rows: Int, timeoutMs: Int = -1): Boolean = Rga.sliceProgressWait(handle, rows, timeoutMs)
+
+    /** Nanoseconds from the start of [process] until [rows] rows were written, -1 if not yet. */
+    fun latencyNs(rows: Int): Long = Rga.sliceProgressLatencyNs(handle, rows)
+
+    override fun close() {
+        if (handle != 0L) {
+            Rga.sliceProgressDestroy(handle)
+            handle = 0L
+        }
+    }
+}
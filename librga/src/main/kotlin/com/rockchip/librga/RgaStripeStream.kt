@@ -0,0 +1,76 @@
+package com.rockchip.librga
+
+/**
+ * Resize + format conversion of frames that arrive in horizontal stripes
+ * (line-based sensors, scanners), writing each output stripe as soon as the
+ * source rows it needs have been pushed instead of waiting for the frame.
+ *
+ * Output stripes sit where the scale maps whole, aligned destination rows
+ * onto whole, aligned source rows: [outputStep] dst rows from every
+ * [inputStep] src rows, at least [minOutputRows] per stripe. Rows a pushed
+ * stripe leaves over are carried into a small buffer and stitched with the
+ * next one. Same-size conversions and integer downscales match a whole-frame
+ * call; upscales can differ next to stripe edges.
+ */
+class RgaStripeStream(
+    val srcWidth: Int,
+    val srcHeight: Int,
+    val srcFormat: Int,
+    val minOutputRows: Int = 16
+) : AutoCloseable {
+
+    data class Stats(
+        val stripes: Long,
+        val outputs: Long,
+        val inPlace: Long,
+        val stitched: Long,
+        val copiedRows: Long
+    )
+
+    private var handle: Long = Rga.stripeCreate(srcWidth, srcHeight, srcFormat, minOutputRows)
+
+    /**
+     * Start a frame written into [dstRect] of [dst] (null = whole image).
+     * [usage] takes IM_HAL_TRANSFORM_FLIP_H; [progress] receives every
+     * written output stripe, e.g. for an encoder handoff.
+     */
+    fun begin(
+        dst: Rga.RgaBuffer,
+        dstRect: Rga.RgaRect? = null,
+        usage: Int = 0,
+        progress: RgaSliceProgress? = null
+    ): Int = Rga.stripeBegin(handle, dst, dstRect, usage, progress?.handle ?: 0L)
+
+    /**
+     * The next [stripe].height rows of the frame, a multiple of the source
+     * format's alignment except for the last stripe. [stripe] may be reused
+     * once this returns.
+     */
+    fun push(stripe: Rga.RgaBuffer): Int = Rga.stripePush(handle, stripe)
+
+    /** Cancel the current frame; its progress finishes with IM_STATUS_FAILED. */
+    fun abort() = Rga.stripeAbort(handle)
+
+    val inputStep: Int
+        get() = Rga.stripeInputStep(handle)
+
+    val outputStep: Int
+        get() = Rga.stripeOutputStep(handle)
+
+    /** Destination rows written in the current frame. */
+    val writtenRows: Int
+        get() = Rga.stripeWrittenRows(handle)
+
+    val stats: Stats
+        get() {
+            val v = Rga.stripeStatsNative(handle)
+            return Stats(v[0], v[1], v[2], v[3], v[4])
+        }
+
+    override fun close() {
+        if (handle != 0L) {
+            Rga.stripeDestroy(handle)
+            handle = 0L
+        }
+    }
+}